@@ -417,14 +417,19 @@ DESIGN TIPS (GD Creator School digest):
 #include <cmath>
 #include <cstdint>
 #include <deque>
+#include <queue>
+#include <fstream>
 #include <unordered_set>
 #include "sessions.hpp"
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <random>
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <cstdio>
 #include <vector>
 
 #ifdef _WIN32
@@ -434,8 +439,10 @@ DESIGN TIPS (GD Creator School digest):
   // (socket/bind/listen/accept/recv/send/WSAStartup) so we just rely on
   // whatever Geode already brought in and tell the linker to pull Ws2_32.lib.
   #pragma comment(lib, "Ws2_32.lib")
+  #include <io.h>          // _commit / _fileno (io::commit's fsync)
   using socklen_compat = int;
 #else
+  #include <fcntl.h>
   #include <arpa/inet.h>
   #include <netinet/in.h>
   #include <sys/select.h>
@@ -783,6 +790,42 @@ inline void clearSavedToken(const std::string& provider) {
 // the temperature param on OpenAI o-series reasoning models.
 static bool isOSeriesModel(const std::string& model);
 
+// keep_alive for every Ollama request the mod sends: the model stays loaded
+// this long after the last one (see ollamaRes). Minutes setting → "30m";
+// 0 leaves Ollama's own default. Platinum coordinators are shared GPUs that
+// manage residency themselves — they never get one.
+static matjson::Value ollamaKeepAlive() {
+    if (geode::Mod::get()->getSettingValue<bool>("use-platinum")) return matjson::Value();
+    auto mins = geode::Mod::get()->getSettingValue<int64_t>("ollama-keep-alive");
+    if (mins <= 0) return matjson::Value();
+    return fmt::format("{}m", mins);
+}
+
+// What a (provider, model) pair can actually do, as reported by its own
+// endpoints (namespace caps, defined later in this file, probes and caches
+// it). Fields stay at their "unknown" value when the endpoint doesn't say;
+// every consumer then falls back to its static guess.
+struct ModelCaps {
+    int         context   = 0;    // usable context window, tokens
+    int         maxOutput = 0;    // output cap, tokens
+    int         tools     = -1;   // -1 unknown, 0 no, 1 yes
+    int         vision    = -1;
+    std::string tokenizer;        // family ("llama", "gpt2", "qwen2", ...)
+    int64_t     probedAt  = 0;    // unix seconds
+};
+static const ModelCaps* probedCaps(const std::string& provider, const std::string& model);
+
+// num_ctx for Ollama requests: the probed window (already capped, see caps)
+// or 0 = leave the runner's default. Every request for a model — warm-up
+// included — must carry the same value, or Ollama reloads the model.
+static int ollamaNumCtx(const std::string& model) {
+    auto* c = probedCaps("ollama", model);
+    return c ? c->context : 0;
+}
+
+// Local daemon, or the best Platinum coordinator (see namespace platinum).
+static std::string getOllamaUrl();
+
 namespace toolUse {
 
 // Tool-call rounds are unbounded — there is no round budget. See the loop
@@ -910,8 +953,9 @@ inline matjson::Value buildToolCatalog() {
         "Run the mod's fly-anywhere pathfinder over the objects from your "
         "ACCEPTED DRAFTS so far (it sees nothing until after your first JSON "
         "answer — use it between EXTEND rounds, not before the first draft). "
-        "Returns the passability percentage and a list of fully-blocked X "
-        "zones (death zones) so you can fix impossible sections early — the "
+        "Returns the physics verifier's verdict (route found, or the first "
+        "provably blocked X) plus the column scan's open percentage and "
+        "fully-blocked zones, so you can fix impossible sections early — the "
         "mod will otherwise bounce them back to you for fixes.",
         {},
         {}
@@ -929,10 +973,11 @@ inline matjson::Value buildToolCatalog() {
     }
     arr.push(openAIToolSchema(
         "simulate_physics",
-        "Run a cube-physics bot through your ACCEPTED DRAFT: it jumps "
-        "greedily over hazards and reports exactly where it dies (un-jumpable "
-        "spike spacing, walls, bad landings). Much stricter than "
-        "check_passability for cube sections. Works after your first draft.",
+        "Search every press/release timing through your ACCEPTED DRAFT with a "
+        "per-gamemode physics bot (cube, ship, ball, ufo, wave, robot, spider, "
+        "swing). Returns either a witness route to the end or the first X no "
+        "timing survives and why (un-jumpable spike spacing, walls, tunnels "
+        "too tight). Works after your first draft.",
         {},
         {}
     ));
@@ -1008,8 +1053,12 @@ struct ParsedResponse {
 };
 
 // Which providers we route through the tool-use loop. "custom" intentionally
-// excluded — we don't know what its tool-use API looks like.
-inline bool supportsToolUse(const std::string& provider) {
+// excluded — we don't know what its tool-use API looks like. A model whose
+// endpoint says it has no tool support stays on the single-shot path
+// instead of spending a round on the HTTP 400.
+inline bool supportsToolUse(const std::string& provider, const std::string& model = {}) {
+    if (!model.empty())
+        if (auto* c = probedCaps(provider, model); c && c->tools == 0) return false;
     return provider == "openai"     || provider == "ministral"  ||
            provider == "huggingface"|| provider == "openrouter" ||
            provider == "deepseek"   || provider == "lm-studio"  ||
@@ -1019,10 +1068,12 @@ inline bool supportsToolUse(const std::string& provider) {
            provider == "ollama";
 }
 
-// Vision: can this provider+model accept inline images? Claude and Gemini
-// always can; everywhere else, sniff the model name for known vision
-// families (conservative — a false negative just means text-only rounds).
+// Vision: can this provider+model accept inline images? A probed answer
+// wins; otherwise Claude and Gemini always can, and everywhere else we
+// sniff the model name for known vision families (conservative — a false
+// negative just means text-only rounds).
 inline bool supportsVision(const std::string& provider, const std::string& model) {
+    if (auto* c = probedCaps(provider, model); c && c->vision >= 0) return c->vision == 1;
     if (provider == "claude" || provider == "gemini") return true;
     auto has = [&](const char* s) {
         return model.find(s) != std::string::npos;
@@ -1053,15 +1104,22 @@ inline bool isOpenAICompat(const std::string& provider) {
 // itself among them — return HTTP 400 when BOTH max_tokens and
 // max_completion_tokens appear in one request, so every body must carry
 // exactly one. Single source of truth for the single-shot path (callAPI)
-// and the tool-use loop (buildOpenAICompatRequest).
+// and the tool-use loop (buildOpenAICompatRequest). With a probed model the
+// limit follows its real output cap, and never more than half its context
+// window — an 8K local model asked for 16K output just truncates the prompt.
 struct TokenLimitSpec { const char* field; int limit; };
-inline TokenLimitSpec tokenLimitSpec(const std::string& provider) {
+inline TokenLimitSpec tokenLimitSpec(const std::string& provider, const std::string& model = {}) {
+    TokenLimitSpec spec{"max_tokens", 8192};   // huggingface, deepseek, custom, ollama, ...
     if (provider == "openai" || provider == "lm-studio" || provider == "llama-cpp")
-        return {"max_completion_tokens", 16384};
-    if (provider == "ministral" || provider == "openrouter")
-        return {"max_tokens", 16384};
-    // huggingface, deepseek, custom, ollama (ignores it), anything else
-    return {"max_tokens", 8192};
+        spec = {"max_completion_tokens", 16384};
+    else if (provider == "ministral" || provider == "openrouter")
+        spec = {"max_tokens", 16384};
+    if (auto* c = model.empty() ? nullptr : probedCaps(provider, model)) {
+        if (c->maxOutput > 0) spec.limit = std::min(c->maxOutput, 32768);
+        if (c->context > 0)   spec.limit = std::min(spec.limit, c->context / 2);
+        spec.limit = std::max(spec.limit, 1024);
+    }
+    return spec;
 }
 
 // ── Per-provider request builders ──────────────────────────────────────────
@@ -1110,18 +1168,14 @@ inline std::string urlFor(const std::string& provider, const std::string& model)
         return base + "/v1/chat/completions";
     }
     if (provider == "ollama") {
-        bool platinum = geode::Mod::get()->getSettingValue<bool>("use-platinum");
-        // Mirror getOllamaUrl() in main.cpp. /api/chat supports tools where
+        // Same base as getOllamaUrl(). /api/chat supports tools where
         // /api/generate doesn't, so the tool-use loop hits the chat endpoint.
-        // Platinum uses a single unified API endpoint at :21800/api/* — the
-        // coordinator transparently routes /api/tags, /api/generate, and
-        // /api/chat through to a worker. (If /api/chat is not yet wired up
-        // on the coordinator, tool-use mode will return 404 on Platinum;
-        // basic /api/generate generation still works in that case.)
-        std::string base = platinum
-            ? std::string("http://sn-1.vltgg.net:21800")
-            : std::string("http://localhost:11434");
-        return base + "/api/chat";
+        // Platinum uses a single unified API endpoint per coordinator — it
+        // transparently routes /api/tags, /api/generate, and /api/chat
+        // through to a worker. (If /api/chat is not yet wired up on the
+        // coordinator, tool-use mode will return 404 on Platinum; basic
+        // /api/generate generation still works in that case.)
+        return getOllamaUrl() + "/api/chat";
     }
     if (provider == "claude")      return "https://api.anthropic.com/v1/messages";
     if (provider == "gemini") {
@@ -1237,13 +1291,15 @@ inline matjson::Value buildOpenAICompatRequest(const std::string& provider,
         // temperature/max_tokens — its knobs live in "options".
         auto options = matjson::Value::object();
         options["temperature"] = 0.7;
-        options["num_predict"] = tokenLimitSpec(provider).limit;
+        options["num_predict"] = tokenLimitSpec(provider, model).limit;
+        if (int ctx = ollamaNumCtx(model)) options["num_ctx"] = ctx;
         body["options"] = options;
+        if (auto ka = ollamaKeepAlive(); !ka.isNull()) body["keep_alive"] = ka;
     } else {
         // Exactly ONE token-limit field — sending both max_tokens and
         // max_completion_tokens makes strict servers (HuggingFace router,
         // OpenAI) reject the request with HTTP 400.
-        auto spec = tokenLimitSpec(provider);
+        auto spec = tokenLimitSpec(provider, model);
         body[spec.field] = spec.limit;
         // OpenAI o-series reasoning models reject a temperature param (400).
         if (!(provider == "openai" && isOSeriesModel(model)))
@@ -2534,7 +2590,8 @@ static std::pair<std::string, std::string> parseAPIError(const std::string& erro
                     code, errorMsg)
                 : fmtUserError(
                     "You're sending requests faster than the provider allows.",
-                    "Wait 20-30 seconds and try again, or raise \"rate-limit-seconds\" in settings.",
+                    "EditorAI already slowed down and retried when the provider asked it to. "
+                    "Try again in a minute, run fewer sessions at once, or switch providers.",
                     code, errorMsg);
 
         } else if (statusCode == 400) {
@@ -2737,7 +2794,6 @@ static std::string extractStyleId(std::string& prompt) {
 // range whose ORIGINAL objects get deleted when the replacement blueprint is
 // accepted. Parsed out of the prompt like extractStyleId.
 struct PendingRegionDelete { float x0 = 0, x1 = 0; bool active = false; };
-static PendingRegionDelete s_pendingRegionDelete;
 
 static bool extractRegionRange(std::string& prompt, float& outX0, float& outX1) {
     static const char* KEY = "region ";
@@ -2792,13 +2848,248 @@ static std::vector<int> parseExampleLevelIds() {
     return ids;
 }
 
+// ─── Platinum coordinators ───────────────────────────────────────────────────
+// Platinum (the free community Ollama network) used to be one hard-wired
+// coordinator; when it was saturated the user just sat in its queue. The
+// platinum-coordinators setting lists any number of them. Each is polled
+// (/api/status, every 5 s while a popup shows Platinum) for health, queue
+// depth and workers, with EWMA-smoothed round trips and generation times,
+// and every request goes to the node with the lowest expected completion:
+//     eta = rtt + (jobs ahead / workers + 1) * generation time
+// A request that dies at the transport level (timeout, refused, 502-504)
+// fails over to the next node; one still queued after QUEUE_PATIENCE while
+// another node has an idle worker is cancelled and re-sent there (see
+// AIGeneratorPopup::pollPlatinumStatus). Requests carry an X-Request-ID;
+// coordinators that list queued IDs in /api/status (queued_ids) let us see
+// our own request waiting, the rest only give counts (see migrateTarget). Pointing the setting at a few local
+// stand-in coordinators with different queue depths exercises all of it.
+namespace platinum {
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char* DEFAULT_COORDINATOR = "http://sn-1.vltgg.net:21800";
+static constexpr double EWMA_ALPHA     = 0.3;
+static constexpr double GEN_SEED_MS    = 45000.0;      // until a generation completes
+static constexpr auto   QUEUE_PATIENCE = std::chrono::seconds(20);
+static constexpr auto   DOWN_BACKOFF   = std::chrono::seconds(30);
+
+struct Node {
+    std::string url;
+    bool   polled  = false;                // answered (or failed) a status poll
+    bool   healthy = false;
+    bool   polling = false;
+    int    queued = 0, active = 0, workers = 0;
+    bool   listsIds = false;                // status carries queued_ids
+    std::vector<std::string> queuedIds;
+    double rttMs = 0.0, genMs = GEN_SEED_MS;
+    Clock::time_point downUntil{}, pollSent{};
+    async::TaskHolder<web::WebResponse> poll;
+};
+// unique_ptr: poll callbacks hold the Node*; a rebuilt list destroys the
+// holders (cancelling them) together with the nodes.
+static std::vector<std::unique_ptr<Node>> s_nodes;
+static std::string                        s_spec;
+
+// The configured list (comma/space separated), rebuilt when the setting
+// changes. Never call from a poll callback — a rebuild would free it.
+static std::vector<std::unique_ptr<Node>>& nodes() {
+    auto spec = Mod::get()->getSettingValue<std::string>("platinum-coordinators");
+    if (spec == s_spec && !s_nodes.empty()) return s_nodes;
+    s_spec = spec;
+    s_nodes.clear();
+    size_t i = 0;
+    while (i < spec.size()) {
+        size_t e = spec.find_first_of(", \t\n", i);
+        if (e == std::string::npos) e = spec.size();
+        std::string url = spec.substr(i, e - i);
+        i = e + 1;
+        while (!url.empty() && url.back() == '/') url.pop_back();
+        if (url.empty()) continue;
+        bool dup = false;
+        for (auto& n : s_nodes) dup |= n->url == url;
+        if (dup) continue;
+        s_nodes.push_back(std::make_unique<Node>());
+        s_nodes.back()->url = url;
+    }
+    if (s_nodes.empty()) {
+        s_nodes.push_back(std::make_unique<Node>());
+        s_nodes.back()->url = DEFAULT_COORDINATOR;
+    }
+    return s_nodes;
+}
+
+static Node* find(const std::string& url) {
+    for (auto& n : nodes())
+        if (n->url == url) return n.get();
+    return nullptr;
+}
+
+static double ewma(double prev, double sample) {
+    return prev <= 0.0 ? sample : prev + EWMA_ALPHA * (sample - prev);
+}
+
+static bool usable(const Node& n) {
+    return Clock::now() >= n.downUntil && (!n.polled || n.healthy);
+}
+
+// Generation times a request sent now waits out on `n`: the jobs ahead of
+// it spread over the workers, plus its own.
+static double factor(const Node& n) {
+    if (!n.polled) return 2.0;                           // unknown: assume a short queue
+    if (n.workers <= 0) return INFINITY;
+    double ahead = n.queued + (n.active >= n.workers ? 1.0 : 0.0);
+    return ahead / n.workers + 1.0;
+}
+
+// Expected ms until a request sent now completes on `n`.
+static double eta(const Node& n) {
+    if (!usable(n)) return INFINITY;
+    return n.rttMs + factor(n) * n.genMs;
+}
+
+// factor() for `url` at send time — the caller divides the observed wall
+// time by it, so queueing doesn't inflate the generation-time estimate.
+static double queueFactor(const std::string& url) {
+    Node* n = find(url);
+    double f = n && n->polled ? factor(*n) : 1.0;
+    return std::isfinite(f) ? f : 1.0;
+}
+
+// Best node not in `exclude` ("" once every node is excluded). With no
+// information at all this is the first configured node.
+static std::string pick(const std::vector<std::string>& exclude = {}) {
+    Node*  best    = nullptr;
+    double bestEta = INFINITY;
+    for (auto& n : nodes()) {
+        if (std::find(exclude.begin(), exclude.end(), n->url) != exclude.end()) continue;
+        double e = eta(*n);
+        if (!best || e < bestEta) { best = n.get(); bestEta = e; }
+    }
+    return best ? best->url : "";
+}
+
+// Poll every node's /api/status (skips nodes whose poll is still out).
+static void refresh() {
+    for (auto& up : nodes()) {
+        Node* n = up.get();
+        if (n->polling) continue;
+        n->polling  = true;
+        n->pollSent = Clock::now();
+        auto request = web::WebRequest();
+        request.timeout(std::chrono::seconds(4));
+        n->poll.spawn(request.get(n->url + "/api/status"), [n](web::WebResponse resp) {
+            n->polling = false;
+            n->polled  = true;
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - n->pollSent).count();
+            auto markDown = [n] {
+                n->healthy   = false;
+                n->downUntil = Clock::now() + DOWN_BACKOFF;
+            };
+            if (!resp.ok()) { markDown(); return; }
+            auto json = resp.json();
+            if (!json) { markDown(); return; }
+            const auto j = json.unwrap();
+            if (!j.contains("coordinator")) { markDown(); return; }
+            const auto& coord = j["coordinator"];
+            n->queued  = (int)coord["queued_requests"].asInt().unwrapOr(0);
+            n->active  = (int)coord["active_workers"].asInt().unwrapOr(0);
+            n->workers = (int)coord["workers"].asInt().unwrapOr(0);
+            n->queuedIds.clear();
+            n->listsIds = coord.contains("queued_ids") && coord["queued_ids"].isArray();
+            if (n->listsIds)
+                for (auto& id : coord["queued_ids"])
+                    if (auto s = id.asString()) n->queuedIds.push_back(s.unwrap());
+            n->rttMs   = ewma(n->rttMs, ms);
+            n->healthy = true;
+        });
+    }
+}
+
+// Outcome of a generation sent to `url`: successes feed the generation-time
+// EWMA, transport failures take the node out of rotation for a while.
+static void observe(const std::string& url, bool ok, bool transportFail, double ms) {
+    Node* n = find(url);
+    if (!n) return;
+    if (ok) n->genMs = ewma(n->genMs, ms);
+    if (transportFail) {
+        n->healthy   = false;
+        n->downUntil = Clock::now() + DOWN_BACKOFF;
+    }
+}
+
+// Per-send request id (X-Request-ID), what queued_ids lists.
+static std::string newRequestId() {
+    static std::mt19937_64 gen{((uint64_t)std::random_device{}() << 32) | std::random_device{}()};
+    return fmt::format("eai-{:016x}", gen());
+}
+
+// Mid-queue failover: request `requestId` `waited` on `current` and is
+// still queued there, while an untried node has an idle worker — move
+// there. "Still queued" is the coordinator listing our id when it lists
+// ids at all; otherwise a queue count is only ours if every worker is busy
+// and not one byte of our response has arrived yet.
+static std::string migrateTarget(const std::string& current,
+                                 const std::vector<std::string>& tried,
+                                 Clock::duration waited,
+                                 const std::string& requestId, size_t bytesReceived) {
+    if (waited < QUEUE_PATIENCE) return "";
+    Node* cur = find(current);
+    if (!cur || !cur->polled) return "";
+    if (cur->listsIds) {
+        if (std::find(cur->queuedIds.begin(), cur->queuedIds.end(), requestId) ==
+            cur->queuedIds.end())
+            return "";                                 // not (or no longer) waiting
+    } else if (cur->queued <= 0 || cur->active < cur->workers || bytesReceived > 0) {
+        return "";                                     // can't be sure we're the one queued
+    }
+    for (auto& n : nodes()) {
+        if (n->url == current || !usable(*n) || !n->polled) continue;
+        if (std::find(tried.begin(), tried.end(), n->url) != tried.end()) continue;
+        if (n->queued == 0 && n->active < n->workers) return n->url;
+    }
+    return "";
+}
+
+// Queue widget text aggregated over the nodes; empty until one answered.
+static std::string statusText() {
+    int polled = 0, online = 0, q = 0, a = 0, w = 0;
+    for (auto& n : nodes()) {
+        if (!n->polled) continue;
+        ++polled;
+        if (!n->healthy) continue;
+        ++online;
+        q += n->queued; a += n->active; w += n->workers;
+    }
+    if (polled == 0) return "";
+    std::string where = nodes().size() > 1
+        ? fmt::format(", {}/{} nodes", online, nodes().size()) : std::string();
+    if (w <= 0)
+        return "Platinum: no workers online" + where;
+    if (q <= 0)
+        return fmt::format("Platinum: idle ({} worker{}{})", w, w == 1 ? "" : "s", where);
+    return fmt::format("Platinum: {} queued, {}/{} busy{}", q, a, w, where);
+}
+
+} // namespace platinum
+
 static std::string getOllamaUrl() {
     bool usePlatinum = Mod::get()->getSettingValue<bool>("use-platinum");
     return usePlatinum
-        ? "http://sn-1.vltgg.net:21800"
+        ? platinum::pick()
         : "http://localhost:11434";
 }
 
+// Strips leading/trailing ASCII whitespace (spaces, tabs, newlines, carriage
+// returns). API keys are frequently copy-pasted with invisible trailing
+// characters that cause 401/403 responses even when the key is valid.
+static std::string trimKey(std::string s) {
+    const std::string ws = " \t\r\n";
+    size_t start = s.find_first_not_of(ws);
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(ws);
+    return s.substr(start, end - start + 1);
+}
+
 // Apply the per-provider authentication header(s) to a WebRequest. One source
 // of truth for the single-shot path, the tool loop, AND the settings popup's
 // key validator.
@@ -2930,6 +3221,527 @@ static std::pair<float, std::string> describeLengthByX(float maxX) {
     return {secs, std::string(cat)};
 }
 
+// ── Object property schema ────────────────────────────────────────────────
+//
+// One declarative row per JSON object field. Five consumers used to keep
+// their own hand-written lists and drifted apart (offset-cam exported dx=
+// but parsed x=; rotate's center= and static-cam's exit never survived an
+// export; toggle's bare `on` was swallowed as a positional). They now all
+// derive from this table:
+//   eas::applyCommonFields / triggerObj / TRIGGER    EAS keywords → JSON
+//   eas::objectsToEAS                                JSON → EAS keywords
+//   the tokenizer's bare-flag set                    Bool keywords
+//   macros::applyMacroPassthroughs                   Obj/Copy keys
+//   AIGeneratorPopup::applyObjectProperties          JSON → GameObject
+//
+// Keywords: the first is what the serializer writes; on parse the first one
+// present on the line wins. Rows apply to GameObjects in table order, so a
+// row that must land after another (flips after scale, spawn_triggered after
+// touch_triggered) simply sits below it.
+namespace props {
+
+enum class Type : uint8_t { Int, Float, Bool, IntList, Hex };
+
+enum Scope : uint8_t {
+    Obj    = 1 << 0,  // any OBJ/macro line; copied by macro passthroughs
+    Trig   = 1 << 1,  // TRIGGER lines of the kinds in `ids` (every kind if empty)
+    Copy   = 1 << 2,  // JSON-only key that macro passthroughs still copy
+    Fx     = 1 << 3,  // setter needs an EffectGameObject (advanced features)
+    Always = 1 << 4,  // Bool parsed as a value, false included
+    Range  = 1 << 5,  // out-of-range values are dropped, not clamped
+};
+
+struct Target {
+    GameObject*       obj;
+    EffectGameObject* fx;      // null unless advanced features + effect object
+    LevelEditorLayer* editor;
+    bool              adv;
+};
+
+struct Prop;
+using Setter = void (*)(const Target&, const matjson::Value&, const Prop&);
+
+struct Prop {
+    const char*      key;
+    const char*      words;    // EAS keywords, space separated ("" = JSON only)
+    Type             type;
+    float            lo, hi;   // clamp range for the setter
+    float            dflt;     // parse fallback; Obj Float rows skip it on export
+    uint8_t          scope;
+    std::vector<int> ids;      // object IDs the row applies to (empty = any)
+    Setter           set;      // null: parsed / copied / exported only
+    int              gd = 0;   // level-string key (levelstr::write); 0 = none
+    std::vector<std::string_view> kw;  // `words` split once by schema()
+};
+
+// ── Setters ──
+// Values reaching a setter already passed accepts() for the row's type.
+template <auto M>
+void objInt(const Target& t, const matjson::Value& v, const Prop& p) {
+    using T = std::remove_cvref_t<decltype(t.obj->*M)>;
+    t.obj->*M = static_cast<T>(std::clamp((int)v.asInt().unwrapOr(0), (int)p.lo, (int)p.hi));
+}
+template <auto M>
+void objSet(const Target& t, const matjson::Value& v, const Prop&) {
+    if (v.asBool().unwrapOr(false)) t.obj->*M = true;
+}
+template <auto M>
+void fxInt(const Target& t, const matjson::Value& v, const Prop& p) {
+    using T = std::remove_cvref_t<decltype(t.fx->*M)>;
+    t.fx->*M = static_cast<T>(std::clamp((int)v.asInt().unwrapOr(0), (int)p.lo, (int)p.hi));
+}
+template <auto M>
+void fxFloat(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.fx->*M = std::clamp((float)v.asDouble().unwrapOr(0.0), p.lo, p.hi);
+}
+template <auto M>
+void fxBool(const Target& t, const matjson::Value& v, const Prop&) {
+    t.fx->*M = v.asBool().unwrapOr(false);
+}
+template <auto M>
+void fxSet(const Target& t, const matjson::Value& v, const Prop&) {
+    if (v.asBool().unwrapOr(false)) t.fx->*M = true;
+}
+
+inline void setRotation(const Target& t, const matjson::Value& v, const Prop& p) {
+    float r = (float)v.asDouble().unwrapOr(0.0);
+    if (r >= p.lo && r <= p.hi) t.obj->setRotation(r);
+}
+inline void setScale(const Target& t, const matjson::Value& v, const Prop& p) {
+    float s = (float)v.asDouble().unwrapOr(1.0);
+    if (s >= p.lo && s <= p.hi) t.obj->setScale(s);
+}
+inline void setFlipX(const Target& t, const matjson::Value& v, const Prop&) {
+    if (v.asBool().unwrapOr(false)) t.obj->setScaleX(-t.obj->getScaleX());
+}
+inline void setFlipY(const Target& t, const matjson::Value& v, const Prop&) {
+    if (v.asBool().unwrapOr(false)) t.obj->setScaleY(-t.obj->getScaleY());
+}
+// ZLayer uses GD's odd-number scheme: B5=-5, B4=-3, B3=-1, B2=1, B1=3,
+// Default=0, T1=5..T4=11. Snap anything else (the AI loves z_layer=2) to the
+// nearest real member. setCustomZLayer also re-parents the sprite to the
+// right batch node — assigning m_zLayer alone renders in the old layer.
+inline int snapZLayer(int zl) {
+    static constexpr int kValidZLayers[] = {-5, -3, -1, 0, 1, 3, 5, 7, 9, 11};
+    int best = 0, bestDist = 99;
+    for (int z : kValidZLayers) {
+        int d = std::abs(zl - z);
+        if (d < bestDist) { bestDist = d; best = z; }
+    }
+    return best;
+}
+inline void setZLayer(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.obj->setCustomZLayer(snapZLayer(std::clamp((int)v.asInt().unwrapOr(0), (int)p.lo, (int)p.hi)));
+}
+inline void setGroups(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (!t.adv) return;
+    int assigned = 0;
+    for (size_t gi = 0; gi < v.size() && assigned < 10; ++gi) {
+        int groupID = (int)v[gi].asInt().unwrapOr(0);
+        if (groupID < (int)p.lo || groupID > (int)p.hi) continue;
+        if (t.obj->addToGroup(groupID) == 1 && t.editor) {
+            t.editor->addToGroup(t.obj, groupID, false);
+            ++assigned;
+        }
+    }
+}
+inline void setBaseColor(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (t.obj->m_baseColor)
+        t.obj->m_baseColor->m_colorID = std::clamp((int)v.asInt().unwrapOr(1), (int)p.lo, (int)p.hi);
+}
+inline void setDetailColor(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (t.obj->m_detailColor)
+        t.obj->m_detailColor->m_colorID = std::clamp((int)v.asInt().unwrapOr(1), (int)p.lo, (int)p.hi);
+}
+// Hex string (JSON origin) or [r,g,b] (the EAS parser stores hexToRGBArray).
+inline void setTargetColor(const Target& t, const matjson::Value& v, const Prop&) {
+    GLubyte r = 255, g = 255, b = 255;
+    if (auto hex = v.asString()) {
+        if (!parseHexColor(hex.unwrap(), r, g, b)) return;
+    } else {
+        auto rr = v[0].asInt(), gg = v[1].asInt(), bb = v[2].asInt();
+        r = (GLubyte)std::clamp(rr ? (int)rr.unwrap() : 255, 0, 255);
+        g = (GLubyte)std::clamp(gg ? (int)gg.unwrap() : 255, 0, 255);
+        b = (GLubyte)std::clamp(bb ? (int)bb.unwrap() : 255, 0, 255);
+    }
+    t.fx->m_triggerTargetColor = {r, g, b};
+}
+// Pulse targets EITHER a group or a color channel — the last one applied
+// decides m_pulseTargetType.
+inline void setPulseGroup(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.fx->m_targetGroupID = std::clamp((int)v.asInt().unwrapOr(1), (int)p.lo, (int)p.hi);
+    t.fx->m_pulseTargetType = 1;
+}
+inline void setPulseChannel(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.fx->m_targetColor = std::clamp((int)v.asInt().unwrapOr(1), (int)p.lo, (int)p.hi);
+    t.fx->m_pulseTargetType = 0;
+}
+// Move and camera-offset triggers share the offset pair; each axis lands
+// on its own so a lone move_y keeps x at the object's default.
+inline void setMoveX(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.fx->m_moveOffset.x = std::clamp((float)v.asDouble().unwrapOr(0.0), p.lo, p.hi);
+}
+inline void setMoveY(const Target& t, const matjson::Value& v, const Prop& p) {
+    t.fx->m_moveOffset.y = std::clamp((float)v.asDouble().unwrapOr(0.0), p.lo, p.hi);
+}
+inline void setDegrees(const Target& t, const matjson::Value& v, const Prop&) {
+    t.fx->m_rotationDegrees = (float)v.asDouble().unwrapOr(0.0);
+}
+inline void setScaleTo(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* xform = typeinfo_cast<TransformTriggerGameObject*>(t.obj)) {
+        float s = std::clamp((float)v.asDouble().unwrapOr(1.0), p.lo, p.hi);
+        xform->m_objectScaleX = s;
+        xform->m_objectScaleY = s;
+    }
+}
+inline void setCamExit(const Target& t, const matjson::Value& v, const Prop&) {
+    if (auto* cam = typeinfo_cast<CameraTriggerGameObject*>(t.obj))
+        if (v.asBool().unwrapOr(false)) cam->m_exitStatic = true;
+}
+inline void setSoundID(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* sfx = typeinfo_cast<SFXTriggerGameObject*>(t.obj))
+        sfx->m_soundID = std::max((int)p.lo, (int)v.asInt().unwrapOr(0));
+}
+inline void setVolume(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* sfx = typeinfo_cast<SFXTriggerGameObject*>(t.obj))
+        sfx->m_volume = std::clamp((float)v.asDouble().unwrapOr(1.0), p.lo, p.hi);
+}
+inline void setPitch(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* sfx = typeinfo_cast<SFXTriggerGameObject*>(t.obj))
+        sfx->m_pitch = std::clamp((float)v.asDouble().unwrapOr(0.0), p.lo, p.hi);
+}
+inline void setSongChannel(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* song = typeinfo_cast<SongTriggerGameObject*>(t.obj))
+        song->m_songChannel = std::clamp((int)v.asInt().unwrapOr(0), (int)p.lo, (int)p.hi);
+}
+inline void setPickupCount(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* count = typeinfo_cast<CountTriggerGameObject*>(t.obj))
+        count->m_pickupCount = std::clamp((int)v.asInt().unwrapOr(1), (int)p.lo, (int)p.hi);
+}
+inline void setTeleportOffset(const Target& t, const matjson::Value& v, const Prop& p) {
+    if (auto* tp = typeinfo_cast<TeleportPortalObject*>(t.obj))
+        tp->m_teleportYOffset = std::clamp((float)v.asDouble().unwrapOr(0.0), p.lo, p.hi);
+}
+inline void setSpawnTriggered(const Target& t, const matjson::Value& v, const Prop&) {
+    if (!v.asBool().unwrapOr(false)) return;
+    t.fx->m_isSpawnTriggered = true;
+    t.fx->m_isTouchTriggered = false;
+}
+
+// ── Table ──
+// Trigger IDs that share a row: `target_group` with a plain clamp, and the
+// duration ranges (cameras/gravity/etc. cap at 30 s, follow triggers at 600).
+inline const std::vector<int> kTargetIDs = {
+    901, 1007, 1346, 1049, 1268, 1616, 2067, 1914, 1347, 1814,
+    1595, 1611, 1811, 1817, 1812, 1585, 3022,
+};
+inline const std::vector<int> kDuration30IDs = {
+    899, 901, 1007, 1346, 2067, 1520, 1913, 1914, 1916, 2066,
+};
+
+inline const std::vector<Prop>& schema() {
+    static const std::vector<Prop> rows = [] {
+        constexpr float kBig = 1e9f;
+        std::vector<Prop> r = {
+            // ── Any object ──
+            {"rotation", "rot rotation", Type::Float, -360, 360, 0, Obj | Range, {}, setRotation, 6},
+            {"scale", "scale", Type::Float, 0.1f, 10, 1, Obj | Range, {}, setScale, 32},
+            {"flip_x", "flip_x", Type::Bool, 0, 1, 0, Obj, {}, setFlipX, 4},
+            {"flip_y", "flip_y", Type::Bool, 0, 1, 0, Obj, {}, setFlipY, 5},
+            {"z_layer", "z_layer", Type::Int, -5, 11, 0, Obj, {}, setZLayer, 24},
+            {"z_order", "z_order", Type::Int, -999, 999, 0, Obj, {}, objInt<&GameObject::m_zOrder>, 25},
+            {"editor_layer", "editor_layer", Type::Int, 0, 999, 0, Obj, {}, objInt<&GameObject::m_editorLayer>, 20},
+            {"editor_layer_2", "editor_layer_2", Type::Int, 0, 999, 0, Obj, {}, objInt<&GameObject::m_editorLayer2>, 61},
+            {"groups", "groups", Type::IntList, 1, 9999, 0, Obj, {}, setGroups, 57},
+            {"color_channel", "color color_channel", Type::Int, 1, 1010, 1, Obj, {}, setBaseColor, 21},
+            {"detail_color_channel", "detail detail_color", Type::Int, 1, 1010, 1, Obj, {}, setDetailColor, 22},
+            // 2.2 editor flags, set-only. passable = player phases through a
+            // solid block; no_touch = hazard loses its hitbox.
+            {"passable", "passable", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isPassable>, 134},
+            {"no_touch", "no_touch notouch", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isNoTouch>, 121},
+            {"hide", "hide", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isHide>, 135},
+            {"no_glow", "no_glow noglow", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_hasNoGlow>, 96},
+            {"dont_fade", "dont_fade nofade", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isDontFade>, 64},
+            {"dont_enter", "dont_enter dontenter", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isDontEnter>, 67},
+            {"high_detail", "high_detail highdetail", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_isHighDetail>, 103},
+            {"no_effects", "no_effects noeffects", Type::Bool, 0, 1, 0, Obj, {}, objSet<&GameObject::m_hasNoEffects>, 116},
+            {"multi_activate", "multi_activate multi", Type::Bool, 0, 1, 0, Obj | Trig | Fx, {},
+             fxSet<&EffectGameObject::m_isMultiTriggered>, 87},
+            {"main_color", "", Type::Int, 0, 0, 0, Copy, {}, nullptr},
+            {"detail_color", "", Type::Int, 0, 0, 0, Copy, {}, nullptr},
+            {"copy_color_channel", "", Type::Int, 0, 0, 0, Copy, {}, nullptr},
+            {"copy_color_hsv", "", Type::Int, 0, 0, 0, Copy, {}, nullptr},
+            // Linked teleport portal: not advFeatures-gated, portals are plain
+            // gameplay objects. Set by the teleport macro, never typed in EAS.
+            {"teleport_y_offset", "", Type::Float, -450, 450, 0, 0, {747}, setTeleportOffset},
+
+            // ── Trigger fields ──
+            {"color_channel", "ch channel", Type::Int, 1, 1010, 1, Trig | Fx, {899},
+             fxInt<&EffectGameObject::m_targetColor>, 23},
+            {"color", "hex", Type::Hex, 0, 0, 0, Trig | Fx, {899, 1006}, setTargetColor, 7},
+            {"target_group", "target groups", Type::Int, 1, 9999, 1, Trig | Fx, kTargetIDs,
+             fxInt<&EffectGameObject::m_targetGroupID>, 51},
+            {"target_group", "target groups", Type::Int, 1, 9999, 1, Trig | Fx, {1006}, setPulseGroup, 51},
+            {"target_color_channel", "ch channel", Type::Int, 1, 1010, 1, Trig | Fx, {1006}, setPulseChannel, 23},
+            {"duration", "duration", Type::Float, 0, 30, 0.5f, Trig | Fx, kDuration30IDs,
+             fxFloat<&EffectGameObject::m_duration>, 10},
+            {"duration", "duration", Type::Float, 0, 600, 10, Trig | Fx, {1347, 1814},
+             fxFloat<&EffectGameObject::m_duration>, 10},
+            // Pulse timing is fade_in/hold/fade_out; duration only round-trips.
+            {"duration", "duration", Type::Float, 0, 30, 0.5f, Trig, {1006}, nullptr},
+            {"opacity", "opacity to", Type::Float, 0, 1, 1, Trig | Fx, {899, 1007},
+             fxFloat<&EffectGameObject::m_opacity>, 35},
+            {"blending", "blend blending", Type::Bool, 0, 1, 0, Trig | Fx, {899},
+             fxBool<&EffectGameObject::m_usesBlending>, 17},
+            {"move_x", "dx move_x", Type::Float, -32767, 32767, 0, Trig | Fx, {901}, setMoveX, 28},
+            {"move_y", "dy move_y", Type::Float, -32767, 32767, 0, Trig | Fx, {901}, setMoveY, 29},
+            {"move_x", "x dx move_x", Type::Float, -2000, 2000, 0, Trig | Fx, {1916}, setMoveX, 28},
+            {"move_y", "y dy move_y", Type::Float, -2000, 2000, 0, Trig | Fx, {1916}, setMoveY, 29},
+            {"lock_to_player_x", "lock_to_player_x", Type::Bool, 0, 1, 0, Trig | Fx, {901},
+             fxSet<&EffectGameObject::m_lockToPlayerX>, 58},
+            {"lock_to_player_y", "lock_to_player_y", Type::Bool, 0, 1, 0, Trig | Fx, {901},
+             fxSet<&EffectGameObject::m_lockToPlayerY>, 59},
+            {"activate_group", "on activate", Type::Bool, 0, 1, 0, Trig | Fx | Always, {1049},
+             fxBool<&EffectGameObject::m_activateGroup>, 56},
+            {"fade_in", "fade_in", Type::Float, 0, 10, 0, Trig | Fx, {1006},
+             fxFloat<&EffectGameObject::m_fadeInDuration>, 45},
+            {"hold", "hold", Type::Float, 0, 10, 0, Trig | Fx, {1006},
+             fxFloat<&EffectGameObject::m_holdDuration>, 46},
+            {"fade_out", "fade_out", Type::Float, 0, 10, 0, Trig | Fx, {1006},
+             fxFloat<&EffectGameObject::m_fadeOutDuration>, 47},
+            {"exclusive", "exclusive", Type::Bool, 0, 1, 0, Trig | Fx, {1006},
+             fxBool<&EffectGameObject::m_pulseExclusive>, 86},
+            {"center_group", "center", Type::Int, 1, 9999, 1, Trig | Fx, {1346},
+             fxInt<&EffectGameObject::m_centerGroupID>, 71},
+            {"degrees", "degrees", Type::Float, -kBig, kBig, 360, Trig | Fx, {1346}, setDegrees, 68},
+            {"lock_object_rotation", "lock_rotation lock_object_rotation", Type::Bool, 0, 1, 0,
+             Trig | Fx, {1346}, fxSet<&EffectGameObject::m_lockObjectRotation>, 70},
+            {"delay", "delay", Type::Float, 0, 30, 0, Trig | Fx, {1268},
+             fxFloat<&EffectGameObject::m_spawnTriggerDelay>, 63},
+            {"editor_disable", "editor_disable", Type::Bool, 0, 1, 0, Trig | Fx, {1268},
+             fxBool<&EffectGameObject::m_previewDisable>},
+            {"scale", "to", Type::Float, 0.05f, 10, 1, Trig | Fx, {2067}, setScaleTo, 150},
+            // Scale trigger's Y factor: the same value again, write-only.
+            {"scale", "", Type::Float, 0.05f, 10, 1, Trig | Fx, {2067}, nullptr, 151},
+            {"strength", "strength", Type::Float, 0, 20, 1, Trig | Fx, {1520},
+             fxFloat<&EffectGameObject::m_shakeStrength>, 75},
+            {"interval", "interval", Type::Float, 0, 5, 0, Trig | Fx, {1520},
+             fxFloat<&EffectGameObject::m_shakeInterval>, 84},
+            {"zoom", "zoom", Type::Float, 0.25f, 4, 1, Trig | Fx, {1913},
+             fxFloat<&EffectGameObject::m_zoomValue>, 371},
+            {"exit", "exit", Type::Bool, 0, 1, 0, Trig | Fx, {1914}, setCamExit},
+            {"mod", "mod", Type::Float, 0.1f, 3, 1, Trig | Fx, {1935},
+             fxFloat<&EffectGameObject::m_timeWarpTimeMod>, 120},
+            {"sound_id", "sound_id", Type::Int, 0, kBig, 0, Trig | Fx, {1934, 3602}, setSoundID},
+            {"channel", "channel", Type::Int, 0, 4, 0, Trig | Fx, {1934}, setSongChannel},
+            {"volume", "volume", Type::Float, 0, 2, 1, Trig | Fx, {1934, 3602}, setVolume},
+            {"pitch", "pitch", Type::Float, -12, 12, 0, Trig | Fx, {1934, 3602}, setPitch},
+            {"follow_group", "follow", Type::Int, 1, 9999, 1, Trig | Fx, {1347},
+             fxInt<&EffectGameObject::m_centerGroupID>, 71},
+            {"x_mod", "x_mod", Type::Float, -10, 10, 1, Trig | Fx, {1347},
+             fxFloat<&EffectGameObject::m_followXMod>, 72},
+            {"y_mod", "y_mod", Type::Float, -10, 10, 1, Trig | Fx, {1347},
+             fxFloat<&EffectGameObject::m_followYMod>, 73},
+            {"speed", "speed", Type::Float, 0, 100, 1, Trig | Fx, {1814},
+             fxFloat<&EffectGameObject::m_followYSpeed>, 90},
+            {"delay", "delay", Type::Float, 0, 10, 0, Trig | Fx, {1814},
+             fxFloat<&EffectGameObject::m_followYDelay>, 91},
+            {"offset", "offset", Type::Int, -500, 500, 0, Trig | Fx, {1814},
+             fxInt<&EffectGameObject::m_followYOffset>, 92},
+            {"max_speed", "max_speed", Type::Float, 0, 100, 0, Trig | Fx, {1814},
+             fxFloat<&EffectGameObject::m_followYMaxSpeed>, 105},
+            {"activate", "activate", Type::Bool, 0, 1, 0, Trig | Fx, {1595, 1611, 1811, 1817, 1812},
+             fxBool<&EffectGameObject::m_activateGroup>, 56},
+            {"hold", "hold", Type::Bool, 0, 1, 0, Trig | Fx, {1595},
+             fxBool<&EffectGameObject::m_touchHoldMode>, 81},
+            {"item_id", "item_id", Type::Int, 1, 9999, 1, Trig | Fx, {1611, 1811, 1817},
+             fxInt<&EffectGameObject::m_itemID>, 80},
+            {"count", "count", Type::Int, -9999, 9999, 1, Trig | Fx, {1611, 1811, 1817}, setPickupCount, 77},
+            {"animation_id", "anim animation_id", Type::Int, 0, 50, 0, Trig | Fx, {1585},
+             fxInt<&EffectGameObject::m_animationID>, 76},
+            {"gravity", "g gravity", Type::Float, 0, 10, 1, Trig | Fx, {2066},
+             fxFloat<&EffectGameObject::m_gravityValue>, 148},
+
+            // ── Any trigger ──
+            // Easing parses on every kind but only move/alpha/rotate apply it.
+            {"easing", "easing", Type::Int, 0, 18, 0, Trig, {}, nullptr},
+            {"easing_rate", "easing_rate", Type::Float, 0.01f, 100, 2, Trig, {}, nullptr},
+            {"easing", "", Type::Int, 0, 18, 0, Fx, {901, 1007, 1346},
+             fxInt<&EffectGameObject::m_easingType>, 30},
+            {"easing_rate", "", Type::Float, 0.01f, 100, 2, Fx, {901, 1007, 1346},
+             fxFloat<&EffectGameObject::m_easingRate>, 85},
+            // The trigger's OWN group membership (spawn-chain targets) —
+            // `groups=` on TRIGGER lines means the target instead. Applied by
+            // the Obj `groups` row.
+            {"groups", "own_groups", Type::IntList, 1, 9999, 0, Trig, {}, nullptr},
+            // Activation mode runs last: default is position-triggered (the
+            // trigger fires when the screen reaches its X — a touch trigger at
+            // y=0 can never fire). spawn_triggered overrides touch.
+            {"touch_triggered", "touch", Type::Bool, 0, 1, 0, Trig | Fx, {},
+             fxBool<&EffectGameObject::m_isTouchTriggered>, 11},
+            {"spawn_triggered", "spawn_triggered", Type::Bool, 0, 1, 0, Trig | Fx, {}, setSpawnTriggered, 62},
+        };
+        for (auto& p : r) {
+            std::string_view w = p.words;
+            while (!w.empty()) {
+                size_t sp = w.find(' ');
+                p.kw.push_back(w.substr(0, sp));
+                if (sp == std::string_view::npos) break;
+                w.remove_prefix(sp + 1);
+            }
+        }
+        return r;
+    }();
+    return rows;
+}
+
+// Whether a row with object-ID list `ids` applies to `id`. id < 0 selects
+// the rows without an ID list (fields every object / every trigger takes).
+inline bool forId(const Prop& p, int id) {
+    if (id < 0) return p.ids.empty();
+    return std::find(p.ids.begin(), p.ids.end(), id) != p.ids.end();
+}
+
+// Shape check before a setter runs — a model writing `"scale": "big"`
+// must fall through exactly like the old per-field asDouble() probes.
+inline bool accepts(Type type, const matjson::Value& v) {
+    switch (type) {
+        case Type::Int:     return v.asInt().isOk();
+        case Type::Float:   return v.asDouble().isOk();
+        case Type::Bool:    return v.asBool().isOk();
+        case Type::IntList: return v.isArray();
+        case Type::Hex:     return v.isString() || (v.isArray() && v.size() >= 3);
+    }
+    return false;
+}
+
+// JSON key → indices of the rows with a setter, for the spawn loop.
+inline const std::unordered_map<std::string_view, std::vector<uint16_t>>& appliers() {
+    static const auto index = [] {
+        std::unordered_map<std::string_view, std::vector<uint16_t>> m;
+        const auto& rows = schema();
+        for (size_t i = 0; i < rows.size(); ++i)
+            if (rows[i].set) m[rows[i].key].push_back((uint16_t)i);
+        return m;
+    }();
+    return index;
+}
+
+// Keys macro expanders copy from their params onto every emitted object.
+inline const std::vector<std::string_view>& passthroughKeys() {
+    static const auto keys = [] {
+        std::vector<std::string_view> out;
+        for (auto& p : schema())
+            if ((p.scope & (Obj | Copy)) &&
+                std::find(out.begin(), out.end(), p.key) == out.end())
+                out.push_back(p.key);
+        return out;
+    }();
+    return keys;
+}
+
+// Bool keywords the EAS tokenizer promotes from bare words to kv "true".
+inline const std::unordered_set<std::string_view>& bareFlags() {
+    static const auto flags = [] {
+        std::unordered_set<std::string_view> out = {"player_color"};  // COLOR verb
+        for (auto& p : schema())
+            if (p.type == Type::Bool && (p.scope & (Obj | Trig)))
+                out.insert(p.kw.begin(), p.kw.end());
+        return out;
+    }();
+    return flags;
+}
+
+// ── Trigger kinds ──
+struct TriggerKind {
+    const char* names;   // EAS kind + accepted spellings; first is written
+    const char* type;    // JSON type the TRIGGER line creates
+    const char* legacy;  // older JSON type that exports as this kind ("" none)
+    int         id;      // object ID selecting the kind's field rows (0: none)
+};
+
+inline const std::vector<TriggerKind>& triggerKinds() {
+    static const std::vector<TriggerKind> kinds = {
+        {"color", "effect_color_trigger", "color_trigger", 899},
+        {"alpha", "effect_alpha_trigger", "alpha_trigger", 1007},
+        {"move", "effect_move_trigger", "move_trigger", 901},
+        {"toggle", "effect_toggle_trigger", "toggle_trigger", 1049},
+        {"pulse", "effect_pulse_trigger", "pulse_trigger", 1006},
+        {"rotate", "effect_rotate_trigger", "rotate_trigger", 1346},
+        {"spawn", "effect_spawn_trigger", "spawn_trigger", 1268},
+        {"stop", "effect_stop_trigger", "stop_trigger", 1616},
+        {"end", "effect_10_level_end_trigger", "end_trigger", 0},
+        {"scale", "effect_scale_trigger", "", 2067},
+        {"shake", "effect_shake_trigger", "", 1520},
+        {"zoom", "effect_zoom_camera_trigger", "", 1913},
+        {"static-cam static_cam camera-static", "effect_static_camera_trigger", "", 1914},
+        {"offset-cam offset_cam camera-offset", "effect_offset_camera_trigger", "", 1916},
+        {"timewarp", "effect_timewarp_trigger", "", 1935},
+        {"song", "effect_song_trigger", "", 1934},
+        {"sfx", "effect_sfx_trigger", "", 3602},
+        {"follow", "effect_follow_trigger", "", 1347},
+        {"follow-y follow_y follow-player-y", "effect_follow_player_y_trigger", "", 1814},
+        {"touch", "effect_touch_trigger", "", 1595},
+        {"count", "effect_count_trigger", "", 1611},
+        {"instant-count instant_count", "effect_instant_count_trigger", "", 1811},
+        {"pickup", "effect_pickup_trigger", "", 1817},
+        {"on-death on_death", "effect_on_death_trigger", "", 1812},
+        {"animate", "effect_animate_trigger", "", 1585},
+        {"gravity", "effect_gravity_trigger", "", 2066},
+        {"teleport", "effect_teleport_trigger", "", 3022},
+        {"reverse", "effect_reverse_trigger", "", 0},
+        {"bg-on bg_on", "effect_background_effect_on_trigger", "", 0},
+        {"bg-off bg_off", "effect_background_effect_off_trigger", "", 0},
+        {"no-enter-fx no_enter_fx", "effect_no_enter_effect_trigger", "", 0},
+        {"show-player show_player", "show_player_trigger", "", 0},
+        {"hide-player hide_player", "hide_player_trigger", "", 0},
+        {"show-trail show_trail", "show_trail_trigger", "", 0},
+        {"hide-trail hide_trail", "hide_trail_trigger", "", 0},
+    };
+    return kinds;
+}
+
+// First space-separated word of a names list — the spelling exports use.
+inline std::string_view primaryName(const char* names) {
+    std::string_view n = names;
+    return n.substr(0, n.find(' '));
+}
+
+// EAS kind spelling → kind (null for an unknown kind).
+inline const TriggerKind* kindByName(std::string_view name) {
+    static const auto index = [] {
+        std::unordered_map<std::string_view, const TriggerKind*> m;
+        for (auto& k : triggerKinds()) {
+            std::string_view n = k.names;
+            while (!n.empty()) {
+                size_t sp = n.find(' ');
+                m.emplace(n.substr(0, sp), &k);
+                if (sp == std::string_view::npos) break;
+                n.remove_prefix(sp + 1);
+            }
+        }
+        return m;
+    }();
+    auto it = index.find(name);
+    return it == index.end() ? nullptr : it->second;
+}
+
+// JSON trigger type (current or legacy name) → kind.
+inline const TriggerKind* kindByType(std::string_view type) {
+    static const auto index = [] {
+        std::unordered_map<std::string_view, const TriggerKind*> m;
+        for (auto& k : triggerKinds()) {
+            m.emplace(k.type, &k);
+            if (*k.legacy) m.emplace(k.legacy, &k);
+        }
+        return m;
+    }();
+    auto it = index.find(type);
+    return it == index.end() ? nullptr : it->second;
+}
+
+} // namespace props
+
 // ── EditorAI Script (EAS) parser ──────────────────────────────────────────
 //
 // EAS is a line-based DSL that replaces JSON for AI output. Each line is one
@@ -2992,17 +3804,19 @@ inline std::string trim(std::string s) {
     return s;
 }
 
-inline std::string lower(std::string s) {
+inline std::string lower(std::string_view v) {
+    std::string s(v);
     for (auto& c : s) c = (char)std::tolower((unsigned char)c);
     return s;
 }
 
-// Safe stof-equivalent — returns `dflt` on bad input, no exceptions (the
-// Geode index rejects exception use outright). Mirrors std::stof's
-// parse-the-leading-prefix behaviour ("30," → 30) so messy AI tokens still
-// land: a single garbage token must not kill the whole EAS line, and
-// `SPIKE basic 105 180` and friends must not vanish on some models.
-inline float tryFloat(const std::string& s, float dflt) {
+// Leading-number scanners behind tryFloat/tryInt (and the tokenizer's
+// pre-parsed kv numbers). Mirror std::stof/stoi's parse-the-leading-prefix
+// behaviour ("30," → 30) so messy AI tokens still land: a single garbage
+// token must not kill the whole EAS line, and `SPIKE basic 105 180` and
+// friends must not vanish on some models. No exceptions (the Geode index
+// rejects exception use outright).
+inline bool scanFloat(std::string_view s, float& out) {
     size_t i = 0, n = s.size();
     while (i < n && (s[i] == ' ' || s[i] == '\t')) ++i;
     // numFromString (from_chars) rejects a leading '+' that stof accepted —
@@ -3024,32 +3838,43 @@ inline float tryFloat(const std::string& s, float dflt) {
         while (k < n && std::isdigit((unsigned char)s[k])) ++k;
         if (k > j) i = k;
     }
-    if (!digits) return dflt;
-    auto res = geode::utils::numFromString<float>(
-        std::string_view(s).substr(start, i - start));
-    return res ? res.unwrap() : dflt;
+    if (!digits) return false;
+    auto res = geode::utils::numFromString<float>(s.substr(start, i - start));
+    if (!res) return false;
+    out = res.unwrap();
+    return true;
 }
 
-// Safe stoi-equivalent with the same leading-prefix semantics as tryFloat.
-inline int tryInt(const std::string& s, int dflt) {
+inline bool scanInt(std::string_view s, int& out) {
     size_t i = 0, n = s.size();
     while (i < n && (s[i] == ' ' || s[i] == '\t')) ++i;
-    // Skip a leading '+' — numFromString rejects it (see tryFloat).
+    // Skip a leading '+' — numFromString rejects it (see scanFloat).
     if (i < n && s[i] == '+') ++i;
     size_t start = i;
     if (i < n && s[i] == '-') ++i;
     size_t d = i;
     while (i < n && std::isdigit((unsigned char)s[i])) ++i;
-    if (i == d) return dflt;
-    auto res = geode::utils::numFromString<int>(
-        std::string_view(s).substr(start, i - start));
-    return res ? res.unwrap() : dflt;
+    if (i == d) return false;
+    auto res = geode::utils::numFromString<int>(s.substr(start, i - start));
+    if (!res) return false;
+    out = res.unwrap();
+    return true;
+}
+
+// Safe stof/stoi-equivalents — return `dflt` on bad input.
+inline float tryFloat(std::string_view s, float dflt) {
+    float v;
+    return scanFloat(s, v) ? v : dflt;
+}
+inline int tryInt(std::string_view s, int dflt) {
+    int v;
+    return scanInt(s, v) ? v : dflt;
 }
 
 // True iff `s` parses cleanly as a leading number. Lets us probe a positional
 // token: if it's numeric, treat it as x/y; if not, it's a variant/color/kind
 // keyword. Mirrors the try/catch dance the SAW handler did inline.
-inline bool isNumericTok(const std::string& s) {
+inline bool isNumericTok(std::string_view s) {
     if (s.empty()) return false;
     size_t i = 0;
     if (s[i] == '+' || s[i] == '-') ++i;
@@ -3081,38 +3906,115 @@ inline std::string strAlias(const L& ln, std::initializer_list<const char*> keys
     return dflt;
 }
 
-// Tokenize one line into a verb + a map of key=value args + a list of positional
-// args (the part between verb and first key=value). Quoted strings are unescaped.
+// Per-parse bump arena for the few bytes a token can't view in place in the
+// source buffer: lower-cased verbs/keys that had capitals, and unescaped
+// quoted values. Blocks never move, so every view handed out stays valid
+// until the arena (i.e. the parse) ends.
+class Arena {
+    static constexpr size_t BLOCK = 8192;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char*  m_cur  = nullptr;
+    size_t m_left = 0;
+public:
+    char* alloc(size_t n) {
+        if (n > BLOCK / 4) {   // oversized: own block, current one stays open
+            m_blocks.emplace_back(new char[n]);
+            return m_blocks.back().get();
+        }
+        if (n > m_left) {
+            m_blocks.emplace_back(new char[BLOCK]);
+            m_cur  = m_blocks.back().get();
+            m_left = BLOCK;
+        }
+        char* p = m_cur;
+        m_cur  += n;
+        m_left -= n;
+        return p;
+    }
+    // View of `s` lower-cased; no copy when it already is.
+    std::string_view lowered(std::string_view s) {
+        bool upper = false;
+        for (char c : s) if (c >= 'A' && c <= 'Z') { upper = true; break; }
+        if (!upper) return s;
+        char* p = alloc(s.size());
+        for (size_t i = 0; i < s.size(); ++i)
+            p[i] = (char)std::tolower((unsigned char)s[i]);
+        return {p, s.size()};
+    }
+};
+
+// One tokenized line: a verb + key=value args + positional args (the part
+// between verb and first key=value). Every field is a view into the source
+// script or the parse's Arena — nothing is owned — and numeric values are
+// parsed once at tokenize time instead of on every fnum/inum access. The
+// parser reuses ONE Line across all lines, so after warm-up the pos/kv
+// vectors stop allocating entirely.
 struct Line {
-    std::string verb;                              // first whitespace-separated token
-    std::vector<std::string> pos;                  // positional args (before key=value pairs)
-    std::unordered_map<std::string, std::string> kv;
-    bool flag(const std::string& k) const {
-        auto it = kv.find(k);
-        return it != kv.end() && (it->second.empty() || it->second == "true" || it->second == "1");
+    struct KV {
+        std::string_view key, val;
+        float f   = 0.f;
+        int   i   = 0;
+        bool  fOk = false, iOk = false;
+    };
+    // Flat key table: lines carry a handful of keys, so a linear scan over
+    // contiguous entries beats hashing. Duplicate keys: last write wins
+    // (the old unordered_map's operator[] semantics).
+    struct KvTable {
+        std::vector<KV> items;
+        const KV* find(std::string_view k) const {
+            for (auto& e : items) if (e.key == k) return &e;
+            return nullptr;
+        }
+        size_t count(std::string_view k) const { return find(k) ? 1 : 0; }
+        void set(std::string_view k, std::string_view v) {
+            KV* e = nullptr;
+            for (auto& it : items) if (it.key == k) { e = &it; break; }
+            if (!e) { items.emplace_back(); e = &items.back(); e->key = k; }
+            e->val = v;
+            e->fOk = scanFloat(v, e->f);
+            e->iOk = scanInt(v, e->i);
+        }
+        void   clear()       { items.clear(); }
+        size_t size()  const { return items.size(); }
+    };
+
+    std::string_view              verb;   // first token, lower-cased
+    std::vector<std::string_view> pos;
+    KvTable                       kv;
+
+    bool flag(std::string_view k) const {
+        auto e = kv.find(k);
+        return e && (e->val.empty() || e->val == "true" || e->val == "1");
     }
-    std::string str(const std::string& k, const std::string& dflt = "") const {
-        auto it = kv.find(k);
-        return it == kv.end() ? dflt : it->second;
+    std::string str(std::string_view k, std::string_view dflt = {}) const {
+        auto e = kv.find(k);
+        return std::string(e ? e->val : dflt);
     }
-    float fnum(const std::string& k, float dflt) const {
-        auto it = kv.find(k);
-        return it == kv.end() ? dflt : tryFloat(it->second, dflt);
+    float fnum(std::string_view k, float dflt) const {
+        auto e = kv.find(k);
+        return e && e->fOk ? e->f : dflt;
     }
-    int inum(const std::string& k, int dflt) const {
-        auto it = kv.find(k);
-        return it == kv.end() ? dflt : tryInt(it->second, dflt);
+    int inum(std::string_view k, int dflt) const {
+        auto e = kv.find(k);
+        return e && e->iOk ? e->i : dflt;
     }
 };
 
-inline Line tokenize(const std::string& raw) {
-    Line out;
-    std::string s = trim(raw);
-    if (s.empty() || s[0] == '#' || (s.size() >= 2 && s[0] == '/' && s[1] == '/')) return out;
+// Tokenize one line into `out` (cleared first). Quoted values are
+// unescaped; comment/blank lines leave out.verb empty.
+inline void tokenize(std::string_view s, Line& out, Arena& arena) {
+    out.verb = {};
+    out.pos.clear();
+    out.kv.clear();
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+        s.remove_suffix(1);
+    if (s.empty() || s[0] == '#' || (s.size() >= 2 && s[0] == '/' && s[1] == '/')) return;
     // First token is the verb.
     size_t i = 0;
     while (i < s.size() && s[i] != ' ' && s[i] != '\t') ++i;
-    out.verb = lower(s.substr(0, i));
+    out.verb = arena.lowered(s.substr(0, i));
     while (i < s.size() && (s[i] == ' ' || s[i] == '\t')) ++i;
 
     // Parse remaining tokens. A token is either:
@@ -3124,10 +4026,10 @@ inline Line tokenize(const std::string& raw) {
         if (i >= s.size()) break;
         // Read until whitespace or '='.
         size_t start = i;
-        size_t eq = std::string::npos;
+        size_t eq = std::string_view::npos;
         // Find the equals or end of the bare token (no spaces inside it)
         while (i < s.size() && s[i] != ' ' && s[i] != '\t') {
-            if (s[i] == '=' && eq == std::string::npos) { eq = i; }
+            if (s[i] == '=' && eq == std::string_view::npos) { eq = i; }
             if (s[i] == '"') {
                 // Quoted segment: scan to matching close quote
                 size_t qend = i + 1;
@@ -3141,50 +4043,56 @@ inline Line tokenize(const std::string& raw) {
             }
             ++i;
         }
-        std::string tok = s.substr(start, i - start);
-        if (eq == std::string::npos) {
+        std::string_view tok = s.substr(start, std::min(i, s.size()) - start);
+        if (eq == std::string_view::npos) {
             // Bare token: either a positional (variant/x/y) OR a known flag
             // word. The system prompt teaches bare flags (`SPIKE 600 notouch`,
             // `BLOCK 900 105 passable`, `COLOR ... blend`, `TRIGGER ... multi_activate`),
             // but flag()/applyCommonFields/triggerObj only read kv — so a bare
             // flag would otherwise fall into `pos`, where positional consumers
             // silently eat it (and the flag never applies). Promote a recognized
-            // flag word into kv as "true"; non-flag bare tokens (variants like
-            // `small`/`ship`/`yellow`) stay positional as before.
-            static const std::unordered_set<std::string> kBareFlags = {
-                "passable", "notouch", "no_touch", "hide", "noglow", "no_glow",
-                "nofade", "dont_fade", "dontenter", "dont_enter", "highdetail",
-                "high_detail", "noeffects", "no_effects", "blend", "blending",
-                "multi_activate", "multi", "touch", "spawn_triggered",
-                "flip_x", "flip_y", "player_color", "exclusive", "lock_rotation",
-                "lock_object_rotation", "lock_to_player_x", "lock_to_player_y",
-                "activate", "hold", "editor_disable", "exit",
-            };
-            std::string lo = lower(tok);
-            if (kBareFlags.count(lo)) out.kv[lo] = "true";
-            else                      out.pos.push_back(tok);
+            // flag word (every Bool keyword in the props schema) into kv as
+            // "true"; non-flag bare tokens (variants like `small`/`ship`/
+            // `yellow`) stay positional as before. The set's own entries
+            // become the kv keys (interned — no per-line copy). A TRIGGER
+            // line's kind word is never a flag: `TRIGGER touch` names the
+            // touch trigger, not touch_triggered.
+            static const auto& kBareFlags = props::bareFlags();
+            // Flags are short — lower into a stack buffer for the lookup.
+            char buf[32];
+            auto it = kBareFlags.end();
+            bool kindWord = out.verb == "trigger" && out.pos.empty();
+            if (!kindWord && tok.size() < sizeof(buf)) {
+                for (size_t j = 0; j < tok.size(); ++j)
+                    buf[j] = (char)std::tolower((unsigned char)tok[j]);
+                it = kBareFlags.find(std::string_view(buf, tok.size()));
+            }
+            if (it != kBareFlags.end()) out.kv.set(*it, "true");
+            else                        out.pos.push_back(tok);
         } else {
             size_t rel = eq - start;
-            std::string k = lower(tok.substr(0, rel));
-            std::string v = tok.substr(rel + 1);
-            // Unwrap quotes + un-escape
+            std::string_view k = arena.lowered(tok.substr(0, rel));
+            std::string_view v = tok.substr(rel + 1);
+            // Unwrap quotes + un-escape (only escaped values touch the arena).
             if (v.size() >= 2 && v.front() == '"' && v.back() == '"') {
                 v = v.substr(1, v.size() - 2);
-                std::string unesc; unesc.reserve(v.size());
-                for (size_t j = 0; j < v.size(); ++j) {
-                    if (v[j] == '\\' && j + 1 < v.size()) { unesc.push_back(v[j+1]); ++j; }
-                    else                                   unesc.push_back(v[j]);
+                if (v.find('\\') != std::string_view::npos) {
+                    char* p = arena.alloc(v.size());
+                    size_t n = 0;
+                    for (size_t j = 0; j < v.size(); ++j) {
+                        if (v[j] == '\\' && j + 1 < v.size()) { p[n++] = v[j+1]; ++j; }
+                        else                                   p[n++] = v[j];
+                    }
+                    v = std::string_view(p, n);
                 }
-                v = unesc;
             }
-            out.kv[k] = v;
+            out.kv.set(k, v);
         }
     }
-    return out;
 }
 
 // Parse "x0..x1" range. Returns (x0, x1, ok).
-inline std::tuple<float, float, bool> parseRange(const std::string& s) {
+inline std::tuple<float, float, bool> parseRange(std::string_view s) {
     auto dd = s.find("..");
     if (dd == std::string::npos) return {0, 0, false};
     float a = tryFloat(s.substr(0, dd), NAN);
@@ -3323,6 +4231,33 @@ inline matjson::Value parseIntList(const std::string& s) {
     return arr;
 }
 
+// Schema-driven keyword parse: every row in `scope` that applies to object
+// `id` (see props::forId) and has one of its keywords on the line. Bool rows
+// are flags; the rest take the first of their keywords present.
+inline void parseProps(matjson::Value& obj, const Line& ln, uint8_t scope, int id) {
+    for (auto& p : props::schema()) {
+        if (!(p.scope & scope) || p.kw.empty() || !props::forId(p, id)) continue;
+        if (p.type == props::Type::Bool) {
+            bool on = false;
+            for (auto w : p.kw) on = on || ln.flag(w);
+            if (on)                            obj[p.key] = true;
+            else if (p.scope & props::Always)  obj[p.key] = false;
+            continue;
+        }
+        for (auto w : p.kw) {
+            if (!ln.kv.count(w)) continue;
+            switch (p.type) {
+                case props::Type::Int:     obj[p.key] = (double)ln.inum(w, (int)p.dflt); break;
+                case props::Type::Float:   obj[p.key] = (double)ln.fnum(w, p.dflt);      break;
+                case props::Type::IntList: obj[p.key] = parseIntList(ln.str(w));          break;
+                case props::Type::Hex:     obj[p.key] = hexToRGBArray(ln.str(w));         break;
+                case props::Type::Bool:    break;
+            }
+            break;
+        }
+    }
+}
+
 // Apply the fields every kind of object can carry: groups, color channels,
 // rotation, scale, multi_activate, etc. Called from every object emitter so
 // the AI can attach these to spikes, blocks, orbs, portals, triggers — all
@@ -3335,44 +4270,10 @@ inline matjson::Value parseIntList(const std::string& s) {
 // receiving side; this function does the emitting side for both object lines
 // AND macro lines (the field names are intentionally identical).
 //
-// Per-axis aliases:
-//   color | color_channel  → color_channel
-//   detail | detail_color  → detail_color_channel
-//   rot | rotation         → rotation
-//   multi | multi_activate → multi_activate
+// Keyword aliases (color|color_channel, rot|rotation, multi|multi_activate,
+// ...) come from the props schema, like everything else this reads.
 inline void applyCommonFields(matjson::Value& obj, const Line& ln) {
-    if (ln.kv.count("groups"))        obj["groups"]               = parseIntList(ln.str("groups"));
-    if (ln.kv.count("color"))         obj["color_channel"]        = (double)ln.inum("color", 1);
-    if (ln.kv.count("color_channel")) obj["color_channel"]        = (double)ln.inum("color_channel", 1);
-    if (ln.kv.count("detail"))        obj["detail_color_channel"] = (double)ln.inum("detail", 1);
-    if (ln.kv.count("detail_color"))  obj["detail_color_channel"] = (double)ln.inum("detail_color", 1);
-    if (ln.kv.count("scale"))         obj["scale"]    = (double)ln.fnum("scale", 1.f);
-    if (ln.kv.count("rot"))           obj["rotation"] = (double)ln.fnum("rot", 0.f);
-    if (ln.kv.count("rotation"))      obj["rotation"] = (double)ln.fnum("rotation", 0.f);
-    if (ln.kv.count("flip_x") && ln.flag("flip_x"))   obj["flip_x"] = true;
-    if (ln.kv.count("flip_y") && ln.flag("flip_y"))   obj["flip_y"] = true;
-    if (ln.flag("multi_activate"))    obj["multi_activate"] = true;
-    if (ln.flag("multi"))             obj["multi_activate"] = true;
-    // 2.2 editor flags (any object): solid-looking decoration, hitbox-less
-    // hazards, hidden helper geometry, glow control.
-    if (ln.flag("passable"))          obj["passable"]    = true;
-    if (ln.flag("notouch") || ln.flag("no_touch"))
-                                      obj["no_touch"]    = true;
-    if (ln.flag("hide"))              obj["hide"]        = true;
-    if (ln.flag("noglow") || ln.flag("no_glow"))
-                                      obj["no_glow"]     = true;
-    if (ln.flag("nofade") || ln.flag("dont_fade"))
-                                      obj["dont_fade"]   = true;
-    if (ln.flag("dontenter") || ln.flag("dont_enter"))
-                                      obj["dont_enter"]  = true;
-    if (ln.flag("highdetail") || ln.flag("high_detail"))
-                                      obj["high_detail"] = true;
-    if (ln.flag("noeffects") || ln.flag("no_effects"))
-                                      obj["no_effects"]  = true;
-    if (ln.kv.count("z_layer"))       obj["z_layer"]       = (double)ln.inum("z_layer", 0);
-    if (ln.kv.count("z_order"))       obj["z_order"]       = (double)ln.inum("z_order", 0);
-    if (ln.kv.count("editor_layer"))  obj["editor_layer"]  = (double)ln.inum("editor_layer", 0);
-    if (ln.kv.count("editor_layer_2"))obj["editor_layer_2"]= (double)ln.inum("editor_layer_2", 0);
+    parseProps(obj, ln, props::Obj, -1);
 }
 
 // ── Trigger emitter (always position-triggered, never touch-triggered) ─────
@@ -3382,26 +4283,363 @@ inline void applyCommonFields(matjson::Value& obj, const Line& ln) {
 // Touch-trigger mode is OFF by default; only emitted if EAS author writes
 // touch=true explicitly.
 //
-// Common trigger fields supported across variants:
+// Fields every trigger kind takes (the schema's Trig rows without IDs):
 //   touch=true            — touch-triggered (rare; default off)
 //   multi_activate=true   — fire every pass, not just first
 //   easing=N              — 0-18 easing curve (see GD enum)
 //   easing_rate=F         — curve sharpness
+//   own_groups=a,b        — the trigger's own groups (groups= is the target)
+// Kind-specific fields are added by the TRIGGER dispatcher from the kind's
+// object ID.
 inline matjson::Value triggerObj(const std::string& type, float x, float y,
                                  const Line& ln) {
     auto t = makeObj(type, x, y);
-    if (ln.flag("touch"))           t["touch_triggered"] = true;
-    if (ln.flag("spawn_triggered")) t["spawn_triggered"] = true;
-    if (ln.flag("multi_activate") || ln.flag("multi"))
-                                    t["multi_activate"] = true;
-    if (ln.kv.count("easing"))      t["easing"]      = (double)ln.inum("easing", 0);
-    if (ln.kv.count("easing_rate")) t["easing_rate"] = (double)ln.fnum("easing_rate", 2.f);
-    // own_groups: the trigger's OWN group membership (so spawn chains can
-    // point at it) — `groups=` on trigger lines means the TARGET instead.
-    if (ln.kv.count("own_groups"))  t["groups"] = parseIntList(ln.str("own_groups"));
+    parseProps(t, ln, props::Trig, -1);
     return t;
 }
 
+// ── Compact dialect (relative coordinates) ─────────────────────────────────
+// Opt-in shorthand a model can use to spend fewer output tokens on the same
+// level. It is lowered to plain absolute EAS BEFORE parsing (and before
+// parseParallel chunks the script — the cursor and WITH stack are stateful),
+// so every verb handler stays untouched and the result is exactly what the
+// equivalent long-hand script would produce:
+//
+//   @+30 / @-15 / @900   x relative to the cursor (or absolute with no sign);
+//                        the cursor moves to the first @ x on each line.
+//                        Ranges: @+0..+600 (a side without a sign is absolute).
+//                        Also valid as the value of x-ish keys (at=@+60).
+//   AT 1200 / AT +300    set / shift the cursor; emits nothing.
+//   r2 / l1              y tiers off the ground: rN = ground+30N (rows),
+//                        lN = ground+90N (lanes). Positional or y-ish keys.
+//   WITH color=4 ... {   sticky fields, added to every object line inside the
+//   }                    block that doesn't set them itself. Blocks nest.
+//   SPIKE @+90 *4        repeat the line; relative tokens re-resolve each time.
+//   REPEAT 3 [every=300] { ... }   repeat a block (every= re-bases the
+//                        cursor per pass instead of letting it run on).
+static constexpr int    COMPACT_MAX_REPEAT = 500;
+static constexpr size_t COMPACT_MAX_LINES  = 50000;
+
+// Calls fn(line) on each trimmed, non-blank line the parser reads (comment
+// lines skipped) until it returns true.
+template <class F>
+inline bool anyCodeLine(std::string_view text, F&& fn) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t' || line.front() == '\r'))
+            line.remove_prefix(1);
+        while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r'))
+            line.remove_suffix(1);
+        if (line.empty() || line[0] == '#' || line.starts_with("//")) continue;
+        if (fn(line)) return true;
+    }
+    return false;
+}
+
+// A cursor token or block opener outside quoted values.
+inline bool hasCompactAnchor(std::string_view line) {
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (!quoted && (c == '@' || c == '{')) return true;
+    }
+    return false;
+}
+
+// Line shape of the block/cursor verbs: AT takes one (signed) number,
+// WITH and REPEAT open a block. Prose that merely starts with "At",
+// "With" or "Repeat" fails it.
+inline bool compactVerbLine(std::string_view line) {
+    size_t e = 0;
+    while (e < line.size() && std::isalpha((unsigned char)line[e])) ++e;
+    auto w = lower(line.substr(0, e));
+    std::string_view rest = line.substr(e);
+    while (!rest.empty() && (rest.front() == ' ' || rest.front() == '\t')) rest.remove_prefix(1);
+    if (w == "at") {
+        if (!rest.empty() && (rest.front() == '+' || rest.front() == '-')) rest.remove_prefix(1);
+        return !rest.empty() && std::all_of(rest.begin(), rest.end(), [](char c) {
+            return std::isdigit((unsigned char)c) || c == '.';
+        });
+    }
+    if (w == "with" || w == "repeat") return !rest.empty() && rest.back() == '{';
+    return false;
+}
+
+// Cheap scan for dialect markers — scripts without any skip lowering.
+// Comment lines and quoted values don't count.
+inline bool usesCompactDialect(std::string_view text) {
+    return anyCodeLine(text, [](std::string_view line) {
+        if (compactVerbLine(line)) return true;
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (c == '"') { quoted = !quoted; continue; }
+            if (quoted) continue;
+            if (c == '@' || c == '{' || c == '}') return true;
+            bool tokStart = i == 0 || line[i - 1] == ' ' || line[i - 1] == '\t' ||
+                            line[i - 1] == '=';
+            if (!tokStart || i + 1 >= line.size()) continue;
+            char n = line[i + 1];
+            if (c == '*' && std::isdigit((unsigned char)n)) return true;
+            if ((c == 'r' || c == 'l') && (std::isdigit((unsigned char)n) || n == '-')) return true;
+        }
+        return false;
+    });
+}
+
+// Shortest exact text for a lowered coordinate (no "1.23e+06" surprises).
+inline std::string fmtCoord(float v) {
+    if (std::fabs(v - std::round(v)) < 0.001f) return fmt::format("{}", (long long)std::lround(v));
+    std::string s = fmt::format("{:.2f}", v);
+    while (s.back() == '0') s.pop_back();
+    if (s.back() == '.') s.pop_back();
+    return s;
+}
+
+class CompactLowering {
+    float m_groundY;
+    float m_cursor = 0.f;
+    std::vector<std::vector<std::string>> m_with;   // sticky key=value tokens
+    std::vector<std::string_view>         m_lines;
+    std::string m_out;
+    size_t      m_emitted = 0;
+
+    // Whitespace split that keeps "quoted values" whole (tokenize's rule).
+    static std::vector<std::string_view> split(std::string_view s) {
+        std::vector<std::string_view> toks;
+        size_t i = 0;
+        while (i < s.size()) {
+            while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r')) ++i;
+            if (i >= s.size()) break;
+            size_t start = i;
+            while (i < s.size() && s[i] != ' ' && s[i] != '\t' && s[i] != '\r') {
+                if (s[i] == '"') {
+                    ++i;
+                    while (i < s.size() && s[i] != '"') i += (s[i] == '\\' && i + 1 < s.size()) ? 2 : 1;
+                }
+                if (i < s.size()) ++i;
+            }
+            toks.push_back(s.substr(start, std::min(i, s.size()) - start));
+        }
+        return toks;
+    }
+
+    static bool isXKey(std::string_view k) {
+        static const std::unordered_set<std::string_view> keys = {
+            "x", "at", "x_start", "x_end", "start", "end", "from", "to", "x0", "x1",
+        };
+        return keys.count(k) > 0;
+    }
+    static bool isYKey(std::string_view k) {
+        static const std::unordered_set<std::string_view> keys = {
+            "y", "y_bot", "y_top", "y_start", "y_end", "floor", "ceiling",
+            "bottom", "top", "y0", "y1",
+        };
+        return keys.count(k) > 0;
+    }
+
+    // rN / lN → ground-relative y; false if `t` isn't a tier token.
+    bool tier(std::string_view t, std::string& out) const {
+        if (t.size() < 2 || (t[0] != 'r' && t[0] != 'l' && t[0] != 'R' && t[0] != 'L')) return false;
+        if (!isNumericTok(t.substr(1)) || t[1] == '+') return false;
+        float step = (t[0] == 'r' || t[0] == 'R') ? 30.f : 90.f;
+        out = fmtCoord(m_groundY + step * tryFloat(t.substr(1), 0.f));
+        return true;
+    }
+
+    // One side of an @ expression: signed → relative to `base`, else absolute.
+    static float side(std::string_view t, float base) {
+        if (t.empty()) return base;
+        float v = tryFloat(t, 0.f);
+        return (t[0] == '+' || t[0] == '-') ? base + v : v;
+    }
+
+    // "@" / "@+30" / "@+0..+600" → absolute text; `first` gets the leading x.
+    static std::string resolveAt(std::string_view t, float base, float& first) {
+        t.remove_prefix(1);
+        auto dots = t.find("..");
+        if (dots == std::string_view::npos) {
+            first = side(t, base);
+            return fmtCoord(first);
+        }
+        first = side(t.substr(0, dots), base);
+        float hi = side(t.substr(dots + 2), base);
+        return fmtCoord(first) + ".." + fmtCoord(hi);
+    }
+
+    void emit(std::string_view line) {
+        if (m_emitted >= COMPACT_MAX_LINES) return;
+        if (++m_emitted == COMPACT_MAX_LINES)
+            geode::log::warn("EAS compact: output capped at {} lines", COMPACT_MAX_LINES);
+        m_out.append(line);
+        m_out.push_back('\n');
+    }
+
+    // One object/command line, with its repeat count already split off.
+    void lowerLine(const std::vector<std::string_view>& toks, std::string_view verb) {
+        static const std::unordered_set<std::string_view> kNoSticky = {
+            "meta", "color", "section", "move", "delete", "edit", "copy",
+            "mirror", "trigger",
+        };
+        float base = m_cursor;
+        bool moved = false;
+        std::unordered_set<std::string> keys;
+        std::string line(toks[0]);
+        auto rewrite = [&](std::string_view t) -> std::string {
+            std::string lowered;
+            auto eq = t.find('=');
+            if (eq == std::string_view::npos) {
+                float first = 0.f;
+                if (!t.empty() && t[0] == '@') {
+                    auto s = resolveAt(t, base, first);
+                    if (!moved) { m_cursor = first; moved = true; }
+                    return s;
+                }
+                if (tier(t, lowered)) return lowered;
+                return std::string(t);
+            }
+            std::string key = lower(t.substr(0, eq));
+            std::string_view val = t.substr(eq + 1);
+            keys.insert(key);
+            if (isXKey(key) && !val.empty() && val[0] == '@') {
+                float first = 0.f;
+                auto s = resolveAt(val, base, first);
+                if (!moved) { m_cursor = first; moved = true; }
+                return key + "=" + s;
+            }
+            if (isYKey(key) && tier(val, lowered)) return key + "=" + lowered;
+            return std::string(t);
+        };
+        for (size_t i = 1; i < toks.size(); ++i) {
+            line.push_back(' ');
+            line += rewrite(toks[i]);
+        }
+        if (!kNoSticky.count(verb)) {
+            // Innermost block first, so a nested WITH overrides its parent.
+            for (auto it = m_with.rbegin(); it != m_with.rend(); ++it) {
+                auto& frame = *it;
+                for (auto& kv : frame) {
+                    std::string key = lower(std::string_view(kv).substr(0, kv.find('=')));
+                    if (keys.count(key)) continue;
+                    line.push_back(' ');
+                    line += rewrite(kv);
+                }
+            }
+        }
+        emit(line);
+    }
+
+    // Index of the "}" closing a block whose body starts at `from`, or
+    // m_lines.size() when it runs to the end of the script.
+    size_t blockEnd(size_t from) const {
+        int depth = 1;
+        for (size_t j = from; j < m_lines.size(); ++j) {
+            std::string_view l = m_lines[j];
+            while (!l.empty() && (l.back() == ' ' || l.back() == '\t' || l.back() == '\r')) l.remove_suffix(1);
+            while (!l.empty() && (l.front() == ' ' || l.front() == '\t')) l.remove_prefix(1);
+            if (l == "}" || l == "END" || l == "end") { if (--depth == 0) return j; }
+            else if (!l.empty() && l.back() == '{') ++depth;
+        }
+        return m_lines.size();
+    }
+
+    // Block header: drops a trailing "{" token (or consumes a lone "{" on the
+    // next line) and returns the index the body starts at.
+    size_t openBlock(std::vector<std::string_view>& toks, size_t i) const {
+        if (!toks.empty() && toks.back() == "{") { toks.pop_back(); return i + 1; }
+        if (!toks.empty() && toks.back().size() > 1 && toks.back().back() == '{')
+            toks.back().remove_suffix(1);
+        if (i + 1 < m_lines.size()) {
+            auto next = split(m_lines[i + 1]);
+            if (next.size() == 1 && next[0] == "{") return i + 2;
+        }
+        return i + 1;
+    }
+
+    void run(size_t begin, size_t end) {
+        for (size_t i = begin; i < end && m_emitted < COMPACT_MAX_LINES; ++i) {
+            std::string_view raw = m_lines[i];
+            auto toks = split(raw);
+            if (toks.empty()) continue;
+            if (toks[0][0] == '#' || toks[0].starts_with("//")) { emit(raw); continue; }
+            std::string verb = lower(toks[0]);
+            if (verb == "}" || verb == "{" || verb == "end") continue;   // stray closer
+
+            if (verb == "at") {
+                if (toks.size() > 1) m_cursor = side(toks[1], m_cursor);
+                continue;
+            }
+            if (verb == "with" || verb == "repeat") {
+                size_t body  = openBlock(toks, i);
+                size_t close = blockEnd(body);
+                if (verb == "with") {
+                    std::vector<std::string> frame;
+                    for (size_t k = 1; k < toks.size(); ++k)
+                        if (toks[k].find('=') != std::string_view::npos) frame.emplace_back(toks[k]);
+                    m_with.push_back(std::move(frame));
+                    run(body, close);
+                    m_with.pop_back();
+                } else {
+                    int n = toks.size() > 1 ? std::clamp(tryInt(toks[1], 1), 1, COMPACT_MAX_REPEAT) : 1;
+                    bool hasEvery = false;
+                    float every = 0.f;
+                    for (size_t k = 2; k < toks.size(); ++k) {
+                        if (toks[k].starts_with("every=")) {
+                            hasEvery = true;
+                            every = tryFloat(toks[k].substr(6), 0.f);
+                        }
+                    }
+                    float start = m_cursor;
+                    for (int r = 0; r < n && m_emitted < COMPACT_MAX_LINES; ++r) {
+                        if (hasEvery) m_cursor = start + every * r;
+                        run(body, close);
+                    }
+                }
+                i = close;
+                continue;
+            }
+
+            // Trailing "*N" repeats the line.
+            int count = 1;
+            if (toks.size() > 1 && toks.back().size() > 1 && toks.back()[0] == '*' &&
+                isNumericTok(toks.back().substr(1))) {
+                count = std::clamp(tryInt(toks.back().substr(1), 1), 1, COMPACT_MAX_REPEAT);
+                toks.pop_back();
+            }
+            for (int r = 0; r < count && m_emitted < COMPACT_MAX_LINES; ++r)
+                lowerLine(toks, verb);
+        }
+    }
+
+public:
+    explicit CompactLowering(float groundY) : m_groundY(groundY) {}
+
+    std::string lowerAll(std::string_view text) {
+        size_t start = 0;
+        for (size_t i = 0; i <= text.size(); ++i) {
+            if (i < text.size() && text[i] != '\n') continue;
+            m_lines.push_back(text.substr(start, i - start));
+            start = i + 1;
+        }
+        m_out.reserve(text.size() + text.size() / 2);
+        run(0, m_lines.size());
+        return std::move(m_out);
+    }
+};
+
+// Lowers the compact dialect to plain absolute EAS. Plain scripts come back
+// as the same view (the marker scan costs far less than a copy); otherwise
+// the lowered text lives in `storage`.
+inline std::string_view lowerCompact(std::string_view text, std::string& storage) {
+    if (!usesCompactDialect(text)) return text;
+    storage = CompactLowering(getGroundY()).lowerAll(text);
+    return storage;
+}
+
 // ── Main parse entry point ─────────────────────────────────────────────────
 
 struct ParseResult {
@@ -3410,19 +4648,32 @@ struct ParseResult {
     matjson::Value root;        // {analysis, objects, macros, level_metadata}
 };
 
-inline ParseResult parse(std::string_view text) {
-    ParseResult r;
-    auto root      = matjson::Value::object();
-    auto objects   = matjson::Value::array();
-    auto macros    = matjson::Value::array();
-    auto metadata  = matjson::Value::object();
-    auto defaultColors = matjson::Value::array();
-    bool metaSeen = false;
-
-    // Stride through lines
-    std::string cur;
-    auto handle_inner = [&](const std::string& raw) {
-        auto ln = tokenize(raw);
+// Everything a run of lines produces. Per-line conversion is independent
+// except for the two accumulating verbs — META (merges keys into one
+// metadata object) and default COLOR (appends to default_colors) — so a
+// script can be converted as separate chunks and the states merged in
+// source order (see parseParallel).
+struct ParseState {
+    matjson::Value objects       = matjson::Value::array();
+    matjson::Value macros        = matjson::Value::array();
+    matjson::Value metadata      = matjson::Value::object();
+    matjson::Value defaultColors = matjson::Value::array();
+    bool           metaSeen      = false;
+};
+
+inline void parseLines(std::string_view text, ParseState& st) {
+    auto& objects       = st.objects;
+    auto& macros        = st.macros;
+    auto& metadata      = st.metadata;
+    auto& defaultColors = st.defaultColors;
+    bool& metaSeen      = st.metaSeen;
+
+    // One Line reused for every script line (its vectors keep their
+    // capacity); tokens view into `text` or the arena, both outliving it.
+    Arena arena;
+    Line  ln;
+    auto handle_inner = [&](std::string_view raw) {
+        tokenize(raw, ln, arena);
         if (ln.verb.empty()) return;
 
         // ── Edit operations on EXISTING level objects ────────────────────
@@ -3434,6 +4685,7 @@ inline ParseResult parse(std::string_view text) {
         //   #5-40      inventory index range (inclusive)
         //   rect:x1,y1,x2,y2   every object inside that box
         //   id:spike / id:8    every object of that type (name or numeric)
+        //   group:7            every member of that group
         // MOVE takes dx=/dy= deltas; EDIT applies rot=, scale=, color=,
         // detail=, flip_x, flip_y (the fields applyEditOps executes —
         // anything else parsed by applyCommonFields is currently ignored).
@@ -3445,7 +4697,7 @@ inline ParseResult parse(std::string_view text) {
                 return;
             }
             auto op = matjson::Value::object();
-            op["op"]  = ln.verb;
+            op["op"]  = std::string(ln.verb);
             op["sel"] = sel;
             // Optional extra filter (combines with rect selectors).
             if (ln.kv.count("type")) op["filter_type"] = ln.str("type");
@@ -3484,10 +4736,7 @@ inline ParseResult parse(std::string_view text) {
             if (ln.kv.count("at")) {
                 // Color trigger — emit as effect_color_trigger object
                 auto t = triggerObj("effect_color_trigger", ln.fnum("at", 0), 0, ln);
-                if (ln.kv.count("ch"))  t["color_channel"] = (double)ln.inum("ch", 1);
-                if (ln.kv.count("hex")) t["color"]         = hexToRGBArray(ln.str("hex"));
-                if (ln.kv.count("duration")) t["duration"] = (double)ln.fnum("duration", 0.5f);
-                if (ln.flag("blend"))        t["blending"] = true;
+                parseProps(t, ln, props::Trig, 899);
                 objects.push(t);
                 return;
             }
@@ -3513,7 +4762,7 @@ inline ParseResult parse(std::string_view text) {
         if (ln.verb == "obj") {
             // OBJ <type> <x> <y> — type is always positional. tryFloat guards
             // against `OBJ block_x 105 nan` and friends.
-            std::string type = ln.pos.empty() ? ln.str("type", "") : ln.pos[0];
+            std::string type = ln.pos.empty() ? ln.str("type", "") : std::string(ln.pos[0]);
             if (type.empty()) return;
             float x = ln.pos.size() > 1 ? tryFloat(ln.pos[1], ln.fnum("x", 0))   : ln.fnum("x", 0);
             float y = ln.pos.size() > 2 ? tryFloat(ln.pos[2], ln.fnum("y", 105)) : ln.fnum("y", 105);
@@ -3560,7 +4809,7 @@ inline ParseResult parse(std::string_view text) {
             // the repetitive rows that dominate output tokens (deco strips,
             // coin lines, chain fences...). Type goes through the same
             // resolution as OBJ, so block/spike aliases work too.
-            std::string type = ln.pos.empty() ? ln.str("type", "") : ln.pos[0];
+            std::string type = ln.pos.empty() ? ln.str("type", "") : std::string(ln.pos[0]);
             if (type.empty()) return;
             float x0 = 0, x1 = 0; bool ok = false;
             if (ln.pos.size() > 1) std::tie(x0, x1, ok) = parseRange(ln.pos[1]);
@@ -3929,263 +5178,116 @@ inline ParseResult parse(std::string_view text) {
         if (ln.verb == "trigger") {
             if (ln.pos.empty()) return;
             std::string kind = lower(ln.pos[0]);
-            float at = ln.fnum("at", 0);
-            if (kind == "color") {
-                auto t = triggerObj("effect_color_trigger", at, 0, ln);
-                if (ln.kv.count("ch"))       t["color_channel"] = (double)ln.inum("ch", 1);
-                if (ln.kv.count("channel"))  t["color_channel"] = (double)ln.inum("channel", 1);
-                if (ln.kv.count("hex"))      t["color"]         = hexToRGBArray(ln.str("hex"));
-                if (ln.kv.count("duration")) t["duration"]      = (double)ln.fnum("duration", 0.5f);
-                if (ln.kv.count("opacity"))  t["opacity"]       = (double)ln.fnum("opacity", 1.f);
-                if (ln.flag("blend"))        t["blending"]      = true;
-                if (ln.flag("blending"))     t["blending"]      = true;
-                objects.push(t);
-            } else if (kind == "alpha") {
-                auto t = triggerObj("effect_alpha_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"]  = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"]  = (double)ln.inum("target", 1);
-                if (ln.kv.count("to"))     t["opacity"]       = (double)ln.fnum("to", 1.f);
-                if (ln.kv.count("opacity")) t["opacity"]      = (double)ln.fnum("opacity", 1.f);
-                if (ln.kv.count("duration")) t["duration"]    = (double)ln.fnum("duration", 0.5f);
-                objects.push(t);
-            } else if (kind == "move") {
-                auto t = triggerObj("effect_move_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"]  = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"]  = (double)ln.inum("target", 1);
-                if (ln.kv.count("dx"))     t["move_x"]        = (double)ln.fnum("dx", 0);
-                if (ln.kv.count("dy"))     t["move_y"]        = (double)ln.fnum("dy", 0);
-                if (ln.kv.count("move_x")) t["move_x"]        = (double)ln.fnum("move_x", 0);
-                if (ln.kv.count("move_y")) t["move_y"]        = (double)ln.fnum("move_y", 0);
-                if (ln.kv.count("duration")) t["duration"]    = (double)ln.fnum("duration", 0.5f);
-                if (ln.flag("lock_to_player_x")) t["lock_to_player_x"] = true;
-                if (ln.flag("lock_to_player_y")) t["lock_to_player_y"] = true;
-                objects.push(t);
-            } else if (kind == "toggle") {
-                auto t = triggerObj("effect_toggle_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                t["activate_group"] = ln.flag("on") || ln.flag("activate");
-                objects.push(t);
-            } else if (kind == "pulse") {
-                auto t = triggerObj("effect_pulse_trigger", at, 0, ln);
-                // Pulse targets EITHER a color channel OR a group, not both.
-                if (ln.kv.count("ch"))       t["target_color_channel"] = (double)ln.inum("ch", 1);
-                if (ln.kv.count("channel"))  t["target_color_channel"] = (double)ln.inum("channel", 1);
-                if (ln.kv.count("groups"))   t["target_group"]         = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))   t["target_group"]         = (double)ln.inum("target", 1);
-                if (ln.kv.count("hex"))      t["color"]                = hexToRGBArray(ln.str("hex"));
-                if (ln.kv.count("duration")) t["duration"]             = (double)ln.fnum("duration", 0.5f);
-                if (ln.kv.count("fade_in"))  t["fade_in"]              = (double)ln.fnum("fade_in", 0.f);
-                if (ln.kv.count("hold"))     t["hold"]                 = (double)ln.fnum("hold", 0.f);
-                if (ln.kv.count("fade_out")) t["fade_out"]             = (double)ln.fnum("fade_out", 0.f);
-                if (ln.flag("exclusive"))    t["exclusive"]            = true;
-                objects.push(t);
-            } else if (kind == "rotate") {
-                auto t = triggerObj("effect_rotate_trigger", at, 0, ln);
-                if (ln.kv.count("groups"))  t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))  t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("center"))  t["center_group"] = (double)ln.inum("center", 1);
-                if (ln.kv.count("degrees")) t["degrees"]      = (double)ln.fnum("degrees", 360);
-                if (ln.kv.count("duration")) t["duration"]    = (double)ln.fnum("duration", 1);
-                if (ln.flag("lock_rotation") || ln.flag("lock_object_rotation"))
-                                            t["lock_object_rotation"] = true;
-                objects.push(t);
-            } else if (kind == "spawn") {
-                auto t = triggerObj("effect_spawn_trigger", at, 0, ln);
-                if (ln.kv.count("target")) t["target_group"]   = (double)ln.inum("target", 1);
-                if (ln.kv.count("groups")) t["target_group"]   = (double)ln.inum("groups", 1);
-                if (ln.kv.count("delay"))  t["delay"]          = (double)ln.fnum("delay", 0);
-                if (ln.flag("editor_disable")) t["editor_disable"] = true;
-                objects.push(t);
-            } else if (kind == "stop") {
-                auto t = triggerObj("effect_stop_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                objects.push(t);
-            } else if (kind == "scale") {
-                auto t = triggerObj("effect_scale_trigger", at, 0, ln);
-                if (ln.kv.count("groups"))   t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))   t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("to"))       t["scale"]        = (double)ln.fnum("to", 1);
-                if (ln.kv.count("duration")) t["duration"]     = (double)ln.fnum("duration", 0.5f);
-                objects.push(t);
-            } else if (kind == "shake") {
-                auto t = triggerObj("effect_shake_trigger", at, 0, ln);
-                if (ln.kv.count("duration")) t["duration"]  = (double)ln.fnum("duration", 1);
-                if (ln.kv.count("strength")) t["strength"]  = (double)ln.fnum("strength", 1);
-                if (ln.kv.count("interval")) t["interval"]  = (double)ln.fnum("interval", 0);
-                objects.push(t);
-            } else if (kind == "zoom") {
-                // TRIGGER zoom at=X zoom=1.5 [duration=T] — 2.2 camera zoom
-                auto t = triggerObj("effect_zoom_camera_trigger", at, 0, ln);
-                if (ln.kv.count("zoom"))     t["zoom"]     = (double)ln.fnum("zoom", 1);
-                if (ln.kv.count("duration")) t["duration"] = (double)ln.fnum("duration", 0.5f);
-                objects.push(t);
-            } else if (kind == "static-cam" || kind == "static_cam" || kind == "camera-static") {
-                // TRIGGER static-cam at=X target=G [duration=T] [exit] — lock camera to group
-                auto t = triggerObj("effect_static_camera_trigger", at, 0, ln);
-                if (ln.kv.count("target"))   t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("groups"))   t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("duration")) t["duration"]     = (double)ln.fnum("duration", 0.5f);
-                if (ln.flag("exit"))         t["exit"]         = true;
-                objects.push(t);
-            } else if (kind == "offset-cam" || kind == "offset_cam" || kind == "camera-offset") {
-                // TRIGGER offset-cam at=X x=DX y=DY [duration=T] — pan the camera
-                auto t = triggerObj("effect_offset_camera_trigger", at, 0, ln);
-                if (ln.kv.count("x"))        t["move_x"]   = (double)ln.fnum("x", 0);
-                if (ln.kv.count("y"))        t["move_y"]   = (double)ln.fnum("y", 0);
-                if (ln.kv.count("duration")) t["duration"] = (double)ln.fnum("duration", 0.5f);
-                objects.push(t);
-            } else if (kind == "timewarp") {
-                // TRIGGER timewarp at=X mod=0.5 — slow-mo / speed-up (2.2)
-                auto t = triggerObj("effect_timewarp_trigger", at, 0, ln);
-                if (ln.kv.count("mod"))      t["mod"] = (double)ln.fnum("mod", 1);
-                objects.push(t);
-            } else if (kind == "song") {
-                // TRIGGER song at=X [sound_id=N channel=C volume=V]
-                auto t = triggerObj("effect_song_trigger", at, 0, ln);
-                if (ln.kv.count("sound_id")) t["sound_id"] = (double)ln.inum("sound_id", 0);
-                if (ln.kv.count("channel"))  t["channel"]  = (double)ln.inum("channel", 0);
-                if (ln.kv.count("volume"))   t["volume"]   = (double)ln.fnum("volume", 1);
-                objects.push(t);
-            } else if (kind == "sfx") {
-                // TRIGGER sfx at=X sound_id=N [volume=V pitch=P]
-                auto t = triggerObj("effect_sfx_trigger", at, 0, ln);
-                if (ln.kv.count("sound_id")) t["sound_id"] = (double)ln.inum("sound_id", 0);
-                if (ln.kv.count("volume"))   t["volume"]   = (double)ln.fnum("volume", 1);
-                if (ln.kv.count("pitch"))    t["pitch"]    = (double)ln.fnum("pitch", 0);
-                objects.push(t);
-            } else if (kind == "follow") {
-                // TRIGGER follow at=X target=G follow=G2 [x_mod=1 y_mod=1 duration=T]
-                auto t = triggerObj("effect_follow_trigger", at, 0, ln);
-                if (ln.kv.count("groups"))   t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))   t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("follow"))   t["follow_group"] = (double)ln.inum("follow", 1);
-                if (ln.kv.count("x_mod"))    t["x_mod"]        = (double)ln.fnum("x_mod", 1);
-                if (ln.kv.count("y_mod"))    t["y_mod"]        = (double)ln.fnum("y_mod", 1);
-                if (ln.kv.count("duration")) t["duration"]     = (double)ln.fnum("duration", 10);
-                objects.push(t);
-            } else if (kind == "follow-y" || kind == "follow_y" || kind == "follow-player-y") {
-                // TRIGGER follow-y at=X target=G [speed=S delay=D offset=O max_speed=M duration=T]
-                auto t = triggerObj("effect_follow_player_y_trigger", at, 0, ln);
-                if (ln.kv.count("groups"))    t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))    t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("speed"))     t["speed"]        = (double)ln.fnum("speed", 1);
-                if (ln.kv.count("delay"))     t["delay"]        = (double)ln.fnum("delay", 0);
-                if (ln.kv.count("offset"))    t["offset"]       = (double)ln.inum("offset", 0);
-                if (ln.kv.count("max_speed")) t["max_speed"]    = (double)ln.fnum("max_speed", 0);
-                if (ln.kv.count("duration"))  t["duration"]     = (double)ln.fnum("duration", 10);
-                objects.push(t);
-            } else if (kind == "touch") {
-                // TRIGGER touch at=X target=G [activate] [hold] — player-tap activation
-                auto t = triggerObj("effect_touch_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.flag("activate"))   t["activate"]     = true;
-                if (ln.flag("hold"))       t["hold"]         = true;
-                objects.push(t);
-            } else if (kind == "count" || kind == "instant-count" || kind == "instant_count") {
-                // TRIGGER count at=X item_id=N count=C target=G [activate]
-                auto t = triggerObj(kind == "count" ? "effect_count_trigger"
-                                                    : "effect_instant_count_trigger",
-                                    at, 0, ln);
-                if (ln.kv.count("item_id")) t["item_id"]      = (double)ln.inum("item_id", 1);
-                if (ln.kv.count("count"))   t["count"]        = (double)ln.inum("count", 1);
-                if (ln.kv.count("groups"))  t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target"))  t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.flag("activate"))    t["activate"]     = true;
-                objects.push(t);
-            } else if (kind == "pickup") {
-                // TRIGGER pickup at=X item_id=N count=C — adjust a counter
-                auto t = triggerObj("effect_pickup_trigger", at, 0, ln);
-                if (ln.kv.count("item_id")) t["item_id"] = (double)ln.inum("item_id", 1);
-                if (ln.kv.count("count"))   t["count"]   = (double)ln.inum("count", 1);
-                objects.push(t);
-            } else if (kind == "on-death" || kind == "on_death") {
-                // TRIGGER on-death target=G [activate] — fires when the player dies
-                auto t = triggerObj("effect_on_death_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.flag("activate"))   t["activate"]     = true;
-                objects.push(t);
-            } else if (kind == "end") {
-                auto t = triggerObj("effect_10_level_end_trigger", at, 0, ln);
-                objects.push(t);
-            } else if (kind == "animate") {
-                // TRIGGER animate groups=G anim=N at=X — play animation N on
-                // the animated objects in group G
-                auto t = triggerObj("effect_animate_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                if (ln.kv.count("anim"))   t["animation_id"] = (double)ln.inum("anim", 0);
-                if (ln.kv.count("animation_id"))
-                    t["animation_id"] = (double)ln.inum("animation_id", 0);
-                objects.push(t);
-            } else if (kind == "gravity") {
-                // TRIGGER gravity g=F at=X [duration=T] — change gravity
-                // multiplier (1 = normal, 0.5 = floaty, 2 = heavy)
-                auto t = triggerObj("effect_gravity_trigger", at, 0, ln);
-                if (ln.kv.count("g"))        t["gravity"]  = (double)ln.fnum("g", 1.f);
-                if (ln.kv.count("gravity"))  t["gravity"]  = (double)ln.fnum("gravity", 1.f);
-                if (ln.kv.count("duration")) t["duration"] = (double)ln.fnum("duration", 0.5f);
-                objects.push(t);
-            } else if (kind == "teleport") {
-                // TRIGGER teleport groups=G at=X — teleport the player to
-                // group G's location (2.2 teleport trigger)
-                auto t = triggerObj("effect_teleport_trigger", at, 0, ln);
-                if (ln.kv.count("groups")) t["target_group"] = (double)ln.inum("groups", 1);
-                if (ln.kv.count("target")) t["target_group"] = (double)ln.inum("target", 1);
-                objects.push(t);
-            } else if (kind == "reverse") {
-                objects.push(triggerObj("effect_reverse_trigger", at, 0, ln));
-            } else if (kind == "bg-on" || kind == "bg_on") {
-                objects.push(triggerObj("effect_background_effect_on_trigger", at, 0, ln));
-            } else if (kind == "bg-off" || kind == "bg_off") {
-                objects.push(triggerObj("effect_background_effect_off_trigger", at, 0, ln));
-            } else if (kind == "no-enter-fx" || kind == "no_enter_fx") {
-                objects.push(triggerObj("effect_no_enter_effect_trigger", at, 0, ln));
-            } else if (kind == "show-player" || kind == "show_player") {
-                objects.push(triggerObj("show_player_trigger", at, 0, ln));
-            } else if (kind == "hide-player" || kind == "hide_player") {
-                objects.push(triggerObj("hide_player_trigger", at, 0, ln));
-            } else if (kind == "show-trail" || kind == "show_trail") {
-                objects.push(triggerObj("show_trail_trigger", at, 0, ln));
-            } else if (kind == "hide-trail" || kind == "hide_trail") {
-                objects.push(triggerObj("hide_trail_trigger", at, 0, ln));
-            } else {
+            // Kind spellings, JSON types and each kind's fields all live in
+            // the props schema — the serializer reads the same tables back.
+            const auto* k = props::kindByName(kind);
+            if (!k) {
                 // A typo'd kind must not vanish silently — the macros
                 // dispatcher warns on unknown names; match it.
                 geode::log::warn("EAS: unknown TRIGGER kind '{}' - line skipped", kind);
+                return;
             }
+            auto t = triggerObj(k->type, ln.fnum("at", 0), 0, ln);
+            if (k->id) parseProps(t, ln, props::Trig, k->id);
+            objects.push(t);
             return;
         }
     };
     // All per-line parsing is exception-free (tryFloat/tryInt/numFromString
     // return defaults on bad input), so a malformed line degrades to default
     // values instead of needing a catch-all here.
-    auto handle = [&](const std::string& raw) { handle_inner(raw); };
-    // Stream through lines
+    // Lines are views into `text` split on \n or \r (empty runs skipped) —
+    // no per-line copy.
+    size_t lineStart = 0;
     for (size_t i = 0; i <= text.size(); ++i) {
-        char c = (i < text.size()) ? text[i] : '\n';
-        if (c == '\n' || c == '\r') {
-            if (!cur.empty()) handle(cur);
-            cur.clear();
-        } else {
-            cur.push_back(c);
-        }
+        if (i < text.size() && text[i] != '\n' && text[i] != '\r') continue;
+        if (i > lineStart) handle_inner(text.substr(lineStart, i - lineStart));
+        lineStart = i + 1;
     }
+}
 
-    // Assemble
-    if (defaultColors.size() > 0) metadata["default_colors"] = defaultColors;
-    if (metaSeen)                 root["level_metadata"]      = metadata;
-    root["objects"] = objects;
-    root["macros"]  = macros;
+inline ParseResult assemble(ParseState& st) {
+    ParseResult r;
+    auto root = matjson::Value::object();
+    if (st.defaultColors.size() > 0) st.metadata["default_colors"] = std::move(st.defaultColors);
+    if (st.metaSeen)                 root["level_metadata"]         = std::move(st.metadata);
+    root["objects"] = std::move(st.objects);
+    root["macros"]  = std::move(st.macros);
     root["analysis"] = std::string("Auto-generated from EAS script.");
     r.ok = true;
-    r.root = root;
+    r.root = std::move(root);
     return r;
 }
 
+inline ParseResult parse(std::string_view text) {
+    std::string lowered;
+    text = lowerCompact(text, lowered);
+    ParseState st;
+    parseLines(text, st);
+    return assemble(st);
+}
+
+// ── Parallel parse (very large scripts) ────────────────────────────────────
+// Splits the script at line boundaries into one chunk per worker, converts
+// each chunk into its own ParseState on a short-lived worker pool, then
+// merges in source order on the calling thread. The merge IS the fix-up
+// pass for the stateful verbs: objects/macros/default colors concatenate,
+// and META keys replay chunk by chunk, so later lines still win and keys
+// keep first-seen order — the result dumps byte-identical to parse().
+// Below PARALLEL_MIN_BYTES thread start-up costs more than it saves.
+// `forceChunks` > 0 skips the size gate (differential checks).
+static constexpr size_t PARALLEL_MIN_BYTES = 256 * 1024;
+
+inline ParseResult parseParallel(std::string_view text, unsigned forceChunks = 0) {
+    // Lower before chunking: the compact dialect's cursor and WITH blocks
+    // span lines, so chunks can't resolve them independently. Lowering is
+    // idempotent, so parse()'s own pass on the small-script path is harmless.
+    std::string lowered;
+    text = lowerCompact(text, lowered);
+    unsigned chunks = forceChunks;
+    if (!chunks) {
+        if (text.size() < PARALLEL_MIN_BYTES) return parse(text);
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        chunks = (unsigned)std::min<size_t>({(size_t)hw, (size_t)8,
+                                             text.size() / (PARALLEL_MIN_BYTES / 4)});
+    }
+    if (chunks <= 1) return parse(text);
+
+    // Boundaries: nominal equal slices, each pushed forward past the next
+    // line break so no line straddles two chunks.
+    std::vector<std::string_view> parts;
+    size_t begin = 0;
+    for (unsigned c = 1; c <= chunks && begin < text.size(); ++c) {
+        size_t end = c == chunks ? text.size() : std::max(begin, text.size() * c / chunks);
+        while (end < text.size() && text[end] != '\n' && text[end] != '\r') ++end;
+        parts.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    std::vector<ParseState> states(parts.size());
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(parts.size() - 1);
+        for (size_t c = 1; c < parts.size(); ++c)
+            pool.emplace_back([&, c] { parseLines(parts[c], states[c]); });
+        parseLines(parts[0], states[0]);   // the caller works chunk 0
+        for (auto& t : pool) t.join();
+    }
+
+    ParseState merged = std::move(states[0]);
+    for (size_t c = 1; c < states.size(); ++c) {
+        auto& st = states[c];
+        for (auto& o : st.objects)       merged.objects.push(std::move(o));
+        for (auto& m : st.macros)        merged.macros.push(std::move(m));
+        for (auto& d : st.defaultColors) merged.defaultColors.push(std::move(d));
+        if (st.metaSeen) {
+            for (auto& [k, v] : st.metadata) merged.metadata[k] = std::move(v);
+            merged.metaSeen = true;
+        }
+    }
+    return assemble(merged);
+}
+
 // Detect whether `text` is EAS or JSON by inspecting the first non-comment,
 // non-whitespace line. EAS verbs are recognized; otherwise assume JSON.
 inline bool looksLikeEAS(const std::string& text) {
@@ -4220,6 +5322,10 @@ inline bool looksLikeEAS(const std::string& text) {
         // First real line — check its first word
         size_t sp = line.find_first_of(" \t");
         std::string word = lower(std::string(line.substr(0, sp)));
+        // The compact verbs are ordinary English words: only a line shaped
+        // like one, in a text that uses @ cursors or { blocks, is a script.
+        if (word == "at" || word == "with" || word == "repeat")
+            return compactVerbLine(line) && anyCodeLine(text, hasCompactAnchor);
         return EAS_VERBS.count(word) > 0;
     }
     return false;
@@ -4242,78 +5348,87 @@ inline std::string extractScript(const std::string& text) {
 // Turns a mod-format objects array back into EAS text. Three consumers:
 // the Mutation Engine (current level as prompt context), .eas blueprint
 // export, and recipe/debug surfaces. Deliberately simple — one line per
-// object, no pattern mining — because EAS OBJ lines are already ~6-8 tokens
-// and correctness beats cleverness when the output is fed back to a model.
+// object, no pattern mining — so exports stay diff-friendly and editable.
+// Prompt context goes through objectsToEASCompact (after `macros`), which
+// mines this output for rows/stacks/repeats and verifies the round-trip.
 inline std::string objectsToEAS(const matjson::Value& objectsArray,
                                 float groundY = 105.f) {
     if (!objectsArray.isArray()) return {};
 
-    // JSON trigger type → EAS TRIGGER kind. Mirrors the TRIGGER dispatcher.
-    static const std::unordered_map<std::string, std::string> TRIGGER_KINDS = {
-        {"color_trigger", "color"},   {"effect_color_trigger",  "color"},
-        {"move_trigger", "move"},     {"effect_move_trigger",   "move"},
-        {"alpha_trigger", "alpha"},   {"effect_alpha_trigger",  "alpha"},
-        {"rotate_trigger", "rotate"}, {"effect_rotate_trigger", "rotate"},
-        {"toggle_trigger", "toggle"}, {"effect_toggle_trigger", "toggle"},
-        {"pulse_trigger", "pulse"},   {"effect_pulse_trigger",  "pulse"},
-        {"spawn_trigger", "spawn"},   {"effect_spawn_trigger",  "spawn"},
-        {"stop_trigger", "stop"},     {"effect_stop_trigger",   "stop"},
-        {"end_trigger", "end"},       {"effect_10_level_end_trigger", "end"},
-        {"effect_scale_trigger", "scale"},     {"effect_shake_trigger", "shake"},
-        {"effect_zoom_camera_trigger", "zoom"},
-        {"effect_static_camera_trigger", "static-cam"},
-        {"effect_offset_camera_trigger", "offset-cam"},
-        {"effect_timewarp_trigger", "timewarp"},
-        {"effect_song_trigger", "song"},       {"effect_sfx_trigger", "sfx"},
-        {"effect_follow_trigger", "follow"},
-        {"effect_follow_player_y_trigger", "follow-y"},
-        {"effect_touch_trigger", "touch"},     {"effect_count_trigger", "count"},
-        {"effect_instant_count_trigger", "instant-count"},
-        {"effect_pickup_trigger", "pickup"},
-        {"effect_on_death_trigger", "on-death"},
-        {"effect_animate_trigger", "animate"},
-        {"effect_gravity_trigger", "gravity"},
-        {"effect_teleport_trigger", "teleport"},
-        {"effect_reverse_trigger", "reverse"},
-        {"effect_background_effect_on_trigger", "bg-on"},
-        {"effect_background_effect_off_trigger", "bg-off"},
-        {"effect_no_enter_effect_trigger", "no-enter-fx"},
-        {"show_player_trigger", "show-player"},
-        {"hide_player_trigger", "hide-player"},
-        {"show_trail_trigger", "show-trail"},
-        {"hide_trail_trigger", "hide-trail"},
-    };
-    // JSON field → EAS keyword, shared across trigger kinds. Only fields the
-    // TRIGGER dispatcher actually round-trips.
-    static const std::vector<std::pair<const char*, const char*>> TRIG_FIELDS = {
-        {"target_group", "target"}, {"duration", "duration"}, {"easing", "easing"},
-        {"move_x", "dx"},           {"move_y", "dy"},         {"degrees", "degrees"},
-        {"strength", "strength"},   {"interval", "interval"}, {"zoom", "zoom"},
-        {"mod", "mod"},             {"sound_id", "sound_id"}, {"channel", "channel"},
-        {"volume", "volume"},       {"pitch", "pitch"},       {"follow_group", "follow"},
-        {"x_mod", "x_mod"},         {"y_mod", "y_mod"},       {"speed", "speed"},
-        {"delay", "delay"},         {"offset", "offset"},     {"max_speed", "max_speed"},
-        {"item_id", "item_id"},     {"count", "count"},       {"opacity", "to"},
-        {"scale", "to"},
-        {"fade_in", "fade_in"},     {"hold", "hold"},         {"fade_out", "fade_out"},
-        {"target_color_channel", "ch"},
-        {"animation_id", "anim"},   {"gravity", "g"},
-        // Bool flags ride the same loop (numeric parse fails → flag emit).
-        {"easing_rate", "easing_rate"},
-        {"blending", "blend"},          {"exclusive", "exclusive"},
-        {"lock_object_rotation", "lock_rotation"},
-        {"lock_to_player_x", "lock_to_player_x"},
-        {"lock_to_player_y", "lock_to_player_y"},
-        {"touch_triggered", "touch"},   {"spawn_triggered", "spawn_triggered"},
-        {"editor_disable", "editor_disable"},
-        {"activate_group", "on"},
-    };
-
     auto fmtNum = [](double v) -> std::string {
         double r = std::round(v);
         if (std::abs(v - r) < 0.01) return fmt::format("{}", (long long)r);
         return fmt::format("{:.1f}", v);
     };
+    // Field values keep two decimals (easing_rate=0.25 must not become 0.2);
+    // trailing zeros are trimmed so whole numbers stay bare.
+    auto fmtField = [](double v) -> std::string {
+        double r = std::round(v);
+        if (std::abs(v - r) < 0.005) return fmt::format("{}", (long long)r);
+        auto s = fmt::format("{:.2f}", v);
+        while (s.back() == '0') s.pop_back();
+        return s;
+    };
+    // One schema row back to its first keyword. Obj Float rows at their
+    // neutral value (scale 1, rot 0) are left out — the parser restores them.
+    auto emitProp = [&](std::string& out, const props::Prop& p,
+                        const matjson::Value& v) {
+        std::string_view kw = p.kw.front();
+        switch (p.type) {
+            case props::Type::Int: {
+                if (auto n = v.asInt()) out += fmt::format(" {}={}", kw, n.unwrap());
+                break;
+            }
+            case props::Type::Float: {
+                auto n = v.asDouble();
+                if (!n) break;
+                if ((p.scope & props::Obj) && std::abs(n.unwrap() - p.dflt) < 0.005) break;
+                out += fmt::format(" {}={}", kw, fmtField(n.unwrap()));
+                break;
+            }
+            case props::Type::Bool: {
+                if (v.asBool().unwrapOr(false)) out += fmt::format(" {}", kw);
+                break;
+            }
+            case props::Type::IntList: {
+                if (!v.isArray()) break;
+                std::string list;
+                for (size_t g = 0; g < v.size(); ++g) {
+                    auto gi = v[g].asInt();
+                    if (!gi) continue;
+                    if (!list.empty()) list += ",";
+                    list += std::to_string(gi.unwrap());
+                }
+                if (!list.empty()) out += fmt::format(" {}={}", kw, list);
+                break;
+            }
+            case props::Type::Hex: {
+                // A hex string (JSON origin) or an RGB array (the EAS parser
+                // stores hexToRGBArray output) — handle both.
+                if (auto hex = v.asString()) {
+                    std::string h = hex.unwrap();
+                    if (!h.empty() && h[0] == '#') h.erase(0, 1);
+                    out += fmt::format(" {}={}", kw, h);
+                } else if (v.isArray() && v.size() >= 3) {
+                    auto rr = v[0].asInt(); auto gg = v[1].asInt(); auto bb = v[2].asInt();
+                    out += fmt::format(" {}={:02x}{:02x}{:02x}", kw,
+                        rr ? std::clamp((int)rr.unwrap(), 0, 255) : 255,
+                        gg ? std::clamp((int)gg.unwrap(), 0, 255) : 255,
+                        bb ? std::clamp((int)bb.unwrap(), 0, 255) : 255);
+                }
+                break;
+            }
+        }
+    };
+    // Every row with an EAS keyword that applies to object `id` (-1: the
+    // ID-less rows), in schema order.
+    auto emitRows = [&](std::string& out, const matjson::Value& o,
+                        uint8_t scope, int id) {
+        for (auto& p : props::schema()) {
+            if (!(p.scope & scope) || p.kw.empty() || !props::forId(p, id)) continue;
+            if (o.contains(p.key)) emitProp(out, p, o[p.key]);
+        }
+    };
 
     std::string out;
     out.reserve(objectsArray.size() * 40);
@@ -4326,92 +5441,20 @@ inline std::string objectsToEAS(const matjson::Value& objectsArray,
         auto xRes = o["x"].asDouble();
         double x = xRes ? xRes.unwrap() : 0.0;
 
-        // Common suffix fields shared by both shapes
-        std::string suffix;
-        {
-            auto col = o["color_channel"].asInt();
-            if (col) suffix += fmt::format(" color={}", col.unwrap());
-            if (o.contains("groups") && o["groups"].isArray() && o["groups"].size() > 0) {
-                suffix += " groups=";
-                const auto& gs = o["groups"];
-                for (size_t g = 0; g < gs.size(); ++g) {
-                    auto gi = gs[g].asInt();
-                    if (!gi) continue;
-                    if (g) suffix += ",";
-                    suffix += fmt::format("{}", gi.unwrap());
-                }
-            }
-            auto sc = o["scale"].asDouble();
-            if (sc && std::abs(sc.unwrap() - 1.0) > 0.01)
-                suffix += fmt::format(" scale={:.2f}", sc.unwrap());
-            auto rot = o["rotation"].asDouble();
-            if (rot && std::abs(rot.unwrap()) > 0.01)
-                suffix += fmt::format(" rot={}", (int)rot.unwrap());
-            auto fx = o["flip_x"].asBool();
-            if (fx && fx.unwrap()) suffix += " flip_x";
-            auto fy = o["flip_y"].asBool();
-            if (fy && fy.unwrap()) suffix += " flip_y";
-            auto zl = o["z_layer"].asInt();
-            if (zl) suffix += fmt::format(" z_layer={}", zl.unwrap());
-            auto zo = o["z_order"].asInt();
-            if (zo) suffix += fmt::format(" z_order={}", zo.unwrap());
-            auto ma = o["multi_activate"].asBool();
-            if (ma && ma.unwrap()) suffix += " multi_activate";
-        }
-
-        auto trigIt = TRIGGER_KINDS.find(type);
-        if (trigIt != TRIGGER_KINDS.end()) {
-            // Triggers do NOT take the generic suffix: on TRIGGER lines
-            // `color=` / `groups=` carry different meanings (channel / target
-            // group), so each field maps explicitly.
-            out += fmt::format("TRIGGER {} at={}", trigIt->second, fmtNum(x));
-            // color may be a hex string (JSON origin) or an RGB array (the
-            // EAS parser stores hexToRGBArray output) — handle both.
-            auto hex = o["color"].asString();
-            if (hex) {
-                std::string h = hex.unwrap();
-                if (!h.empty() && h[0] == '#') h.erase(0, 1);
-                out += fmt::format(" hex={}", h);
-            } else if (o.contains("color") && o["color"].isArray() &&
-                       o["color"].size() >= 3) {
-                const auto& carr = o["color"];
-                auto rr = carr[0].asInt(); auto gg = carr[1].asInt(); auto bb = carr[2].asInt();
-                out += fmt::format(" hex={:02x}{:02x}{:02x}",
-                    rr ? std::clamp((int)rr.unwrap(), 0, 255) : 255,
-                    gg ? std::clamp((int)gg.unwrap(), 0, 255) : 255,
-                    bb ? std::clamp((int)bb.unwrap(), 0, 255) : 255);
-            }
-            auto trigCh = o["color_channel"].asInt();
-            if (trigCh) out += fmt::format(" ch={}", trigCh.unwrap());
-            for (auto& [jk, ek] : TRIG_FIELDS) {
-                if (!o.contains(jk)) continue;
-                auto num = o[jk].asDouble();
-                if (num) { out += fmt::format(" {}={}", ek, fmtNum(num.unwrap())); continue; }
-                auto b = o[jk].asBool();
-                if (b && b.unwrap()) out += fmt::format(" {}", ek);
-            }
-            auto act = o["activate"].asBool();
-            if (act && act.unwrap()) out += " activate";
-            auto ma = o["multi_activate"].asBool();
-            if (ma && ma.unwrap()) out += " multi_activate";
-            // The trigger's OWN group membership (spawn-chain targets) uses
-            // own_groups= on TRIGGER lines — groups= means the TARGET there.
-            if (o.contains("groups") && o["groups"].isArray() &&
-                o["groups"].size() > 0) {
-                std::string gl;
-                const auto& garr = o["groups"];
-                for (size_t gi = 0; gi < garr.size(); ++gi) {
-                    auto gv = garr[gi].asInt();
-                    if (!gv) continue;
-                    if (!gl.empty()) gl += ",";
-                    gl += std::to_string(gv.unwrap());
-                }
-                if (!gl.empty()) out += fmt::format(" own_groups={}", gl);
-            }
+        if (const auto* kind = props::kindByType(type)) {
+            // Triggers do NOT take the OBJ suffix: on TRIGGER lines `color=`
+            // / `groups=` carry different meanings (channel / target group),
+            // so only the schema's Trig rows apply.
+            out += fmt::format("TRIGGER {} at={}", props::primaryName(kind->names), fmtNum(x));
+            if (kind->id) emitRows(out, o, props::Trig, kind->id);
+            emitRows(out, o, props::Trig, -1);
             out += '\n';
             continue;
         }
 
+        std::string suffix;
+        emitRows(suffix, o, props::Obj, -1);
+
         auto yRes = o["y"].asDouble();
         double y = yRes ? yRes.unwrap() : groundY;
         // Omit Y at ground — the parser defaults to it, and this is the
@@ -4549,17 +5592,6 @@ inline bool isBlockingType(const std::string& type) {
     return false;
 }
 
-// Triggers that "remove" objects (effectively) when fired. Recognise both the
-// legacy short names (used by JSON output) and the `effect_*_trigger` names
-// the EAS parser emits — same trigger, two name conventions.
-inline bool isMovingTrigger(const std::string& type) {
-    if (type == "effect_move_trigger"   || type == "move_trigger")   return true;
-    if (type == "effect_alpha_trigger"  || type == "alpha_trigger")  return true;
-    if (type == "effect_toggle_trigger" || type == "toggle_trigger") return true;
-    if (type == "effect_stop_trigger"   || type == "stop_trigger")   return true;
-    return false;
-}
-
 // Shared matjson accessors with defaults. matjson's typed accessors return
 // Result<T>; these wrap them with fallbacks so call sites stay compact. Used
 // by the level checker and every macro expander.
@@ -4594,29 +5626,272 @@ inline bool getBool(const matjson::Value& v, const std::string& key, bool dflt)
     return dflt;
 }
 
-inline std::set<int> parseGroups(const matjson::Value& v) {
-    std::set<int> out;
-    if (!v.contains("groups")) return out;
-    auto& g = v["groups"];
-    if (g.isArray()) {
-        for (size_t i = 0; i < g.size(); ++i) {
-            auto n = g[i].asInt();
-            if (n) out.insert((int)n.unwrap());
-        }
-    } else {
-        auto n = g.asInt();
-        if (n) out.insert((int)n.unwrap());
-    }
-    return out;
-}
-
 inline int parseSingleGroup(const matjson::Value& v, const char* key) {
     if (!v.contains(key)) return 0;
     auto n = v[key].asInt();
     return n ? (int)n.unwrap() : 0;
 }
 
-inline Result check(const matjson::Value& objectsArray) {
+// ── Trigger / group dependency graph ────────────────────────────────────────
+// Who belongs to which group, which triggers target which group, when each
+// trigger actually fires (spawn-triggered ones fire when the spawn chain
+// reaching them does, delay included), and — per group — the X intervals
+// during which it's gone (toggled off, faded out, moved away) before a
+// toggle-on / fade-in brings it back. All flat arrays: node i is entry i of
+// the source array; membership and target lists are CSR (offset + span).
+// A group's hidden intervals are disjoint by construction (one state sweep
+// over its events), so each group's sorted run with a binary search is the
+// interval index — no general-purpose tree needed. Nodes append cheaply;
+// trigger-derived data re-resolves lazily on the next query after a trigger
+// was appended.
+class TriggerGraph {
+public:
+    enum class Effect : uint8_t { None, Hide, Show, Spawn };
+    static constexpr float NEVER = std::numeric_limits<float>::infinity();
+
+    void clear() { *this = TriggerGraph(); }
+    size_t size() const { return m_x.size(); }
+
+    // Draft entry i (call in array order; untyped entries still take a slot
+    // so node ids stay array indices).
+    void append(const matjson::Value& o) {
+        size_t node = m_x.size();
+        float x = o.isObject() ? getFloat(o, "x", 0.f) : 0.f;
+        m_x.push_back(std::isfinite(x) ? x : 0.f);
+        std::string type;
+        if (o.isObject())
+            if (auto t = o["type"].asString()) type = t.unwrap();
+
+        Effect fx = effectOf(type, o);
+        int target = fx == Effect::None ? 0 : parseSingleGroup(o, "target_group");
+        // Legacy triggers name their target in "groups" (then they have no
+        // own groups for spawn chains to reach).
+        bool legacyTargets = fx != Effect::None && target == 0;
+        if (o.isObject() && o.contains("groups")) {
+            auto& g = o["groups"];
+            auto push = [&](int gid) {
+                if (gid <= 0) return;
+                if (legacyTargets) addTrigger(node, gid, fx, o);
+                else m_membership.push_back({gid, (uint32_t)node});
+            };
+            if (g.isArray())
+                for (size_t k = 0; k < g.size(); ++k) push((int)g[k].asInt().unwrapOr(0));
+            else push((int)g.asInt().unwrapOr(0));
+        }
+        if (target > 0) addTrigger(node, target, fx, o);
+        m_membersSorted = false;
+    }
+
+    // Membership-only node (live editor objects, for group selectors).
+    void appendNode(float x, std::span<const int> groups) {
+        size_t node = m_x.size();
+        m_x.push_back(std::isfinite(x) ? x : 0.f);
+        for (int g : groups)
+            if (g > 0) m_membership.push_back({g, (uint32_t)node});
+        m_membersSorted = false;
+    }
+
+    void build(const matjson::Value& arr) {
+        clear();
+        if (!arr.isArray()) return;
+        m_x.reserve(arr.size());
+        for (size_t i = 0; i < arr.size(); ++i) append(arr[i]);
+    }
+
+    // Node ids of group `g`'s members.
+    std::span<const uint32_t> members(int g) const {
+        sortMembers();
+        auto lo = std::lower_bound(m_membership.begin(), m_membership.end(),
+                                   Member{g, 0}, byGroup);
+        auto hi = std::upper_bound(lo, m_membership.end(), Member{g, ~0u}, byGroup);
+        if (lo == hi) return {};
+        m_memberIds.resize(m_membership.size());
+        size_t a = lo - m_membership.begin(), b = hi - m_membership.begin();
+        for (size_t k = a; k < b; ++k) m_memberIds[k] = m_membership[k].node;
+        return {m_memberIds.data() + a, b - a};
+    }
+
+    // Is group g gone when the player reaches x?
+    bool groupHiddenAt(int g, float x) const {
+        resolve();
+        auto lo = std::lower_bound(m_hidden.begin(), m_hidden.end(),
+                                   Interval{g, -NEVER, 0.f}, byGroupStart);
+        // Last interval of g starting at or before x.
+        auto hi = std::upper_bound(lo, m_hidden.end(), Interval{g, x, 0.f}, byGroupStart);
+        if (hi == lo) return false;
+        --hi;
+        return hi->group == g && hi->start < x && x < hi->end;
+    }
+
+    // Is node i (any of its groups) gone by the time the player reaches it?
+    bool nodeHidden(size_t i) const {
+        if (i >= m_x.size()) return false;
+        sortMembers();
+        resolve();
+        if (m_hidden.empty()) return false;
+        auto [a, b] = nodeGroups(i);
+        for (size_t k = a; k < b; ++k)
+            if (groupHiddenAt(m_nodeGroups[k], m_x[i])) return true;
+        return false;
+    }
+
+    size_t triggerCount() const { return m_trigs.size(); }
+    size_t hiddenIntervalCount() const { resolve(); return m_hidden.size(); }
+
+private:
+    struct Member   { int group; uint32_t node; };
+    struct Trig     { uint32_t node; int target; Effect fx; bool spawnTriggered; float delay; };
+    struct Interval { int group; float start, end; };
+    static bool byGroup(const Member& a, const Member& b) {
+        return a.group != b.group ? a.group < b.group : a.node < b.node;
+    }
+    static bool byGroupStart(const Interval& a, const Interval& b) {
+        return a.group != b.group ? a.group < b.group : a.start < b.start;
+    }
+
+    std::vector<float>            m_x;
+    mutable std::vector<Member>   m_membership;
+    mutable bool                  m_membersSorted = true;
+    mutable std::vector<uint32_t> m_memberIds;
+    // node → its groups (CSR), rebuilt with the membership sort.
+    mutable std::vector<uint32_t> m_nodeStart;
+    mutable std::vector<int>      m_nodeGroups;
+
+    std::vector<Trig>             m_trigs;
+    mutable bool                  m_resolved = true;
+    mutable std::vector<float>    m_fire;     // parallel to m_trigs
+    mutable std::vector<Interval> m_hidden;   // sorted by (group, start)
+
+    static Effect effectOf(const std::string& type, const matjson::Value& o) {
+        if (type.empty()) return Effect::None;
+        if (type == "spawn_trigger" || type == "effect_spawn_trigger") return Effect::Spawn;
+        if (type == "toggle_trigger" || type == "effect_toggle_trigger")
+            return getBool(o, "activate_group", false) ? Effect::Show : Effect::Hide;
+        if (type == "alpha_trigger" || type == "effect_alpha_trigger")
+            return getFloat(o, "opacity", 0.f) > 0.05f ? Effect::Show : Effect::Hide;
+        if (type == "move_trigger" || type == "effect_move_trigger") return Effect::Hide;
+        return Effect::None;
+    }
+
+    void addTrigger(size_t node, int target, Effect fx, const matjson::Value& o) {
+        m_trigs.push_back({(uint32_t)node, target, fx,
+                           getBool(o, "spawn_triggered", false),
+                           std::max(0.f, getFloat(o, "delay", 0.f))});
+        m_resolved = false;
+    }
+
+    std::pair<size_t, size_t> nodeGroups(size_t i) const {
+        if (i + 1 >= m_nodeStart.size()) return {0, 0};
+        return {m_nodeStart[i], m_nodeStart[i + 1]};
+    }
+
+    void sortMembers() const {
+        if (m_membersSorted && m_nodeStart.size() == m_x.size() + 1) return;
+        std::sort(m_membership.begin(), m_membership.end(), byGroup);
+        // Node → groups CSR via a counting pass.
+        m_nodeStart.assign(m_x.size() + 1, 0);
+        for (auto& m : m_membership) ++m_nodeStart[m.node + 1];
+        for (size_t i = 1; i < m_nodeStart.size(); ++i) m_nodeStart[i] += m_nodeStart[i - 1];
+        m_nodeGroups.resize(m_membership.size());
+        std::vector<uint32_t> fill(m_nodeStart.begin(), m_nodeStart.end() - 1);
+        for (auto& m : m_membership) m_nodeGroups[fill[m.node]++] = m.group;
+        m_membersSorted = true;
+    }
+
+    // Fire X per trigger (spawn chains, cycle-safe), then each group's
+    // hidden intervals from its time-ordered hide/show events.
+    void resolve() const {
+        if (m_resolved) return;
+        sortMembers();
+        size_t T = m_trigs.size();
+        m_fire.assign(T, NEVER);
+        // Spawn triggers by target group, for "who spawns group g".
+        std::vector<std::pair<int, uint32_t>> spawners;
+        for (uint32_t t = 0; t < T; ++t)
+            if (m_trigs[t].fx == Effect::Spawn) spawners.push_back({m_trigs[t].target, t});
+        std::sort(spawners.begin(), spawners.end());
+        // Spawn-triggered t fires after whichever of its spawners fires
+        // first (CSR: preds[predStart[t] ..)). Triggers placed in the level
+        // have none and fire at their own X.
+        std::vector<uint32_t> predStart(T + 1, 0), preds;
+        for (uint32_t t = 0; t < T; ++t) {
+            predStart[t] = (uint32_t)preds.size();
+            if (!m_trigs[t].spawnTriggered) continue;
+            auto [a, b] = nodeGroups(m_trigs[t].node);
+            for (size_t k = a; k < b; ++k) {
+                int g = m_nodeGroups[k];
+                auto lo = std::lower_bound(spawners.begin(), spawners.end(),
+                                           std::pair<int, uint32_t>{g, 0});
+                for (auto it = lo; it != spawners.end() && it->first == g; ++it)
+                    preds.push_back(it->second);
+            }
+        }
+        predStart[T] = (uint32_t)preds.size();
+        // Earliest fire X is a shortest path: placed triggers are sources
+        // at their own X, and a spawn edge costs the spawner's delay in
+        // units (never negative). Dijkstra over the spawner → spawned
+        // edges (the transpose of preds) reaches every trigger a spawn
+        // loop can be entered from; loops nothing enters stay NEVER.
+        std::vector<uint32_t> succStart(T + 1, 0), succs(preds.size());
+        for (uint32_t p : preds) ++succStart[p + 1];
+        for (uint32_t t = 0; t < T; ++t) succStart[t + 1] += succStart[t];
+        {
+            std::vector<uint32_t> fill(succStart.begin(), succStart.end() - 1);
+            for (uint32_t t = 0; t < T; ++t)
+                for (uint32_t k = predStart[t]; k < predStart[t + 1]; ++k)
+                    succs[fill[preds[k]]++] = t;
+        }
+        using Reach = std::pair<float, uint32_t>;   // fire X, trigger
+        std::priority_queue<Reach, std::vector<Reach>, std::greater<Reach>> open;
+        for (uint32_t t = 0; t < T; ++t)
+            if (!m_trigs[t].spawnTriggered) {
+                m_fire[t] = m_x[m_trigs[t].node];
+                open.push({m_fire[t], t});
+            }
+        while (!open.empty()) {
+            auto [x, t] = open.top();
+            open.pop();
+            if (x > m_fire[t]) continue;            // stale entry
+            float next = x + m_trigs[t].delay * GD_PLAYER_SPEED_1X;
+            for (uint32_t k = succStart[t]; k < succStart[t + 1]; ++k) {
+                uint32_t v = succs[k];
+                if (next < m_fire[v]) {
+                    m_fire[v] = next;
+                    open.push({next, v});
+                }
+            }
+        }
+
+        struct Event { int group; float x; bool hide; };
+        std::vector<Event> events;
+        events.reserve(T);
+        for (uint32_t t = 0; t < T; ++t) {
+            auto fx = m_trigs[t].fx;
+            if ((fx == Effect::Hide || fx == Effect::Show) && m_fire[t] != NEVER)
+                events.push_back({m_trigs[t].target, m_fire[t], fx == Effect::Hide});
+        }
+        std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+            return a.group != b.group ? a.group < b.group : a.x < b.x;
+        });
+        m_hidden.clear();
+        for (size_t i = 0; i < events.size();) {
+            int g = events[i].group;
+            bool hidden = false;
+            float since = 0.f;
+            for (; i < events.size() && events[i].group == g; ++i) {
+                if (events[i].hide && !hidden) { hidden = true; since = events[i].x; }
+                else if (!events[i].hide && hidden) {
+                    hidden = false;
+                    if (events[i].x > since) m_hidden.push_back({g, since, events[i].x});
+                }
+            }
+            if (hidden) m_hidden.push_back({g, since, NEVER});
+        }
+        m_resolved = true;
+    }
+};
+
+inline Result check(const matjson::Value& objectsArray, const TriggerGraph* graph = nullptr) {
     Result r;
     if (!objectsArray.isArray() || objectsArray.size() == 0) {
         r.pass_rate = 1.f;
@@ -4624,53 +5899,24 @@ inline Result check(const matjson::Value& objectsArray) {
         return r;
     }
 
-    // ── Stage 1: build trigger index — which groups get moved/hidden, by what X ──
-    // group_id → earliest trigger X that affects it
-    std::unordered_map<int, float> groupRemovedAtX;
+    // ── Stage 1: trigger graph — which groups are gone at which X ──
+    // Callers holding a graph for this exact array pass it in; otherwise
+    // build one here.
+    TriggerGraph localGraph;
+    if (!graph || graph->size() != objectsArray.size()) {
+        localGraph.build(objectsArray);
+        graph = &localGraph;
+    }
 
     // ── Stage 2: scan objects, building (a) blocker list, (b) max X ──
-    struct Obj { float x, y, half_w, half_h; std::set<int> groups; };
+    struct Obj { float x, y, half_w, half_h; };
     std::vector<Obj> blockers;
     float maxX = 0.f;
     int skippedGarbage = 0;
 
-    // First pass: collect triggers (so we know which groups are "moved away")
-    for (size_t i = 0; i < objectsArray.size(); ++i) {
-        const auto& o = objectsArray[i];
-        if (!o.isObject()) continue;
-        auto typeRes = o["type"].asString();
-        if (!typeRes) continue;
-        std::string type = typeRes.unwrap();
-        if (!isMovingTrigger(type)) continue;
-        // Direction matters: a toggle that turns a group ON adds blockers,
-        // it doesn't remove them — treating it as removal hides real death
-        // zones. Same for alpha fading TO visible (opacity > 0).
-        if (type.find("toggle") != std::string::npos) {
-            auto act = o["activate_group"].asBool();
-            if (act && act.unwrap()) continue;
-        }
-        if (type.find("alpha") != std::string::npos) {
-            float to = getFloat(o, "opacity", 0.f);
-            if (to > 0.05f) continue;
-        }
-        float trigX = getFloat(o, "x", 0.f);
-        int target = parseSingleGroup(o, "target_group");
-        if (target == 0) {
-            // legacy "groups" field on triggers
-            auto gs = parseGroups(o);
-            for (int g : gs) {
-                auto it = groupRemovedAtX.find(g);
-                if (it == groupRemovedAtX.end() || trigX < it->second)
-                    groupRemovedAtX[g] = trigX;
-            }
-        } else {
-            auto it = groupRemovedAtX.find(target);
-            if (it == groupRemovedAtX.end() || trigX < it->second)
-                groupRemovedAtX[target] = trigX;
-        }
-    }
-
-    // Second pass: collect blockers, filtering out "moved before player reaches" ones
+    // Collect blockers, filtering out ones whose group is gone (toggled off,
+    // faded out, moved away — directly or via a spawn chain) by the time
+    // the player reaches them.
     for (size_t i = 0; i < objectsArray.size(); ++i) {
         const auto& o = objectsArray[i];
         if (!o.isObject()) continue;
@@ -4698,23 +5944,14 @@ inline Result check(const matjson::Value& objectsArray) {
         }
         if (x > maxX) maxX = x;
 
-        auto groups = parseGroups(o);
-        bool movedBefore = false;
-        for (int g : groups) {
-            auto it = groupRemovedAtX.find(g);
-            if (it != groupRemovedAtX.end() && it->second < x) {
-                movedBefore = true;
-                break;
-            }
-        }
-        if (movedBefore) continue;   // object is gone by the time player arrives
+        if (graph->nodeHidden(i)) continue;   // gone by the time player arrives
 
         float scale = getFloat(o, "scale", 1.f);
         if (!std::isfinite(scale)) scale = 1.f;
         scale = std::clamp(scale, 0.05f, 50.f);
         // Standard GD cell is 30×30; spikes are roughly the same bounding box.
         float half = 15.f * scale;
-        blockers.push_back({x, y, half, half, std::move(groups)});
+        blockers.push_back({x, y, half, half});
     }
 
     if (blockers.empty()) {
@@ -4903,37 +6140,86 @@ inline Result check(const matjson::Value& objectsArray) {
     return r;
 }
 
-// ── Greedy-bot cube simulator ───────────────────────────────────────────────
-// Traces an actual cube trajectory through the draft: gravity, jump arcs, a
-// greedy "jump when a hazard/wall approaches" policy, AABB death checks.
-// Catches the classic AI failure — a spike at exactly un-jumpable distance —
-// that column-occupancy checks can't see. Constants are community-measured
-// GD values at 1x; this is an ADVISORY sim, not a frame-perfect replica.
-struct SimDeath { float x, y; std::string reason; };
-struct SimResult {
-    std::vector<cocos2d::CCPoint> path;   // sampled trajectory for the overlay
-    std::vector<SimDeath> deaths;
-    float reachedX = 0.f;
-    bool  finished = false;
-};
-
-inline SimResult simulateCube(const matjson::Value& objectsArray, float groundY) {
-    SimResult res;
-    if (!objectsArray.isArray() || objectsArray.size() == 0) return res;
+// ── Input-search passability verifier ───────────────────────────────────────
+// Proves a draft passable (or not) instead of hoping one scripted run is
+// representative. A fixed-step physics model per gamemode is driven by a
+// breadth-first search over press/release inputs: the player's X is input-
+// independent (speed portals are positional), so every candidate state at a
+// tick shares one X, one gamemode and one collision window, and states that
+// quantize to the same (y, vy, gravity, grounded, held, last booster) merge.
+// The layer is capped (a beam) with an even spread over Y so pruning keeps
+// diverse routes rather than the first ones found.
+//
+// Long levels are cut into X segments searched in parallel. Segment 0 starts
+// from the real spawn; later segments start speculatively from canonical
+// entry states (every standable surface for ground modes, a Y/velocity grid
+// for flight). At stitch time each real exit state of segment k-1 hands off
+// to a speculative seed within HANDOFF tolerance; when none matches — or a
+// failure shows up anywhere downstream of a speculative handoff — the
+// affected segments are re-searched exactly from the real frontier. So a
+// witness may carry a sub-hitbox jump at a seam, but "unpassable" is only
+// ever reported from exact frontiers. Constants are community-measured GD
+// values at 1x; this is a MODEL (60 Hz, AABB hitboxes), not a replica.
+enum class SimMode : uint8_t { Cube, Ship, Ball, Ufo, Wave, Robot, Spider, Swing };
+
+inline const char* simModeName(SimMode m) {
+    switch (m) {
+        case SimMode::Ship:   return "ship";
+        case SimMode::Ufo:    return "ufo";
+        case SimMode::Wave:   return "wave";
+        case SimMode::Ball:   return "ball";
+        case SimMode::Spider: return "spider";
+        case SimMode::Swing:  return "swing";
+        case SimMode::Robot:  return "robot";
+        default:              return "cube";
+    }
+}
 
-    struct Box { float x, y, halfW, halfH; };
-    std::vector<Box> solids, hazards;
-    // v2: gamemode segments, speed portals, and jump orbs/pads. The bot is
-    // mode-aware — cube/robot run the jump simulation; flight modes run a
-    // corridor-gap check (a cube model in a ship tunnel reports nonsense).
-    enum class SimMode { Cube, Ship, Ball, Ufo, Wave, Robot, Spider, Swing };
+// Static collision world, built once per verification and shared read-only
+// by every segment worker.
+struct SimWorld {
+    struct Box         { float x, y, halfW, halfH; };
     struct ModeChange  { float x; SimMode m; };
     struct SpeedChange { float x; float mult; };
     struct Booster     { float x, y, impulse; bool isPad; };
+    std::vector<Box>         solids, hazards;    // sorted by x
     std::vector<ModeChange>  modes;
     std::vector<SpeedChange> speeds;
     std::vector<Booster>     boosters;
-    float maxX = 0.f;
+    float maxX     = 0.f;
+    float unmodeledX = std::numeric_limits<float>::infinity();  // first object the model can't play
+    float floorTop = 0.f;
+    float maxHalfW = 15.f;    // widest box, bounds the collision window
+};
+
+// Objects that change the player in ways the bot has no physics for:
+// gravity/size/dual/teleport portals, gravity/dash/spider/teleport/toggle
+// orbs and pads, and the triggers that flip gravity, reverse or teleport.
+// Asked after the modeled portals/orbs have been taken, so any other
+// portal_ type left is one of these (mirror only flips the camera).
+inline bool unmodeledType(std::string_view t) {
+    auto has = [&](std::string_view s) { return t.find(s) != std::string_view::npos; };
+    if (t.substr(0, 7) == "portal_") return !has("mirror") && !has("particle");
+    if (t == "effect_gravity_trigger" || t == "effect_reverse_trigger" ||
+        t == "effect_teleport_trigger")
+        return true;
+    if (t.substr(0, 4) == "obj_" && !has("glow"))
+        return t.ends_with("_orb") || t.ends_with("_pad") || has("gravity");
+    return false;
+}
+
+inline SimWorld buildSimWorld(const matjson::Value& objectsArray, float groundY,
+                              const TriggerGraph* graph) {
+    SimWorld w;
+    w.floorTop = groundY + 15.f;                  // top surface of the ground row
+    if (!objectsArray.isArray() || objectsArray.size() == 0) return w;
+    // Same trigger accounting as check(): objects whose group is gone when
+    // the player gets there don't collide.
+    TriggerGraph localGraph;
+    if (!graph || graph->size() != objectsArray.size()) {
+        localGraph.build(objectsArray);
+        graph = &localGraph;
+    }
     for (size_t i = 0; i < objectsArray.size(); ++i) {
         const auto& o = objectsArray[i];
         if (!o.isObject()) continue;
@@ -4948,27 +6234,31 @@ inline SimResult simulateCube(const matjson::Value& objectsArray, float groundY)
         if (!std::isfinite(scale)) scale = 1.f;
         scale = std::clamp(scale, 0.05f, 50.f);
         // Gamemode portals.
-        if      (t == "portal_cube_portal")   { modes.push_back({x, SimMode::Cube});   continue; }
-        else if (t == "portal_ship_portal")   { modes.push_back({x, SimMode::Ship});   continue; }
-        else if (t == "portal_ball_portal")   { modes.push_back({x, SimMode::Ball});   continue; }
-        else if (t == "portal_ufo_portal")    { modes.push_back({x, SimMode::Ufo});    continue; }
-        else if (t == "portal_wave_portal")   { modes.push_back({x, SimMode::Wave});   continue; }
-        else if (t == "portal_robot_portal")  { modes.push_back({x, SimMode::Robot});  continue; }
-        else if (t == "portal_spider_portal") { modes.push_back({x, SimMode::Spider}); continue; }
-        else if (t == "portal_swing_portal")  { modes.push_back({x, SimMode::Swing});  continue; }
+        if      (t == "portal_cube_portal")   { w.modes.push_back({x, SimMode::Cube});   continue; }
+        else if (t == "portal_ship_portal")   { w.modes.push_back({x, SimMode::Ship});   continue; }
+        else if (t == "portal_ball_portal")   { w.modes.push_back({x, SimMode::Ball});   continue; }
+        else if (t == "portal_ufo_portal")    { w.modes.push_back({x, SimMode::Ufo});    continue; }
+        else if (t == "portal_wave_portal")   { w.modes.push_back({x, SimMode::Wave});   continue; }
+        else if (t == "portal_robot_portal")  { w.modes.push_back({x, SimMode::Robot});  continue; }
+        else if (t == "portal_spider_portal") { w.modes.push_back({x, SimMode::Spider}); continue; }
+        else if (t == "portal_swing_portal")  { w.modes.push_back({x, SimMode::Swing});  continue; }
         // Speed portals (community-measured ratios vs 311.58 u/s).
-        else if (t == "portal_yellow_slow_speed_portal") { speeds.push_back({x, 0.8061f}); continue; }
-        else if (t == "portal_blue_normal_speed_portal") { speeds.push_back({x, 1.0f});    continue; }
-        else if (t == "portal_green_fast_speed_portal")  { speeds.push_back({x, 1.2434f}); continue; }
-        else if (t == "portal_pink_fast_speed_portal")   { speeds.push_back({x, 1.5020f}); continue; }
-        else if (t == "portal_red_fast_speed_portal")    { speeds.push_back({x, 1.8486f}); continue; }
-        // Jump orbs / pads (gravity & dash variants excluded — the bot
-        // can't reason about them; better blind than wrong).
+        else if (t == "portal_yellow_slow_speed_portal") { w.speeds.push_back({x, 0.8061f}); continue; }
+        else if (t == "portal_blue_normal_speed_portal") { w.speeds.push_back({x, 1.0f});    continue; }
+        else if (t == "portal_green_fast_speed_portal")  { w.speeds.push_back({x, 1.2434f}); continue; }
+        else if (t == "portal_pink_fast_speed_portal")   { w.speeds.push_back({x, 1.5020f}); continue; }
+        else if (t == "portal_red_fast_speed_portal")    { w.speeds.push_back({x, 1.8486f}); continue; }
+        // Jump orbs / pads. Gravity & dash variants aren't simulated; they
+        // only mark where the model stops being trustworthy (unmodeledX).
         else if (t.rfind("jump_orb_", 0) == 0 || t.rfind("jump_pad_", 0) == 0) {
             float imp = t.find("red") != std::string::npos    ? 1.35f
                       : t.find("pink") != std::string::npos   ? 0.75f
                                                               : 1.0f;
-            boosters.push_back({x, y, imp, t.rfind("jump_pad_", 0) == 0});
+            w.boosters.push_back({x, y, imp, t.rfind("jump_pad_", 0) == 0});
+            continue;
+        }
+        else if (unmodeledType(t)) {
+            if (!graph->nodeHidden(i)) w.unmodeledX = std::min(w.unmodeledX, x);
             continue;
         }
         bool hazard = t.rfind("spike_", 0) == 0 || t.rfind("hazard_", 0) == 0 ||
@@ -4976,7 +6266,7 @@ inline SimResult simulateCube(const matjson::Value& objectsArray, float groundY)
         bool solid  = !hazard && isBlockingType(t);
         if (!hazard && !solid) continue;
         // Flagged-off collision: no_touch hazards can't kill, passable
-        // solids can't block — skip both so the bot sees the real level.
+        // solids can't block — skip both so the model sees the real level.
         if (hazard) {
             auto nt = o["no_touch"].asBool();
             if (nt && nt.unwrap()) continue;
@@ -4985,309 +6275,748 @@ inline SimResult simulateCube(const matjson::Value& objectsArray, float groundY)
             auto pr = o["passable"].asBool();
             if (pr && pr.unwrap()) continue;
         }
+        if (graph->nodeHidden(i)) continue;
         // Hazard hitboxes in GD are forgiving (~40-60% of the sprite).
         float half = 15.f * scale * (hazard ? 0.55f : 1.f);
-        (hazard ? hazards : solids).push_back({x, y, half, half});
-        if (x > maxX) maxX = x;
+        (hazard ? w.hazards : w.solids).push_back({x, y, half, half});
+        w.maxHalfW = std::max(w.maxHalfW, half);
+        w.maxX     = std::max(w.maxX, x);
+    }
+    auto byX = [](const auto& a, const auto& b) { return a.x < b.x; };
+    std::sort(w.solids.begin(),   w.solids.end(),   byX);
+    std::sort(w.hazards.begin(),  w.hazards.end(),  byX);
+    std::sort(w.modes.begin(),    w.modes.end(),    byX);
+    std::sort(w.speeds.begin(),   w.speeds.end(),   byX);
+    std::sort(w.boosters.begin(), w.boosters.end(), byX);
+    return w;
+}
+
+struct VerifyResult {
+    bool  passable   = false;   // a witness input sequence reaches the end
+    bool  exhaustive = true;    // failing chain searched without dropping a state
+    bool  modeled    = true;    // every object up to blockedX is one the sim plays
+    float blockedX   = 0.f;     // first X no explored input survives past
+    float blockedY   = 0.f;
+    std::string reason;         // what killed the last survivors
+    float reachedX   = 0.f;
+    std::vector<cocos2d::CCPoint> path;             // witness / furthest attempt
+    std::vector<std::pair<float, float>> holds;     // witness input: [press X, release X)
+    unsigned segments = 1;
+    unsigned reruns   = 0;      // speculative segments redone exactly
+    size_t   states   = 0;      // states expanded, all segments
+
+    // A failure callers may act on. Past an unmodeled object the bot is
+    // playing a different level, so its death there proves nothing.
+    bool blocked() const { return !passable && modeled && !reason.empty(); }
+};
+
+namespace bot {
+
+// 1x physics. Cube jump: v0≈603.7 u/s, g≈2794 u/s² → apex ≈ 65u, length ≈ 134u.
+constexpr float VX = 311.58f, V_JUMP = 603.72f, GRAV = 2794.11f;
+constexpr float DT = 1.f / 60.f;
+constexpr float HALF = 15.f;                     // player half-extent
+constexpr float CEIL = 540.f;                    // flight-section ceiling
+constexpr float V_TERMINAL = 810.f;
+constexpr float SHIP_UP = 1900.f, SHIP_DOWN = 1500.f, SHIP_VMAX = 430.f;
+constexpr float UFO_HOP = 460.f;
+constexpr size_t BEAM = 384;                     // states kept per tick
+constexpr int    MAX_TICKS = 24000;
+constexpr int    MIN_SEGMENT_TICKS = 600;        // ~10 s of play per worker
+// Real→seed handoff tolerance at a segment seam.
+constexpr float HANDOFF_Y = 3.f, HANDOFF_VY = 60.f;
+
+enum Cause : uint8_t { kAlive, kWall, kHazard, kHead, kOut, kCauseCount };
+inline const char* causeText(Cause c) {
+    switch (c) {
+        case kWall:   return "every timing runs into a wall";
+        case kHazard: return "every timing hits a hazard";
+        case kHead:   return "every timing bonks a block from below";
+        case kOut:    return "every timing leaves the playfield";
+        default:      return "no surviving input";
     }
-    if (maxX <= 0.f) return res;
-    auto byX = [](const Box& a, const Box& b) { return a.x < b.x; };
-    std::sort(solids.begin(),  solids.end(),  byX);
-    std::sort(hazards.begin(), hazards.end(), byX);
-    std::sort(modes.begin(),  modes.end(),
-              [](const ModeChange& a,  const ModeChange& b)  { return a.x < b.x; });
-    std::sort(speeds.begin(), speeds.end(),
-              [](const SpeedChange& a, const SpeedChange& b) { return a.x < b.x; });
-    std::sort(boosters.begin(), boosters.end(),
-              [](const Booster& a, const Booster& b) { return a.x < b.x; });
-
-    // 1x physics. Jump: v0≈603.7 u/s, g≈2794 u/s² → apex ≈ 65u, length ≈ 134u.
-    constexpr float VX = 311.58f, V_JUMP = 603.72f, GRAV = 2794.11f;
-    constexpr float DT = 1.f / 60.f;
-    constexpr float HALF = 15.f;                  // player cube half-extent
-    const float floorTop = groundY + 15.f;        // top surface of the ground row
-
-    float x = 0.f, y = floorTop + HALF, vy = 0.f;
-    bool grounded = true;
-    size_t sWin = 0, hWin = 0;                    // two-pointer sweep windows
-    int sinceSample = 0;
+}
+
+struct State {
+    float    y, vy;
+    int8_t   grav;          // +1 normal, -1 flipped
+    bool     grounded;
+    bool     held;          // input held on the previous tick (edge detection)
+    int16_t  booster;       // last booster consumed, -1 none
+    uint16_t origin;        // entry-state index this route started from
+};
+
+// Per-tick context shared by every state at that tick.
+struct Tick {
+    float x, mult;
+    SimMode mode;
+    bool modeChanged;
+    uint32_t s0, s1, h0, h1, b0, b1;  // collision windows into the world
+};
+
+// Parent index + input per surviving state, per tick — enough to rebuild a
+// route by walking back; states are replayed forward for the path. Packed
+// into two bytes: parents index a beam or a seed set, both under 0x8000.
+struct Link {
+    uint16_t v;
+    uint16_t parent() const { return v >> 1; }
+    bool     press()  const { return v & 1; }
+};
+
+inline std::vector<Tick> schedule(const SimWorld& w) {
+    std::vector<Tick> ticks;
+    float x = 0.f, mult = 1.f;
     SimMode mode = SimMode::Cube;
-    float   vxMult = 1.f;
-    size_t  mWin = 0, spWin = 0, bWin = 0;
-    float   lastCorridorX = -1e9f;
-    auto isCorridorMode = [](SimMode m) {
-        return m == SimMode::Ship || m == SimMode::Ufo || m == SimMode::Wave ||
-               m == SimMode::Ball || m == SimMode::Spider || m == SimMode::Swing;
-    };
-    auto modeName = [](SimMode m) -> const char* {
-        switch (m) {
-            case SimMode::Ship:   return "ship";
-            case SimMode::Ufo:    return "ufo";
-            case SimMode::Wave:   return "wave";
-            case SimMode::Ball:   return "ball";
-            case SimMode::Spider: return "spider";
-            case SimMode::Swing:  return "swing";
-            case SimMode::Robot:  return "robot";
-            default:              return "cube";
-        }
-    };
+    size_t mi = 0, si = 0, s0 = 0, h0 = 0, b0 = 0;
+    ticks.reserve(std::min<size_t>(MAX_TICKS, (size_t)((w.maxX + 400.f) / (VX * DT)) + 2));
+    for (int t = 0; t < MAX_TICKS && x <= w.maxX + 200.f; ++t) {
+        SimMode prev = mode;
+        while (mi < w.modes.size() && w.modes[mi].x <= x) mode = w.modes[mi++].m;
+        // The multiplier in effect BEFORE crossing a portal moves this tick
+        // (GD applies the new speed from the next frame).
+        float stepMult = mult;
+        while (si < w.speeds.size() && w.speeds[si].x <= x) mult = w.speeds[si++].mult;
+        float reach = HALF + w.maxHalfW;
+        while (s0 < w.solids.size()   && w.solids[s0].x   < x - reach) ++s0;
+        while (h0 < w.hazards.size()  && w.hazards[h0].x  < x - reach) ++h0;
+        while (b0 < w.boosters.size() && w.boosters[b0].x < x - 30.f)  ++b0;
+        size_t s1 = s0, h1 = h0, b1 = b0;
+        while (s1 < w.solids.size()   && w.solids[s1].x   <= x + reach) ++s1;
+        while (h1 < w.hazards.size()  && w.hazards[h1].x  <= x + reach) ++h1;
+        while (b1 < w.boosters.size() && w.boosters[b1].x <= x + 30.f)  ++b1;
+        ticks.push_back({x, stepMult, mode, t > 0 && mode != prev,
+                         (uint32_t)s0, (uint32_t)s1, (uint32_t)h0, (uint32_t)h1,
+                         (uint32_t)b0, (uint32_t)b1});
+        x += VX * stepMult * DT;
+    }
+    return ticks;
+}
+
+inline bool groundMode(SimMode m) {
+    return m == SimMode::Cube || m == SimMode::Robot ||
+           m == SimMode::Ball || m == SimMode::Spider;
+}
+
+inline bool overlapsX(const SimWorld::Box& b, float x, float half) {
+    return x + half > b.x - b.halfW && x - half < b.x + b.halfW;
+}
 
-    // Standing surface under the player: ground, or the highest block top
-    // whose span contains px.
-    auto surfaceAt = [&](float px, float py) {
-        float best = floorTop;
-        for (size_t i = sWin; i < solids.size() && solids[i].x - solids[i].halfW <= px + HALF; ++i) {
-            const auto& b = solids[i];
-            if (px + HALF < b.x - b.halfW || px - HALF > b.x + b.halfW) continue;
+// Support surface in the gravity direction at tick `c`: the highest top
+// under the feet (normal) or the lowest bottom over the head (flipped),
+// floor/ceiling included.
+inline float supportAt(const SimWorld& w, const Tick& c, float y, int grav) {
+    float best = grav > 0 ? w.floorTop : CEIL;
+    for (uint32_t i = c.s0; i < c.s1; ++i) {
+        const auto& b = w.solids[i];
+        if (!overlapsX(b, c.x, HALF - 1.f)) continue;
+        if (grav > 0) {
             float top = b.y + b.halfH;
-            if (top <= py - HALF + 6.f && top > best) best = top;
+            if (top <= y - HALF + 6.f && top > best) best = top;
+        } else {
+            float bot = b.y - b.halfH;
+            if (bot >= y + HALF - 6.f && bot < best) best = bot;
         }
-        return best;
-    };
+    }
+    return best;
+}
 
-    res.path.reserve(2048);
-    float lastPadX = -1e9f;        // a pad fires once per pass, not per tick
-    for (int tick = 0; tick < 12000; ++tick) {
-        // Mode / speed segment advancement. The multiplier in effect BEFORE
-        // crossing a portal moves this tick — GD applies the new speed from
-        // the next frame, and matching that avoids stepping over a spike
-        // sitting right on the portal.
-        float stepMult = vxMult;
-        while (mWin < modes.size() && modes[mWin].x <= x) {
-            SimMode prev = mode;
-            mode = modes[mWin++].m;
-            if (isCorridorMode(mode) != isCorridorMode(prev))
-                lastCorridorX = -1e9f;
-            if (!isCorridorMode(mode)) {
-                vy = 0.f;
-                if (isCorridorMode(prev)) {
-                    // Leaving flight: snap to the standing surface instead
-                    // of free-falling from corridor-center height (a ceiling
-                    // at that height would false-flag a wall slam).
-                    y = surfaceAt(x, y) + HALF;
-                    grounded = true;
-                } else {
-                    grounded = false;
-                }
-            }
+// Advance one state by one tick under `press`. Returns the cause of death,
+// or kAlive with `s` updated in place.
+inline Cause step(const SimWorld& w, const Tick& c, State& s, bool press) {
+    const bool edge = press && !s.held;
+    const float prevY = s.y;
+    const SimMode m = c.mode;
+    const int g = s.grav;
+    if (c.modeChanged && groundMode(m)) s.vy = 0.f;
+
+    // Pads fire on contact, once per pass; orbs on a fresh press.
+    for (uint32_t i = c.b0; i < c.b1; ++i) {
+        const auto& bo = w.boosters[i];
+        if ((int16_t)i == s.booster) continue;
+        if (std::abs(bo.x - c.x) >= (bo.isPad ? 20.f : 28.f)) continue;
+        if (std::abs(bo.y - s.y) >= (bo.isPad ? 30.f : 45.f)) continue;
+        if (bo.isPad) {
+            s.vy = g * V_JUMP * bo.impulse * 1.15f;   // pads kick harder than taps
+        } else if (edge && m != SimMode::Wave) {
+            s.vy = g * V_JUMP * bo.impulse;
+        } else {
+            continue;
         }
-        while (spWin < speeds.size() && speeds[spWin].x <= x)
-            vxMult = speeds[spWin++].mult;
-        while (bWin < boosters.size() && boosters[bWin].x < x - 100.f) ++bWin;
+        s.grounded = false;
+        s.booster = (int16_t)i;
+        break;
+    }
 
-        x += VX * stepMult * DT;
-        if (x > maxX + 200.f) { res.finished = true; break; }
-        // Advance sweep windows past geometry far behind the player.
-        while (sWin < solids.size()  && solids[sWin].x  + solids[sWin].halfW  < x - 200.f) ++sWin;
-        while (hWin < hazards.size() && hazards[hWin].x + hazards[hWin].halfW < x - 200.f) ++hWin;
-
-        // ── Flight/corridor modes: vertical freedom, so the question is
-        // only "does an adequately tall free gap exist at this X?" ──────────
-        if (isCorridorMode(mode)) {
-            if (x - lastCorridorX >= 15.f) {
-                lastCorridorX = x;
-                // Occupied vertical intervals at this column (solids AND
-                // hazards both block a flight path).
-                std::vector<std::pair<float, float>> occ;
-                for (size_t i = sWin; i < solids.size() &&
-                     solids[i].x - solids[i].halfW <= x + HALF; ++i) {
-                    const auto& b = solids[i];
-                    if (x + HALF < b.x - b.halfW || x - HALF > b.x + b.halfW) continue;
-                    occ.push_back({b.y - b.halfH, b.y + b.halfH});
-                }
-                for (size_t i = hWin; i < hazards.size() &&
-                     hazards[i].x - hazards[i].halfW <= x + HALF; ++i) {
-                    const auto& h = hazards[i];
-                    if (x + HALF < h.x - h.halfW || x - HALF > h.x + h.halfW) continue;
-                    occ.push_back({h.y - h.halfH, h.y + h.halfH});
-                }
-                std::sort(occ.begin(), occ.end());
-                float lo = floorTop, bestGap = 0.f, bestLo = floorTop;
-                constexpr float CEIL = 540.f;
-                for (auto& iv : occ) {
-                    if (iv.first > lo) {
-                        float gap = std::min(iv.first, CEIL) - lo;
-                        if (gap > bestGap) { bestGap = gap; bestLo = lo; }
-                    }
-                    lo = std::max(lo, iv.second);
-                    if (lo >= CEIL) break;
-                }
-                if (CEIL > lo && CEIL - lo > bestGap) {
-                    bestGap = CEIL - lo;
-                    bestLo  = lo;
-                }
-                // Below 40u even a wave can't thread it. (60u+ is comfy;
-                // 40-60 is tight-but-fair, not flagged.)
-                if (bestGap < 40.f) {
-                    res.deaths.push_back({x, y,
-                        fmt::format("corridor too tight for {} ({}u free)",
-                                    modeName(mode), (int)bestGap)});
-                    if (res.deaths.size() >= 8) break;
-                    x += 60.f;
-                    sinceSample = 0;     // settle before sampling again
-                    while (sWin < solids.size()  &&
-                           solids[sWin].x  + solids[sWin].halfW  < x - 200.f) ++sWin;
-                    while (hWin < hazards.size() &&
-                           hazards[hWin].x + hazards[hWin].halfW < x - 200.f) ++hWin;
-                } else {
-                    y = bestLo + bestGap * 0.5f;   // fly the widest gap
-                }
+    switch (m) {
+        case SimMode::Cube:
+        case SimMode::Robot:
+            if (press && s.grounded) { s.vy = g * V_JUMP; s.grounded = false; }
+            if (!s.grounded) s.vy -= g * GRAV * DT;
+            break;
+        case SimMode::Ship:
+            s.vy += g * (press ? SHIP_UP : -SHIP_DOWN) * DT;
+            s.vy = std::clamp(s.vy, -SHIP_VMAX, SHIP_VMAX);
+            s.grounded = false;
+            break;
+        case SimMode::Ufo:
+            if (edge) { s.vy = g * UFO_HOP; s.grounded = false; }
+            if (!s.grounded) s.vy -= g * GRAV * 0.7f * DT;
+            break;
+        case SimMode::Wave:
+            s.vy = g * (press ? 1.f : -1.f) * VX * c.mult;
+            s.grounded = false;
+            break;
+        case SimMode::Ball:
+            if (edge && s.grounded) { s.grav = -s.grav; s.grounded = false; }
+            if (!s.grounded) s.vy -= s.grav * GRAV * 0.6f * DT;
+            break;
+        case SimMode::Spider:
+            if (edge && s.grounded) {
+                // Instant teleport to the opposite surface.
+                s.grav = -s.grav;
+                float to = supportAt(w, c, s.y, s.grav);
+                s.y  = to + s.grav * HALF;
+                s.vy = 0.f;
+            } else if (!s.grounded) {
+                s.vy -= s.grav * GRAV * 0.6f * DT;
             }
-            if (++sinceSample >= 3) {
-                sinceSample = 0;
-                res.path.push_back({x, y});
+            break;
+        case SimMode::Swing:
+            if (edge) s.grav = -s.grav;
+            s.vy -= s.grav * GRAV * 0.5f * DT;
+            s.vy = std::clamp(s.vy, -SHIP_VMAX, SHIP_VMAX);
+            s.grounded = false;
+            break;
+    }
+    s.vy = std::clamp(s.vy, -V_TERMINAL, V_TERMINAL);
+    s.y += s.vy * DT;
+    s.held = press;
+
+    // Vertical resolution against floor, ceiling and solids: arriving from
+    // the gravity side lands, arriving from the other side bonks (fatal for
+    // cube/robot), anything else is a wall.
+    const bool headKills = m == SimMode::Cube || m == SimMode::Robot;
+    bool landed = false;
+    auto resolve = [&](float bot, float top) -> Cause {
+        if (s.y + HALF <= bot || s.y - HALF >= top) return kAlive;
+        bool fromAbove = prevY - HALF >= top - 6.f;
+        bool fromBelow = prevY + HALF <= bot + 6.f;
+        bool feet = s.grav > 0 ? fromAbove : fromBelow;
+        if (feet) {
+            s.y = s.grav > 0 ? top + HALF : bot - HALF;
+            s.vy = 0.f;
+            landed = true;
+            return kAlive;
+        }
+        if (fromAbove || fromBelow) {
+            if (headKills) return kHead;
+            s.y = fromBelow ? bot - HALF : top + HALF;
+            s.vy = 0.f;
+            return kAlive;
+        }
+        return kWall;
+    };
+    if (Cause k = resolve(-1e9f, w.floorTop); k != kAlive) return k;
+    if (!(headKills && s.grav > 0))
+        if (Cause k = resolve(CEIL, 1e9f); k != kAlive) return k;
+    for (uint32_t i = c.s0; i < c.s1; ++i) {
+        const auto& b = w.solids[i];
+        if (!overlapsX(b, c.x, HALF - 1.f)) continue;
+        if (Cause k = resolve(b.y - b.halfH, b.y + b.halfH); k != kAlive) return k;
+    }
+    if (s.y > CEIL + 200.f || s.y < w.floorTop - 200.f) return kOut;
+    if (landed) {
+        s.grounded = true;
+        s.booster = -1;                          // pads re-arm on landing
+    } else if (s.grounded) {
+        // Walked off an edge?
+        float sup = supportAt(w, c, s.y, s.grav);
+        if (std::abs((s.grav > 0 ? s.y - HALF : s.y + HALF) - sup) > 1.5f)
+            s.grounded = false;
+    }
+
+    for (uint32_t i = c.h0; i < c.h1; ++i) {
+        const auto& h = w.hazards[i];
+        if (c.x + HALF * 0.7f > h.x - h.halfW && c.x - HALF * 0.7f < h.x + h.halfW &&
+            s.y + HALF * 0.7f > h.y - h.halfH && s.y - HALF * 0.7f < h.y + h.halfH)
+            return kHazard;
+    }
+    return kAlive;
+}
+
+inline uint64_t stateKey(const State& s, SimMode m) {
+    int64_t qy  = std::lround(s.y * 2.f);
+    int64_t qvy = (m == SimMode::Wave || s.grounded) ? 0 : std::lround(s.vy / 12.f);
+    uint64_t k = (uint64_t)(qy & 0xFFFF);
+    k = k << 12 | (uint64_t)(qvy & 0xFFF);
+    k = k << 16 | (uint16_t)s.booster;
+    k = k << 1  | (s.grav < 0);
+    k = k << 1  | s.grounded;
+    k = k << 1  | s.held;
+    return k;
+}
+
+inline bool sameState(const State& a, const State& b) {
+    return a.y == b.y && a.vy == b.vy && a.grav == b.grav && a.grounded == b.grounded &&
+           a.held == b.held && a.booster == b.booster;
+}
+
+// One segment's search over ticks [t0, t1].
+struct Segment {
+    int t0 = 0, t1 = 0;
+    std::vector<State> entry;            // states at t0 (origin = index)
+    std::vector<int>   entryPrev;        // entry → previous segment's exit index
+    std::vector<Link>     links;         // every kept layer, back to back
+    std::vector<uint32_t> layerAt;       // layer t - t0 - 1 starts at links[layerAt[..]]
+    std::vector<State> exit;             // frontier at the last live tick
+    int    lastTick   = 0;               // last tick with a live state
+    Cause  cause      = kAlive;          // dominant death when the frontier died
+    float  causeY     = 0.f;
+    bool   truncated  = false;           // a distinct state was dropped (beam or merge)
+    bool   speculative = false;          // entry = canonical seeds, not real states
+    size_t expanded   = 0;
+
+    size_t layers() const { return layerAt.size(); }
+    const Link& link(size_t layer, size_t i) const { return links[layerAt[layer] + i]; }
+};
+
+inline void search(const SimWorld& w, const std::vector<Tick>& ticks, Segment& seg) {
+    std::vector<State> cur = seg.entry;
+    for (size_t i = 0; i < cur.size(); ++i) cur[i].origin = (uint16_t)i;
+    // One layer per tick of this segment's window, no more.
+    seg.links.clear();
+    seg.layerAt.clear();
+    seg.layerAt.reserve(seg.t1 - seg.t0);
+    seg.lastTick = seg.t0;
+    std::vector<State> next;
+    std::vector<Link>  nextLinks;
+    std::unordered_map<uint64_t, uint32_t> seen;   // state key → index in next
+    for (int t = seg.t0 + 1; t <= seg.t1 && !cur.empty(); ++t) {
+        const Tick& c = ticks[t];
+        next.clear();
+        nextLinks.clear();
+        seen.clear();
+        std::array<uint32_t, kCauseCount> deaths{};
+        float deathY = 0.f;
+        for (size_t p = 0; p < cur.size(); ++p) {
+            for (uint8_t press = 0; press < 2; ++press) {
+                State s = cur[p];
+                Cause k = step(w, c, s, press);
+                ++seg.expanded;
+                if (k != kAlive) { ++deaths[k]; deathY = s.y; continue; }
+                auto [it, fresh] = seen.try_emplace(stateKey(s, c.mode), (uint32_t)next.size());
+                if (!fresh) {
+                    // An exact duplicate costs nothing; a merely close one is
+                    // a route the search stops exploring.
+                    if (!sameState(next[it->second], s)) seg.truncated = true;
+                    continue;
+                }
+                next.push_back(s);
+                nextLinks.push_back({(uint16_t)(p << 1 | press)});
             }
-            res.reachedX = x;
-            continue;
         }
+        if (next.empty()) {
+            seg.cause  = (Cause)(std::max_element(deaths.begin() + 1, deaths.end()) - deaths.begin());
+            seg.causeY = deathY;
+            break;
+        }
+        if (next.size() > BEAM) {
+            // Even spread over (gravity, Y) keeps structurally different
+            // routes alive instead of the first BEAM found.
+            std::vector<uint32_t> order(next.size());
+            for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                if (next[a].grav != next[b].grav) return next[a].grav < next[b].grav;
+                return next[a].y < next[b].y;
+            });
+            std::vector<State> keep;
+            std::vector<Link>  keepLinks;
+            keep.reserve(BEAM);
+            keepLinks.reserve(BEAM);
+            for (size_t k = 0; k < BEAM; ++k) {
+                uint32_t i = order[k * order.size() / BEAM];
+                keep.push_back(next[i]);
+                keepLinks.push_back(nextLinks[i]);
+            }
+            next.swap(keep);
+            nextLinks.swap(keepLinks);
+            seg.truncated = true;
+        }
+        seg.layerAt.push_back((uint32_t)seg.links.size());
+        seg.links.insert(seg.links.end(), nextLinks.begin(), nextLinks.end());
+        cur.swap(next);
+        seg.lastTick = t;
+    }
+    // On a death the links still end at the last live layer, which is what
+    // the "furthest attempt" path walks back from.
+    if (seg.cause == kAlive) seg.exit = cur;
+    else seg.exit.clear();
+}
 
-        // ── Cube / robot: jump physics ──────────────────────────────────────
-        // Pads fire on contact, no input needed — but only ONCE per pass
-        // (the contact window spans several ticks; re-firing every tick
-        // would relaunch mid-arc and double the apex).
-        for (size_t i = bWin; i < boosters.size() && boosters[i].x <= x + 20.f; ++i) {
-            const auto& bo = boosters[i];
-            if (bo.isPad && bo.x != lastPadX &&
-                std::abs(bo.x - x) < 20.f && std::abs(bo.y - y) < 30.f) {
-                vy = V_JUMP * bo.impulse * 1.15f;  // pads kick harder than taps
-                grounded = false;
-                lastPadX = bo.x;
-                break;
-            }
+// Canonical entry states at tick t for a speculative segment.
+inline std::vector<State> seeds(const SimWorld& w, const Tick& c) {
+    std::vector<State> out;
+    auto add = [&](float y, float vy, int grav, bool grounded) {
+        if (out.size() < 0x7FFF) out.push_back({y, vy, (int8_t)grav, grounded, false, -1, 0});
+    };
+    if (groundMode(c.mode)) {
+        bool flips = c.mode == SimMode::Ball || c.mode == SimMode::Spider;
+        add(w.floorTop + HALF, 0.f, 1, true);
+        if (flips) add(CEIL - HALF, 0.f, -1, true);
+        for (uint32_t i = c.s0; i < c.s1; ++i) {
+            const auto& b = w.solids[i];
+            if (!overlapsX(b, c.x, HALF - 1.f)) continue;
+            add(b.y + b.halfH + HALF, 0.f, 1, true);
+            if (flips) add(b.y - b.halfH - HALF, 0.f, -1, true);
         }
-        if (grounded) {
-            // Greedy jump policy: hazard in the next ~90u at foot level, or a
-            // wall (solid whose top is above standable step) in the next 50u.
-            bool wantJump = false;
-            for (size_t i = hWin; i < hazards.size() && hazards[i].x < x + 95.f; ++i) {
-                const auto& h = hazards[i];
-                if (h.x > x + 20.f && h.y - h.halfH < y + 25.f && h.y + h.halfH > y - HALF - 25.f) {
-                    wantJump = true; break;
-                }
-            }
-            if (!wantJump) {
-                for (size_t i = sWin; i < solids.size() && solids[i].x < x + 55.f; ++i) {
-                    const auto& b = solids[i];
-                    if (b.x > x + HALF && b.y + b.halfH > y - HALF + 6.f &&
-                        b.y - b.halfH < y + HALF) { wantJump = true; break; }
-                }
-            }
-            if (wantJump) { vy = V_JUMP; grounded = false; }
-        }
-        if (!grounded) {
-            vy -= GRAV * DT;
-            y += vy * DT;
-            // surfaceAt(x, y): with py=y the filter accepts only tops at or
-            // below the player's center — passing y+30 let the bot snap UP
-            // onto blocks above itself, sailing over real death zones.
-            // Computed once; the orb scan below reuses it.
-            float surf = surfaceAt(x, y);
-            // Mid-air orb: falling toward trouble? A jump orb within reach
-            // resets the jump — exactly how players chain orbs over pits.
-            if (vy < 0.f) {
-                for (size_t i = bWin; i < boosters.size() &&
-                     boosters[i].x <= x + 30.f; ++i) {
-                    const auto& bo = boosters[i];
-                    if (bo.isPad) continue;
-                    if (std::abs(bo.x - x) < 28.f && std::abs(bo.y - y) < 45.f) {
-                        bool danger = surf <= floorTop + 1.f;  // pit below
-                        for (size_t k = hWin; !danger && k < hazards.size() &&
-                             hazards[k].x < x + 100.f; ++k)
-                            if (hazards[k].x > x - 20.f &&
-                                std::abs(hazards[k].y - y) < 90.f) danger = true;
-                        if (danger) { vy = V_JUMP * bo.impulse; break; }
-                    }
+    } else {
+        // Wave velocity is input-determined, so Y alone identifies a state.
+        const std::array<float, 3> vys{0.f, -2 * HANDOFF_VY, 2 * HANDOFF_VY};
+        size_t nv = c.mode == SimMode::Wave ? 1 : vys.size();
+        for (float y = w.floorTop + HALF; y <= CEIL - HALF; y += 2 * HANDOFF_Y)
+            for (size_t v = 0; v < nv; ++v)
+                for (int grav : {1, -1}) {
+                    if (grav < 0 && c.mode != SimMode::Swing) continue;
+                    add(y, vys[v], grav, false);
                 }
-            }
-            if (vy <= 0.f && y - HALF <= surf) {
-                y = surf + HALF; vy = 0.f; grounded = true;
-                lastPadX = -1e9f;          // pads re-arm on landing
-            }
-        } else {
-            float surf = surfaceAt(x, y);
-            if (surf < y - HALF - 1.f) { grounded = false; vy = 0.f; }  // walked off an edge
-            else y = surf + HALF;
-        }
-
-        // Wall slam: grounded into a solid's face.
-        for (size_t i = sWin; i < solids.size() && solids[i].x - solids[i].halfW <= x + HALF; ++i) {
-            const auto& b = solids[i];
-            if (x + HALF > b.x - b.halfW && x - HALF < b.x + b.halfW &&
-                y + HALF - 6.f > b.y - b.halfH && y - HALF + 6.f < b.y + b.halfH) {
-                res.deaths.push_back({x, y, "ran into a wall"});
-                goto died;
-            }
-        }
-        // Hazard intersect.
-        for (size_t i = hWin; i < hazards.size() && hazards[i].x - hazards[i].halfW <= x + HALF; ++i) {
-            const auto& h = hazards[i];
-            if (x + HALF * 0.7f > h.x - h.halfW && x - HALF * 0.7f < h.x + h.halfW &&
-                y + HALF * 0.7f > h.y - h.halfH && y - HALF * 0.7f < h.y + h.halfH) {
-                res.deaths.push_back({x, y, "hit a hazard"});
-                goto died;
-            }
-        }
-        goto survived;
-    died:
-        if (res.deaths.size() >= 8) break;
-        x += 60.f;                       // respawn-skip past the killer
-        // Catch the sweep windows up to the teleported x before surfaceAt.
-        while (sWin < solids.size()  && solids[sWin].x  + solids[sWin].halfW  < x - 200.f) ++sWin;
-        while (hWin < hazards.size() && hazards[hWin].x + hazards[hWin].halfW < x - 200.f) ++hWin;
-        y = surfaceAt(x, floorTop + 90.f) + HALF;
-        vy = 0.f;
-        grounded = true;
-        sinceSample = 0;                 // settle before sampling again
-        res.reachedX = x;
-        continue;                        // no path point on the death tick
-    survived:
-        if (++sinceSample >= 3) {
-            sinceSample = 0;
-            res.path.push_back({x, y});
-        }
-        res.reachedX = x;
+    }
+    return out;
+}
+
+inline bool handoff(const State& real, const State& seed, SimMode m) {
+    if (real.grav != seed.grav || real.grounded != seed.grounded) return false;
+    if (std::abs(real.y - seed.y) > HANDOFF_Y) return false;
+    if (m == SimMode::Wave || real.grounded) return true;
+    return std::abs(real.vy - seed.vy) <= HANDOFF_VY;
+}
+
+// Which exit states can continue: all of them for exact segments, only those
+// descending from a handed-off seed for speculative ones.
+inline bool usable(const Segment& seg, const State& s) {
+    return !seg.speculative || (s.origin < seg.entryPrev.size() && seg.entryPrev[s.origin] >= 0);
+}
+
+inline void rerunExact(const SimWorld& w, const std::vector<Tick>& ticks,
+                       const Segment& prev, Segment& seg) {
+    seg.entry.clear();
+    seg.entryPrev.clear();
+    for (size_t i = 0; i < prev.exit.size(); ++i) {
+        if (!usable(prev, prev.exit[i])) continue;
+        seg.entry.push_back(prev.exit[i]);
+        seg.entryPrev.push_back((int)i);
+    }
+    seg.speculative = false;
+    seg.truncated   = false;
+    seg.cause       = kAlive;
+    search(w, ticks, seg);
+}
+
+} // namespace bot
+
+inline VerifyResult verifyPassable(const matjson::Value& objectsArray, float groundY,
+                                   const TriggerGraph* graph = nullptr) {
+    using namespace bot;
+    VerifyResult res;
+    SimWorld w = buildSimWorld(objectsArray, groundY, graph);
+    if (w.maxX <= 0.f) return res;
+    std::vector<Tick> ticks = schedule(w);
+    if (ticks.size() < 2) return res;
+    int T = (int)ticks.size() - 1;
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned S  = (unsigned)std::clamp<int>(T / MIN_SEGMENT_TICKS, 1, (int)std::min(hw, 8u));
+    std::vector<Segment> segs(S);
+    for (unsigned k = 0; k < S; ++k) {
+        segs[k].t0 = (int)((int64_t)T * k / S);
+        segs[k].t1 = (int)((int64_t)T * (k + 1) / S);
+    }
+    segs[0].entry     = {{w.floorTop + HALF, 0.f, 1, true, false, -1, 0}};
+    segs[0].entryPrev = {-1};
+    for (unsigned k = 1; k < S; ++k) {
+        segs[k].entry       = seeds(w, ticks[segs[k].t0]);
+        segs[k].entryPrev.assign(segs[k].entry.size(), -1);
+        segs[k].speculative = true;
+    }
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(S - 1);
+        for (unsigned k = 1; k < S; ++k)
+            pool.emplace_back([&, k] { search(w, ticks, segs[k]); });
+        search(w, ticks, segs[0]);        // the caller works segment 0
+        for (auto& t : pool) t.join();
+    }
+
+    // Stitch. `firstSpec` = first segment of the current chain whose entry
+    // came from a seed handoff (S when the chain is exact so far).
+    unsigned firstSpec = S, reached = 0;
+    bool alive = false;
+    for (unsigned k = 0; k < S; ++k) {
+        if (k > 0) {
+            const Segment& prev = segs[k - 1];
+            Segment& seg = segs[k];
+            bool handed = false;
+            if (seg.speculative && !seg.exit.empty()) {
+                SimMode m = ticks[seg.t0].mode;
+                for (size_t e = 0; e < seg.entry.size(); ++e)
+                    for (size_t i = 0; i < prev.exit.size(); ++i)
+                        if (usable(prev, prev.exit[i]) && handoff(prev.exit[i], seg.entry[e], m)) {
+                            seg.entryPrev[e] = (int)i;
+                            break;
+                        }
+                for (auto& s : seg.exit) handed |= usable(seg, s);
+            }
+            if (handed) {
+                firstSpec = std::min(firstSpec, k);
+            } else if (seg.speculative) {
+                rerunExact(w, ticks, prev, seg);
+                ++res.reruns;
+            }
+        }
+        alive = false;
+        for (auto& s : segs[k].exit) alive |= usable(segs[k], s);
+        if (!alive && firstSpec <= k) {
+            // Failure downstream of a speculative handoff proves nothing:
+            // redo the chain exactly from its last exact frontier.
+            for (unsigned j = firstSpec; j <= k; ++j) {
+                rerunExact(w, ticks, segs[j - 1], segs[j]);
+                ++res.reruns;
+                if (segs[j].exit.empty()) { k = j; break; }
+            }
+            firstSpec = S;
+            alive = !segs[k].exit.empty();
+        }
+        reached = k;
+        if (!alive) break;
+    }
+    res.segments = S;
+    for (auto& s : segs) res.states += s.expanded;
+
+    // Walk back from one live state of the last reached segment (or from the
+    // furthest layer of the failing one) to rebuild the input stream, then
+    // replay each segment forward from its entry for the path.
+    const Segment& last = segs[reached];
+    res.passable = reached == S - 1 && alive;
+    std::vector<uint8_t> inputs(T + 1, 0);
+    std::vector<int> entryIdx(reached + 1, 0);
+    {
+        // Index of the chosen state in the last layer of segment `reached`.
+        int idx = 0;
+        if (res.passable) {
+            for (size_t i = 0; i < last.exit.size(); ++i)
+                if (usable(last, last.exit[i])) { idx = (int)i; break; }
+        }
+        for (int k = (int)reached; k >= 0; --k) {
+            const Segment& sg = segs[k];
+            for (int li = (int)sg.layers() - 1; li >= 0; --li) {
+                inputs[sg.t0 + 1 + li] = sg.link(li, idx).press();
+                idx = sg.link(li, idx).parent();
+            }
+            entryIdx[k] = idx;
+            if (k > 0) {
+                idx = sg.entryPrev[idx];
+                if (idx < 0) idx = 0;
+            }
+        }
+    }
+    for (unsigned k = 0; k <= reached; ++k) {
+        const Segment& sg = segs[k];
+        if (sg.entry.empty()) break;
+        State s = sg.entry[std::min<size_t>(entryIdx[k], sg.entry.size() - 1)];
+        int end = sg.t0 + (int)sg.layers();
+        for (int t = sg.t0 + 1; t <= end; ++t) {
+            if (step(w, ticks[t], s, inputs[t]) != kAlive) break;
+            if (t % 3 == 0) res.path.push_back({ticks[t].x, s.y});
+            res.reachedX = ticks[t].x;
+        }
+    }
+    if (res.passable) {
+        bool down = false;
+        float from = 0.f;
+        for (int t = 1; t <= T; ++t) {
+            if (inputs[t] && !down) { down = true; from = ticks[t].x; }
+            else if (!inputs[t] && down) { down = false; res.holds.push_back({from, ticks[t].x}); }
+        }
+        if (down) res.holds.push_back({from, ticks[T].x});
+    } else {
+        int dieTick = std::min(T, last.lastTick + 1);
+        res.blockedX   = ticks[dieTick].x;
+        res.blockedY   = last.causeY;
+        res.reason     = fmt::format("{} ({})", causeText(last.cause),
+                                     simModeName(ticks[dieTick].mode));
+        // Every segment of the failing chain is exact by now (see the
+        // stitch); any of them dropping a state leaves the verdict open.
+        for (unsigned k = 0; k <= reached; ++k)
+            if (segs[k].truncated) res.exhaustive = false;
+        res.modeled    = w.unmodeledX > res.blockedX + HALF + w.maxHalfW;
+        res.reachedX   = std::max(res.reachedX, ticks[last.lastTick].x);
     }
     return res;
 }
 
-// ── Difficulty-curve histogram ──────────────────────────────────────────────
-// Bins hazard density into fixed X windows so the AI can SEE its own pacing.
-// Pure array math over the draft — no allocation surprises, same coordinate
-// sanitation as check().
+// ── Density index ───────────────────────────────────────────────────────────
+// Per-class object counts over 30u cells (one grid column) plus prefix sums,
+// so any [x0, x1) count or density is two prefix lookups plus an exact scan
+// of the two cells the bounds fall in (each cell keeps its objects' X), at
+// any window alignment. The prefix is rebuilt
+// lazily from the lowest dirty cell — appends past the current tail (how
+// drafts grow) only re-sum the tail. One index per source (draft, live
+// editor) is kept current by its owner; every analysis tool reads it
+// instead of rescanning the objects, so calls inside a long tool loop stop
+// scaling with level size. Coarser windows (the 1200u difficulty curve,
+// the inventory's 500u buckets) are just prefix differences.
+enum ObjClass : uint8_t {
+    kSolid, kHazard, kOrb, kPortal, kTrigger, kDeco, kOther, kClassCount
+};
+constexpr uint32_t classBit(ObjClass c) { return 1u << c; }
+constexpr uint32_t kAllClasses      = (1u << kClassCount) - 1;
+// What counts toward level length (computeMaxXFromObjects' rule).
+constexpr uint32_t kLengthClasses   = kAllClasses & ~classBit(kTrigger) & ~classBit(kDeco);
+constexpr uint32_t kBlockingClasses = classBit(kSolid) | classBit(kHazard);
+
+inline ObjClass classifyType(std::string_view t) {
+    if (t.empty()) return kOther;
+    auto has   = [&](std::string_view s) { return t.find(s) != std::string_view::npos; };
+    auto start = [&](std::string_view s) { return t.substr(0, s.size()) == s; };
+    if (has("trigger")) return kTrigger;
+    if (start("decor_") || start("parallax_") || start("particle_") ||
+        t == "effect_pulsing_music_note")
+        return kDeco;
+    if (start("spike_") || start("hazard_") || has("_saw") || has("saw_") ||
+        has("sawblade"))
+        return kHazard;
+    if (has("portal")) return kPortal;
+    if (has("orb") || has("pad")) return kOrb;
+    if (start("block_")) return kSolid;
+    return kOther;
+}
+
+// Live objects: by catalog name, with the trigger IDs the catalog lacks.
+inline ObjClass classifyObjectId(int id) {
+    if (id == 899 || id == 901 || id == 34 || id == 32 || id == 33) return kTrigger;
+    static const auto& idToName = objectIdToName();
+    auto it = idToName.find(id);
+    return it != idToName.end() ? classifyType(it->second) : kOther;
+}
+
 struct CurveWindow { float x0, x1, density; };
-inline std::vector<CurveWindow> difficultyHistogram(const matjson::Value& objectsArray,
-                                                    float windowWidth = 1200.f) {
-    std::vector<CurveWindow> out;
-    if (!objectsArray.isArray() || objectsArray.size() == 0) return out;
-    float maxX = 0.f;
-    std::vector<float> hazardXs;
-    hazardXs.reserve(objectsArray.size() / 4);
-    for (size_t i = 0; i < objectsArray.size(); ++i) {
-        const auto& o = objectsArray[i];
-        if (!o.isObject()) continue;
+
+class DensityIndex {
+public:
+    static constexpr float CELL  = 30.f;
+    static constexpr float MAX_X = 250000.f;   // same sanitation as check()
+
+    void clear() {
+        m_cells.clear();
+        m_objs.clear();
+        m_prefix.assign(1, {});
+        m_dirtyFrom = 0;
+        m_total = {};
+        m_maxX.fill(-1.f);
+    }
+
+    void add(float x, ObjClass c) {
+        if (!std::isfinite(x) || x < 0.f || x > MAX_X) return;
+        size_t cell = (size_t)(x / CELL);
+        if (cell >= m_cells.size()) {
+            m_cells.resize(cell + 1, Counts{});
+            m_objs.resize(cell + 1);
+        }
+        ++m_cells[cell][c];
+        m_objs[cell].push_back({x, c});
+        ++m_total[c];
+        m_dirtyFrom = std::min(m_dirtyFrom, cell);
+        m_maxX[c]   = std::max(m_maxX[c], x);
+    }
+
+    // Draft entries: {"type", "x"}; edit ops and untyped entries are skipped.
+    void addObject(const matjson::Value& o) {
+        if (!o.isObject() || o.contains("op")) return;
         auto typeRes = o["type"].asString();
-        if (!typeRes) continue;
-        const std::string& t = typeRes.unwrap();
-        float x = getFloat(o, "x", 0.f);
-        if (!std::isfinite(x) || x < 0.f || x > 250000.f) continue;
-        bool hazard = t.rfind("spike_", 0) == 0 || t.rfind("hazard_", 0) == 0 ||
-                      t.find("_saw") != std::string::npos ||
-                      t.find("saw_") != std::string::npos;
-        if (hazard) hazardXs.push_back(x);
-        if (isBlockingType(t) && x > maxX) maxX = x;
-    }
-    if (maxX <= 0.f) return out;
-    int windows = std::clamp((int)(maxX / windowWidth) + 1, 1, 64);
-    std::vector<int> counts(windows, 0);
-    for (float x : hazardXs) {
-        int w = (int)(x / windowWidth);
-        if (w >= 0 && w < windows) ++counts[w];
-    }
-    out.reserve(windows);
-    for (int w = 0; w < windows; ++w)
-        out.push_back({w * windowWidth, (w + 1) * windowWidth,
-                       counts[w] / windowWidth * 1000.f});
-    return out;
+        if (!typeRes) return;
+        add(getFloat(o, "x", -1.f), classifyType(typeRes.unwrap()));
+    }
+
+    // Objects with x in [x0, x1) whose class is in `mask`.
+    int count(float x0, float x1, uint32_t mask = kAllClasses) const {
+        if (m_cells.empty() || x1 <= x0) return 0;
+        rebuildPrefix();
+        return below(x1, mask) - below(x0, mask);
+    }
+    // Objects per 1000u over [x0, x1).
+    float per1000(float x0, float x1, uint32_t mask = kAllClasses) const {
+        return x1 > x0 ? count(x0, x1, mask) / (x1 - x0) * 1000.f : 0.f;
+    }
+    int total(uint32_t mask = kAllClasses) const {
+        int n = 0;
+        for (int c = 0; c < kClassCount; ++c)
+            if (mask & (1u << c)) n += m_total[c];
+        return n;
+    }
+    // Furthest X among `mask` classes (0 when none).
+    float maxX(uint32_t mask = kAllClasses) const {
+        float m = 0.f;
+        for (int c = 0; c < kClassCount; ++c)
+            if (mask & (1u << c)) m = std::max(m, m_maxX[c]);
+        return m;
+    }
+
+    // Fixed windows of `width` from 0 to the furthest `extentMask` object,
+    // density of `mask` classes per 1000u, at most `maxWindows` windows.
+    std::vector<CurveWindow> histogram(float width, uint32_t mask, uint32_t extentMask,
+                                       int maxWindows = 64) const {
+        std::vector<CurveWindow> out;
+        float end = maxX(extentMask);
+        if (end <= 0.f || width <= 0.f) return out;
+        int windows = std::clamp((int)(end / width) + 1, 1, maxWindows);
+        out.reserve(windows);
+        for (int w = 0; w < windows; ++w) {
+            float x0 = w * width, x1 = x0 + width;
+            out.push_back({x0, x1, per1000(x0, x1, mask)});
+        }
+        return out;
+    }
+
+private:
+    using Counts = std::array<int32_t, kClassCount>;
+    struct Entry { float x; ObjClass c; };
+    std::vector<Counts>         m_cells;
+    std::vector<std::vector<Entry>> m_objs;   // per cell, for the edge scans
+    mutable std::vector<Counts> m_prefix = std::vector<Counts>(1);  // [i] = cells [0, i)
+    mutable size_t              m_dirtyFrom = 0;
+    std::array<int32_t, kClassCount> m_total{};
+    std::array<float, kClassCount>   m_maxX = [] {
+        std::array<float, kClassCount> a; a.fill(-1.f); return a;
+    }();
+
+    // Objects with X < x in `mask`: the whole cells before x's cell from
+    // the prefix, then x's own cell scanned exactly. Prefix must be current.
+    int below(float x, uint32_t mask) const {
+        if (!(x > 0.f)) return 0;
+        size_t cell = std::min(m_cells.size(), (size_t)(std::min(x, MAX_X + CELL) / CELL));
+        int n = 0;
+        for (int c = 0; c < kClassCount; ++c)
+            if (mask & (1u << c)) n += m_prefix[cell][c];
+        if (cell < m_objs.size())
+            for (const auto& e : m_objs[cell])
+                if (e.x < x && (mask & classBit(e.c))) ++n;
+        return n;
+    }
+    void rebuildPrefix() const {
+        if (m_dirtyFrom >= m_cells.size() && m_prefix.size() == m_cells.size() + 1) return;
+        m_prefix.resize(m_cells.size() + 1);
+        for (size_t i = m_dirtyFrom; i < m_cells.size(); ++i)
+            for (int c = 0; c < kClassCount; ++c)
+                m_prefix[i + 1][c] = m_prefix[i][c] + m_cells[i][c];
+        m_dirtyFrom = m_cells.size();
+    }
+};
+
+// ── Difficulty-curve histogram ──────────────────────────────────────────────
+// Hazard density in fixed X windows so the AI can SEE its own pacing; the
+// span runs to the furthest blocking object.
+inline std::vector<CurveWindow> difficultyHistogram(const DensityIndex& idx,
+                                                    float windowWidth = 1200.f) {
+    return idx.histogram(windowWidth, classBit(kHazard), kBlockingClasses);
 }
 
 } // namespace levelcheck
@@ -5391,27 +7120,13 @@ namespace macros {
     // Per-object x/y are NEVER copied (those come from the macro's own math).
     // type isn't copied either (each macro chooses its own type per-step).
     //
-    // The keys mirror what EAS's applyCommonFields attaches to single objects
-    // — so a `FLOOR 0..900 color=4 scale=1.2` line and a row of individual
-    // `BLOCK x y color=4 scale=1.2` lines produce identical objects.
+    // The keys are the props schema's Obj rows — exactly what EAS's
+    // applyCommonFields attaches to single objects — plus the JSON-only Copy
+    // rows, so a `FLOOR 0..900 color=4 scale=1.2` line and a row of
+    // individual `BLOCK x y color=4 scale=1.2` lines produce identical objects.
     static void applyMacroPassthroughs(matjson::Value& obj, const matjson::Value& p) {
-        static const std::vector<const char*> COPY_KEYS = {
-            "color_channel", "detail_color_channel",
-            "groups",
-            "scale", "rotation",
-            "z_layer", "z_order",
-            "editor_layer", "editor_layer_2",
-            "multi_activate",
-            "flip_x", "flip_y",
-            "main_color", "detail_color",
-            "copy_color_channel", "copy_color_hsv",
-            // 2.2 editor flags — `FLOOR 0..900 passable` must reach every
-            // child block the macro emits.
-            "passable", "no_touch", "hide", "no_glow",
-            "dont_fade", "dont_enter", "high_detail", "no_effects",
-        };
         if (!p.isObject()) return;
-        for (auto k : COPY_KEYS) {
+        for (auto k : props::passthroughKeys()) {
             if (!p.contains(k)) continue;
             // Per-object fields the macro set on its own (rare) take priority.
             if (obj.contains(k)) continue;
@@ -5925,8 +7640,10 @@ namespace macros {
 // can override the template ad-hoc.
 //
 // Keyed by the same "type" name the AI uses in objects (e.g.
-// "block_black_gradient_square"). Empty map = no templates.
-static std::unordered_map<std::string, matjson::Value> s_blockTemplates;
+// "block_black_gradient_square"). Empty map = no templates. Expansions that
+// only simulate (eas::expandScript) pass their own map instead.
+using BlockTemplates = std::unordered_map<std::string, matjson::Value>;
+static BlockTemplates s_blockTemplates;
 
 // Reset templates whenever a generation starts so old templates don't bleed
 // into a fresh prompt. Called from prepareObjects.
@@ -5963,7 +7680,9 @@ namespace macros {
     // earlier in the same macros array.
     static bool expand(const std::string& name,
                        const matjson::Value& params,
-                       std::vector<matjson::Value>& out_objects)
+                       std::vector<matjson::Value>& out_objects,
+                       bool quiet = false,
+                       BlockTemplates& templates = s_blockTemplates)
     {
         // block_template doesn't produce objects — it stores a template
         // that applies to all future objects of the given type. Accept the
@@ -5979,8 +7698,8 @@ namespace macros {
                 log::warn("block_template: 'properties' is not an object — skipping");
                 return false;
             }
-            s_blockTemplates[typeRes.unwrap()] = props;
-            log::info("Block template set for type '{}' ({} props)",
+            templates[typeRes.unwrap()] = props;
+            if (!quiet) log::info("Block template set for type '{}' ({} props)",
                       typeRes.unwrap(), (int)props.size());
             return true;
         }
@@ -6045,16 +7764,19 @@ namespace macros {
             // sneak past and overwrite fields on re-emitted objects.
             applyMacroPassthroughs(r, params);
         }
-        log::info("Macro '{}' expanded to {} objects", name, r.size());
+        if (!quiet) log::info("Macro '{}' expanded to {} objects", name, r.size());
         for (auto& obj : r) out_objects.push_back(std::move(obj));
         return true;
     }
 
     // Iterates a "macros" array from the AI response and appends every
     // expansion into out_objects. Each entry must be an object with a "name"
-    // string; any other fields are passed verbatim as params.
+    // string; any other fields are passed verbatim as params. `quiet`
+    // silences the per-macro log lines (internal verification passes).
     static void expandAll(const matjson::Value& macrosArray,
-                          std::vector<matjson::Value>& out_objects)
+                          std::vector<matjson::Value>& out_objects,
+                          bool quiet = false,
+                          BlockTemplates& templates = s_blockTemplates)
     {
         if (!macrosArray.isArray()) return;
         int totalBefore = (int)out_objects.size();
@@ -6066,31 +7788,1217 @@ namespace macros {
                 log::warn("EditorAI: macro entry {} has no 'name' — skipping", i);
                 continue;
             }
-            expand(nameRes.unwrap(), entry, out_objects);
+            expand(nameRes.unwrap(), entry, out_objects, quiet, templates);
         }
-        log::info("Macros: expanded {} objects total", (int)out_objects.size() - totalBefore);
+        if (!quiet)
+            log::info("Macros: expanded {} objects total", (int)out_objects.size() - totalBefore);
     }
 } // namespace macros
 
-// ─── Blueprint preview shared state ─────────────────────────────────────────
-// These statics are shared between AIGeneratorPopup (which creates ghost objects)
-// and AIEditorUI (which shows accept/deny buttons). Using statics avoids a
-// circular dependency between the two classes.
-
-static bool s_inPreviewMode = false;
-static bool s_inEditMode   = false;  // user is editing accepted objects before clicking Done
-static std::vector<Ref<GameObject>> s_previewObjects;
-// Layer-based preview: generated objects land on their OWN editor layer and
-// the editor switches to it — GD fades every other layer, so the new build
-// shows in full color against the dimmed level (no tints, no opacity hacks).
-// Per preview object: the editor layer(s) it should END on after Accept
-// (the AI-assigned editor_layer, captured before the preview override).
-static std::vector<std::pair<short, short>> s_previewIntendedLayers;
-static short s_previewLayer            = -1;  // layer the preview lives on
-static short s_editorLayerBeforePreview = -1; // restored on accept/deny/edit
+// ─── Compressing EAS serializer ──────────────────────────────────────────────
+// objectsToEAS spends one line per object, which caps how much of a big
+// level fits in a model's context. objectsToEASCompact mines the same
+// output for structure and re-expresses it with the existing verbs:
+//   evenly spaced rows    → FLOOR (30-spaced blocks), SPIKE-TRAIN, ROW
+//   vertical block stacks → PILLAR;  diagonal runs → STAIR-UP
+//   repeated / mirrored sections → COPY / MIRROR over the macro output
+// Round-trip guarantee: the result is re-parsed and macro-expanded and must
+// reproduce exactly the objects the plain serialization reproduces (as a
+// multiset, positions snapped to 0.1). On any mismatch it retries without
+// COPY/MIRROR, then returns the plain text — never a lossy compaction.
+// Every COPY/MIRROR line sits right after its source window, so any line
+// prefix of the result is itself a valid script: a byte budget cuts at the
+// last whole line that fits (fitBudget) and loses only the level's tail.
+// Lives after `macros` because it simulates expansion to verify itself.
+namespace eas {
 
-// Switch the editor's visible layer + keep GD's own label in sync.
-static void setEditorCurrentLayer(LevelEditorLayer* lel, short layer) {
+// Order-independent identity of one object: sorted key=value pairs, x/y
+// snapped to 0.1 units so macro float math (x0 + i*step) never reads as
+// a difference.
+inline std::string objectSignature(const matjson::Value& o) {
+    std::vector<std::string> parts;
+    for (auto& [k, v] : o) {
+        if (k == "x" || k == "y") {
+            auto d = v.asDouble();
+            parts.push_back(fmt::format("{}={}", k, d ? std::llround(d.unwrap() * 10.0) : 0));
+        } else {
+            parts.push_back(k + "=" + v.dump(matjson::NO_INDENTATION));
+        }
+    }
+    std::sort(parts.begin(), parts.end());
+    std::string out;
+    for (auto& part : parts) { out += part; out += ';'; }
+    return out;
+}
+
+// Objects a script produces: direct objects + quiet macro expansion. Like
+// the apply path, macros expand into their own vector, so COPY/MIRROR only
+// ever see earlier macro output. Block templates land in a throwaway map:
+// simulating a script never touches the generation's templates, and the
+// whole serializer stays safe to run on a worker.
+inline std::vector<matjson::Value> expandScript(std::string_view script) {
+    std::vector<matjson::Value> out;
+    auto r = parse(script);
+    if (r.root.contains("objects") && r.root["objects"].isArray())
+        for (auto& o : r.root["objects"]) out.push_back(o);
+    if (r.root.contains("macros") && r.root["macros"].isArray()) {
+        std::vector<matjson::Value> expanded;
+        BlockTemplates templates;
+        macros::expandAll(r.root["macros"], expanded, /*quiet*/ true, templates);
+        for (auto& o : expanded) out.push_back(std::move(o));
+    }
+    return out;
+}
+
+inline std::unordered_map<std::string, int>
+signatureCounts(const std::vector<matjson::Value>& objs) {
+    std::unordered_map<std::string, int> m;
+    for (auto& o : objs) ++m[objectSignature(o)];
+    return m;
+}
+
+// Prompt-context budget shared by every caller that embeds a level.
+static constexpr size_t CONTEXT_BUDGET = 24000;
+
+// Cuts `script` after its last whole line within `budget` bytes (0 = no
+// limit) and says so, so the model knows the level goes on.
+inline std::string fitBudget(std::string script, size_t budget) {
+    static constexpr std::string_view NOTE = "# (level truncated for context)\n";
+    if (budget == 0 || script.size() <= budget) return script;
+    size_t keep = budget > NOTE.size() ? budget - NOTE.size() : 0;
+    size_t nl = script.rfind('\n', keep ? keep - 1 : 0);
+    script.resize(nl == std::string::npos || keep == 0 ? 0 : nl + 1);
+    script += NOTE;
+    return script;
+}
+
+inline std::string objectsToEASCompact(const matjson::Value& objectsArray,
+                                       float groundY = 105.f, size_t budget = 0) {
+    std::string plain = objectsToEAS(objectsArray, groundY);
+    if (plain.empty()) return plain;
+
+    auto fmtNum = [](double v) -> std::string {
+        double r = std::round(v);
+        if (std::abs(v - r) < 0.01) return fmt::format("{}", (long long)r);
+        return fmt::format("{:.1f}", v);
+    };
+
+    // ── Split the plain text back into per-line items. Each line's own
+    //    parse is its canonical object — the compaction target.
+    struct Item {
+        std::string line, type, suffix;   // suffix = common fields, verbatim
+        float x = 0, y = 0;
+        bool  obj  = false;               // OBJ line (minable) vs TRIGGER
+        bool  used = false;
+        size_t canon = 0;                 // index into `canonical`
+    };
+    std::vector<Item> items;
+    std::vector<matjson::Value> canonical;
+    {
+        size_t pos = 0;
+        while (pos < plain.size()) {
+            size_t nl = plain.find('\n', pos);
+            if (nl == std::string::npos) nl = plain.size();
+            std::string line = plain.substr(pos, nl - pos);
+            pos = nl + 1;
+            if (line.empty()) continue;
+            auto objs = expandScript(line);
+            if (objs.size() != 1) {           // defensive: keep verbatim
+                for (auto& o : objs) canonical.push_back(std::move(o));
+                items.push_back({std::move(line)});
+                items.back().used = true;
+                continue;
+            }
+            Item it;
+            it.line = line;
+            it.x = (float)objs[0]["x"].asDouble().unwrapOr(0.0);
+            it.y = (float)objs[0]["y"].asDouble().unwrapOr(0.0);
+            it.canon = canonical.size();
+            if (line.rfind("OBJ ", 0) == 0) {
+                // OBJ <type> <x> [<y>] <suffix...>
+                size_t a = 4, b = line.find(' ', a);
+                it.type = line.substr(a, b - a);
+                size_t c = b == std::string::npos ? b : line.find(' ', b + 1);
+                if (c != std::string::npos) {
+                    size_t d = line.find(' ', c + 1);
+                    std::string tok = line.substr(c + 1, d == std::string::npos ? d : d - c - 1);
+                    if (isNumericTok(tok)) c = d;
+                }
+                it.suffix = c == std::string::npos ? "" : line.substr(c);
+                it.obj = true;
+            }
+            canonical.push_back(std::move(objs[0]));
+            items.push_back(std::move(it));
+        }
+    }
+    const auto want = signatureCounts(canonical);
+
+    struct Unit {
+        std::string line;
+        float x0 = 0, x1 = 0;
+        bool  macro = false;               // output visible to COPY/MIRROR
+        std::string shape;                 // translation-invariant form
+        std::vector<matjson::Value> objs;  // expansion (macro units)
+        bool  removed = false;
+    };
+    std::vector<Unit> units;
+    // A mined line replaces the items in `covered` only if it expands to
+    // exactly their objects — catches float drift in ROW/FLOOR counts and
+    // 0.1-rounded steps locally instead of failing the whole result.
+    auto addUnit = [&](std::string line, std::string shape, float x0, float x1,
+                       bool macro, const std::vector<size_t>& covered) {
+        Unit u;
+        u.x0 = x0; u.x1 = x1; u.macro = macro;
+        u.shape = std::move(shape);
+        if (!covered.empty()) {
+            auto objs = expandScript(line);
+            std::vector<matjson::Value> expect;
+            for (size_t i : covered) expect.push_back(canonical[items[i].canon]);
+            if (signatureCounts(objs) != signatureCounts(expect)) return false;
+            if (macro) u.objs = std::move(objs);
+            for (size_t i : covered) items[i].used = true;
+        }
+        u.line = std::move(line);
+        units.push_back(std::move(u));
+        return true;
+    };
+
+    static const std::unordered_map<std::string, std::string> SPIKE_WORDS = {
+        {"spike_black_gradient_spike", ""},
+        {"spike_black_gradient_tiny_spike", "tiny"},
+        {"spike_colored_small_spike", "small"},
+        {"spike_colored_half_spike", "half"},
+        {"spike_colored_spike", "colored"},
+        {"spike_black_pit_hazard", "pit"},
+        {"spike_black_slope_hazard", "slope"},
+    };
+    // PILLAR / STAIR-UP take no type — only the default block round-trips.
+    static const std::string DEFAULT_BLOCK = "block_black_gradient_square";
+    auto approx = [](float a, float b) { return std::abs(a - b) < 0.05f; };
+
+    // Minable items grouped by style (type + common fields).
+    std::map<std::string, std::vector<size_t>> styles;
+    for (size_t i = 0; i < items.size(); ++i)
+        if (items[i].obj) styles[items[i].type + "|" + items[i].suffix].push_back(i);
+
+    // ── Horizontal runs (FLOOR / SPIKE-TRAIN / ROW) ────────────────────────
+    for (auto& [key, idx] : styles) {
+        std::sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+            if (!approx(items[a].y, items[b].y)) return items[a].y < items[b].y;
+            return items[a].x < items[b].x;
+        });
+        for (size_t i = 0; i + 2 < idx.size();) {
+            const auto& first = items[idx[i]];
+            float step = items[idx[i + 1]].x - first.x;
+            size_t j = i + 1;
+            if (approx(items[idx[j]].y, first.y) && step >= 5.f)
+                while (j + 1 < idx.size() && approx(items[idx[j + 1]].y, first.y) &&
+                       approx(items[idx[j + 1]].x - items[idx[j]].x, step))
+                    ++j;
+            size_t len = j - i + 1;
+            if (len < 3 || !approx(items[idx[j]].y, first.y) || step < 5.f) { ++i; continue; }
+
+            const std::string& type = first.type;
+            const std::string& suf  = first.suffix;
+            bool isFloor = type.rfind("block_", 0) == 0 && approx(step, 30.f) &&
+                           OBJECT_IDS.count(type);
+            auto spikeIt = SPIKE_WORDS.find(type);
+            bool isTrain = !isFloor && spikeIt != SPIKE_WORDS.end() && step >= 15.f;
+            size_t cap = isFloor || isTrain ? 200 : 300;
+            for (size_t k = i; k <= j; k += cap) {
+                size_t n = std::min(cap, j - k + 1);
+                float x0 = items[idx[k]].x, x1 = items[idx[k + n - 1]].x;
+                auto render = [&](float ox) {
+                    if (isFloor)
+                        return fmt::format("FLOOR {}..{} y={} type={}{}", fmtNum(x0 - ox),
+                                           fmtNum(x1 - ox), fmtNum(first.y), type, suf);
+                    if (isTrain)
+                        return fmt::format("SPIKE-TRAIN {} count={} spacing={} y={}{}{}",
+                                           fmtNum(x0 - ox), n, fmtNum(step), fmtNum(first.y),
+                                           spikeIt->second.empty() ? "" : " type=" + spikeIt->second,
+                                           suf);
+                    return fmt::format("ROW {} {}..{} y={} step={}{}", type, fmtNum(x0 - ox),
+                                       fmtNum(x1 - ox), fmtNum(first.y), fmtNum(step), suf);
+                };
+                addUnit(render(0.f), render(x0), x0, x1, isFloor || isTrain,
+                        std::vector<size_t>(idx.begin() + k, idx.begin() + k + n));
+            }
+            i = j + 1;
+        }
+    }
+
+    // ── Vertical stacks (PILLAR) and diagonal runs (STAIR-UP) ──────────────
+    // Position index over the still-unused default blocks, per style.
+    auto cell = [](float x, float y) {
+        return ((int64_t)std::llround(x * 10.0) << 32) ^ (uint32_t)std::llround(y * 10.0);
+    };
+    for (auto& [key, idx] : styles) {
+        if (idx.empty() || items[idx[0]].type != DEFAULT_BLOCK) continue;
+        std::unordered_map<int64_t, size_t> at;
+        for (size_t i : idx) if (!items[i].used) at[cell(items[i].x, items[i].y)] = i;
+        std::vector<size_t> order;
+        for (size_t i : idx) if (!items[i].used) order.push_back(i);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if (!approx(items[a].x, items[b].x)) return items[a].x < items[b].x;
+            return items[a].y < items[b].y;
+        });
+        auto chain = [&](size_t start, float dx, float dy, size_t cap) {
+            std::vector<size_t> c{start};
+            while (c.size() < cap) {
+                const auto& last = items[c.back()];
+                auto f = at.find(cell(last.x + dx, last.y + dy));
+                if (f == at.end() || items[f->second].used) break;
+                c.push_back(f->second);
+            }
+            return c;
+        };
+        for (size_t s0 : order) {
+            if (items[s0].used) continue;
+            const auto& st = items[s0];
+            auto col = chain(s0, 0.f, 30.f, 50);
+            if (col.size() >= 3) {
+                float yTop = items[col.back()].y;
+                auto render = [&](float ox) {
+                    return fmt::format("PILLAR {} y_bot={} y_top={}{}", fmtNum(st.x - ox),
+                                       fmtNum(st.y), fmtNum(yTop), st.suffix);
+                };
+                if (addUnit(render(0.f), render(st.x), st.x, st.x, true, col)) continue;
+            }
+            std::vector<size_t> best;
+            float bw = 0, bh = 0;
+            for (float w : {30.f, 15.f, 60.f})
+                for (float h : {30.f, 15.f, 60.f}) {
+                    auto c = chain(s0, w, h, 50);
+                    if (c.size() > best.size()) { best = std::move(c); bw = w; bh = h; }
+                }
+            if (best.size() >= 3) {
+                size_t n = best.size();
+                float x1 = items[best.back()].x;
+                auto render = [&](float ox) {
+                    return fmt::format("STAIR-UP {} steps={} step-w={} step-h={} y={}{}",
+                                       fmtNum(st.x - ox), n, fmtNum(bw), fmtNum(bh),
+                                       fmtNum(st.y), st.suffix);
+                };
+                addUnit(render(0.f), render(st.x), st.x, x1, true, best);
+            }
+        }
+    }
+
+    // Everything unmined stays a plain line (shape empty: never a COPY target).
+    for (auto& it : items)
+        if (!it.obj || !it.used) addUnit(it.line, "", it.x, it.x, false, {});
+
+    // ── Repeated / mirrored sections (COPY / MIRROR) ───────────────────────
+    // COPY/MIRROR re-emit every MACRO-produced object in their source window,
+    // so they're simulated against exactly that pool. The pool is invariant
+    // (a region op reproduces the units it replaces), but a replaced unit's
+    // objects appear only AFTER its op line — so units inside an accepted
+    // source window are pinned and may not be replaced later.
+    struct RegionOp { std::string line; float lo, hi; };
+    auto mineRegions = [&](std::vector<RegionOp>& ops) {
+        std::vector<const matjson::Value*> pool;
+        for (auto& u : units)
+            if (u.macro) for (auto& o : u.objs) pool.push_back(&o);
+        std::vector<size_t> order;
+        for (size_t i = 0; i < units.size(); ++i)
+            if (units[i].macro && !units[i].shape.empty()) order.push_back(i);
+        std::sort(order.begin(), order.end(),
+                  [&](size_t a, size_t b) { return units[a].x0 < units[b].x0; });
+        auto pinned = [&](const Unit& u) {
+            for (auto& op : ops) if (u.x1 >= op.lo && u.x0 <= op.hi) return true;
+            return false;
+        };
+        auto stripFlip = [](std::string sh) {
+            auto p = sh.find(" flip_x");
+            if (p != std::string::npos) sh.erase(p, 7);
+            return sh;
+        };
+
+        // Candidate transforms ranked by how many unit pairs they explain.
+        // mirror=false: x → x + t (COPY offset t); true: x → 2t - x (axis t).
+        struct Cand { bool mirror; float t; int votes; };
+        std::map<std::pair<bool, int64_t>, int> votes;
+        for (size_t a = 0; a < order.size(); ++a)
+            for (size_t b = a + 1; b < order.size() && b < a + 64; ++b) {
+                const auto& u = units[order[a]];
+                const auto& v = units[order[b]];
+                if (v.x0 <= u.x1) continue;
+                if (u.shape == v.shape)
+                    ++votes[{false, std::llround((v.x0 - u.x0) * 10.0)}];
+                else if (v.shape.find(" flip_x") != std::string::npos &&
+                         stripFlip(u.shape) == stripFlip(v.shape))
+                    ++votes[{true, std::llround((u.x0 + v.x1) * 5.0)}];  // axis*10
+            }
+        std::vector<Cand> cands;
+        for (auto& [k, n] : votes)
+            if (n >= 2) cands.push_back({k.first, (float)(k.second / 10.0), n});
+        std::sort(cands.begin(), cands.end(),
+                  [](const Cand& a, const Cand& b) { return a.votes > b.votes; });
+        if (cands.size() > 6) cands.resize(6);
+
+        // Partner lookup, built once: shape → x0 (COPY sources) and
+        // unflipped shape → x1 (MIRROR sources) on the 0.1 grid.
+        auto gridKey = [](const std::string& shape, float x) {
+            return fmt::format("{}|{}", shape, std::llround(x * 10.0));
+        };
+        std::unordered_multimap<std::string, size_t> byX0, byFlatX1;
+        for (size_t i : order) {
+            byX0.emplace(gridKey(units[i].shape, units[i].x0), i);
+            byFlatX1.emplace(gridKey(stripFlip(units[i].shape), units[i].x1), i);
+        }
+        // Any unit other than `self` filed under `shape` within approx() of x.
+        auto partner = [&](const std::unordered_multimap<std::string, size_t>& index,
+                           const std::string& shape, float x, bool atX1, size_t self) {
+            int64_t g = std::llround(x * 10.0);
+            for (int64_t d = -1; d <= 1; ++d) {
+                auto [lo, hi] = index.equal_range(fmt::format("{}|{}", shape, g + d));
+                for (auto it = lo; it != hi; ++it)
+                    if (it->second != self &&
+                        approx(atX1 ? units[it->second].x1 : units[it->second].x0, x))
+                        return true;
+            }
+            return false;
+        };
+
+        for (auto& cd : cands) {
+            // Target units: each has a same-shape partner where the
+            // transform says its source is.
+            auto isTarget = [&](size_t ui) {
+                const Unit& u = units[ui];
+                if (u.removed || pinned(u)) return false;
+                if (!cd.mirror) return partner(byX0, u.shape, u.x0 - cd.t, false, ui);
+                return u.shape.find(" flip_x") != std::string::npos &&
+                       partner(byFlatX1, stripFlip(u.shape), 2 * cd.t - u.x0, true, ui);
+            };
+            // Try a group of target units as one op; returns true if taken.
+            auto tryGroup = [&](const std::vector<size_t>& group) {
+                float tlo = 1e30f, thi = -1e30f;
+                size_t lineBytes = 0;
+                std::vector<matjson::Value> need;
+                for (size_t i : group) {
+                    tlo = std::min(tlo, units[i].x0);
+                    thi = std::max(thi, units[i].x1);
+                    lineBytes += units[i].line.size();
+                    for (auto& o : units[i].objs) need.push_back(o);
+                }
+                // Source window, widened a hair and snapped to the 0.1 grid
+                // fmtNum prints, so the simulation sees the exact bounds the
+                // parser will read back.
+                float slo = std::floor((cd.mirror ? 2 * cd.t - thi : tlo - cd.t) * 10.f - 0.5f) / 10.f;
+                float shi = std::ceil((cd.mirror ? 2 * cd.t - tlo : thi - cd.t) * 10.f + 0.5f) / 10.f;
+                if (shi >= tlo) return false;   // windows must not overlap
+                std::vector<matjson::Value> got;
+                for (auto* o : pool) {
+                    float x = (float)(*o)["x"].asDouble().unwrapOr(0.0);
+                    if (x < slo || x > shi) continue;
+                    auto c = *o;
+                    c["x"] = cd.mirror ? (double)(2 * cd.t - x) : (double)(x + cd.t);
+                    if (cd.mirror) c["flip_x"] = true;
+                    got.push_back(std::move(c));
+                }
+                if (got.empty() || got.size() > 200) return false;
+                if (signatureCounts(got) != signatureCounts(need)) return false;
+                std::string line = cd.mirror
+                    ? fmt::format("MIRROR axis={} from={}..{}", fmtNum(cd.t),
+                                  fmtNum(slo), fmtNum(shi))
+                    : fmt::format("COPY from={}..{} offset={}",
+                                  fmtNum(slo), fmtNum(shi), fmtNum(cd.t));
+                if (group.size() < 2 && line.size() >= lineBytes) return false;
+                for (size_t i : group) units[i].removed = true;
+                ops.push_back({std::move(line), slo, shi});
+                return true;
+            };
+            std::vector<size_t> group;
+            auto flush = [&] {
+                if (group.empty()) return;
+                if (!tryGroup(group))
+                    for (size_t i : group) tryGroup({i});
+                group.clear();
+            };
+            for (size_t i : order) {
+                if (isTarget(i)) group.push_back(i);
+                else if (!units[i].removed) flush();
+            }
+            flush();
+        }
+    };
+
+    // Units by x0, each op right after the last unit that can feed its
+    // source window (every unit with x0 <= hi). Ops whose targets sit in a
+    // later op's window have a lower hi, so they still come first.
+    auto render = [&](std::vector<RegionOp> ops) {
+        std::vector<const Unit*> live;
+        for (auto& u : units) if (!u.removed) live.push_back(&u);
+        std::stable_sort(live.begin(), live.end(),
+                         [](const Unit* a, const Unit* b) { return a->x0 < b->x0; });
+        std::stable_sort(ops.begin(), ops.end(),
+                         [](const RegionOp& a, const RegionOp& b) { return a.hi < b.hi; });
+        std::string out;
+        out.reserve(plain.size() / 2);
+        out += fmt::format("# compact: {} objects (COPY/MIRROR re-emit earlier macro output)\n",
+                           canonical.size());
+        size_t k = 0;
+        for (auto* u : live) {
+            for (; k < ops.size() && ops[k].hi < u->x0; ++k) { out += ops[k].line; out += '\n'; }
+            out += u->line;
+            out += '\n';
+        }
+        for (; k < ops.size(); ++k) { out += ops[k].line; out += '\n'; }
+        return out;
+    };
+
+    std::vector<RegionOp> ops;
+    mineRegions(ops);
+    std::string out = render(ops);
+    if (signatureCounts(expandScript(out)) == want && out.size() < plain.size())
+        return fitBudget(std::move(out), budget);
+    if (!ops.empty()) {
+        for (auto& u : units) u.removed = false;
+        out = render({});
+        if (signatureCounts(expandScript(out)) == want && out.size() < plain.size())
+            return fitBudget(std::move(out), budget);
+    }
+    log::debug("Compact EAS: no verified saving - using the plain serialization");
+    return fitBudget(std::move(plain), budget);
+}
+
+} // namespace eas
+
+// ─── Draft patching ──────────────────────────────────────────────────────────
+// MOVE/DELETE/EDIT over the in-memory draft (the generation's accumulator)
+// instead of the live editor, so refinement, fix and review rounds — and
+// the speculative-draft patch — can change what they already produced
+// rather than layering hide/move triggers on top of it. Every draft object
+// carries a stable id (ids[i] names objs[i], ascending along the array,
+// never reused within a generation): #n / #a-b select by id, so a listing
+// stays valid after later rounds add or delete. rect:/id:/group: select the
+// same way the live resolver does. Deletes are applied last.
+namespace draftpatch {
+
+struct Stats { int moved = 0, deleted = 0, edited = 0, missed = 0; };
+
+inline int typeIdOf(const matjson::Value& o) {
+    auto it = OBJECT_IDS.find(levelcheck::getStr(o, "type", ""));
+    return it != OBJECT_IDS.end() ? it->second : 0;
+}
+
+// Indices of the draft objects an op's selector picks.
+inline std::vector<size_t> select(const matjson::Value& objs,
+                                  const std::vector<uint32_t>& ids,
+                                  const levelcheck::TriggerGraph& graph,
+                                  const std::vector<bool>& dead,
+                                  const matjson::Value& op) {
+    std::vector<size_t> out;
+    std::string sel = levelcheck::getStr(op, "sel", "");
+    if (sel.empty()) return out;
+
+    int filterId = (int)levelcheck::getFloat(op, "filter_id", 0.f);
+    std::string filterType = levelcheck::getStr(op, "filter_type", "");
+    if (!filterType.empty() && filterId == 0) {
+        auto it = OBJECT_IDS.find(filterType);
+        if (it != OBJECT_IDS.end()) filterId = it->second;
+    }
+    auto take = [&](size_t i) {
+        if (i >= objs.size() || dead[i] || !objs[i].isObject()) return;
+        if (filterId != 0 && typeIdOf(objs[i]) != filterId) return;
+        out.push_back(i);
+    };
+
+    if (sel[0] == '#') {
+        std::string body = sel.substr(1);
+        auto dash = body.find('-');
+        int a = geode::utils::numFromString<int>(body.substr(0, dash)).unwrapOr(-1);
+        int b = dash == std::string::npos
+            ? a : geode::utils::numFromString<int>(body.substr(dash + 1)).unwrapOr(-1);
+        if (a < 0 || b < a) return out;
+        auto it = std::lower_bound(ids.begin(), ids.end(), (uint32_t)a);
+        for (; it != ids.end() && *it <= (uint32_t)b; ++it) take(it - ids.begin());
+        return out;
+    }
+    if (sel.rfind("group:", 0) == 0) {
+        int g = geode::utils::numFromString<int>(sel.substr(6)).unwrapOr(0);
+        if (g > 0)
+            for (uint32_t node : graph.members(g)) take(node);
+        return out;
+    }
+
+    float rx0 = 0, ry0 = 0, rx1 = 0, ry1 = 0;
+    bool useRect = false;
+    if (sel.rfind("rect:", 0) == 0) {
+        std::array<float, 4> v{};
+        size_t pos = 5;
+        int got = 0;
+        while (got < 4 && pos <= sel.size()) {
+            size_t comma = sel.find(',', pos);
+            v[got++] = eas::tryFloat(sel.substr(pos,
+                comma == std::string::npos ? std::string::npos : comma - pos), 0.f);
+            if (comma == std::string::npos) break;
+            pos = comma + 1;
+        }
+        if (got < 4) return out;
+        rx0 = std::min(v[0], v[2]); rx1 = std::max(v[0], v[2]);
+        ry0 = std::min(v[1], v[3]); ry1 = std::max(v[1], v[3]);
+        useRect = true;
+    } else if (sel.rfind("id:", 0) == 0) {
+        std::string body = sel.substr(3);
+        int id = geode::utils::numFromString<int>(body).unwrapOr(0);
+        if (id == 0) {
+            auto it = OBJECT_IDS.find(body);
+            if (it != OBJECT_IDS.end()) id = it->second;
+        }
+        if (id == 0) return out;
+        filterId = id;
+    } else {
+        return out;
+    }
+    for (size_t i = 0; i < objs.size(); ++i) {
+        if (useRect) {
+            const auto& o = objs[i];
+            float x = levelcheck::getFloat(o, "x", 0.f), y = levelcheck::getFloat(o, "y", 0.f);
+            if (x < rx0 || x > rx1 || y < ry0 || y > ry1) continue;
+        }
+        take(i);
+    }
+    return out;
+}
+
+// Run every op against the draft in place (ids stay aligned). EDIT covers
+// the same fields applyEditOps executes on live objects.
+inline Stats apply(matjson::Value& objs, std::vector<uint32_t>& ids,
+                   const std::vector<matjson::Value>& ops) {
+    Stats st;
+    if (!objs.isArray() || ids.size() != objs.size()) return st;
+    levelcheck::TriggerGraph graph;
+    graph.build(objs);
+    std::vector<bool> dead(objs.size(), false);
+    for (const auto& op : ops) {
+        std::string kind = levelcheck::getStr(op, "op", "");
+        auto targets = select(objs, ids, graph, dead, op);
+        if (targets.empty()) { ++st.missed; continue; }
+        if (kind == "move") {
+            float dx = levelcheck::getFloat(op, "dx", 0.f);
+            float dy = levelcheck::getFloat(op, "dy", 0.f);
+            for (size_t i : targets) {
+                auto& o = objs[i];
+                o["x"] = (double)(levelcheck::getFloat(o, "x", 0.f) + dx);
+                o["y"] = (double)(levelcheck::getFloat(o, "y", 0.f) + dy);
+                ++st.moved;
+            }
+        } else if (kind == "delete") {
+            for (size_t i : targets) { dead[i] = true; ++st.deleted; }
+        } else if (kind == "edit") {
+            for (size_t i : targets) {
+                auto& o = objs[i];
+                for (const char* k : {"rotation", "scale", "color_channel",
+                                      "detail_color_channel"})
+                    if (op.contains(k)) o[k] = op[k];
+                for (const char* k : {"flip_x", "flip_y"})
+                    if (levelcheck::getBool(op, k, false))
+                        o[k] = !levelcheck::getBool(o, k, false);
+                ++st.edited;
+            }
+        }
+    }
+    if (st.deleted > 0) {
+        auto kept = matjson::Value::array();
+        size_t w = 0;
+        for (size_t i = 0; i < objs.size(); ++i) {
+            if (dead[i]) continue;
+            kept.push(std::move(objs[i]));
+            ids[w++] = ids[i];
+        }
+        objs = std::move(kept);
+        ids.resize(w);
+    }
+    return st;
+}
+
+// ── Concurrent patches ──────────────────────────────────────────────────────
+// A patch reply's ops, additions (macros expanded, its block templates baked
+// in) and metadata, plus the prose ahead of its script.
+struct Patch {
+    std::string label, note;
+    std::vector<matjson::Value> ops, adds;
+    matjson::Value meta;
+};
+
+inline Patch parse(const std::string& reply) {
+    Patch pt;
+    auto mark = reply.rfind("## Level Script");
+    pt.note = mark == std::string::npos ? "" : reply.substr(0, mark);
+    std::string script = eas::extractScript(reply);
+    if (!eas::looksLikeEAS(script)) return pt;
+    auto er = eas::parse(script);
+    if (!er.ok) return pt;
+    const auto& r = er.root;
+    if (r.contains("objects") && r["objects"].isArray())
+        for (const auto& o : r["objects"]) {
+            if (!o.isObject()) continue;
+            (o.contains("op") ? pt.ops : pt.adds).push_back(o);
+        }
+    resetBlockTemplates();
+    if (r.contains("macros") && r["macros"].isArray()) {
+        std::vector<matjson::Value> expanded;
+        macros::expandAll(r["macros"], expanded);
+        for (auto& o : expanded) pt.adds.push_back(std::move(o));
+    }
+    for (auto& o : pt.adds) applyBlockTemplateToObject(o);
+    resetBlockTemplates();
+    if (r.contains("level_metadata") && r["level_metadata"].isObject())
+        pt.meta = r["level_metadata"];
+    return pt;
+}
+
+struct MergeStats {
+    int kept = 0, narrowed = 0, dropped = 0;   // ops
+    int added = 0, overlapping = 0;            // additions
+};
+
+struct Merged {
+    std::vector<matjson::Value> ops, adds;
+    matjson::Value meta;                       // null when no patch set any
+    MergeStats st;
+};
+
+inline bool isGameplay(const matjson::Value& o) {
+    auto c = levelcheck::classifyType(levelcheck::getStr(o, "type", ""));
+    return c == levelcheck::kSolid || c == levelcheck::kHazard
+        || c == levelcheck::kOrb   || c == levelcheck::kPortal;
+}
+
+// Patches written independently against the same draft, taken in priority
+// order. An object an earlier patch touched is off-limits to later ones: a
+// later op is narrowed to the objects still free (rewritten as #id runs so
+// it can't widen again) or dropped. A later patch's gameplay additions are
+// dropped within 60u in X of an earlier patch's gameplay change, so two
+// passes reworking the same jump don't stack; decoration and triggers
+// always merge. Metadata keys go to the first patch that sets them;
+// default_colors concatenate.
+inline Merged merge(const matjson::Value& objs, const std::vector<uint32_t>& ids,
+                    const std::vector<Patch>& patches) {
+    constexpr float WINDOW = 60.f;
+    Merged m;
+    levelcheck::TriggerGraph graph;
+    graph.build(objs);
+    const std::vector<bool> none(objs.size(), false);
+    std::vector<int> owner(objs.size(), -1);
+    std::vector<float> claimed;                // sorted X of earlier gameplay changes
+    auto nearClaim = [&](float x) {
+        auto it = std::lower_bound(claimed.begin(), claimed.end(), x - WINDOW);
+        return it != claimed.end() && *it <= x + WINDOW;
+    };
+
+    for (int p = 0; p < (int)patches.size(); ++p) {
+        const auto& pt = patches[p];
+        std::vector<float> mine;
+        for (const auto& op : pt.ops) {
+            auto targets = select(objs, ids, graph, none, op);
+            if (targets.empty()) continue;
+            std::sort(targets.begin(), targets.end());
+            targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+            std::vector<size_t> free;
+            for (size_t i : targets)
+                if (owner[i] < 0 || owner[i] == p) free.push_back(i);
+            if (free.empty()) { ++m.st.dropped; continue; }
+            ++(free.size() < targets.size() ? m.st.narrowed : m.st.kept);
+            for (size_t i : free) {
+                owner[i] = p;
+                if (isGameplay(objs[i])) mine.push_back(levelcheck::getFloat(objs[i], "x", 0.f));
+            }
+            for (size_t a = 0; a < free.size();) {
+                size_t b = a;
+                while (b + 1 < free.size() && free[b + 1] == free[b] + 1) ++b;
+                matjson::Value o = op;
+                o["sel"] = fmt::format("#{}-{}", ids[free[a]], ids[free[b]]);
+                if (o.contains("filter_id"))   o["filter_id"] = 0;
+                if (o.contains("filter_type")) o["filter_type"] = "";
+                m.ops.push_back(std::move(o));
+                a = b + 1;
+            }
+        }
+        for (const auto& a : pt.adds) {
+            if (isGameplay(a)) {
+                float x = levelcheck::getFloat(a, "x", 0.f);
+                if (nearClaim(x)) { ++m.st.overlapping; continue; }
+                mine.push_back(x);
+            }
+            m.adds.push_back(a);
+            ++m.st.added;
+        }
+        if (pt.meta.isObject()) {
+            if (!m.meta.isObject()) m.meta = matjson::Value::object();
+            for (auto& [k, v] : pt.meta) {
+                if (k == "default_colors" && v.isArray() && m.meta.contains(k)
+                    && m.meta[k].isArray()) {
+                    for (auto& c : v) m.meta[k].push(c);
+                } else if (!m.meta.contains(k)) {
+                    m.meta[k] = v;
+                }
+            }
+        }
+        claimed.insert(claimed.end(), mine.begin(), mine.end());
+        std::sort(claimed.begin(), claimed.end());
+    }
+    return m;
+}
+
+} // namespace draftpatch
+
+// ─── Procedural scaffold ─────────────────────────────────────────────────────
+// Deterministic first draft with no model in the loop: from the length,
+// difficulty and style settings, the gamemodes the prompt names (in the
+// order it names them) and its BPM, lay out beat-aligned sections of known
+// patterns as EAS, expand it, and run the verifier over the result. A
+// section the verifier can't get through is toned down and the level laid
+// out again, so what comes back is passable before anything is sent. Each
+// section seeds its own generator from the prompt, so demoting one leaves
+// every other section exactly as it was and the same prompt always yields
+// the same scaffold.
+namespace scaffold {
+
+struct Params {
+    float seconds    = 45.f;
+    int   difficulty = 1;                   // 0 easy .. 4 extreme/demon
+    int   bpm        = 0;                   // 0 = no grid, fixed spacing
+    float groundY    = 105.f;
+    std::vector<std::string> modes;         // section plan, "cube" when empty
+    std::string style;                      // lowercased free text
+    uint32_t    seed = 0;
+};
+
+struct Result {
+    std::string    script;                  // the EAS the objects came from
+    matjson::Value objects = matjson::Value::array();
+    levelcheck::VerifyResult route;
+    int sections = 0;
+    int demoted  = 0;                       // demotion steps the verifier forced
+};
+
+inline int difficultyLevel(const std::string& setting) {
+    std::string d = eas::lower(setting);
+    if (d.find("extreme") != std::string::npos || d.find("demon") != std::string::npos) return 4;
+    if (d.find("insane") != std::string::npos  || d.find("harder") != std::string::npos) return 3;
+    if (d.find("hard") != std::string::npos)   return 2;
+    if (d.find("easy") != std::string::npos    || d.find("auto") != std::string::npos) return 0;
+    return 1;
+}
+
+// Gamemodes in the order the prompt first names them. Whole words only
+// (plural allowed), so "relationship" is not a ship section.
+inline std::vector<std::string> modePlan(const std::string& prompt) {
+    static const char* MODES[] = {"cube", "ship", "ball", "ufo", "wave",
+                                  "robot", "spider", "swing"};
+    std::string t = eas::lower(prompt);
+    auto alpha = [&](size_t i) { return i < t.size() && std::isalpha((unsigned char)t[i]); };
+    std::vector<std::pair<size_t, std::string>> hits;
+    for (const char* m : MODES) {
+        size_t len = std::strlen(m);
+        for (size_t at = t.find(m); at != std::string::npos; at = t.find(m, at + 1)) {
+            size_t end = at + len;
+            if (t.size() > end && t[end] == 's') ++end;
+            if ((at > 0 && alpha(at - 1)) || alpha(end)) continue;
+            hits.push_back({at, m});
+            break;
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+    std::vector<std::string> out;
+    for (auto& [at, m] : hits) out.push_back(m);
+    if (out.empty()) out.push_back("cube");
+    return out;
+}
+
+inline uint32_t seedFor(const std::string& prompt, const std::string& salt) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : prompt + '\x1f' + salt) { h ^= c; h *= 16777619u; }
+    return h;
+}
+
+// One section's lines. k is the section's intensity (0..4); below zero the
+// section is left as open floor.
+inline void writeSection(std::string& out, const Params& p, const std::string& mode,
+                         float x0, float x1, float slot, int k, uint32_t seed) {
+    const float G = p.groundY;
+    std::mt19937 rng(seed);
+    auto pick = [&](uint32_t n) { return (int)(rng() % n); };
+    auto line = [&](const std::string& l) { out += l; out += '\n'; };
+
+    if (mode == "ship" || mode == "wave" || mode == "swing" || mode == "ufo") {
+        // Flying modes get a ceiling eight rows up; obstacles leave at least
+        // four rows open, alternating floor and ceiling except for ufo.
+        line(fmt::format("FLOOR {:.0f}..{:.0f} y={:.0f}", x0 + 30.f, x1, G + 240.f));
+        if (k < 0) return;
+        bool ufo = mode == "ufo";
+        int i = 0;
+        for (float x = x0 + slot; x + 60.f <= x1; x += slot, ++i) {
+            int h = ufo ? 1 + (k >= 2 ? pick(2) : 0) : std::clamp(1 + k / 2 + pick(2), 1, 4);
+            if (k == 0 && pick(3) == 0) continue;
+            if (!ufo && (i & 1))
+                line(fmt::format("PILLAR {:.0f} y_bot={:.0f} y_top={:.0f}",
+                                 x, G + 240.f - 30.f * h, G + 210.f));
+            else
+                line(fmt::format("PILLAR {:.0f} y_bot={:.0f} y_top={:.0f}", x, G, G + 30.f * (h - 1)));
+        }
+        return;
+    }
+    if (mode == "ball" || mode == "spider") {
+        // Low ceiling to flip onto; spikes alternate between the two sides.
+        line(fmt::format("FLOOR {:.0f}..{:.0f} y={:.0f}", x0 + 30.f, x1, G + 150.f));
+        if (k < 0) return;
+        int i = 0;
+        for (float x = x0 + slot; x + 60.f <= x1; x += slot, ++i) {
+            int n = 1 + (k >= 3);
+            for (int j = 0; j < n; ++j) {
+                if (i & 1) line(fmt::format("SPIKE {:.0f} {:.0f} rot=180", x + 30.f * j, G + 120.f));
+                else       line(fmt::format("SPIKE {:.0f} {:.0f}", x + 30.f * j, G));
+            }
+        }
+        return;
+    }
+
+    // Cube / robot: weighted pick of spike trains, blocks, pad launches and
+    // short stairs; the style text shifts the weights.
+    if (k < 0) return;
+    int w[4] = {4, 3, 2, 1};                // spikes, block, pad, stair
+    if (p.style.find("flow") != std::string::npos) { w[0] = 2; w[2] = 5; }
+    if (p.style.find("retro") != std::string::npos || p.style.find("classic") != std::string::npos)
+        w[2] = 0;
+    if (p.style.find("memory") != std::string::npos || p.style.find("tech") != std::string::npos)
+        { w[1] = 5; w[3] = 2; }
+    int total = w[0] + w[1] + w[2] + w[3];
+    for (float x = x0 + slot; x + 90.f <= x1; x += slot) {
+        if (k == 0 && pick(5) < 2) continue;
+        int r = pick((uint32_t)total);
+        if (k == 0 || r < w[0]) {
+            int n = std::min(3, 1 + (k >= 2) + (k >= 4 ? pick(2) : 0));
+            line(fmt::format("SPIKE-TRAIN {:.0f} count={}", x, n));
+        } else if ((r -= w[0]) < w[1]) {
+            line(fmt::format("PILLAR {:.0f} y_bot={:.0f} y_top={:.0f}",
+                             x, G, G + (k >= 3 ? 30.f : 0.f)));
+        } else if ((r -= w[1]) < w[2] && slot >= 150.f) {
+            line(fmt::format("PAD yellow {:.0f} {:.0f}", x - 75.f, G));
+            line(fmt::format("PILLAR {:.0f} y_bot={:.0f} y_top={:.0f}", x + 45.f, G, G + 60.f));
+        } else {
+            line(fmt::format("STAIR-UP {:.0f} steps={}", x, 2 + (k >= 2)));
+        }
+    }
+}
+
+// `verify` off returns the first layout unchecked (the instant sketch);
+// on, the verifier demotes blocked sections for up to 8 attempts. Safe
+// on a worker: macros expand into a local template table.
+inline Result build(const Params& p, bool verify = true) {
+    Result res;
+    const float G     = p.groundY;
+    const float beat  = p.bpm > 0 ? GD_PLAYER_SPEED_1X * 60.f / (float)p.bpm : 0.f;
+    const float endX  = std::max(900.f, p.seconds * GD_PLAYER_SPEED_1X);
+
+    // Obstacles on every other beat (every beat from insane up), sections
+    // of four measures; both folded by octaves into a playable range.
+    float slot = beat > 0.f ? beat * (p.difficulty >= 3 ? 1.f : 2.f)
+                            : 210.f - 20.f * (float)p.difficulty;
+    while (slot < 120.f) slot *= 2.f;
+    while (slot > 400.f) slot *= 0.5f;
+    float span = beat > 0.f ? beat * 16.f : 900.f;
+    while (span < 600.f)  span *= 2.f;
+    while (span > 1800.f) span *= 0.5f;
+    float start = beat > 0.f ? std::ceil(300.f / (beat * 4.f)) * beat * 4.f : 300.f;
+
+    std::vector<float> bounds;
+    for (float x = start; x < endX; x += span) bounds.push_back(x);
+    if (bounds.empty()) bounds.push_back(start);
+    bounds.push_back(std::max(endX, bounds.back() + 300.f));
+    size_t n = bounds.size() - 1;
+    res.sections = (int)n;
+
+    // Difficulty curve: the first quarter one step easier, the last one
+    // step harder.
+    std::vector<int> level(n);
+    for (size_t i = 0; i < n; ++i)
+        level[i] = std::clamp(p.difficulty + (i >= n * 3 / 4 ? 1 : 0) - (i < n / 4 ? 1 : 0), 0, 4);
+    const auto& modes = p.modes.empty() ? std::vector<std::string>{"cube"} : p.modes;
+
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        std::string s;
+        std::string prev = "cube";
+        for (size_t i = 0; i < n; ++i) {
+            const std::string& mode = modes[i * modes.size() / n];
+            if (mode != prev)
+                s += fmt::format("PORTAL {} {:.0f} {:.0f}\n", mode, bounds[i], G + 60.f);
+            prev = mode;
+            writeSection(s, p, mode, bounds[i], bounds[i + 1], slot, level[i],
+                         p.seed ^ (uint32_t)(i * 0x9E3779B9u));
+        }
+        auto parsed = eas::parse(s);
+        if (!parsed.ok) { res.script = std::move(s); return res; }
+
+        auto objs = matjson::Value::array();
+        const matjson::Value& root = parsed.root;
+        if (root.contains("objects") && root["objects"].isArray())
+            for (auto& o : root["objects"]) objs.push(o);
+        if (root.contains("macros") && root["macros"].isArray()) {
+            std::vector<matjson::Value> expanded;
+            BlockTemplates templates;
+            macros::expandAll(root["macros"], expanded, false, templates);
+            for (auto& o : expanded) objs.push(std::move(o));
+        }
+        res.script  = std::move(s);
+        res.objects = std::move(objs);
+        if (!verify) break;
+        res.route   = levelcheck::verifyPassable(res.objects, G);
+        if (!res.route.blocked()) break;
+
+        // Tone down the section that stopped every input; one already
+        // emptied means the block is structural and the patch has to fix it.
+        size_t at = 0;
+        while (at + 1 < n && bounds[at + 1] <= res.route.blockedX) ++at;
+        if (level[at] < 0) break;
+        --level[at];
+        ++res.demoted;
+    }
+    return res;
+}
+
+} // namespace scaffold
+
+// ─── Blueprint staging contexts ─────────────────────────────────────────────
+// Everything one generation stages into an editor lives in its own
+// StagingContext: the ghost objects on their preview layer, the edit-op
+// journal, a pending region rebuild, the playtest ghost and the feedback
+// snapshot. The context is owned by the session's engine (createForSession
+// re-attaches the same one) and registered in s_stagings while it has
+// something staged. Several generations can therefore stage into one
+// editor at once — each on its own preview layer — and be accepted or
+// denied independently; the editor's tray acts on the FOCUSED context and
+// the rest wait on their layers until focus reaches them.
+
+// Per-generation feedback (rating, telemetry, Why?, export).
+struct GenerationFeedback {
+    std::string userPrompt;          // the raw prompt the user typed
+    std::string aiNarration;         // AI's plan prose, shown by the Why? button
+    std::string difficulty, style, length;
+    bool        wasAccepted = false;
+    std::string generatedJson;       // raw JSON objects array from the AI
+    std::string editSummary;         // edit diff from Edit mode (set by onDoneEditing)
+    std::string editedObjectsJson;   // objects after user edits (set by onDoneEditing)
+    int         selfRating = 0;      // AI's own RATING: n/10 from self-review
+};
+
+// ── Edit-op journal ─────────────────────────────────────────────────────────
+// MOVE/DELETE/EDIT ops execute against LIVE editor objects the moment a
+// result stages, but stay reversible until the user decides: every touched
+// object's original transform is journaled in the staging context. Deletes
+// are soft (hidden) until Accept makes them real; Deny restores everything.
+//
+// Keyed by object pointer (first touch wins, O(1) per touch) with the
+// original state in parallel arrays, so a 3000-object bulk op journals in
+// linear time and rollback/finalize are single sweeps over flat data.
+class EditOpJournal {
+public:
+    // Color channel sentinel for "object has no such sprite" (0 is a real
+    // channel, so it can't double as absent).
+    static constexpr int NO_SPRITE = -1;
+
+    size_t size()  const { return m_obj.size(); }
+    bool   empty() const { return m_obj.empty(); }
+
+    // Journal `go`'s current state unless already journaled; a delete on
+    // an already-journaled object only sets its flag.
+    void touch(GameObject* go, bool asDelete) {
+        auto [it, fresh] = m_index.try_emplace(go, (uint32_t)m_obj.size());
+        if (!fresh) {
+            if (asDelete) m_deleted[it->second] = 1;
+            return;
+        }
+        m_obj.emplace_back(go);
+        m_pos.push_back(go->getPosition());
+        m_rot.push_back(go->getRotation());
+        m_scaleX.push_back(go->getScaleX());
+        m_scaleY.push_back(go->getScaleY());
+        m_baseColor.push_back(go->m_baseColor ? go->m_baseColor->m_colorID : NO_SPRITE);
+        m_detailColor.push_back(go->m_detailColor ? go->m_detailColor->m_colorID : NO_SPRITE);
+        m_visible.push_back(go->isVisible());
+        m_deleted.push_back(asDelete);
+    }
+
+    bool softDeleted(GameObject* go) const {
+        auto it = m_index.find(go);
+        return it != m_index.end() && m_deleted[it->second];
+    }
+
+    bool holds(GameObject* go) const { return m_index.count(go) > 0; }
+
+    void clear() { *this = EditOpJournal(); }
+
+    // Accept: the soft-deleted objects still in the scene.
+    std::vector<GameObject*> pendingDeletes() const {
+        std::vector<GameObject*> out;
+        for (size_t i = 0; i < m_obj.size(); ++i)
+            if (m_deleted[i] && m_obj[i] && m_obj[i]->getParent()) out.push_back(m_obj[i]);
+        return out;
+    }
+
+    // Deny: restore every journaled object in one pass. Positions change
+    // with plain setPosition; the objects that actually moved are returned
+    // so the caller can refresh editor sections once, after the sweep.
+    std::vector<GameObject*> restore(size_t& restored) const {
+        std::vector<GameObject*> moved;
+        restored = 0;
+        for (size_t i = 0; i < m_obj.size(); ++i) {
+            GameObject* obj = m_obj[i];
+            if (!obj || !obj->getParent()) continue;
+            if (obj->getPosition() != m_pos[i]) {
+                obj->setPosition(m_pos[i]);
+                moved.push_back(obj);
+            }
+            obj->setRotation(m_rot[i]);
+            obj->setScaleX(m_scaleX[i]);
+            obj->setScaleY(m_scaleY[i]);
+            if (m_baseColor[i] != NO_SPRITE && obj->m_baseColor)
+                obj->m_baseColor->m_colorID = m_baseColor[i];
+            if (m_detailColor[i] != NO_SPRITE && obj->m_detailColor)
+                obj->m_detailColor->m_colorID = m_detailColor[i];
+            obj->setVisible(m_visible[i]);
+            ++restored;
+        }
+        return moved;
+    }
+
+private:
+    std::unordered_map<GameObject*, uint32_t> m_index;
+    std::vector<Ref<GameObject>>  m_obj;
+    std::vector<cocos2d::CCPoint> m_pos;
+    std::vector<float>            m_rot, m_scaleX, m_scaleY;
+    std::vector<int>              m_baseColor, m_detailColor;
+    std::vector<uint8_t>          m_visible, m_deleted;
+};
+
+struct StagingContext {
+    int  sessionId = 0;
+    bool inPreview = false;
+    bool inEdit    = false;   // user is editing accepted objects before clicking Done
+    std::vector<Ref<GameObject>> previewObjects;
+    // Layer-based preview: generated objects land on their OWN editor layer
+    // and the editor switches to it — GD fades every other layer, so the new
+    // build shows in full color against the dimmed level (no tints, no
+    // opacity hacks). Per preview object: the editor layer(s) it should END
+    // on after Accept (the AI-assigned editor_layer, captured before the
+    // preview override).
+    std::vector<std::pair<short, short>> intendedLayers;
+    short previewLayer = -1;   // layer the preview lives on
+    bool  layerReserved = false;  // previewLayer is this context's own layer
+                                  // (false: ops-only, on the user's layer)
+    short layerBefore  = -1;   // restored when this context leaves review
+    EditOpJournal                   editOps;          // incl. pending soft deletes
+    PendingRegionDelete             regionDelete;
+    // Playtest-ghost overlay (CCDrawNode polyline of the verifier's witness
+    // route) on the editor's object layer.
+    Ref<cocos2d::CCDrawNode>        playtestGhost;
+    GenerationFeedback              fb;
+
+    bool active() const { return inPreview || inEdit; }
+};
+
+static std::vector<std::shared_ptr<StagingContext>> s_stagings;  // staging order
+static std::weak_ptr<StagingContext> s_focusedStage;
+
+// The context the tray acts on: the focused one while it's still active,
+// else the oldest active context (which becomes focused).
+static std::shared_ptr<StagingContext> focusedStage() {
+    if (auto f = s_focusedStage.lock(); f && f->active()) return f;
+    for (auto& c : s_stagings)
+        if (c->active()) { s_focusedStage = c; return c; }
+    s_focusedStage.reset();
+    return nullptr;
+}
+
+static bool anyStageActive() { return focusedStage() != nullptr; }
+
+static size_t activeStageCount() {
+    size_t n = 0;
+    for (auto& c : s_stagings) if (c->active()) ++n;
+    return n;
+}
+
+// The session's existing context (a re-created engine keeps staging into
+// the same preview), or a fresh one.
+static std::shared_ptr<StagingContext> acquireStage(int sessionId) {
+    for (auto& c : s_stagings)
+        if (c->sessionId == sessionId) return c;
+    auto c = std::make_shared<StagingContext>();
+    c->sessionId = sessionId;
+    return c;
+}
+
+static void registerStage(const std::shared_ptr<StagingContext>& ctx) {
+    if (std::find(s_stagings.begin(), s_stagings.end(), ctx) == s_stagings.end())
+        s_stagings.push_back(ctx);
+    if (!s_focusedStage.lock()) s_focusedStage = ctx;
+}
+
+// The context left review (accepted, denied, or Done after editing).
+static void retireStage(const std::shared_ptr<StagingContext>& ctx) {
+    s_stagings.erase(std::remove(s_stagings.begin(), s_stagings.end(), ctx),
+                     s_stagings.end());
+    if (s_focusedStage.lock() == ctx) s_focusedStage.reset();
+}
+
+// A soft delete pending in ANY context — inventories and selectors must not
+// hand another generation's about-to-vanish objects to the model.
+static bool stageSoftDeleted(GameObject* go) {
+    for (auto& c : s_stagings)
+        if (c->editOps.softDeleted(go)) return true;
+    return false;
+}
+
+// An object another context holds: one of its ghosts (they sit on its
+// reserved preview layer from the first spawn tick) or one its journal
+// already touched. Each journal
+// restores the state IT saw, so a second context journaling the same object
+// would make out-of-order denies restore a state matching neither edit —
+// one context owns an object until it leaves review.
+static bool stageForeign(GameObject* go, const StagingContext* self) {
+    for (auto& c : s_stagings) {
+        if (c.get() == self) continue;
+        if (c->layerReserved &&
+            (go->m_editorLayer == c->previewLayer || go->m_editorLayer2 == c->previewLayer))
+            return true;
+        if (c->editOps.holds(go)) return true;
+    }
+    return false;
+}
+
+// Hidden from `self`'s inventory and op selectors: soft-deleted anywhere,
+// or held by another context.
+static bool stageHidden(GameObject* go, const StagingContext* self) {
+    return stageSoftDeleted(go) || stageForeign(go, self);
+}
+
+// Reserve a fresh preview layer for `ctx`: above every layer the level uses
+// AND every layer another context already holds — the other contexts'
+// ghosts may not have spawned yet, so a scan of the level alone can hand
+// two contexts the same layer. Registers the context, so the reservation is
+// visible to the next one immediately.
+static void reservePreviewLayer(LevelEditorLayer* lel,
+                                const std::shared_ptr<StagingContext>& ctx) {
+    short maxLayer = 0;
+    if (lel && lel->m_objects) {
+        for (auto* raw : CCArrayExt<CCObject*>(lel->m_objects)) {
+            auto* go = typeinfo_cast<GameObject*>(raw);
+            if (!go) continue;
+            maxLayer = std::max({maxLayer, go->m_editorLayer, go->m_editorLayer2});
+        }
+    }
+    for (auto& c : s_stagings)
+        if (c != ctx && c->layerReserved)
+            maxLayer = std::max(maxLayer, c->previewLayer);
+    ctx->previewLayer  = (short)std::min<int>(maxLayer + 1, 999);
+    ctx->layerReserved = true;
+    registerStage(ctx);
+}
+
+// Switch the editor's visible layer + keep GD's own label in sync.
+static void setEditorCurrentLayer(LevelEditorLayer* lel, short layer) {
     if (!lel) return;
     lel->m_currentLayer = layer;
     lel->updateOptions();
@@ -6101,73 +9009,40 @@ static void setEditorCurrentLayer(LevelEditorLayer* lel, short layer) {
     }
 }
 
-// ── Edit-op journal ─────────────────────────────────────────────────────────
-// MOVE/DELETE/EDIT ops execute against LIVE editor objects the moment a
-// result stages, but stay reversible until the user decides: every touched
-// object's original transform is journaled here. Deletes are soft (hidden)
-// until Accept makes them real; Deny restores everything.
-struct EditOpRecord {
-    Ref<GameObject>  obj;
-    cocos2d::CCPoint pos;
-    float rot     = 0.f;
-    float scaleX  = 1.f;
-    float scaleY  = 1.f;
-    bool  hadBaseColor   = false;  // object has an m_baseColor sprite
-    bool  hadDetailColor = false;  // object has an m_detailColor sprite
-    int   baseColorID   = 0;       // original channel (valid iff hadBaseColor)
-    int   detailColorID = 0;       // original channel (valid iff hadDetailColor)
-    bool  wasVisible = true;
-    bool  deleted    = false;   // soft-deleted (hidden); removed on Accept
-};
-static std::vector<EditOpRecord> s_editOpJournal;
-static std::unordered_set<GameObject*> s_editOpDeleted;  // pending soft deletes
+// Bumped whenever editor objects are removed (by anyone — see the
+// LevelEditorLayer::removeObject hook), restored or edited in place by mod
+// code. Live indexes only follow appends incrementally; any other change
+// invalidates them through this.
+static uint32_t s_levelMutationEpoch = 0;
 
 // Accept / Done: make soft deletes real, drop the journal.
-static void finalizeEditOps(LevelEditorLayer* lel) {
-    int removed = 0;
-    for (auto& rec : s_editOpJournal) {
-        GameObject* obj = rec.obj;
-        if (!obj || !rec.deleted) continue;
-        if (lel && obj->getParent()) {
-            lel->removeObject(obj, true);
-            ++removed;
-        }
-    }
-    if (removed > 0)
-        log::info("EditorAI: finalized {} AI deletions", removed);
-    s_editOpJournal.clear();
-    s_editOpDeleted.clear();
-}
-
-// Deny: restore every touched object to its journaled state.
-static void rollbackEditOps(LevelEditorLayer* lel) {
-    int restored = 0;
-    for (auto it = s_editOpJournal.rbegin(); it != s_editOpJournal.rend(); ++it) {
-        GameObject* obj = it->obj;
-        if (!obj || !obj->getParent()) continue;
-        if (obj->getPosition() != it->pos) {
-            // moveObject keeps the editor's spatial sections consistent.
-            if (lel && lel->m_editorUI)
-                lel->m_editorUI->moveObject(obj, it->pos - obj->getPosition());
-            else
-                obj->setPosition(it->pos);
-        }
-        obj->setRotation(it->rot);
-        obj->setScaleX(it->scaleX);
-        obj->setScaleY(it->scaleY);
-        // Presence-flag gated (channel 0 is a legitimate value, so ">0"
-        // would silently fail to restore an object whose original was 0).
-        if (it->hadBaseColor && obj->m_baseColor)
-            obj->m_baseColor->m_colorID   = it->baseColorID;
-        if (it->hadDetailColor && obj->m_detailColor)
-            obj->m_detailColor->m_colorID = it->detailColorID;
-        obj->setVisible(it->wasVisible);
-        ++restored;
-    }
-    if (restored > 0)
-        log::info("EditorAI: rolled back AI edits on {} objects", restored);
-    s_editOpJournal.clear();
-    s_editOpDeleted.clear();
+static void finalizeEditOps(LevelEditorLayer* lel, StagingContext& ctx) {
+    size_t removed = 0;
+    if (lel) {
+        auto doomed = ctx.editOps.pendingDeletes();
+        for (auto* obj : doomed) lel->removeObject(obj, true);
+        removed = doomed.size();
+    }
+    if (removed > 0) {
+        ++s_levelMutationEpoch;
+        log::info("EditorAI: finalized {} AI deletions (session {})", removed, ctx.sessionId);
+    }
+    ctx.editOps.clear();
+}
+
+// Deny: restore every touched object to its journaled state. Section
+// updates for moved objects run as one batch after the restore sweep.
+static void rollbackEditOps(LevelEditorLayer* lel, StagingContext& ctx) {
+    size_t restored = 0;
+    auto moved = ctx.editOps.restore(restored);
+    if (lel)
+        for (auto* obj : moved) lel->updateObjectSection(obj);
+    if (restored > 0) {
+        ++s_levelMutationEpoch;
+        log::info("EditorAI: rolled back AI edits on {} objects ({} moved, session {})",
+                  restored, moved.size(), ctx.sessionId);
+    }
+    ctx.editOps.clear();
 }
 
 // Active rating popup, if any. Set by RatingPopup::create, cleared in its
@@ -6179,10 +9054,6 @@ static Ref<CCNode> s_activeRatingPopup;
 // Forward declaration — defined after AIEditorUI
 static void showPreviewButtonsOnEditorUI(EditorUI* ui);
 
-// ─── Feedback / rating persistence ──────────────────────────────────────────
-// Stores the last generation context so the rating popup (shown after
-// accept/deny) can save it alongside the user's 1-10 score.
-
 // ─── Prompt history ──────────────────────────────────────────────────────────
 static std::vector<std::string> s_promptHistory;
 static int s_promptHistoryIndex = -1;
@@ -6197,37 +9068,384 @@ static void addToPromptHistory(const std::string& prompt) {
     s_promptHistoryIndex = (int)s_promptHistory.size();  // past the end = "current"
 }
 
-// Playtest-ghost overlay (CCDrawNode polyline of the simulated cube run).
-// Lives on the editor's object layer; cleared on accept/deny/edit/new spawn.
-static Ref<cocos2d::CCDrawNode> s_playtestGhost;
+// Playtest ghost of one context: cleared on accept/deny/edit/new spawn.
+static void removePlaytestGhost(StagingContext& ctx) {
+    if (ctx.playtestGhost) {
+        ctx.playtestGhost->removeFromParent();
+        ctx.playtestGhost = nullptr;
+    }
+}
 
-static void removePlaytestGhost() {
-    if (s_playtestGhost) {
-        s_playtestGhost->removeFromParent();
-        s_playtestGhost = nullptr;
+// Last API generation start (the enable-rate-limiting gate). File scope so
+// the batch scheduler can space its starts to pass the same gate.
+static std::chrono::steady_clock::time_point s_lastRequestTime{};
+
+// Whole seconds until the gate reopens (0 = open, or the gate is off).
+static int64_t rateLimitRemaining() {
+    if (!Mod::get()->getSettingValue<bool>("enable-rate-limiting")) return 0;
+    int64_t minSeconds = Mod::get()->getSettingValue<int64_t>("rate-limit-seconds");
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - s_lastRequestTime).count();
+    return std::max<int64_t>(0, minSeconds - elapsed);
+}
+
+static bool isLocalProvider(const std::string& p) {
+    return p == "ollama" || p == "lm-studio" || p == "llama-cpp";
+}
+
+// Should the system prompt teach the compact EAS dialect (eas::lowerCompact)?
+// The parser always accepts it; this only decides whether the model is told
+// about it. "auto" keeps it away from local and small models, which lose
+// track of a running cursor and produce misplaced objects — plain absolute
+// coordinates cost them tokens but not correctness.
+static bool compactDialectFor(const std::string& provider, const std::string& model) {
+    auto mode = Mod::get()->getSettingValue<std::string>("eas-compact-dialect");
+    if (mode == "on")  return true;
+    if (mode == "off") return false;
+    if (isLocalProvider(provider)) return false;
+    // Whole name tokens, not substrings: a bare "mini" also matches
+    // "gemini" and "ministral", which turned the dialect off for both
+    // default cloud models. "gpt-4o-mini" → gpt / 4o / mini.
+    std::string m = model;
+    for (auto& c : m) c = (char)std::tolower((unsigned char)c);
+    size_t i = 0;
+    while (i < m.size()) {
+        size_t e = m.find_first_of("-:/_.", i);
+        if (e == std::string::npos) e = m.size();
+        std::string_view tok(m.data() + i, e - i);
+        i = e + 1;
+        for (std::string_view small : {"mini", "nano", "lite", "haiku", "small", "tiny"})
+            if (tok == small) return false;
+        // Parameter count: 1b .. 8b (a "4o" or "3.5" token isn't one).
+        if (tok.size() >= 2 && tok.back() == 'b' &&
+            std::all_of(tok.begin(), tok.end() - 1, [](char c) { return std::isdigit((unsigned char)c); })) {
+            int billions = std::atoi(std::string(tok.substr(0, tok.size() - 1)).c_str());
+            if (billions > 0 && billions <= 8) return false;
+        }
+    }
+    return true;
+}
+
+// ─── Provider rate limiter ───────────────────────────────────────────────────
+// One token bucket per cloud provider, shared by every request the mod sends
+// to it: tool rounds, single-shot calls, ask_subagent, every session and
+// batch job. A request takes a token or waits in the provider's queue; the
+// queue drains on one shared timer, serving the owner (session) that was
+// served longest ago first, so a chatty tool loop can't starve a parallel
+// session. The rate adapts AIMD-style: each 2xx nudges it up, each 429
+// halves it, and Retry-After / x-ratelimit-* headers block the bucket
+// until the provider says it's open again. Retries go through the same
+// queue with a not-before time — no sleeping threads.
+// Local providers bypass it entirely.
+namespace ratelimit {
+
+using Clock = std::chrono::steady_clock;
+
+struct Waiter {
+    int                   owner;      // session id (0 = no session)
+    Clock::time_point     notBefore;
+    std::function<void()> fire;
+    bool                  free = false;   // delay-only: waits, takes no token
+};
+
+struct Bucket {
+    double            rate   = 1.0;   // tokens per second (adaptive)
+    double            maxRate = 4.0;
+    double            burst  = 3.0;
+    double            tokens = 3.0;
+    Clock::time_point refilled = Clock::now();
+    Clock::time_point blockedUntil{};
+    std::deque<Waiter> queue;
+    int               throttled = 0;  // 429s seen (for the log)
+};
+
+static std::unordered_map<std::string, Bucket> s_buckets;
+static std::unordered_map<int, Clock::time_point> s_lastServed;
+
+// Starting points per provider; AIMD finds the real ceiling from there.
+// Gemini's free tier is the tight one (~10-15 RPM).
+static Bucket& bucket(const std::string& provider) {
+    auto it = s_buckets.find(provider);
+    if (it != s_buckets.end()) return it->second;
+    Bucket b;
+    if (provider == "gemini")          { b.rate = 0.2; b.maxRate = 2.0; b.burst = 2.0; }
+    else if (provider == "claude")     { b.rate = 0.8; b.maxRate = 4.0; b.burst = 3.0; }
+    else if (provider == "huggingface"){ b.rate = 0.3; b.maxRate = 2.0; b.burst = 2.0; }
+    b.tokens = b.burst;
+    return s_buckets.emplace(provider, std::move(b)).first->second;
+}
+
+static void refill(Bucket& b, Clock::time_point now) {
+    double dt = std::chrono::duration<double>(now - b.refilled).count();
+    b.tokens   = std::min(b.burst, b.tokens + dt * b.rate);
+    b.refilled = now;
+}
+
+// Serve every provider queue as far as its tokens allow. Fairness: among
+// ready waiters, the owner served least recently goes first. Callbacks run
+// after the sweep — they may enqueue (and so rehash s_buckets).
+static void drain() {
+    auto now = Clock::now();
+    std::vector<std::function<void()>> ready;
+    for (auto& [provider, b] : s_buckets) {
+        refill(b, now);
+        while (!b.queue.empty() && now >= b.blockedUntil) {
+            auto pick = b.queue.end();
+            for (auto it = b.queue.begin(); it != b.queue.end(); ++it) {
+                if (it->notBefore > now) continue;
+                if (!it->free && b.tokens < 1.0) continue;
+                if (pick == b.queue.end() ||
+                    s_lastServed[it->owner] < s_lastServed[pick->owner])
+                    pick = it;
+            }
+            if (pick == b.queue.end()) break;
+            ready.push_back(std::move(pick->fire));
+            if (!pick->free) {
+                s_lastServed[pick->owner] = now;
+                b.tokens -= 1.0;
+            }
+            b.queue.erase(pick);
+        }
+    }
+    for (auto& fire : ready) fire();
+}
+
+class Pump : public CCObject {
+public:
+    void tick(float) { drain(); }
+};
+
+static void ensureTimer() {
+    static Pump* pump = nullptr;
+    if (pump) return;
+    pump = new Pump();   // lives for the process, like the batch pump
+    CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
+        schedule_selector(Pump::tick), pump, 0.1f, false);
+}
+
+static void enqueue(const std::string& provider, int owner,
+                    std::function<void()> fire, double delaySeconds, bool free) {
+    auto& b = bucket(provider);
+    b.queue.push_back({owner,
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(delaySeconds)),
+        std::move(fire), free});
+    ensureTimer();
+    drain();
+}
+
+// Run `fire` on the main thread once `provider` has a token (immediately if
+// it has one now). Rate limiting OFF or a local provider = no budget.
+static void acquire(const std::string& provider, int owner, std::function<void()> fire) {
+    if (isLocalProvider(provider) ||
+        !Mod::get()->getSettingValue<bool>("enable-rate-limiting")) {
+        fire();
+        return;
     }
+    enqueue(provider, owner, std::move(fire), 0.0, false);
 }
 
+// Run `fire` after `delaySeconds` AND once the provider's block has lifted,
+// without spending a token — the retry path, whose re-sent request then
+// acquires normally.
+static void defer(const std::string& provider, int owner,
+                  std::function<void()> fire, double delaySeconds) {
+    enqueue(provider, owner, std::move(fire), delaySeconds, true);
+}
+
+// "1s", "6m0s", "120ms", "0.5s" (OpenAI reset format) or bare seconds.
+static double parseDuration(std::string_view v) {
+    double total = 0.0, num = 0.0, frac = 0.0;
+    bool any = false, inFrac = false;
+    for (size_t i = 0; i < v.size(); ++i) {
+        char c = v[i];
+        if (c >= '0' && c <= '9') {
+            if (inFrac) { frac /= 10.0; num += (c - '0') * frac; }
+            else num = num * 10.0 + (c - '0');
+            any = true;
+        } else if (c == '.') {
+            inFrac = true; frac = 1.0;
+        } else if (c == 'h') { total += num * 3600; num = 0; inFrac = false; }
+        else if (c == 'm' && i + 1 < v.size() && v[i + 1] == 's') {
+            total += num / 1000.0; num = 0; inFrac = false; ++i;
+        }
+        else if (c == 'm') { total += num * 60; num = 0; inFrac = false; }
+        else if (c == 's') { total += num; num = 0; inFrac = false; }
+        else if (c != ' ') return -1.0;   // HTTP-date or junk
+    }
+    return any ? total + num : -1.0;
+}
+
+// Feed a provider's response back into its bucket. Returns the wait (s) the
+// provider asked for, or -1 if it gave none.
+static double observe(const std::string& provider, const web::WebResponse& resp) {
+    if (isLocalProvider(provider)) return -1.0;
+    auto& b = bucket(provider);
+    auto now = Clock::now();
+    auto header = [&](const char* name) -> double {
+        auto h = resp.header(name);
+        return h ? parseDuration(*h) : -1.0;
+    };
+    double wait = header("retry-after");
+    if (wait < 0) wait = header("retry-after-ms") >= 0 ? header("retry-after-ms") / 1000.0 : -1.0;
+
+    // Remaining == 0 means the next request would 429: block until reset.
+    for (auto* kind : {"requests", "tokens"}) {
+        auto rem = resp.header(fmt::format("x-ratelimit-remaining-{}", kind));
+        if (rem && rem->find_first_not_of("0") == std::string::npos && !rem->empty()) {
+            double reset = header(fmt::format("x-ratelimit-reset-{}", kind).c_str());
+            if (reset > wait) wait = reset;
+        }
+    }
+
+    int code = resp.code();
+    if (code == 429) {
+        b.rate   = std::max(1.0 / 60.0, b.rate * 0.5);
+        b.tokens = 0.0;
+        ++b.throttled;
+        if (wait < 0) wait = std::min(60.0, 2.0 / b.rate);
+        log::info("Rate limit: {} 429 #{} - rate now {:.2f}/s, waiting {:.1f}s",
+                  provider, b.throttled, b.rate, wait);
+    } else if (code >= 200 && code < 300) {
+        // Additive increase: about one extra request/min per success.
+        b.rate = std::min(b.maxRate, b.rate + 1.0 / 60.0);
+    }
+    if (wait > 0) {
+        auto until = now + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double>(std::min(wait, 600.0)));
+        b.blockedUntil = std::max(b.blockedUntil, until);
+    }
+    return wait;
+}
+
+// Seconds until `provider` reopens (0 = open now).
+static double blockedFor(const std::string& provider) {
+    auto it = s_buckets.find(provider);
+    if (it == s_buckets.end()) return 0.0;
+    return std::max(0.0, std::chrono::duration<double>(
+        it->second.blockedUntil - Clock::now()).count());
+}
+
+} // namespace ratelimit
+
+// ─── One-shot completions ────────────────────────────────────────────────────
+// A single system+prompt request with no tools and no history, for side jobs
+// that run on a second (usually cheaper) model: ask_subagent and the chat
+// compactor. OpenAI-compat family + ollama generate + claude + gemini.
+namespace oneshot {
+
+struct Request { std::string url, body; };
+
+static Request build(const std::string& provider, const std::string& model,
+                     const std::string& system, const std::string& prompt,
+                     int maxTokens) {
+    matjson::Value body = matjson::Value::object();
+    std::string url;
+    if (provider == "claude") {
+        auto msg = matjson::Value::object();
+        msg["role"] = "user";
+        msg["content"] = prompt;
+        body["model"] = model;
+        body["max_tokens"] = maxTokens;
+        body["system"] = system;
+        body["messages"] = std::vector<matjson::Value>{msg};
+        url = "https://api.anthropic.com/v1/messages";
+    } else if (provider == "gemini") {
+        auto part = matjson::Value::object();
+        part["text"] = prompt;
+        auto content = matjson::Value::object();
+        auto parts = matjson::Value::array();
+        parts.push(part);
+        content["parts"] = parts;
+        auto contents = matjson::Value::array();
+        contents.push(content);
+        body["contents"] = contents;
+        auto sysPart = matjson::Value::object();
+        sysPart["text"] = system;
+        auto sysParts = matjson::Value::array();
+        sysParts.push(sysPart);
+        auto sysInst = matjson::Value::object();
+        sysInst["parts"] = sysParts;
+        body["systemInstruction"] = sysInst;
+        url = fmt::format(
+            "https://generativelanguage.googleapis.com/v1beta/models/{}:generateContent",
+            model);
+    } else if (provider == "ollama") {
+        body["model"] = model;
+        body["prompt"] = fmt::format("{}\n\n{}", system, prompt);
+        body["stream"] = false;
+        if (auto ka = ollamaKeepAlive(); !ka.isNull()) body["keep_alive"] = ka;
+        if (int ctx = ollamaNumCtx(model)) {
+            auto options = matjson::Value::object();
+            options["num_ctx"] = ctx;
+            body["options"] = options;
+        }
+        url = getOllamaUrl() + "/api/generate";
+    } else {
+        // OpenAI-compatible family (openai/openrouter/ministral/hf/
+        // deepseek/lm-studio/llama-cpp).
+        auto sys = matjson::Value::object();
+        sys["role"] = "system";  sys["content"] = system;
+        auto usr = matjson::Value::object();
+        usr["role"] = "user";    usr["content"] = prompt;
+        auto msgs = matjson::Value::array();
+        msgs.push(sys); msgs.push(usr);
+        body["model"] = model;
+        body["messages"] = msgs;
+        body["max_tokens"] = maxTokens;
+        url = toolUse::urlFor(provider, model);
+    }
+    return {std::move(url), body.dump()};
+}
+
+// The reply text, or empty when the response has none.
+static std::string parse(const std::string& provider, const matjson::Value& j) {
+    std::string text;
+    if (provider == "claude") {
+        if (j.contains("content") && j["content"].isArray() && j["content"].size() > 0) {
+            auto t = j["content"][0]["text"].asString();
+            if (t) text = t.unwrap();
+        }
+    } else if (provider == "gemini") {
+        if (j.contains("candidates") && j["candidates"].isArray() &&
+            j["candidates"].size() > 0) {
+            const auto& cand = j["candidates"][0];
+            if (cand.contains("content") && cand["content"].contains("parts") &&
+                cand["content"]["parts"].isArray()) {
+                // All text parts — a leading thought part would
+                // otherwise make parts[0]["text"] miss.
+                const auto& parts = cand["content"]["parts"];
+                for (size_t pi = 0; pi < parts.size(); ++pi)
+                    if (parts[pi].contains("text"))
+                        if (auto t = parts[pi]["text"].asString())
+                            text += t.unwrap();
+            }
+        }
+    } else if (provider == "ollama") {
+        auto t = j["response"].asString();
+        if (t) text = t.unwrap();
+    } else {
+        if (j.contains("choices") && j["choices"].isArray() && j["choices"].size() > 0) {
+            auto t = j["choices"][0]["message"]["content"].asString();
+            if (t) text = t.unwrap();
+        }
+    }
+    return text;
+}
+
+} // namespace oneshot
+
 // Set by the editor's Mutate button just before opening the generator popup;
 // init() consumes it and switches the popup into mutation mode.
 static bool s_openInMutationMode = false;
 
-static std::string s_lastUserPrompt;    // the raw prompt the user typed
-static std::string s_lastAINarration;   // AI's plan prose, shown by the Why? button
-static std::string s_lastDifficulty;
-static std::string s_lastStyle;
-static std::string s_lastLength;
-static bool        s_lastWasAccepted = false;
-static std::string s_lastGeneratedJson;  // raw JSON objects array from the AI
-static std::string s_lastEditSummary;       // edit diff from Edit mode (set by onDoneEditing)
-static std::string s_lastEditedObjectsJson; // objects after user edits (set by onDoneEditing)
-static int         s_lastSelfRating = 0;    // AI's own RATING: n/10 from self-review
-
 // Auto-telemetry: with allow-telemetry ON, every completed generation is
 // uploaded to the community collector (and re-sent once the user rates it,
 // so the training filter sees the human verdict). Defined near the other
 // collector plumbing; forward-declared here for processFinalResponse.
-static void autoContributeGeneration(int userRating);
+static void autoContributeGeneration(const GenerationFeedback& fb, int userRating);
+static void telemetryOutboxResume();           // $on_mod(Loaded): drain last run's queue
+static std::string telemetryOutboxSummary();   // request inspector counters line
 
 // Edit tracking: snapshot of accepted objects for implicit feedback
 struct AcceptedObjectSnapshot {
@@ -6237,6 +9455,223 @@ struct AcceptedObjectSnapshot {
 static std::vector<AcceptedObjectSnapshot> s_acceptedSnapshot;
 static std::string s_snapshotPrompt;
 
+// ─── Background I/O service ──────────────────────────────────────────────────
+// Every save-dir write goes through one long-lived worker instead of a
+// detached thread per write (each with its own static mutex and sequence
+// counter). Writes are keyed by path and coalesce: a write queued while an
+// older one for the same file is still waiting replaces it (last write
+// wins, keeping the older one's place in line), so a busy tool loop that
+// dirties sessions.json every tick costs one write, not one per tick.
+//
+// Callers hand over a producer, not bytes: the snapshot is taken on the
+// caller's thread (it reads live state) but the dump() — the expensive part
+// for files full of level JSON — runs on the worker, and a superseded
+// snapshot is never serialized at all.
+//
+// Guarantees:
+//  - Every commit is temp file + rename: a reader (or the next launch) sees
+//    the old file or the new one, never a torn mix.
+//  - Writes to one file land in queue order; different files may interleave.
+//  - Durability::Synced fsyncs the data before the rename (and the directory
+//    after it on POSIX), so the new contents survive a power loss too. Use
+//    it for data that can't be rebuilt (ratings, the telemetry outbox).
+//    Buffered leaves that to the OS — a crash keeps the old file or the new
+//    one, a power cut may keep the old one.
+//  - flush() is the exit barrier: $on_mod(DataSaved) waits (bounded) for
+//    everything queued so far to be committed.
+namespace io {
+
+enum class Durability { Buffered, Synced };
+
+using Producer = std::function<std::string()>;
+using Done     = std::function<void(bool ok)>;   // runs on the main thread
+
+struct Job {
+    std::filesystem::path path;       // empty: plain task (see post)
+    Producer              produce;
+    std::function<void()> task;
+    Durability            durability = Durability::Buffered;
+    std::vector<Done>     done;       // superseded writes' callbacks ride along
+};
+
+struct Stats {
+    uint64_t writes = 0, coalesced = 0, failures = 0, bytes = 0;
+};
+
+class Service {
+public:
+    void enqueue(std::string key, Job job) {
+        {
+            std::lock_guard lock(m_mutex);
+            auto it = m_pending.find(key);
+            if (it != m_pending.end()) {
+                // Last write wins; the loser's completion fires with it.
+                for (auto& d : it->second.done) job.done.push_back(std::move(d));
+                it->second = std::move(job);
+                ++m_stats.coalesced;
+            } else {
+                m_order.push_back(key);
+                m_pending.emplace(std::move(key), std::move(job));
+            }
+            if (!m_started) {
+                m_started = true;
+                // Lives for the process, like the schedulers' pumps — never
+                // joined from a static destructor (DLL unload would deadlock
+                // on the loader lock); flush() is the shutdown barrier.
+                std::thread([this] { run(); }).detach();
+            }
+        }
+        m_wake.notify_one();
+    }
+
+    bool flush(std::chrono::milliseconds timeout) {
+        std::unique_lock lock(m_mutex);
+        return m_idle.wait_for(lock, timeout, [this] { return m_order.empty() && !m_busy; });
+    }
+
+    Stats stats() {
+        std::lock_guard lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [this] { return !m_order.empty(); });
+                auto key = std::move(m_order.front());
+                m_order.pop_front();
+                auto it = m_pending.find(key);
+                job = std::move(it->second);
+                m_pending.erase(it);
+                m_busy = true;
+            }
+            bool ok = true;
+            size_t bytes = 0;
+            if (job.task) {
+                job.task();
+            } else {
+                std::string data = job.produce ? job.produce() : std::string();
+                bytes = data.size();
+                ok = commit(job.path, data, job.durability);
+            }
+            {
+                std::lock_guard lock(m_mutex);
+                m_busy = false;
+                if (!job.task) {
+                    ++m_stats.writes;
+                    m_stats.bytes += bytes;
+                    if (!ok) ++m_stats.failures;
+                }
+            }
+            m_idle.notify_all();
+            if (!job.done.empty()) {
+                Loader::get()->queueInMainThread([done = std::move(job.done), ok] {
+                    for (auto& d : done) d(ok);
+                });
+            }
+        }
+    }
+
+    static std::FILE* openWrite(const std::filesystem::path& p) {
+#ifdef _WIN32
+        return _wfopen(p.c_str(), L"wb");
+#else
+        return std::fopen(p.c_str(), "wb");
+#endif
+    }
+
+    static bool syncFile(std::FILE* f) {
+#ifdef _WIN32
+        return _commit(_fileno(f)) == 0;
+#else
+        return ::fsync(fileno(f)) == 0;
+#endif
+    }
+
+    static bool commit(const std::filesystem::path& path, const std::string& data,
+                       Durability durability) {
+        auto name = utils::string::pathToString(path.filename());
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        auto tmp = path;
+        tmp += ".tmp";
+        std::FILE* f = openWrite(tmp);
+        if (!f) {
+            log::error("Failed to save {}: can't open temp file", name);
+            return false;
+        }
+        bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size()
+               && std::fflush(f) == 0;
+        if (ok && durability == Durability::Synced) ok = syncFile(f);
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok) {
+            log::error("Failed to save {}: write error", name);
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            log::error("Failed to commit {}: {}", name, ec.message());
+            return false;
+        }
+#ifndef _WIN32
+        if (durability == Durability::Synced) {
+            // The rename itself lives in the directory entry.
+            int dir = ::open(path.parent_path().c_str(), O_RDONLY);
+            if (dir >= 0) { ::fsync(dir); ::close(dir); }
+        }
+#endif
+        return true;
+    }
+
+    std::mutex                           m_mutex;
+    std::condition_variable              m_wake, m_idle;
+    std::deque<std::string>              m_order;
+    std::unordered_map<std::string, Job> m_pending;
+    Stats                                m_stats;
+    bool                                 m_busy    = false;
+    bool                                 m_started = false;
+};
+
+static Service& service() {
+    static Service* s = new Service();   // intentionally leaked (see above)
+    return *s;
+}
+
+// Queue an atomic write of `produce()` to `path`, replacing any write to the
+// same path that hasn't started yet. `done` (optional) runs on the main
+// thread once the write — or the one that superseded it — has landed.
+static void write(std::filesystem::path path, Producer produce,
+                  Durability durability = Durability::Buffered, Done done = {}) {
+    Job job;
+    job.path       = std::move(path);
+    job.produce    = std::move(produce);
+    job.durability = durability;
+    if (done) job.done.push_back(std::move(done));
+    auto key = utils::string::pathToString(job.path);
+    service().enqueue(std::move(key), std::move(job));
+}
+
+// Run `task` on the I/O worker, in order with the queued writes (warm-up
+// reads). Never coalesced.
+static void post(std::function<void()> task) {
+    static std::atomic<uint64_t> s_taskSeq{0};
+    Job job;
+    job.task = std::move(task);
+    service().enqueue(fmt::format("#task{}", ++s_taskSeq), std::move(job));
+}
+
+// Exit barrier: block until everything queued so far has been committed,
+// or `timeout` passes. False on timeout.
+static bool flush(std::chrono::milliseconds timeout = std::chrono::seconds(3)) {
+    return service().flush(timeout);
+}
+
+} // namespace io
+
 // Each feedback entry saved to disk
 struct FeedbackEntry {
     std::string prompt;
@@ -6257,8 +9692,8 @@ static std::filesystem::path getFeedbackPath() {
 }
 
 // All rated generations. Loaded from disk once per session, then kept in
-// sync in memory; saves serialize on the calling thread and write on a
-// background thread so the frame never blocks on disk.
+// sync in memory; saves snapshot on the calling thread and serialize +
+// write on the I/O worker so the frame never blocks on disk.
 static std::vector<FeedbackEntry>& loadFeedback() {
     static std::vector<FeedbackEntry> s_cache = [] {
         std::vector<FeedbackEntry> entries;
@@ -6293,7 +9728,7 @@ static std::vector<FeedbackEntry>& loadFeedback() {
     return s_cache;
 }
 
-// Serialize the in-memory cache and write it out on a background thread.
+// Snapshot the in-memory cache and hand it to the I/O worker.
 static void persistFeedback() {
     auto& entries = loadFeedback();
     auto arr = matjson::Value::array();
@@ -6319,29 +9754,10 @@ static void persistFeedback() {
 
     // Move the matjson tree into the worker and dump() there — entries hold
     // full level dumps, so serialization itself is the expensive part.
-    // Snapshots carry a sequence number so two in-flight writers can't land
-    // out of order (last-SNAPSHOT-wins, not last-thread-wins), and the write
-    // goes through a temp file + rename so a crash mid-write can't tear
-    // feedback.json.
-    static std::atomic<uint64_t> s_writeGen{0};
-    uint64_t gen = ++s_writeGen;
-    std::thread([path = getFeedbackPath(), arr = std::move(arr), gen] {
-        static std::mutex s_writeMutex;
-        static uint64_t   s_lastWritten = 0;
-        std::lock_guard<std::mutex> lock(s_writeMutex);
-        if (gen <= s_lastWritten) return;  // a newer snapshot already landed
-        auto tmp = path;
-        tmp += ".tmp";
-        auto res = utils::file::writeString(tmp, arr.dump());
-        if (!res) {
-            log::error("Failed to save feedback.json: {}", res.unwrapErr());
-            return;
-        }
-        std::error_code ec;
-        std::filesystem::rename(tmp, path, ec);
-        if (ec) log::error("Failed to commit feedback.json: {}", ec.message());
-        else    s_lastWritten = gen;
-    }).detach();
+    // Ratings can't be rebuilt, so this one is fsynced.
+    io::write(getFeedbackPath(),
+              [arr = std::move(arr)] { return arr.dump(); },
+              io::Durability::Synced);
 }
 
 static void saveFeedbackEntry(const FeedbackEntry& entry) {
@@ -6551,6 +9967,7 @@ protected:
     // Ref: the ring lives unparented until first selection and gets
     // reparented between buttons — a raw pointer would dangle.
     Ref<CCSprite>  m_selRing;
+    GenerationFeedback m_fb;   // the generation being rated (snapshot)
 
     bool init() override {
         constexpr float W = 380.f, H = 280.f;
@@ -6563,7 +9980,7 @@ protected:
         ui::addGroove(m_mainLayer, 330.f, W / 2.f, H - 36.f);
 
         auto descLabel = CCLabelBMFont::create(
-            s_lastWasAccepted ? "How good was this generation?" : "How was this generation?",
+            m_fb.wasAccepted ? "How good was this generation?" : "How was this generation?",
             "bigFont.fnt");
         descLabel->limitLabelWidth(340.f, 0.4f, 0.1f);
         descLabel->setColor(ui::TEXT_PRIMARY);
@@ -6675,7 +10092,7 @@ protected:
     // generated level. No keys, no identity — see the setting description.
     void onShareTelemetry(CCObject*) {
         if (m_shared || m_selectedRating < 8) return;
-        if (s_lastGeneratedJson.empty() || s_lastUserPrompt.empty()) {
+        if (m_fb.generatedJson.empty() || m_fb.userPrompt.empty()) {
             Notification::create("Nothing to share for this generation",
                                  NotificationIcon::Warning)->show();
             return;
@@ -6686,18 +10103,18 @@ protected:
         auto body = matjson::Value::object();
         body["v"]          = 1;
         body["rating"]     = m_selectedRating;
-        body["prompt"]     = s_lastUserPrompt;
-        body["difficulty"] = s_lastDifficulty;
-        body["style"]      = s_lastStyle;
-        body["length"]     = s_lastLength;
-        body["objects"]    = s_lastGeneratedJson;   // compact JSON string
+        body["prompt"]     = m_fb.userPrompt;
+        body["difficulty"] = m_fb.difficulty;
+        body["style"]      = m_fb.style;
+        body["length"]     = m_fb.length;
+        body["objects"]    = m_fb.generatedJson;   // compact JSON string
 
         auto request = web::WebRequest();
         request.header("Content-Type", "application/json");
         request.timeout(std::chrono::seconds(10));
         request.bodyString(body.dump());
         m_shareTask.spawn(
-            request.post("http://sn-1.vltgg.net:21800/api/contribute"),
+            request.post(platinum::pick() + "/api/contribute"),
             [](web::WebResponse resp) {
                 Notification::create(
                     resp.ok() ? "Shared - thanks for improving the model!"
@@ -6763,21 +10180,19 @@ protected:
         }
 
         FeedbackEntry entry;
-        entry.prompt      = s_lastUserPrompt;
-        entry.difficulty  = s_lastDifficulty;
-        entry.style       = s_lastStyle;
-        entry.length      = s_lastLength;
+        entry.prompt      = m_fb.userPrompt;
+        entry.difficulty  = m_fb.difficulty;
+        entry.style       = m_fb.style;
+        entry.length      = m_fb.length;
         entry.feedback    = m_feedbackInput->getString();
-        entry.objectsJson       = s_lastGeneratedJson;
-        entry.editedObjectsJson = s_lastEditedObjectsJson;
-        entry.editSummary       = s_lastEditSummary;
+        entry.objectsJson       = m_fb.generatedJson;
+        entry.editedObjectsJson = m_fb.editedObjectsJson;
+        entry.editSummary       = m_fb.editSummary;
         entry.rating            = m_selectedRating;
-        entry.accepted          = s_lastWasAccepted;
+        entry.accepted          = m_fb.wasAccepted;
         entry.timestamp         = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
         saveFeedbackEntry(entry);
-        s_lastEditSummary.clear();
-        s_lastEditedObjectsJson.clear();
 
         Notification::create(
             fmt::format("Rated {}/10 — thanks!", m_selectedRating),
@@ -6798,8 +10213,9 @@ protected:
     }
 
 public:
-    static RatingPopup* create() {
+    static RatingPopup* create(const GenerationFeedback& fb) {
         auto ret = new RatingPopup();
+        ret->m_fb = fb;   // before init: the header reads it
         if (ret->init()) {
             ret->autorelease();
             // Remember this popup so clicking the AI button can cancel it.
@@ -6823,7 +10239,7 @@ static void cancelActiveRatingPopup() {
 }
 
 // Forward declaration — defined after AIEditorUI
-static void showRatingIfEnabled();
+static void showRatingIfEnabled(const StagingContext& ctx);
 
 // ─── In-mod settings popup (replaces the trip to Geode's settings page) ─────
 //
@@ -6855,6 +10271,34 @@ static const char* providerModelSettingKey(const std::string& p) {
     return "custom-provider-model";
 }
 
+// Model-list endpoint per provider — the settings popup's dynamic model
+// list (see there) and the capability probes (caps) both read it.
+static std::string providerModelListUrl(const std::string& provider) {
+    if (provider == "ollama")     return getOllamaUrl() + "/api/tags";
+    if (provider == "lm-studio")  return geode::Mod::get()->getSettingValue<std::string>("lm-studio-url") + "/v1/models";
+    if (provider == "llama-cpp")  return geode::Mod::get()->getSettingValue<std::string>("llama-cpp-url") + "/v1/models";
+    if (provider == "openai")     return "https://api.openai.com/v1/models";
+    if (provider == "claude")     return "https://api.anthropic.com/v1/models";
+    if (provider == "ministral")  return "https://api.mistral.ai/v1/models";
+    if (provider == "deepseek")   return "https://api.deepseek.com/v1/models";
+    if (provider == "openrouter") return "https://openrouter.ai/api/v1/models";
+    if (provider == "gemini")     return "https://generativelanguage.googleapis.com/v1beta/models";
+    if (provider == "huggingface")
+        return "https://huggingface.co/api/models?pipeline_tag=text-generation&sort=trending&limit=60";
+    if (provider == "custom") {
+        std::string base = geode::Mod::get()->getSettingValue<std::string>("custom-provider-url");
+        if (base.empty()) return "";
+        auto pos = base.find("/chat/completions");
+        if (pos != std::string::npos) base = base.substr(0, pos);
+        while (!base.empty() && base.back() == '/') base.pop_back();
+        auto endsWith = [&](const char* s){ std::string t = s; return base.size() >= t.size() && base.compare(base.size() - t.size(), t.size(), t) == 0; };
+        if (endsWith("/v1/models")) return base;
+        if (endsWith("/v1"))        return base + "/models";
+        return base + "/v1/models";
+    }
+    return "";
+}
+
 class AISettingsPopup : public Popup {
 public:
     enum class Tab { General, Provider, Advanced };
@@ -7454,6 +10898,7 @@ protected:
             addToggle("Platinum", "use-platinum");
             addText("Tag",         "ollama-model", "entity12208/editorai:v3-7b", 100);
             addInt ("Timeout (s)", "ollama-timeout", 60, 1800, 600);
+            addInt ("Keep (min)",  "ollama-keep-alive", 0, 1440, 30);
         } else if (p == "lm-studio") {
             addText("URL",   "lm-studio-url",   "http://localhost:1234", 100);
             addText("Model", "lm-studio-model", "loaded model name",     100);
@@ -7658,34 +11103,8 @@ protected:
     // trending text-generation list for HuggingFace. Results are cached for the
     // session; the Provider tab renders each as a tappable row.
     static std::unordered_map<std::string, std::vector<std::string>>& modelCache() {
-        static std::unordered_map<std::string, std::vector<std::string>> c;
-        return c;
-    }
-
-    static std::string modelListUrl(const std::string& provider) {
-        if (provider == "ollama")     return getOllamaUrl() + "/api/tags";
-        if (provider == "lm-studio")  return geode::Mod::get()->getSettingValue<std::string>("lm-studio-url") + "/v1/models";
-        if (provider == "llama-cpp")  return geode::Mod::get()->getSettingValue<std::string>("llama-cpp-url") + "/v1/models";
-        if (provider == "openai")     return "https://api.openai.com/v1/models";
-        if (provider == "claude")     return "https://api.anthropic.com/v1/models";
-        if (provider == "ministral")  return "https://api.mistral.ai/v1/models";
-        if (provider == "deepseek")   return "https://api.deepseek.com/v1/models";
-        if (provider == "openrouter") return "https://openrouter.ai/api/v1/models";
-        if (provider == "gemini")     return "https://generativelanguage.googleapis.com/v1beta/models";
-        if (provider == "huggingface")
-            return "https://huggingface.co/api/models?pipeline_tag=text-generation&sort=trending&limit=60";
-        if (provider == "custom") {
-            std::string base = geode::Mod::get()->getSettingValue<std::string>("custom-provider-url");
-            if (base.empty()) return "";
-            auto pos = base.find("/chat/completions");
-            if (pos != std::string::npos) base = base.substr(0, pos);
-            while (!base.empty() && base.back() == '/') base.pop_back();
-            auto endsWith = [&](const char* s){ std::string t = s; return base.size() >= t.size() && base.compare(base.size() - t.size(), t.size(), t) == 0; };
-            if (endsWith("/v1/models")) return base;
-            if (endsWith("/v1"))        return base + "/models";
-            return base + "/v1/models";
-        }
-        return "";
+        static std::unordered_map<std::string, std::vector<std::string>> c;
+        return c;
     }
 
     // Normalize a model-list response into a deduped, sorted, capped id list.
@@ -7722,7 +11141,7 @@ protected:
     void onFetchModels(CCObject*) {
         flushInputs();   // persist typed key/url/model before any rebuild
         std::string provider = geode::Mod::get()->getSettingValue<std::string>("ai-provider");
-        std::string url = modelListUrl(provider);
+        std::string url = providerModelListUrl(provider);
         if (url.empty()) {
             setAuthStatus("Set the endpoint URL first.", ui::ERROR_COL); return;
         }
@@ -7943,11 +11362,222 @@ static void logApiResponse(int code, const std::string& body) {
     e.responseBody = body.size() > 4096 ? body.substr(0, 4096) + "\n...(truncated)" : body;
 }
 
+// ─── Phase tracer ────────────────────────────────────────────────────────────
+// Scoped spans over the generation hot paths (prompt build, serialization,
+// HTTP round-trip, lenient parse, macro expansion, levelcheck, tool calls,
+// spawn ticks, Accept). Each session owns a fixed-size ring so a long chat
+// never grows memory and the newest phases always survive; the export is
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) with one
+// "process" lane per session. Recording is a lock + a POD store — names
+// are string literals, so a span costs no allocation on the hot path.
+namespace trace {
+
+struct Event {
+    const char* name = "";
+    const char* cat  = "";
+    int64_t     tsUs  = 0;   // microseconds since the tracer epoch
+    int64_t     durUs = 0;
+    uint32_t    tid   = 0;
+};
+
+struct SessionRing {
+    int                sessionId = 0;
+    std::vector<Event> buf;          // fixed capacity, overwritten in a circle
+    size_t             head  = 0;    // next write slot
+    size_t             count = 0;
+};
+
+// 4096 spans ≈ 160 KB per session; 8 sessions bounds the whole tracer.
+static constexpr size_t RING_CAP     = 4096;
+static constexpr size_t MAX_SESSIONS = 8;
+
+static std::mutex              s_mutex;
+static std::deque<SessionRing> s_rings;
+
+static int64_t nowUs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+// Small stable per-thread ids (1 = first thread to trace, normally main) —
+// std::thread::id has no portable integer form.
+static uint32_t threadIndex() {
+    static std::atomic<uint32_t> s_next{1};
+    thread_local uint32_t t_id = s_next.fetch_add(1);
+    return t_id;
+}
+
+static void record(int sessionId, const char* name, const char* cat,
+                   int64_t startUs, int64_t endUs) {
+    Event ev{name, cat, startUs, std::max<int64_t>(endUs - startUs, 0), threadIndex()};
+    std::lock_guard lock(s_mutex);
+    SessionRing* ring = nullptr;
+    for (auto& r : s_rings)
+        if (r.sessionId == sessionId) { ring = &r; break; }
+    if (!ring) {
+        if (s_rings.size() >= MAX_SESSIONS) s_rings.pop_front();
+        s_rings.push_back({sessionId, std::vector<Event>(RING_CAP), 0, 0});
+        ring = &s_rings.back();
+    }
+    ring->buf[ring->head] = ev;
+    ring->head = (ring->head + 1) % RING_CAP;
+    ring->count = std::min(ring->count + 1, RING_CAP);
+}
+
+// RAII span: records [construction, destruction) under the given session.
+// Session 0 collects spans that happen outside any generation.
+class Span {
+    const char* m_name;
+    const char* m_cat;
+    int         m_session;
+    int64_t     m_start;
+public:
+    Span(const char* name, int sessionId, const char* cat = "gen")
+        : m_name(name), m_cat(cat), m_session(sessionId), m_start(nowUs()) {}
+    ~Span() { record(m_session, m_name, m_cat, m_start, nowUs()); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+};
+
+// Chrome trace-event JSON ("X" complete events + process-name metadata).
+// Built by hand: matjson would allocate a node per field for a payload
+// that can hold 32k events.
+static std::string exportJson() {
+    std::vector<SessionRing> snap;
+    {
+        std::lock_guard lock(s_mutex);
+        snap.assign(s_rings.begin(), s_rings.end());
+    }
+    std::string out;
+    out.reserve(4096 + snap.size() * 96 * 256);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (auto& r : snap) {
+        if (!first) out += ",";
+        first = false;
+        out += fmt::format(
+            "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":{},"
+            "\"args\":{{\"name\":\"{}\"}}}}",
+            r.sessionId, r.sessionId ? fmt::format("session #{}", r.sessionId)
+                                     : std::string("no session"));
+        // Oldest first: the ring's logical start is head - count.
+        size_t start = (r.head + RING_CAP - r.count) % RING_CAP;
+        for (size_t i = 0; i < r.count; ++i) {
+            const auto& e = r.buf[(start + i) % RING_CAP];
+            out += fmt::format(
+                ",{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},"
+                "\"dur\":{},\"pid\":{},\"tid\":{}}}",
+                e.name, e.cat, e.tsUs, e.durUs, r.sessionId, e.tid);
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+// Writes trace.json into the mod save dir. Synchronous on purpose: it's a
+// one-shot debug action and the caller wants the path (or error) now.
+static bool exportToFile(std::string& pathOut, std::string& err) {
+    size_t spans = 0;
+    {
+        std::lock_guard lock(s_mutex);
+        for (auto& r : s_rings) spans += r.count;
+    }
+    if (spans == 0) { err = "No spans recorded yet - run a generation first."; return false; }
+    auto path = Mod::get()->getSaveDir() / "trace.json";
+    auto res = utils::file::writeString(path, exportJson());
+    if (!res) { err = res.unwrapErr(); return false; }
+    pathOut = utils::string::pathToString(path);
+    log::info("Trace: exported {} spans to {}", spans, pathOut);
+    return true;
+}
+
+} // namespace trace
+
 // ─── EAS dry-run validation (no editor mutation, no preview) ─────────────────
 // Parses + macro-expands + sanity-checks an EAS buffer and reports without
 // touching the editor. Powers the "Validate clipboard EAS" debug action.
+// Differential check for eas::parseParallel: the chunked parse (forced to
+// `chunks` workers regardless of size) must dump byte-identical to the
+// sequential one. Returns true on a match.
+static bool easParallelMatches(std::string_view script, unsigned chunks = 4) {
+    auto seq = eas::parse(script);
+    auto par = eas::parseParallel(script, chunks);
+    return seq.ok == par.ok && seq.root.dump() == par.root.dump();
+}
+
+// Same check over the embedded example corpus: every example section goes
+// through objectsToEAS, the scripts are concatenated (with META/COLOR lines
+// between them so the stateful-verb merge gets exercised), and the whole
+// buffer is compared at several chunk counts.
+static std::string easParallelSelfTest() {
+    std::string script;
+    int n = 0;
+    for (auto& ex : EXAMPLE_SECTIONS) {
+        auto objs = editorai::json_lenient::parse(ex.objectsJson);
+        if (!objs.ok || !objs.value.isArray()) continue;
+        script += fmt::format("META name=\"{}\" song_id={}\nCOLOR ch={} hex={:06x}\n",
+                              ex.levelName, n, 1 + n % 8, (n * 2654435761u) & 0xffffff);
+        script += eas::objectsToEAS(objs.value);
+        script += "\n";
+        ++n;
+    }
+    if (script.empty()) return "No example sections loaded - nothing to test.";
+    for (unsigned chunks : {2u, 3u, 8u, 32u}) {
+        if (!easParallelMatches(script, chunks))
+            return fmt::format("MISMATCH at {} chunks ({} sections, {} KB script)",
+                               chunks, n, script.size() / 1024);
+    }
+    return fmt::format("Parallel EAS parse identical to sequential: {} sections, "
+                       "{} KB script, 2/3/8/32 chunks", n, script.size() / 1024);
+}
+
+// Exactness check for the compact dialect: a script using every shorthand
+// must parse to the same dump as its hand-lowered long-hand twin. Both sides
+// go through parse(), so the ground tiers use the configured ground Y.
+static std::string easCompactSelfTest() {
+    float g = getGroundY();
+    auto y = [&](float dy) { return eas::fmtCoord(g + dy); };
+    std::string compact =
+        "AT 300\n"
+        "SPIKE @ r0\n"
+        "SPIKE @+90 *3\n"
+        "WITH color=4 groups=2 {\n"
+        "  BLOCK @+60 r1\n"
+        "  PILLAR @+120 y_bot=r0 y_top=l2\n"
+        "  WITH color=7 {\n"
+        "    ORB yellow @+30 r3\n"
+        "  }\n"
+        "}\n"
+        "REPEAT 2 every=300 {\n"
+        "  SPIKE @+0\n"
+        "  SPIKE @+30\n"
+        "}\n"
+        "FLOOR @+0..+600 y=r0\n"
+        "TRIGGER alpha at=@+0 groups=5\n";
+    std::string longhand = fmt::format(
+        "SPIKE 300 {0}\n"
+        "SPIKE 390\nSPIKE 480\nSPIKE 570\n"
+        "BLOCK 630 {1} color=4 groups=2\n"
+        "PILLAR 750 y_bot={0} y_top={2} color=4 groups=2\n"
+        "ORB yellow 780 {3} color=7 groups=2\n"
+        "SPIKE 780\nSPIKE 810\nSPIKE 1080\nSPIKE 1110\n"
+        "FLOOR 1110..1710 y={0}\n"
+        "TRIGGER alpha at=1110 groups=5\n",
+        y(0), y(30), y(180), y(90));
+    auto a = eas::parse(compact);
+    auto b = eas::parse(longhand);
+    if (!a.ok || !b.ok || a.root.dump() != b.root.dump())
+        return "Compact dialect MISMATCH against its long-hand lowering";
+    if (!easParallelMatches(compact, 3))
+        return "Compact dialect MISMATCH between parallel and sequential parse";
+    return fmt::format("Compact dialect lowers exactly ({} -> {} bytes)",
+                       compact.size(), longhand.size());
+}
+
 static std::string validateEASReport(const std::string& src) {
-    auto er = eas::parse(eas::extractScript(src));
+    std::string script = eas::extractScript(src);
+    auto er = eas::parse(script);
     if (!er.ok)
         return fmt::format("PARSE FAILED: {}", er.error.empty() ? "unknown error" : er.error);
 
@@ -7998,6 +11628,8 @@ static std::string validateEASReport(const std::string& src) {
     if (!pass.deaths.empty())
         report += fmt::format("\n<cy>{} death zone(s)</c> - first at X={:.0f}",
                               pass.deaths.size(), pass.deaths[0].x_start);
+    if (!easParallelMatches(script))
+        report += "\n<cr>Parallel parse differs from sequential!</c>";
     return report;
 }
 
@@ -8159,6 +11791,15 @@ protected:
         ui::styleTitle(m_title, 0.8f);
         ui::addGroove(m_mainLayer, 360.f, W / 2.f, H - 36.f);
 
+        // Telemetry outbox counters (queue, batches, compression, drops).
+        {
+            auto l = CCLabelBMFont::create(telemetryOutboxSummary().c_str(), "chatFont.fnt");
+            l->limitLabelWidth(374.f, 0.45f, 0.3f);
+            l->setColor(ui::TEXT_SECONDARY);
+            l->setPosition({W / 2.f, H - 46.f});
+            m_mainLayer->addChild(l);
+        }
+
         m_log.assign(s_requestLog.begin(), s_requestLog.end());
         if (m_log.empty()) {
             auto l = CCLabelBMFont::create("No API requests yet this session.",
@@ -8206,7 +11847,7 @@ protected:
 
         // Bottom actions
         auto barMenu = CCMenu::create();
-        barMenu->setContentSize({320.f, 24.f});
+        barMenu->setContentSize({372.f, 24.f});
         barMenu->ignoreAnchorPointForPosition(false);
         barMenu->setAnchorPoint({0.5f, 0.5f});
         barMenu->setPosition({W / 2.f, 20.f});
@@ -8217,8 +11858,9 @@ protected:
             b->setPosition({x, 12.f});
             barMenu->addChild(b);
         };
-        mk("Copy Last Exchange", menu_selector(DebugInspectorPopup::onCopyLast), 80.f);
-        mk("Validate Clipboard EAS", menu_selector(DebugInspectorPopup::onValidate), 240.f);
+        mk("Copy Last Exchange", menu_selector(DebugInspectorPopup::onCopyLast), 62.f);
+        mk("Validate Clipboard EAS", menu_selector(DebugInspectorPopup::onValidate), 196.f);
+        mk("Export Trace", menu_selector(DebugInspectorPopup::onExportTrace), 322.f);
         m_mainLayer->addChild(barMenu);
         return true;
     }
@@ -8262,6 +11904,17 @@ protected:
                              validateEASReport(clip), "OK", nullptr, 380.f)->show();
     }
 
+    void onExportTrace(CCObject*) {
+        std::string path, err;
+        if (!trace::exportToFile(path, err)) {
+            Notification::create(err, NotificationIcon::Warning)->show();
+            return;
+        }
+        utils::clipboard::write(path);
+        Notification::create("trace.json written (path copied)",
+                             NotificationIcon::Success)->show();
+    }
+
 public:
     static DebugInspectorPopup* create() {
         auto ret = new DebugInspectorPopup();
@@ -8755,6 +12408,128 @@ static bool s_sessionsDirty  = false;
 static int  s_sessionsNextId = 1;
 void editoraiMarkSessionsDirty() { s_sessionsDirty = true; }
 
+// ── Transcript spill / paging (Transcript is declared in sessions.hpp) ──────
+// Each spill hands one batch to the I/O worker as its own file (io::write:
+// atomic, serialized off-thread); the entries stay readable from memory
+// until the write lands. Page-ins are io::post reads, ordered behind any
+// queued writes. sessions.json stores how many entries were spilled; a
+// batch file a crash never wrote simply reads back as placeholders.
+static std::filesystem::path transcriptSpillDir(int sessionId) {
+    return Mod::get()->getSaveDir() / "transcripts" /
+           fmt::format("session-{}", sessionId);
+}
+
+void Transcript::push(Entry e) {
+    if (m_ring.empty()) m_ring.resize(RING_CAP);
+    if (m_count == RING_CAP) spillOldest(SPILL_BATCH);
+    ringAt(m_count) = std::move(e);
+    ++m_count;
+}
+
+void Transcript::spillOldest(size_t n) {
+    n = std::min(n, m_count);
+    if (n == 0) return;
+    size_t batch = m_spilled / SPILL_BATCH;
+    auto entries = std::make_shared<Batch>();
+    entries->reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        entries->push_back(std::move(ringAt(i)));   // the slot's heap goes with it
+    std::shared_ptr<const Batch> shared = std::move(entries);
+    m_state->unwritten[batch] = shared;
+
+    auto path = transcriptSpillDir(m_owner) / fmt::format("{}.jsonl", batch);
+    std::weak_ptr<SpillState> weak = m_state;
+    io::write(path,
+        [shared] {
+            std::string buf;
+            for (auto& e : *shared) {
+                auto o = matjson::Value::object();
+                o["k"] = (int)e.kind;
+                o["t"] = e.text;
+                buf += o.dump(matjson::NO_INDENTATION);
+                buf += '\n';
+            }
+            return buf;
+        },
+        io::Durability::Buffered,
+        [weak, batch, path](bool ok) {
+            // A failed batch reads back as placeholders; the session itself
+            // keeps working.
+            if (!ok)
+                log::warn("EditorAI: transcript spill to {} failed",
+                          utils::string::pathToString(path));
+            if (auto st = weak.lock()) st->unwritten.erase(batch);
+        });
+    m_head = (m_head + n) % RING_CAP;
+    m_count  -= n;
+    m_spilled += n;
+}
+
+const TranscriptEntry& Transcript::at(size_t i) const {
+    static const Entry MISSING{Entry::Kind::Status, "(history unavailable)"};
+    static const Entry LOADING{Entry::Kind::Status, "(loading…)"};
+    if (i >= size()) return MISSING;
+    if (i >= m_spilled) return ringAt(i - m_spilled);
+
+    size_t batch = i / SPILL_BATCH, line = i % SPILL_BATCH;
+    auto& st = *m_state;
+    if (auto it = st.unwritten.find(batch); it != st.unwritten.end())
+        return line < it->second->size() ? (*it->second)[line] : MISSING;
+    for (size_t p = 0; p < st.pages.size(); ++p) {
+        if (st.pages[p].first != batch) continue;
+        if (p) std::rotate(st.pages.begin(), st.pages.begin() + p, st.pages.begin() + p + 1);
+        const auto& v = st.pages.front().second;
+        return line < v.size() ? v[line] : MISSING;
+    }
+    if (!st.loading.insert(batch).second) return LOADING;
+
+    std::weak_ptr<SpillState> weak = m_state;
+    io::post([weak, batch,
+              path = transcriptSpillDir(m_owner) / fmt::format("{}.jsonl", batch)] {
+        Batch v;
+        if (auto read = utils::file::readString(path)) {
+            std::string_view rest = read.unwrap();
+            while (!rest.empty() && v.size() < SPILL_BATCH) {
+                size_t nl = rest.find('\n');
+                auto text = rest.substr(0, nl);
+                rest = nl == std::string_view::npos ? std::string_view() : rest.substr(nl + 1);
+                Entry e = MISSING;
+                if (auto parsed = matjson::parse(text)) {
+                    const auto o = parsed.unwrap();
+                    e.kind = (Entry::Kind)std::clamp<int64_t>(o["k"].asInt().unwrapOr(5), 0, 6);
+                    e.text = o["t"].asString().unwrapOr("");
+                }
+                v.push_back(std::move(e));
+            }
+        }
+        Loader::get()->queueInMainThread([weak, batch, v = std::move(v)]() mutable {
+            auto st = weak.lock();
+            if (!st) return;
+            st->loading.erase(batch);
+            st->pages.insert(st->pages.begin(), {batch, std::move(v)});
+            if (st->pages.size() > MAX_PAGES) st->pages.pop_back();
+        });
+    });
+    return LOADING;
+}
+
+// Spill directories of sessions that no longer exist (evicted, cleared, or
+// past the restore cap) — removed once per launch, on the I/O worker, so a
+// recycled id after a full clear can't inherit a stranger's history.
+static void pruneTranscriptSpills(const std::vector<std::shared_ptr<GenSession>>& live) {
+    std::unordered_set<std::string> keep;
+    for (auto& s : live)
+        if (s) keep.insert(utils::string::pathToString(transcriptSpillDir(s->id).filename()));
+    io::post([dir = Mod::get()->getSaveDir() / "transcripts", keep = std::move(keep)] {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(dir, ec)) return;
+        for (auto& ent : std::filesystem::directory_iterator(dir, ec)) {
+            auto name = utils::string::pathToString(ent.path().filename());
+            if (!keep.count(name)) std::filesystem::remove_all(ent.path(), ec);
+        }
+    });
+}
+
 // Load persisted sessions once, on first registry access. Restored sessions
 // are read-only history: the engine (in-flight network state, tool history)
 // can't be serialized, so anything that was live becomes Done with a note.
@@ -8801,13 +12576,19 @@ static void loadPersistedSessions(std::vector<std::shared_ptr<GenSession>>& out)
         // burying it as Done.
         if (!s->pendingEdit.empty())
             s->state = GenSession::State::AwaitingEditor;
+        // Older history stays in the session's spill files; only the ring's
+        // tail is in sessions.json. (Pre-spill saves carry up to 400 entries
+        // and no count — pushing them spills the overflow, which migrates.)
+        s->transcript.bind(s->id);
+        s->transcript.restoreSpilled(
+            (size_t)std::max<int64_t>(0, o["spilled"].asInt().unwrapOr(0)));
         const auto& tr = o["transcript"];
         if (tr.isArray()) {
-            for (size_t j = 0; j < tr.size() && j < 400; ++j) {
+            for (size_t j = 0; j < tr.size(); ++j) {
                 const auto& e = tr[j];
                 if (!e.isObject()) continue;
                 int k = (int)e["k"].asInt().unwrapOr(0);
-                s->transcript.push_back({
+                s->transcript.push({
                     (GenSession::Entry::Kind)std::clamp(k, 0, 6),
                     e["t"].asString().unwrapOr("")});
             }
@@ -8827,6 +12608,7 @@ static void loadPersistedSessions(std::vector<std::shared_ptr<GenSession>>& out)
                     m["t"].asString().unwrapOr("")});
             }
         }
+        s->chatRecount();
         // Re-resolve the target level by name so go-to-level and edit
         // resumes work across restarts (CCObject pointers don't persist).
         if (!s->targetLevelName.empty()) {
@@ -8858,14 +12640,138 @@ std::vector<std::shared_ptr<GenSession>>& genSessions() {
     static std::vector<std::shared_ptr<GenSession>> s = [] {
         std::vector<std::shared_ptr<GenSession>> v;
         loadPersistedSessions(v);
+        pruneTranscriptSpills(v);
         return v;
     }();
     return s;
 }
 
-// Serialize on the caller, write on a detached thread (persistFeedback
-// pattern). Throttled by the dirty flag — the overlay ticks this every
-// few seconds and $on_mod(DataSaved) flushes on exit.
+// ─── Chat compaction ─────────────────────────────────────────────────────────
+// Once a session's live chat passes the chat-compact-budget setting, the
+// oldest turns (down to half the budget, never the newest few) go to a cheap
+// model — the subagent provider or local Ollama, per chat-compactor — which
+// rewrites them plus the existing summary into a structured memory. The
+// request waits in the provider's rate-limit queue like any other and never
+// blocks a generation; when the reply lands (main thread) the summary is
+// swapped in and exactly those turns are dropped in one step. If the chat
+// moved under it (a hard-cap fold ran meanwhile) the reply is stale and
+// discarded. Failures back off for a minute; the digest fold in chatPush
+// remains the safety net at twice the budget.
+namespace compactor {
+
+struct Job {
+    async::TaskHolder<web::WebResponse> net;
+    std::chrono::steady_clock::time_point retryAfter{};
+    bool inFlight = false;
+};
+static std::unordered_map<int, Job> s_jobs;   // by session id
+
+static const char* MEMORY_SYS =
+    "You maintain the long-term memory of a conversation between a user and "
+    "a Geometry Dash level-design AI. Merge the existing memory with the new "
+    "turns into ONE updated memory using exactly these sections:\n"
+    "## Goals\n## Constraints & preferences\n## Accepted changes\n"
+    "## Rejected / reverted\n## Open threads\n"
+    "Terse bullets. Keep concrete facts (X ranges, object types, colors, "
+    "names, numbers) and decisions; drop chit-chat and anything superseded. "
+    "Under 500 words. Output only the memory.";
+
+static std::string providerFor() {
+    auto mode = Mod::get()->getSettingValue<std::string>("chat-compactor");
+    if (mode == "ollama") return "ollama";
+    if (mode == "subagent")
+        return Mod::get()->getSettingValue<std::string>("subagent-provider");
+    return "";
+}
+
+static std::shared_ptr<GenSession> findSession(int id) {
+    for (auto& s : genSessions())
+        if (s && s->id == id) return s;
+    return nullptr;
+}
+
+static void start(GenSession& s, const std::string& provider, size_t budget) {
+    // Oldest turns down to half the budget, always leaving the newest 6.
+    size_t take = 0, left = s.chatBytes;
+    while (take + 6 < s.chat.size() && left > budget / 2)
+        left -= GenSession::chatCost(s.chat[take++]);
+    if (take == 0) return;
+
+    std::string prompt = s.chatSummary.empty()
+        ? std::string("EXISTING MEMORY: (none yet)\n\n")
+        : fmt::format("EXISTING MEMORY:\n{}\n\n", s.chatSummary);
+    prompt += "NEW TURNS (oldest first):\n";
+    for (size_t i = 0; i < take; ++i)
+        prompt += fmt::format("{}: {}\n\n", s.chat[i].role == 0 ? "User" : "AI",
+                              s.chat[i].text);
+
+    std::string model = provider == Mod::get()->getSettingValue<std::string>("subagent-provider")
+        ? Mod::get()->getSettingValue<std::string>("subagent-model") : "";
+    if (model.empty()) model = getProviderModel(provider);
+    std::string apiKey = trimKey(getProviderApiKey(provider));
+    auto req = oneshot::build(provider, model, MEMORY_SYS, prompt, 1200);
+
+    int id = s.id;
+    uint64_t base = s.chatFolded;
+    s_jobs[id].inFlight = true;
+    log::info("Session {}: compacting {} oldest chat turns via {} ({})",
+              id, take, provider, model);
+    ratelimit::acquire(provider, id,
+        [id, base, take, provider, apiKey, req = std::move(req)] {
+            auto request = web::WebRequest();
+            request.header("Content-Type", "application/json");
+            request.timeout(std::chrono::seconds(120));
+            applyProviderAuth(request, provider, apiKey);
+            request.bodyString(req.body);
+            s_jobs[id].net.spawn(request.post(req.url),
+                [id, base, take, provider](web::WebResponse resp) {
+                    ratelimit::observe(provider, resp);
+                    auto& job = s_jobs[id];
+                    job.inFlight = false;
+                    std::string memory;
+                    if (resp.ok())
+                        if (auto json = resp.json()) memory = oneshot::parse(provider, json.unwrap());
+                    auto s = findSession(id);
+                    if (memory.empty() || !s) {
+                        job.retryAfter = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+                        log::info("Session {}: chat compaction failed (HTTP {}), "
+                                  "retrying later", id, resp.code());
+                        return;
+                    }
+                    if (s->chatFolded != base || s->chat.size() < take) {
+                        log::info("Session {}: chat moved during compaction, "
+                                  "discarding the stale summary", id);
+                        return;
+                    }
+                    GenSession::utf8Trim(memory, 6000);
+                    s->chatSummary = std::move(memory);
+                    s->chatDropFront(take);
+                    editoraiMarkSessionsDirty();
+                    log::info("Session {}: compacted {} turns into a {}-char memory "
+                              "({} bytes of chat left)", id, take,
+                              s->chatSummary.size(), s->chatBytes);
+                });
+        });
+}
+
+} // namespace compactor
+
+size_t editoraiCompactChat(GenSession& s) {
+    size_t budget = (size_t)std::max<int64_t>(4000,
+        Mod::get()->getSettingValue<int64_t>("chat-compact-budget"));
+    std::string provider = compactor::providerFor();
+    if (provider.empty()) return budget;
+    if (s.chatBytes > budget) {
+        auto& job = compactor::s_jobs[s.id];
+        if (!job.inFlight && std::chrono::steady_clock::now() >= job.retryAfter)
+            compactor::start(s, provider, budget);
+    }
+    return budget * 2;
+}
+
+// Snapshot on the caller, serialize + write on the I/O worker
+// (persistFeedback pattern). Throttled by the dirty flag — the overlay ticks
+// this every few seconds and $on_mod(DataSaved) flushes on exit.
 void editoraiPersistSessionsIfDirty() {
     if (!s_sessionsDirty) return;
     s_sessionsDirty = false;
@@ -8889,13 +12795,14 @@ void editoraiPersistSessionsIfDirty() {
         o["fbRating"]   = s->fbRating;
         o["fbShared"]   = s->fbShared;
         auto tr = matjson::Value::array();
-        for (auto& e : s->transcript) {
+        s->transcript.forEachResident([&](const GenSession::Entry& e) {
             auto eo = matjson::Value::object();
             eo["k"] = (int)e.kind;
             eo["t"] = e.text;
             tr.push(std::move(eo));
-        }
+        });
         o["transcript"] = tr;
+        o["spilled"]    = (int64_t)s->transcript.spilled();
         auto ch = matjson::Value::array();
         for (auto& m : s->chat) {
             auto mo = matjson::Value::object();
@@ -8910,35 +12817,21 @@ void editoraiPersistSessionsIfDirty() {
         o["pendingEditMode"] = s->pendingEditMode;
         arr.push(std::move(o));
     }
-    // Same delivery scheme as persistFeedback: snapshots carry a sequence
-    // number (last-SNAPSHOT-wins, not last-thread-wins) and land via temp
-    // file + rename so a crash or overlapping writer can't tear the file.
-    static std::atomic<uint64_t> s_writeGen{0};
-    uint64_t gen = ++s_writeGen;
-    std::string out = arr.dump(matjson::NO_INDENTATION);
-    std::thread([out = std::move(out), gen,
-                 path = Mod::get()->getSaveDir() / "sessions.json"] {
-        static std::mutex s_writeMutex;
-        static uint64_t   s_lastWritten = 0;
-        std::lock_guard<std::mutex> lock(s_writeMutex);
-        if (gen <= s_lastWritten) return;  // a newer snapshot already landed
-        auto tmp = path;
-        tmp += ".tmp";
-        auto res = geode::utils::file::writeString(tmp, out);
-        if (!res) {
-            log::error("Failed to save sessions.json: {}", res.unwrapErr());
-            return;
-        }
-        std::error_code ec;
-        std::filesystem::rename(tmp, path, ec);
-        if (ec) log::error("Failed to commit sessions.json: {}", ec.message());
-        else    s_lastWritten = gen;
-    }).detach();
+    io::write(Mod::get()->getSaveDir() / "sessions.json",
+              [arr = std::move(arr)] { return arr.dump(matjson::NO_INDENTATION); });
 }
 
 $on_mod(DataSaved) {
     s_sessionsDirty = true;          // force a flush even if throttle just ran
     editoraiPersistSessionsIfDirty();
+    // Exit barrier: everything queued so far (this snapshot, feedback,
+    // caches, the telemetry outbox) is on disk before the game goes away.
+    // Bounded — a wedged disk must not hang the exit.
+    if (!io::flush(std::chrono::seconds(3)))
+        log::warn("I/O flush timed out; some saves may be one write behind");
+    auto st = io::service().stats();
+    log::debug("I/O: {} writes ({} coalesced, {} failed, {} KB)",
+               st.writes, st.coalesced, st.failures, st.bytes / 1024);
 }
 
 static std::shared_ptr<GenSession> newGenSession() {
@@ -8959,29 +12852,798 @@ static std::shared_ptr<GenSession> newGenSession() {
         if (it == all.end()) break;
         all.erase(it);
     }
-    // Second bound: AwaitingEditor sessions pin whole engines (deferred
-    // objects, tool history, TaskHolders) via engineRef. Queuing many
-    // never-opened targets must not grow without limit — keep the 3 newest.
-    int awaiting = 0;
-    for (auto& e : all)
-        if (e && e->state == GenSession::State::AwaitingEditor) ++awaiting;
-    while (awaiting > 3) {
-        auto it = std::find_if(all.begin(), all.end(), [](auto& e) {
-            return e && e->state == GenSession::State::AwaitingEditor;
-        });
-        if (it == all.end()) break;
-        (*it)->state = GenSession::State::Failed;
-        (*it)->push(GenSession::Entry::Kind::Status,
-                    "(dropped - too many generations waiting for editors)");
-        (*it)->engineRef = nullptr;   // releases the pinned engine
-        (*it)->enginePtr = nullptr;
-        (*it)->pendingEdit.clear();   // a dropped session must not fire later
-        --awaiting;
+    // Second bound: AwaitingEditor sessions pin whole engines (deferred
+    // objects, tool history, TaskHolders) via engineRef. Queuing many
+    // never-opened targets must not grow without limit — keep the 3 newest.
+    int awaiting = 0;
+    for (auto& e : all)
+        if (e && e->state == GenSession::State::AwaitingEditor) ++awaiting;
+    while (awaiting > 3) {
+        auto it = std::find_if(all.begin(), all.end(), [](auto& e) {
+            return e && e->state == GenSession::State::AwaitingEditor;
+        });
+        if (it == all.end()) break;
+        (*it)->state = GenSession::State::Failed;
+        (*it)->push(GenSession::Entry::Kind::Status,
+                    "(dropped - too many generations waiting for editors)");
+        (*it)->engineRef = nullptr;   // releases the pinned engine
+        (*it)->enginePtr = nullptr;
+        (*it)->pendingEdit.clear();   // a dropped session must not fire later
+        --awaiting;
+    }
+    editoraiMarkSessionsDirty();
+    return s;
+}
+
+// "type" name → object ID, written into obj["id"] (untyped entries keep
+// whatever id they carry). Shared by editor staging and the level-string
+// writer so both resolve names identically.
+static void resolveObjectTypeId(matjson::Value& obj) {
+    auto typeResult = obj["type"].asString();
+    if (!typeResult) return;
+    const std::string& typeName = typeResult.unwrap();
+    // Triggers with hardcoded IDs not in object_ids.json
+    static const std::unordered_map<std::string, int> TRIGGER_IDS = {
+        {"color_trigger", 899},
+        {"move_trigger", 901},
+        {"end_trigger", 34},
+        {"show_trail_trigger", 32},
+        {"hide_trail_trigger", 33},
+    };
+    auto trigIt = TRIGGER_IDS.find(typeName);
+    if (trigIt != TRIGGER_IDS.end()) {
+        obj["id"] = trigIt->second;
+    } else {
+        auto it = OBJECT_IDS.find(typeName);
+        obj["id"] = (it != OBJECT_IDS.end()) ? it->second : 1;
+    }
+}
+
+// ─── Model capability probes ─────────────────────────────────────────────────
+// Context window, output cap, tool/vision support and tokenizer family used
+// to be guessed from the provider and model name. Now each (provider, model)
+// is asked once, via the endpoint that knows:
+//   ollama      POST /api/show          model_info.<arch>.context_length, capabilities
+//   lm-studio   GET  /api/v0/models/ID  max/loaded_context_length, type=vlm, tool_use
+//   llama-cpp   GET  /props             per-slot n_ctx, modalities.vision
+//   openrouter  GET  /api/v1/models     context_length, max_completion_tokens, ...
+//   ministral   GET  /v1/models/ID      max_context_length, capabilities{}
+//   gemini      GET  models/ID          input/outputTokenLimit
+//   custom      GET  <base>/v1/models   context_length / max_model_len (vLLM, Groq...)
+// Results persist in model-caps.json for a week; failures retry after a
+// minute and are never cached. The OpenAI, Claude, DeepSeek and HuggingFace
+// model endpoints carry no limits, so those stay on the static tables.
+// Consumers: tokenLimitSpec, supportsToolUse, supportsVision, Ollama num_ctx,
+// the history window and the elastic prompt sections (promptScale).
+namespace caps {
+
+static constexpr int64_t TTL_SECONDS    = 7 * 24 * 3600;
+// Ollama allocates KV cache for whatever num_ctx asks; past 16K a 7B model
+// stops fitting in 8 GB of VRAM and spills to the CPU.
+static constexpr int     OLLAMA_CTX_CAP = 16384;
+
+static int64_t nowUnix() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string keyFor(const std::string& provider, const std::string& model) {
+    return provider + "|" + model;
+}
+
+static std::unordered_map<std::string, ModelCaps>& store() {
+    static std::unordered_map<std::string, ModelCaps> s = [] {
+        std::unordered_map<std::string, ModelCaps> out;
+        auto res = utils::file::readString(Mod::get()->getSaveDir() / "model-caps.json");
+        if (!res) return out;
+        auto parsed = matjson::parse(res.unwrap());
+        if (!parsed || !parsed.unwrap().isObject()) return out;
+        for (auto& [key, value] : parsed.unwrap()) {
+            const matjson::Value& v = value;
+            ModelCaps c;
+            c.context   = (int)v["context"].asInt().unwrapOr(0);
+            c.maxOutput = (int)v["max_output"].asInt().unwrapOr(0);
+            c.tools     = (int)v["tools"].asInt().unwrapOr(-1);
+            c.vision    = (int)v["vision"].asInt().unwrapOr(-1);
+            c.tokenizer = v["tokenizer"].asString().unwrapOr("");
+            c.probedAt  = v["probed_at"].asInt().unwrapOr(0);
+            out[key] = std::move(c);
+        }
+        return out;
+    }();
+    return s;
+}
+
+static void persist() {
+    auto obj = matjson::Value::object();
+    for (auto& [key, c] : store()) {
+        auto o = matjson::Value::object();
+        o["context"]    = c.context;
+        o["max_output"] = c.maxOutput;
+        o["tools"]      = c.tools;
+        o["vision"]     = c.vision;
+        o["tokenizer"]  = c.tokenizer;
+        o["probed_at"]  = c.probedAt;
+        obj[key] = std::move(o);
+    }
+    io::write(Mod::get()->getSaveDir() / "model-caps.json",
+              [obj = std::move(obj)] { return obj.dump(); });
+}
+
+static bool arrayHas(const matjson::Value& arr, std::string_view what) {
+    if (!arr.isArray()) return false;
+    for (const auto& e : arr)
+        if (e.asString().unwrapOr("") == what) return true;
+    return false;
+}
+
+// ── Per-endpoint readers ──────────────────────────────────────────────────
+static void fromOllamaShow(const matjson::Value& j, ModelCaps& c) {
+    const auto& info = j["model_info"];
+    std::string arch = info["general.architecture"].asString().unwrapOr("");
+    c.tokenizer = info["tokenizer.ggml.model"].asString().unwrapOr(arch);
+    int trained = (int)info[arch + ".context_length"].asInt().unwrapOr(0);
+    // A Modelfile num_ctx ("num_ctx     8192" in the parameters text) is what
+    // the runner really allocates; otherwise we pick, up to the cap.
+    std::string params = j["parameters"].asString().unwrapOr("");
+    auto at = params.find("num_ctx");
+    int pinned = at == std::string::npos ? 0 : eas::tryInt(std::string_view(params).substr(at + 7), 0);
+    c.context = pinned > 0 ? pinned : std::min(trained, OLLAMA_CTX_CAP);
+    if (j["capabilities"].isArray()) {           // Ollama 0.6+
+        c.tools  = arrayHas(j["capabilities"], "tools")  ? 1 : 0;
+        c.vision = arrayHas(j["capabilities"], "vision") ? 1 : 0;
+    } else if (!j["projector_info"].isNull()) {
+        c.vision = 1;
+    }
+}
+
+static void fromLmStudio(const matjson::Value& j, ModelCaps& c) {
+    c.context = (int)j["loaded_context_length"].asInt().unwrapOr(
+                     j["max_context_length"].asInt().unwrapOr(0));
+    std::string type = j["type"].asString().unwrapOr("");
+    if (!type.empty()) c.vision = type == "vlm" ? 1 : 0;
+    if (j["capabilities"].isArray()) c.tools = arrayHas(j["capabilities"], "tool_use") ? 1 : 0;
+    c.tokenizer = j["arch"].asString().unwrapOr("");
+}
+
+static void fromLlamaCppProps(const matjson::Value& j, ModelCaps& c) {
+    c.context = (int)j["default_generation_settings"]["n_ctx"].asInt().unwrapOr(
+                     j["n_ctx"].asInt().unwrapOr(0));
+    if (j["modalities"].isObject())
+        c.vision = j["modalities"]["vision"].asBool().unwrapOr(false) ? 1 : 0;
+    // Tool calls need a template that renders them; one that never mentions
+    // tools can't (the server 400s the request).
+    std::string tmpl = j["chat_template"].asString().unwrapOr("");
+    if (!tmpl.empty() && tmpl.find("tool") == std::string::npos) c.tools = 0;
+}
+
+static void fromOpenRouter(const matjson::Value& j, const std::string& model, ModelCaps& c) {
+    if (!j["data"].isArray()) return;
+    for (const auto& m : j["data"]) {
+        if (m["id"].asString().unwrapOr("") != model) continue;
+        c.context   = (int)m["context_length"].asInt().unwrapOr(0);
+        c.maxOutput = (int)m["top_provider"]["max_completion_tokens"].asInt().unwrapOr(0);
+        const auto& arch = m["architecture"];
+        if (arch["input_modalities"].isArray())
+            c.vision = arrayHas(arch["input_modalities"], "image") ? 1 : 0;
+        if (m["supported_parameters"].isArray())
+            c.tools = arrayHas(m["supported_parameters"], "tools") ? 1 : 0;
+        c.tokenizer = arch["tokenizer"].asString().unwrapOr("");
+        return;
+    }
+}
+
+static void fromMistral(const matjson::Value& j, ModelCaps& c) {
+    c.context = (int)j["max_context_length"].asInt().unwrapOr(0);
+    const auto& cap = j["capabilities"];
+    if (cap.isObject()) {
+        c.tools  = cap["function_calling"].asBool().unwrapOr(false) ? 1 : 0;
+        c.vision = cap["vision"].asBool().unwrapOr(false) ? 1 : 0;
+    }
+    c.tokenizer = "mistral";
+}
+
+static void fromGemini(const matjson::Value& j, ModelCaps& c) {
+    c.context   = (int)j["inputTokenLimit"].asInt().unwrapOr(0);
+    c.maxOutput = (int)j["outputTokenLimit"].asInt().unwrapOr(0);
+    c.tokenizer = "gemini";
+}
+
+// OpenAI-style /models list from an arbitrary server: the limit fields
+// differ per implementation, so take the first one present.
+static void fromOpenAIList(const matjson::Value& j, const std::string& model, ModelCaps& c) {
+    if (!j["data"].isArray()) return;
+    for (const auto& m : j["data"]) {
+        if (m["id"].asString().unwrapOr("") != model) continue;
+        for (const char* k : {"context_length", "max_model_len", "context_window",
+                              "max_context_length"})
+            if (auto v = m[k].asInt()) { c.context = (int)v.unwrap(); break; }
+        for (const char* k : {"max_completion_tokens", "max_output_tokens"})
+            if (auto v = m[k].asInt()) { c.maxOutput = (int)v.unwrap(); break; }
+        return;
+    }
+}
+
+// ── Probe driver ──────────────────────────────────────────────────────────
+struct Probe {
+    async::TaskHolder<web::WebResponse> net;
+    std::vector<std::function<void()>>  waiters;
+};
+static std::unordered_map<std::string, Probe> s_probes;                 // in flight
+static std::unordered_map<std::string, std::chrono::steady_clock::time_point> s_failedAt;
+
+static bool probeable(const std::string& provider) {
+    if (provider == "ollama") return !Mod::get()->getSettingValue<bool>("use-platinum");
+    return provider == "lm-studio" || provider == "llama-cpp" || provider == "openrouter" ||
+           provider == "ministral" || provider == "gemini"    || provider == "custom";
+}
+
+// True when asking again would be pointless right now: a fresh cache entry,
+// a failure in the last minute, or a provider with nothing to ask.
+static bool settled(const std::string& provider, const std::string& model) {
+    if (!probeable(provider) || model.empty()) return true;
+    auto key = keyFor(provider, model);
+    if (auto it = store().find(key); it != store().end() &&
+        nowUnix() - it->second.probedAt < TTL_SECONDS) return true;
+    auto f = s_failedAt.find(key);
+    return f != s_failedAt.end() &&
+           std::chrono::steady_clock::now() - f->second < std::chrono::minutes(1);
+}
+
+// Fire-and-forget probe; `done` (optional) runs on the main thread once the
+// pair is settled, immediately when it already is.
+static void probe(const std::string& provider, const std::string& model,
+                  std::function<void()> done = {}) {
+    if (settled(provider, model)) { if (done) done(); return; }
+    auto key = keyFor(provider, model);
+    if (auto it = s_probes.find(key); it != s_probes.end()) {
+        if (done) it->second.waiters.push_back(std::move(done));
+        return;
+    }
+
+    std::string url;
+    std::string body;
+    if (provider == "ollama") {
+        url = getOllamaUrl() + "/api/show";
+        auto b = matjson::Value::object();
+        b["model"] = model;
+        body = b.dump(matjson::NO_INDENTATION);
+    } else if (provider == "lm-studio") {
+        url = Mod::get()->getSettingValue<std::string>("lm-studio-url") + "/api/v0/models/" + model;
+    } else if (provider == "llama-cpp") {
+        url = Mod::get()->getSettingValue<std::string>("llama-cpp-url") + "/props";
+    } else if (provider == "ministral") {
+        url = "https://api.mistral.ai/v1/models/" + model;
+    } else if (provider == "gemini") {
+        url = "https://generativelanguage.googleapis.com/v1beta/models/" + model;
+    } else {
+        url = providerModelListUrl(provider);   // openrouter, custom: full list
+    }
+    if (url.empty()) {
+        s_failedAt[key] = std::chrono::steady_clock::now();
+        if (done) done();
+        return;
+    }
+
+    auto request = web::WebRequest();
+    request.timeout(std::chrono::seconds(10));
+    applyProviderAuth(request, provider, trimKey(getProviderApiKey(provider)));
+    if (!body.empty()) {
+        request.header("Content-Type", "application/json");
+        request.bodyString(body);
+    }
+    auto& p = s_probes[key];
+    if (done) p.waiters.push_back(std::move(done));
+    p.net.spawn(body.empty() ? request.get(url) : request.post(url),
+        [provider, model, key](web::WebResponse resp) {
+            ModelCaps c;
+            bool ok = resp.ok();
+            if (ok) {
+                if (auto json = resp.json()) {
+                    const auto j = json.unwrap();
+                    if      (provider == "ollama")     fromOllamaShow(j, c);
+                    else if (provider == "lm-studio")  fromLmStudio(j, c);
+                    else if (provider == "llama-cpp")  fromLlamaCppProps(j, c);
+                    else if (provider == "openrouter") fromOpenRouter(j, model, c);
+                    else if (provider == "ministral")  fromMistral(j, c);
+                    else if (provider == "gemini")     fromGemini(j, c);
+                    else                               fromOpenAIList(j, model, c);
+                } else {
+                    ok = false;
+                }
+            }
+            if (ok) {
+                c.probedAt = nowUnix();
+                log::info("Caps: {} / {} -> context {}, output {}, tools {}, vision {}, tokenizer '{}'",
+                          provider, model, c.context, c.maxOutput, c.tools, c.vision, c.tokenizer);
+                store()[key] = std::move(c);
+                s_failedAt.erase(key);
+                persist();
+            } else {
+                s_failedAt[key] = std::chrono::steady_clock::now();
+                log::info("Caps: probe of {} / {} failed (HTTP {}), using static limits",
+                          provider, model, resp.code());
+            }
+            // The entry's TaskHolder owns this lambda — erase it on the next
+            // main-thread tick, not from inside it.
+            auto waiters = std::move(s_probes[key].waiters);
+            Loader::get()->queueInMainThread([key] { s_probes.erase(key); });
+            for (auto& w : waiters) w();
+        });
+}
+
+// ── Sizing ────────────────────────────────────────────────────────────────
+// Multiplier for the prompt's elastic sections (feedback examples, level
+// inventory listings): an 8K window gets a quarter, 100K+ gets double.
+static float promptScale(const std::string& provider, const std::string& model) {
+    auto* c = probedCaps(provider, model);
+    int ctx = c ? c->context : 0;
+    if (ctx <= 0)       return 1.f;
+    if (ctx <= 8192)    return 0.25f;
+    if (ctx <= 16384)   return 0.5f;
+    if (ctx >= 100000)  return 2.f;
+    return 1.f;
+}
+
+// Tool-loop history: fold old turns past `trigger` messages down to `keep`,
+// and cut older tool results to `resultCap` chars.
+struct HistoryWindow { size_t trigger, keep, resultCap; };
+static HistoryWindow historyWindow(const std::string& provider, const std::string& model) {
+    auto* c = probedCaps(provider, model);
+    int ctx = c ? c->context : 0;
+    if (ctx <= 0)       return {40, 30, 300};
+    if (ctx <= 8192)    return {12,  8, 150};
+    if (ctx <= 32768)   return {24, 16, 300};
+    if (ctx >= 100000)  return {80, 60, 600};
+    return {40, 30, 300};
+}
+
+} // namespace caps
+
+static const ModelCaps* probedCaps(const std::string& provider, const std::string& model) {
+    if (provider == "ollama" && Mod::get()->getSettingValue<bool>("use-platinum")) return nullptr;
+    auto& s = caps::store();
+    auto it = s.find(caps::keyFor(provider, model));
+    return it == s.end() ? nullptr : &it->second;
+}
+
+// ─── Ollama residency ────────────────────────────────────────────────────────
+// A cold Ollama model costs seconds to minutes of loading on the first
+// request, which used to land inside the generation (providerTimeout just
+// waited it out). Instead, the configured model is preloaded the moment the
+// overlay or the generator popup opens — /api/generate with no prompt only
+// loads it — and re-pinned with keep_alive every half period while a session
+// runs, so the generation's time-to-first-token is inference only. /api/ps
+// reports what is actually resident (and how much of it sits in VRAM) for
+// the provider chip. Platinum routes to remote workers, so none of this
+// applies there; ollama-keep-alive = 0 turns it off.
+namespace ollamaRes {
+
+enum class Phase { Unknown, Loading, Resident, Unloaded, Missing, Unreachable };
+
+struct State {
+    async::TaskHolder<web::WebResponse> load, ps;
+    std::string model;                          // what the phase describes
+    Phase       phase    = Phase::Unknown;
+    uint64_t    size     = 0, vram = 0;         // bytes, from /api/ps
+    std::chrono::steady_clock::time_point warmedAt{}, loadStart{}, polledAt{};
+};
+static State s_state;
+
+static bool enabled() {
+    return Mod::get()->getSettingValue<std::string>("ai-provider") == "ollama" &&
+           !Mod::get()->getSettingValue<bool>("use-platinum") &&
+           Mod::get()->getSettingValue<int64_t>("ollama-keep-alive") > 0;
+}
+
+// /api/ps lists "name:tag"; a configured tag-less name means ":latest".
+static bool sameModel(const std::string& listed, const std::string& want) {
+    return listed == want || (want.find(':') == std::string::npos && listed == want + ":latest");
+}
+
+static void pollPs() {
+    if (!enabled()) return;
+    std::string model = getProviderModel("ollama");
+    auto request = web::WebRequest();
+    request.timeout(std::chrono::seconds(4));
+    s_state.polledAt = std::chrono::steady_clock::now();
+    s_state.ps.spawn(request.get(getOllamaUrl() + "/api/ps"),
+        [model](web::WebResponse resp) {
+            if (s_state.model != model) return;          // model changed meanwhile
+            if (!resp.ok()) {
+                if (s_state.phase != Phase::Loading) s_state.phase = Phase::Unreachable;
+                return;
+            }
+            auto json = resp.json();
+            if (!json) return;
+            const auto j = json.unwrap();
+            bool found = false;
+            if (j["models"].isArray()) {
+                for (const auto& m : j["models"]) {
+                    if (!sameModel(m["name"].asString().unwrapOr(""), model)) continue;
+                    found = true;
+                    s_state.size = (uint64_t)m["size"].asDouble().unwrapOr(0.0);
+                    s_state.vram = (uint64_t)m["size_vram"].asDouble().unwrapOr(0.0);
+                }
+            }
+            if (found)                              s_state.phase = Phase::Resident;
+            else if (s_state.phase != Phase::Loading &&
+                     s_state.phase != Phase::Missing) s_state.phase = Phase::Unloaded;
+        });
+}
+
+// Preload (or re-pin) the configured model. Cheap when it's already
+// resident — Ollama answers at once and just extends the expiry.
+static void warm(const char* why) {
+    if (!enabled()) return;
+    std::string model = getProviderModel("ollama");
+    if (model.empty()) return;
+    if (model != s_state.model) {
+        s_state = State{};
+        s_state.model = model;
+    }
+    if (s_state.phase == Phase::Loading) return;
+    // The warm-up must load with the num_ctx the generation will ask for
+    // (caps), or the first real request reloads the model anyway.
+    if (!caps::settled("ollama", model)) {
+        std::string reason = why;
+        caps::probe("ollama", model, [reason] { warm(reason.c_str()); });
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    s_state.warmedAt = now;
+    if (s_state.phase != Phase::Resident) {
+        s_state.phase = Phase::Loading;
+        s_state.loadStart = now;
+    }
+    auto body = matjson::Value::object();
+    body["model"]      = model;
+    body["keep_alive"] = ollamaKeepAlive();
+    body["stream"]     = false;
+    if (int ctx = ollamaNumCtx(model)) {
+        auto options = matjson::Value::object();
+        options["num_ctx"] = ctx;
+        body["options"] = options;
+    }
+    auto request = web::WebRequest();
+    request.header("Content-Type", "application/json");
+    request.timeout(std::chrono::seconds(
+        (int)Mod::get()->getSettingValue<int64_t>("ollama-timeout")));
+    request.bodyString(body.dump(matjson::NO_INDENTATION));
+    log::info("Ollama: warming {} ({})", model, why);
+    s_state.load.spawn(request.post(getOllamaUrl() + "/api/generate"),
+        [model](web::WebResponse resp) {
+            if (s_state.model != model) return;
+            if (resp.ok()) {
+                auto secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - s_state.loadStart).count();
+                if (s_state.phase == Phase::Loading)
+                    log::info("Ollama: {} resident after {:.1f}s", model, secs);
+                s_state.phase = Phase::Resident;
+                pollPs();
+            } else {
+                s_state.phase = resp.code() == 404 ? Phase::Missing : Phase::Unreachable;
+                log::warn("Ollama: warm-up of {} failed (HTTP {})", model, resp.code());
+            }
+        });
+}
+
+// Periodic driver (overlay tick, panel or not): keeps the model pinned
+// while any session is generating and refreshes /api/ps every few seconds
+// while something shows it.
+static void tick(bool visible) {
+    if (!enabled()) return;
+    auto now = std::chrono::steady_clock::now();
+    bool running = false;
+    for (auto& s : genSessions())
+        if (s && s->state == GenSession::State::Running) { running = true; break; }
+    auto half = std::chrono::seconds(
+        30 * std::max<int64_t>(1, Mod::get()->getSettingValue<int64_t>("ollama-keep-alive")));
+    if (running && now - s_state.warmedAt > half) warm("session active");
+    if ((visible || running) && s_state.phase != Phase::Loading &&
+        now - s_state.polledAt > std::chrono::seconds(5))
+        pollPs();
+}
+
+// The phase for the configured model (Unknown when residency is off).
+static Phase phase() {
+    if (!enabled() || s_state.model != getProviderModel("ollama")) return Phase::Unknown;
+    return s_state.phase;
+}
+
+// Provider-chip suffix; empty when there is nothing to say.
+static std::string chipText() {
+    if (!enabled() || s_state.model != getProviderModel("ollama")) return "";
+    switch (s_state.phase) {
+        case Phase::Loading:     return "loading...";
+        case Phase::Unloaded:    return "not loaded";
+        case Phase::Missing:     return "not installed";
+        case Phase::Unreachable: return "offline";
+        case Phase::Resident:
+            if (s_state.size == 0) return "loaded";
+            if (s_state.vram >= s_state.size) return fmt::format("{:.1f} GB VRAM", s_state.vram / 1e9);
+            return fmt::format("{:.0f}% VRAM", 100.0 * s_state.vram / s_state.size);
+        default:                 return "";
+    }
+}
+
+} // namespace ollamaRes
+
+// Called every overlay frame: the open edge warms at once, the rest runs at
+// most once a second (settings reads aren't free at 120 fps).
+void editoraiOllamaTick(bool panelOpen) {
+    static bool s_wasOpen = false;
+    static std::chrono::steady_clock::time_point s_last{};
+    if (panelOpen && !s_wasOpen) ollamaRes::warm("panel opened");
+    s_wasOpen = panelOpen;
+    auto now = std::chrono::steady_clock::now();
+    if (now - s_last < std::chrono::seconds(1)) return;
+    s_last = now;
+    ollamaRes::tick(panelOpen);
+}
+
+// ─── GD level-string writer ──────────────────────────────────────────────────
+// Builds a finished generation straight into a CLOSED level: the object list
+// is serialized to GD's level format (header;obj;obj;... with each object a
+// comma-separated key,value list — 1=id, 2=x, 3=y, ...), gzip+base64'd with
+// GD's own ZipUtils and stored in GJGameLevel::m_levelString. No editor load,
+// no per-object createObject — milliseconds instead of seconds. Fields are
+// the props::schema rows applyObjectProperties uses, with their keys (gd)
+// and clamps; anything that only the live path knows how to apply (edit
+// ops, rows without a key) makes write() decline so the caller stages instead.
+namespace levelstr {
+
+// Header for a level that has never been saved: GD fills every missing
+// key with its defaults on load.
+static constexpr const char* EMPTY_HEADER =
+    "kA13,0,kA15,0,kA16,0,kA14,,kA6,0,kA7,0,kA17,0,kA18,0,kS39,0,kA2,0,"
+    "kA3,0,kA8,0,kA4,0,kA9,0,kA10,0,kA11,0";
+
+// Triggers — what the live path reaches as an EffectGameObject, read from
+// the ID since there is no object to cast here: every trigger kind, plus the
+// placement-only effect triggers (the ID alone is the effect).
+static bool isTrigger(int id) {
+    switch (id) {
+        case 1612: case 1613: case 32: case 33: case 34: case 1917:
+        case 1818: case 1819: case 1915: case 200: case 201: case 202:
+        case 203: case 1334:
+            return true;
+    }
+    for (auto& k : props::triggerKinds())
+        if (k.id == id) return true;
+    return false;
+}
+
+// Schema rows by JSON key: every row the live path applies or this writer
+// serializes. Keys and clamps come from the rows (props::Prop::gd, lo, hi),
+// so the two paths can't drift apart.
+static const std::unordered_map<std::string_view, std::vector<uint16_t>>& fieldRows() {
+    static const auto index = [] {
+        std::unordered_map<std::string_view, std::vector<uint16_t>> m;
+        const auto& rows = props::schema();
+        for (size_t i = 0; i < rows.size(); ++i)
+            if (rows[i].set || rows[i].gd) m[rows[i].key].push_back((uint16_t)i);
+        return m;
+    }();
+    return index;
+}
+
+// The rows reaching object `id`, in schema order — the live path's rule
+// (ID list, Fx needs an effect object; groups need advanced features).
+static std::vector<std::pair<uint16_t, const matjson::Value*>>
+fieldsOf(const matjson::Value& o, int id, bool adv) {
+    const auto& rows = props::schema();
+    const auto& index = fieldRows();
+    std::vector<std::pair<uint16_t, const matjson::Value*>> hits;
+    for (auto& [key, value] : o) {
+        auto it = index.find(std::string_view(key));
+        if (it == index.end()) continue;
+        for (uint16_t r : it->second) {
+            const auto& p = rows[r];
+            if (!p.ids.empty() && !props::forId(p, id)) continue;
+            if ((p.scope & props::Fx) && !(adv && isTrigger(id))) continue;
+            if (p.type == props::Type::IntList && !adv) continue;
+            if (!props::accepts(p.type, value)) continue;
+            hits.emplace_back(r, &value);
+        }
+    }
+    std::sort(hits.begin(), hits.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return hits;
+}
+
+struct Writer {
+    std::string out;
+    void kv(int key, std::string_view v) {
+        out += fmt::format("{},{},", key, v);
+    }
+    void kv(int key, int v)   { out += fmt::format("{},{},", key, v); }
+    void kv(int key, float v) { out += fmt::format("{},{},", key, v); }
+};
+
+static void appendObject(std::string& out, const matjson::Value& o, int id,
+                         float x, float y, bool adv) {
+    Writer w;
+    w.out.reserve(64);
+    w.kv(1, id);
+    w.kv(2, x);
+    w.kv(3, y);
+
+    const auto& rows = props::schema();
+    // Activation mode, same precedence as the live path: spawn wins.
+    bool spawned = o["spawn_triggered"].asBool().unwrapOr(false);
+    for (auto [r, vp] : fieldsOf(o, id, adv)) {
+        const auto& p = rows[r];
+        const matjson::Value& v = *vp;
+        if (!p.gd || (p.gd == 11 && spawned)) continue;
+        // Missing keys read back as 0 (scale: 1), so Obj rows at their
+        // default add nothing. Color channels default to 1, which is a real
+        // channel rather than the object's own color, and stay.
+        bool obj = (p.scope & props::Obj) && !(p.scope & props::Trig);
+        switch (p.type) {
+            case props::Type::Int: {
+                int n = std::clamp((int)v.asInt().unwrap(), (int)p.lo, (int)p.hi);
+                if (obj && p.dflt == 0.f && n == 0) break;
+                w.kv(p.gd, p.gd == 24 ? props::snapZLayer(n) : n);
+                break;
+            }
+            case props::Type::Float: {
+                float f = (float)v.asDouble().unwrap();
+                if ((p.scope & props::Range) && (f < p.lo || f > p.hi)) break;
+                f = std::clamp(f, p.lo, p.hi);
+                if (obj && std::abs(f - p.dflt) < 0.005f) break;
+                w.kv(p.gd, f);
+                break;
+            }
+            case props::Type::Bool:
+                if (v.asBool().unwrapOr(false)) w.kv(p.gd, 1);
+                break;
+            case props::Type::IntList: {
+                std::string list;
+                int assigned = 0;
+                for (auto& g : v) {
+                    auto gid = g.asInt();
+                    if (!gid || gid.unwrap() < p.lo || gid.unwrap() > p.hi || assigned >= 10)
+                        continue;
+                    if (!list.empty()) list += '.';
+                    list += fmt::format("{}", gid.unwrap());
+                    ++assigned;
+                }
+                if (!list.empty()) w.kv(p.gd, list);
+                break;
+            }
+            case props::Type::Hex: {
+                // "#rrggbb" (JSON) or [r,g,b] (EAS) into gd, gd+1, gd+2.
+                GLubyte cr = 255, cg = 255, cb = 255;
+                if (auto hex = v.asString()) {
+                    if (!parseHexColor(hex.unwrap(), cr, cg, cb)) break;
+                } else {
+                    cr = (GLubyte)std::clamp((int)v[0].asInt().unwrapOr(255), 0, 255);
+                    cg = (GLubyte)std::clamp((int)v[1].asInt().unwrapOr(255), 0, 255);
+                    cb = (GLubyte)std::clamp((int)v[2].asInt().unwrapOr(255), 0, 255);
+                }
+                w.kv(p.gd, (int)cr); w.kv(p.gd + 1, (int)cg); w.kv(p.gd + 2, (int)cb);
+                break;
+            }
+        }
+    }
+    // Pulse target type: a channel wins over a group (setPulseChannel runs
+    // after setPulseGroup).
+    if (adv && id == 1006) {
+        if (o["target_color_channel"].asInt())   w.kv(52, 0);
+        else if (o["target_group"].asInt())      w.kv(52, 1);
     }
-    editoraiMarkSessionsDirty();
-    return s;
+    w.out.back() = ';';   // replace the trailing ',' with the separator
+    out += w.out;
+}
+
+// A field the live path would apply that has no level-string key (song
+// and SFX fields, camera exit, linked teleport offset...) — the object
+// needs the editor's apply path. Empty when everything it carries writes.
+static std::string_view unwritableField(const matjson::Value& o, int id, bool adv) {
+    const auto& rows = props::schema();
+    for (auto [r, v] : fieldsOf(o, id, adv))
+        if (rows[r].set && !rows[r].gd) return rows[r].key;
+    return {};
+}
+
+struct WriteResult {
+    bool        ok = false;
+    size_t      written = 0;
+    std::string reason;   // why it declined (caller stages instead)
+};
+
+// Serialize `objects` (the engine's final array; entries are consumed) into
+// `level`. Replace drops the level's existing objects but keeps its header
+// (colors, song offsets, settings); otherwise the new objects are appended.
+static WriteResult write(GJGameLevel* level, matjson::Value& objects, bool replace,
+                    bool adv, int maxObjects, float groundY) {
+    WriteResult res;
+    if (!level || !objects.isArray()) { res.reason = "no level"; return res; }
+
+    struct Placed { int id; float x, y; size_t idx; };
+    std::vector<Placed> placed;
+    placed.reserve(objects.size());
+    size_t count = std::min(objects.size(), (size_t)std::max(maxObjects, 0));
+    for (size_t i = 0; i < count; ++i) {
+        if (!objects[i].isObject()) continue;
+        if (objects[i].contains("op")) { res.reason = "edit ops need a live editor"; return res; }
+        resolveObjectTypeId(objects[i]);
+        // Const probes: non-const operator[] inserts nulls on missing keys.
+        const matjson::Value& o = objects[i];
+        auto id = o["id"].asInt();
+        auto x  = o["x"].asDouble();
+        auto y  = o["y"].asDouble();
+        if (!id || !x || !y || id.unwrap() < 1 || id.unwrap() > 10000) continue;
+        int oid = (int)id.unwrap();
+        if (auto field = unwritableField(o, oid, adv); !field.empty()) {
+            res.reason = fmt::format("object {} needs the editor's apply path ({})", oid, field);
+            return res;
+        }
+        placed.push_back({oid, (float)x.unwrap(), (float)y.unwrap(), i});
+    }
+    if (placed.empty()) { res.reason = "no valid objects"; return res; }
+
+    // Same ground rule as editor staging: shift the whole set so its lowest
+    // object sits on the configured ground row.
+    float minY = placed[0].y;
+    for (auto& p : placed) minY = std::min(minY, p.y);
+    float shift = minY < groundY ? groundY - minY : 0.f;
+
+    // Existing contents: inflate, keep the header, keep objects unless
+    // replacing.
+    std::string existing;
+    std::string stored = level->m_levelString;
+    if (!stored.empty()) {
+        auto bytes = urlSafeBase64Decode(stored);
+        existing = zlibInflateBytes(bytes.data(), bytes.size());
+        if (existing.empty()) { res.reason = "couldn't decode the saved level"; return res; }
+    }
+    std::string out;
+    out.reserve(existing.size() + placed.size() * 48);
+    if (existing.empty()) {
+        out = EMPTY_HEADER;
+        out += ';';
+    } else if (replace) {
+        out = existing.substr(0, existing.find(';'));
+        out += ';';
+    } else {
+        out = existing;
+        if (out.back() != ';') out += ';';
+    }
+    for (auto& p : placed) {
+        auto& o = objects[p.idx];
+        applyBlockTemplateToObject(o);
+        appendObject(out, o, p.id, p.x, p.y + shift, adv);
+    }
+    level->m_levelString = cocos2d::ZipUtils::compressString(out, false, 0);
+    res.ok = true;
+    res.written = placed.size();
+    return res;
+}
+
+// The GJGameLevel half of applyLevelMetadata (name, description, song,
+// track) — same limits. Background/ground/platformer live in LevelSettings,
+// which only exists inside an editor, so a direct write leaves them alone.
+static void applyLevelFields(GJGameLevel* level, const matjson::Value& md) {
+    if (!level || !md.isObject()) return;
+    if (auto r = md["name"].asString()) {
+        std::string cleaned;
+        for (char c : r.unwrap().substr(0, 20))
+            if (c >= 0x20 && c < 0x7f) cleaned += c;
+        if (!cleaned.empty()) level->m_levelName = cleaned;
+    }
+    if (auto r = md["description"].asString())
+        level->m_levelDesc = r.unwrap().substr(0, 140);
+    if (auto r = md["song_id"].asInt())
+        level->m_songID = std::clamp((int)r.unwrap(), 0, 999'999'999);
+    if (auto r = md["audio_track"].asInt())
+        level->m_audioTrack = std::clamp((int)r.unwrap(), 0, 21);
 }
 
+} // namespace levelstr
+
 class AIGeneratorPopup : public Popup {
 protected:
     TextInput*               m_promptInput    = nullptr;
@@ -9007,6 +13669,10 @@ protected:
     // in fresh-generation mode (toggle off ⇒ clear level, with confirmation).
     bool                     m_shouldClearLevel = true;
     bool                     m_isGenerating     = false;
+    // Bumped when a generation or follow-up turn starts and on Cancel.
+    // Deferred work (limiter slots, retries) captures it: m_isGenerating
+    // alone can't tell a cancelled round from the one started right after.
+    uint32_t                 m_generation       = 0;
     int                      m_transientRetries = 0;   // reset per generation
     std::string              m_lastCallPrompt;          // for transient retry
     std::string              m_lastCallKey;
@@ -9015,19 +13681,64 @@ protected:
     std::string              m_styleBrief;              // fetched summary (single-shot)
     std::string              m_lockedPalette;           // COLOR lines from PalettePopup
     std::shared_ptr<GenSession> m_session;               // background-survivable identity
+    // Batch jobs pin provider/difficulty/style/length per job instead of
+    // reading the live settings (which the user may change mid-batch).
+    // Empty = the setting. See genProvider()/genSetting().
+    struct GenOverrides { std::string provider, difficulty, style, length; };
+    GenOverrides             m_overrides;
+    std::string genProvider() const {
+        return m_overrides.provider.empty()
+            ? Mod::get()->getSettingValue<std::string>("ai-provider")
+            : m_overrides.provider;
+    }
+    std::string genSetting(std::string_view key) const {
+        const std::string& o = key == "difficulty" ? m_overrides.difficulty
+                             : key == "style"      ? m_overrides.style
+                                                   : m_overrides.length;
+        return o.empty() ? Mod::get()->getSettingValue<std::string>(std::string(key)) : o;
+    }
+    // Elastic prompt sections scale with the generation model's probed
+    // context window (caps::promptScale) — 1 when it's unknown.
+    float promptScale() const {
+        std::string p = genProvider();
+        return caps::promptScale(p, getProviderModel(p));
+    }
+    // This generation's staged preview, journal and feedback (see
+    // StagingContext). Shared with the s_stagings registry while staged.
+    std::shared_ptr<StagingContext> m_stage = std::make_shared<StagingContext>();
     std::shared_ptr<matjson::Value> m_pendingApplyObjects; // staged while no editor
     std::shared_ptr<matjson::Value> m_pendingMetadata;
     std::string              m_platinumStatus;          // queue widget text
+    // Platinum routing for the in-flight single-shot request: the serving
+    // coordinator ("" when not Platinum), when it was sent, its queue factor
+    // at send time, the nodes this generation already gave up on, and the
+    // request id / response bytes so far that tell queued from running.
+    std::string              m_platinumNode;
+    std::string              m_platinumRequestId;
+    std::shared_ptr<std::atomic<size_t>> m_platinumBytes;
+    std::chrono::steady_clock::time_point m_platinumSentAt{};
+    double                   m_platinumFactor = 1.0;
+    std::vector<std::string> m_platinumTried;
     CCLabelBMFont*           m_chipLabel = nullptr;     // provider chip live refresh
     CCSprite*                m_chipDot   = nullptr;
     std::string              m_chipProviderShown;
-    async::TaskHolder<web::WebResponse> m_platinumPoll;
+    std::string              m_chipResidencyShown;
     async::TaskHolder<web::WebResponse> m_subagentTask;
     bool                     m_mutationMode = false;    // Mutate button flow
     bool                     m_coopMode     = false;    // AI-continues-your-build flow
     CCMenuItemToggler*       m_coopToggle   = nullptr;
     std::string              m_lastCostPrompt;          // dirty-check for the cost tick
     size_t                   m_sysPromptLenEst  = 0;    // measured once at popup open
+    // Current level as compact EAS for the mutation / co-op context,
+    // compacted on a worker (refreshLevelContext) and keyed by the level
+    // state it was taken from. Waiters run once a fresh one lands.
+    struct LevelContext { std::string eas; float maxX = 0.f; };
+    LevelContext             m_levelEAS;
+    bool                     m_levelEASValid = false;   // m_levelEAS holds a result
+    bool                     m_levelEASBusy  = false;   // a worker is compacting
+    uint32_t                 m_levelEASEpoch = 0;
+    unsigned                 m_levelEASCount = 0;
+    std::vector<std::function<void()>> m_levelEASWaiters;
     // When true the popup is in "small edits" mode — a different system
     // prompt is built (additive only, no clearing, conservative changes)
     // and the popup retitles to "Editor AI - Edit Mode".
@@ -9046,6 +13757,11 @@ protected:
     int    m_spawnBatchSize     = 8;
     bool   m_advFeatures        = false;
     std::chrono::steady_clock::time_point m_generationStartTime;
+    // Phase tracer: the HTTP span straddles two callbacks, so its start
+    // lives here; spawn ticks aggregate into one span per staging run.
+    int64_t m_traceHttpStartUs  = 0;
+    int64_t m_traceSpawnStartUs = 0;
+    int traceSession() const { return m_session ? m_session->id : 0; }
 
     // ── init ──────────────────────────────────────────────────────────────────
 
@@ -9354,9 +14070,16 @@ protected:
         // up to 24 KB of level context via appendModeContext).
         {
             std::string sysEst = buildSystemPrompt();
-            appendModeContext(sysEst);
+            appendModeContext(sysEst, /*estimate=*/true);
             m_sysPromptLenEst = sysEst.size();
         }
+        // Learn the model's real limits and load the local model now, while
+        // the user is still typing.
+        {
+            std::string provider = genProvider();
+            caps::probe(provider, getProviderModel(provider));
+        }
+        ollamaRes::warm("generator opened");
         this->schedule(schedule_selector(AIGeneratorPopup::updateCostEstimate), 1.0f);
         this->schedule(schedule_selector(AIGeneratorPopup::pollPlatinumStatus), 5.0f);
 
@@ -9423,12 +14146,12 @@ protected:
             return;
         }
         if (eas::looksLikeEAS(clip) || clip.find("## Level Script") != std::string::npos) {
-            if (m_isGenerating || m_isCreatingObjects || s_inPreviewMode || s_inEditMode) {
+            if (m_isGenerating || m_isCreatingObjects || m_stage->active()) {
                 Notification::create("Finish the current generation/preview first",
                                      NotificationIcon::Warning)->show();
                 return;
             }
-            auto er = eas::parse(eas::extractScript(clip));
+            auto er = eas::parseParallel(eas::extractScript(clip));
             if (!er.ok) {
                 Notification::create("Clipboard EAS didn't parse",
                                      NotificationIcon::Error)->show();
@@ -9457,7 +14180,7 @@ protected:
 
     // Re-stage a past generation as a fresh blueprint — no API call.
     void reapplyFromHistory(const std::string& objectsJson) {
-        if (m_isGenerating || m_isCreatingObjects || s_inPreviewMode || s_inEditMode) {
+        if (m_isGenerating || m_isCreatingObjects || m_stage->active()) {
             Notification::create("Finish the current generation/preview first",
                                  NotificationIcon::Warning)->show();
             return;
@@ -9492,43 +14215,36 @@ protected:
     }
 
     // ── Platinum queue status ──────────────────────────────────────────────
-    // 5 s poll while the popup is open and Platinum is selected. Result is a
-    // short string the cost-label tick appends. Endpoint absent → silent.
+    // 5 s poll of every coordinator while the popup is open and Platinum is
+    // selected. The aggregate is a short string the cost-label tick appends.
+    // While a request is out it also drives mid-queue failover: still queued
+    // after QUEUE_PATIENCE and another node has an idle worker → cancel and
+    // re-send there (see namespace platinum).
     void pollPlatinumStatus(float) {
-        if (m_isGenerating) return;
         std::string provider = Mod::get()->getSettingValue<std::string>("ai-provider");
         if (provider != "ollama" || !Mod::get()->getSettingValue<bool>("use-platinum")) {
             m_platinumStatus.clear();
             return;
         }
-        auto request = web::WebRequest();
-        request.timeout(std::chrono::seconds(4));
-        // Live coordinator (VLT GG-hosted distributed Ollama network).
-        m_platinumPoll.spawn(
-            request.get("http://sn-1.vltgg.net:21800/api/status"),
-            [this](web::WebResponse resp) {
-                if (!resp.ok()) { m_platinumStatus.clear(); return; }
-                auto json = resp.json();
-                if (!json) { m_platinumStatus.clear(); return; }
-                const auto j = json.unwrap();
-                if (!j.contains("coordinator")) { m_platinumStatus.clear(); return; }
-                const auto& coord = j["coordinator"];
-                auto queued  = coord["queued_requests"].asInt();
-                auto active  = coord["active_workers"].asInt();
-                auto workers = coord["workers"].asInt();
-                int q = queued  ? (int)queued.unwrap()  : 0;
-                int a = active  ? (int)active.unwrap()  : 0;
-                int w = workers ? (int)workers.unwrap() : 0;
-                if (w <= 0)
-                    m_platinumStatus = "Platinum: no workers online";
-                else if (q <= 0)
-                    m_platinumStatus = fmt::format("Platinum: idle ({} worker{})",
-                                                   w, w == 1 ? "" : "s");
-                else
-                    m_platinumStatus = fmt::format("Platinum: {} queued, {}/{} busy",
-                                                   q, a, w);
-                m_lastCostPrompt.clear();  // force the cost label to refresh
-            });
+        platinum::refresh();
+        std::string text = platinum::statusText();
+        if (text != m_platinumStatus) {
+            m_platinumStatus = std::move(text);
+            m_lastCostPrompt.clear();  // force the cost label to refresh
+        }
+
+        if (!m_isGenerating || m_platinumNode.empty()) return;
+        std::string target = platinum::migrateTarget(
+            m_platinumNode, m_platinumTried,
+            std::chrono::steady_clock::now() - m_platinumSentAt,
+            m_platinumRequestId, m_platinumBytes ? m_platinumBytes->load() : 0);
+        if (target.empty()) return;
+        log::info("Platinum: {} still queued, moving the request to idle {}",
+                  m_platinumNode, target);
+        m_listener = {};                       // drop our place in the old queue
+        m_platinumTried.push_back(std::exchange(m_platinumNode, std::string()));
+        showStatus("Platinum queue is long — moving to a free coordinator...");
+        this->callAPI(m_lastCallPrompt, m_lastCallKey);
     }
 
     // ── Idle cost estimate ─────────────────────────────────────────────────
@@ -9537,17 +14253,25 @@ protected:
     void updateCostEstimate(float) {
         // Provider chip live-refresh: settings changed behind this popup
         // (the settings popup stacks on top) used to leave stale text here.
+        // Ollama residency (load state + VRAM share from /api/ps) rides
+        // along as a suffix and turns the dot green once the model is in.
         if (m_chipLabel) {
             std::string provider = Mod::get()->getSettingValue<std::string>("ai-provider");
-            if (provider != m_chipProviderShown) {
-                m_chipProviderShown = provider;
+            ollamaRes::tick(true);
+            std::string residency = ollamaRes::chipText();
+            bool providerChanged = provider != m_chipProviderShown;
+            if (providerChanged || residency != m_chipResidencyShown) {
+                m_chipProviderShown  = provider;
+                m_chipResidencyShown = residency;
                 std::string model = getProviderModel(provider);
                 std::string shownName = provider;
                 if (provider == "custom") {
                     std::string nm = Mod::get()->getSettingValue<std::string>("custom-provider-name");
                     if (!nm.empty()) shownName = nm;
                 }
-                m_chipLabel->setString(fmt::format("{} - {}", shownName, model).c_str());
+                std::string text = fmt::format("{} - {}", shownName, model);
+                if (!residency.empty()) text += " - " + residency;
+                m_chipLabel->setString(text.c_str());
                 m_chipLabel->limitLabelWidth(168.f, 0.3f, 0.1f);
                 if (m_chipDot) {
                     bool local = provider == "ollama" || provider == "lm-studio" ||
@@ -9558,11 +14282,18 @@ protected:
                                           ? std::string("custom-provider-api-key")
                                           : provider + "-api-key").empty() ||
                                   provider == "custom";
-                    m_chipDot->setColor(local ? ui::WARN_COL
-                                      : hasAny ? ui::SUCCESS_COL : ui::ERROR_COL);
+                    auto phase = ollamaRes::phase();
+                    m_chipDot->setColor(
+                        phase == ollamaRes::Phase::Resident     ? ui::SUCCESS_COL
+                      : phase == ollamaRes::Phase::Missing ||
+                        phase == ollamaRes::Phase::Unreachable  ? ui::ERROR_COL
+                      : local                                   ? ui::WARN_COL
+                      : hasAny ? ui::SUCCESS_COL : ui::ERROR_COL);
+                }
+                if (providerChanged) {
+                    m_sysPromptLenEst = buildSystemPrompt().size();  // re-measure
+                    m_lastCostPrompt.clear();                        // force cost refresh
                 }
-                m_sysPromptLenEst = buildSystemPrompt().size();  // provider changed → re-measure
-                m_lastCostPrompt.clear();                        // force cost refresh
             }
         }
         if (!m_costLabel) return;
@@ -9686,10 +14417,14 @@ protected:
         m_toolListenerNG    = {};
         m_toolListenerWeb   = {};
         m_isGenerating = false;
+        ++m_generation;
+        releaseReservation();
         // Turn-scoped flags die with the turn — leaking them poisons the
         // next generation's gates (see startGeneration's reset block).
         m_followUpTurn    = false;
         m_critiquePending = false;
+        resetDraft();
+        cancelQualityPasses();
         if (m_session) {
             m_session->state = GenSession::State::Done;
             m_session->push(GenSession::Entry::Kind::Status, "Cancelled by user");
@@ -9817,18 +14552,30 @@ protected:
 
     // ── Level manipulation ────────────────────────────────────────────────────
 
-    void clearLevel() {
-        if (!m_editorLayer) return;
+    // False when the clear is refused: another generation's preview is
+    // staged in this editor, and wiping the level would delete its ghosts
+    // out from under the tray. The caller reports that to the user rather
+    // than quietly building alongside — a replace-level result stacked on
+    // the old level is not what was asked for.
+    bool clearLevel() {
+        if (!m_editorLayer) return true;
         auto objects = m_editorLayer->m_objects;
-        if (!objects) return;
+        if (!objects) return true;
+        if (anyStageActive()) {
+            log::info("Refusing level clear: {} preview(s) staged",
+                      activeStageCount());
+            return false;
+        }
 
         int count = objects->count();
         // One batch call instead of per-object removeObject() — the per-object
         // path does full editor bookkeeping each time and visibly hangs the
         // frame on multi-thousand-object levels.
         m_editorLayer->removeAllObjects();
+        ++s_levelMutationEpoch;
 
         log::info("Cleared {} objects from editor", count);
+        return true;
     }
 
     // Serialize the current editor objects to compact JSON so the AI can see what
@@ -9844,16 +14591,35 @@ protected:
 
         static const std::unordered_map<int, std::string>& idToName = objectIdToName();
 
+        // Counts come from the live density index; the scan below only has
+        // to find the first MAX_REPORT objects to list.
+        const auto& idx = liveDensity();
+        static constexpr std::pair<levelcheck::ObjClass, const char*> CLASSES[] = {
+            {levelcheck::kSolid, "solid"}, {levelcheck::kHazard, "hazard"},
+            {levelcheck::kOrb, "orb_pad"}, {levelcheck::kPortal, "portal"},
+            {levelcheck::kTrigger, "trigger"}, {levelcheck::kDeco, "deco"},
+            {levelcheck::kOther, "other"},
+        };
+        // The listing below takes X in [x0, x1]; the index counts [x0, x1).
+        float x1In = std::nextafter(x1, std::numeric_limits<float>::infinity());
+        int total = idx.count(x0, x1In);
+        std::string byClass;
+        for (auto& [cls, name] : CLASSES) {
+            int n = idx.count(x0, x1In, levelcheck::classBit(cls));
+            if (n == 0) continue;
+            if (!byClass.empty()) byClass += ",";
+            byClass += fmt::format("\"{}\":{}", name, n);
+        }
+
         constexpr int MAX_REPORT = 80;
-        int total = 0, reported = 0;
+        int reported = 0;
         std::string items;
         for (auto* raw : CCArrayExt<CCObject*>(objects)) {
+            if (reported >= MAX_REPORT) break;
             auto* gameObj = typeinfo_cast<GameObject*>(raw);
             if (!gameObj) continue;
             float x = gameObj->getPositionX();
             if (x < x0 || x > x1) continue;
-            ++total;
-            if (reported >= MAX_REPORT) continue;
             std::string typeName = "unknown";
             auto it = idToName.find(gameObj->m_objectID);
             if (it != idToName.end()) typeName = it->second;
@@ -9864,12 +14630,12 @@ protected:
         }
         return fmt::format(
             "{{\"x_range\":[{:.0f},{:.0f}],\"region_object_count\":{},"
-            "\"shown\":{},\"objects\":[{}]}}",
-            x0, x1, total, reported, items);
+            "\"by_class\":{{{}}},\"shown\":{},\"objects\":[{}]}}",
+            x0, x1, total, byClass, reported, items);
     }
 
     // Current editor objects as a mod-format matjson array (capped) — the
-    // source for mutation/co-op EAS context via eas::objectsToEAS.
+    // source for mutation/co-op EAS context via eas::objectsToEASCompact.
     matjson::Value buildLevelDataArray(int cap = 500) {
         auto arr = matjson::Value::array();
         // revalidate first: the editor scene may have been freed mid-loop
@@ -9980,7 +14746,7 @@ protected:
         objs.reserve(m_editorLayer->m_objects->count());
         for (auto* raw : CCArrayExt<CCObject*>(m_editorLayer->m_objects)) {
             auto* go = typeinfo_cast<GameObject*>(raw);
-            if (!go || s_editOpDeleted.count(go)) continue;
+            if (!go || stageHidden(go, m_stage.get())) continue;
             objs.push_back(go);
         }
         std::sort(objs.begin(), objs.end(), [](GameObject* a, GameObject* b) {
@@ -10010,11 +14776,16 @@ protected:
         }
         if ((int)objs.size() > listed) {
             out += "DENSITY BEYOND THE LISTING (use rect:/id: selectors there):\n";
-            std::map<int, int> buckets;
-            for (size_t i = listed; i < objs.size(); ++i)
-                ++buckets[(int)(objs[i]->getPositionX() / 500.f)];
-            for (auto& [b, n] : buckets)
-                out += fmt::format("  X {}-{}: {} objects\n", b * 500, b * 500 + 500, n);
+            const auto& idx = liveDensity();
+            float from = objs[listed]->getPositionX();
+            int last = (int)(objs.back()->getPositionX() / 500.f);
+            for (int b = std::max(0, (int)(from / 500.f)); b <= last; ++b) {
+                // The first bucket starts at the first unlisted object.
+                float lo = std::max(b * 500.f, from), hi = b * 500.f + 500.f;
+                int n = idx.count(lo, hi);
+                if (n > 0)
+                    out += fmt::format("  X {:.0f}-{:.0f}: {} objects\n", lo, hi, n);
+            }
         }
         m_editInventory.assign(objs.begin(), objs.begin() + listed);
         return out;
@@ -10058,7 +14829,7 @@ protected:
             if (m_editInventory.empty()) buildLevelInventoryListing(2500);
             for (int i = a; i <= b && i < (int)m_editInventory.size(); ++i) {
                 GameObject* go = m_editInventory[i];
-                if (go && go->getParent() && !s_editOpDeleted.count(go)
+                if (go && go->getParent() && !stageHidden(go, m_stage.get())
                     && passesFilter(go))
                     out.push_back(go);
                 if (out.size() >= CAP) break;
@@ -10084,6 +14855,20 @@ protected:
             rx0 = std::min(v[0], v[2]); rx1 = std::max(v[0], v[2]);
             ry0 = std::min(v[1], v[3]); ry1 = std::max(v[1], v[3]);
             useRect = true;
+        } else if (sel.rfind("group:", 0) == 0) {
+            // group:N — every member of group N, from the live trigger
+            // graph's membership index instead of a whole-level scan.
+            int g = geode::utils::numFromString<int>(sel.substr(6)).unwrapOr(0);
+            if (g <= 0) return out;
+            const auto& graph = liveGraph();
+            for (uint32_t node : graph.members(g)) {
+                GameObject* go = m_liveGraphObjs[node];
+                if (go && go->getParent() && !stageHidden(go, m_stage.get())
+                    && passesFilter(go))
+                    out.push_back(go);
+                if (out.size() >= CAP) break;
+            }
+            return out;
         } else if (sel.rfind("id:", 0) == 0) {
             std::string body = sel.substr(3);
             int id = geode::utils::numFromString<int>(body).unwrapOr(0);
@@ -10100,7 +14885,7 @@ protected:
 
         for (auto* raw : CCArrayExt<CCObject*>(m_editorLayer->m_objects)) {
             auto* go = typeinfo_cast<GameObject*>(raw);
-            if (!go || s_editOpDeleted.count(go)) continue;
+            if (!go || stageHidden(go, m_stage.get())) continue;
             if (useRect) {
                 float x = go->getPositionX(), y = go->getPositionY();
                 if (x < rx0 || x > rx1 || y < ry0 || y > ry1) continue;
@@ -10113,37 +14898,23 @@ protected:
     }
 
     // Journal an object once (first touch wins — that's the state Deny
-    // must restore).
-    void journalEditOp(GameObject* go, bool asDelete) {
-        for (auto& rec : s_editOpJournal)
-            if (rec.obj == go) {
-                if (asDelete) rec.deleted = true;
-                return;
-            }
-        EditOpRecord rec;
-        rec.obj        = go;
-        rec.pos        = go->getPosition();
-        rec.rot        = go->getRotation();
-        rec.scaleX     = go->getScaleX();
-        rec.scaleY     = go->getScaleY();
-        if (go->m_baseColor) {
-            rec.hadBaseColor = true;
-            rec.baseColorID  = go->m_baseColor->m_colorID;
-        }
-        if (go->m_detailColor) {
-            rec.hadDetailColor = true;
-            rec.detailColorID  = go->m_detailColor->m_colorID;
-        }
-        rec.wasVisible = go->isVisible();
-        rec.deleted    = asDelete;
-        s_editOpJournal.push_back(std::move(rec));
+    // must restore). Refused when another context already holds it: the
+    // op skips that object rather than stacking two journals on it.
+    bool journalEditOp(GameObject* go, bool asDelete) {
+        if (stageForeign(go, m_stage.get())) return false;
+        m_stage->editOps.touch(go, asDelete);
+        return true;
     }
 
     // Execute every op against the live editor. Returns objects affected.
+    // Moves are plain setPosition calls; the editor's spatial sections are
+    // refreshed once per moved object after all ops ran, so a bulk rework
+    // doesn't pay a section update per op per object.
     int applyEditOps(const std::vector<matjson::Value>& ops) {
         if (!revalidateEditor()) return 0;
-        auto* ui = m_editorLayer->m_editorUI;
         int affected = 0;
+        std::vector<GameObject*> moved;
+        std::unordered_set<GameObject*> movedSeen;
         for (const auto& op : ops) {
             std::string kind = levelcheck::getStr(op, "op", "");
             auto targets = resolveOpSelector(op);
@@ -10157,19 +14928,15 @@ protected:
                 float dy = levelcheck::getFloat(op, "dy", 0.f);
                 if (dx == 0.f && dy == 0.f) continue;
                 for (auto* go : targets) {
-                    journalEditOp(go, false);
-                    if (ui) ui->moveObject(go, {dx, dy});
-                    else {
-                        go->setPosition(go->getPosition() + CCPoint{dx, dy});
-                        m_editorLayer->updateObjectSection(go);
-                    }
+                    if (!journalEditOp(go, false)) continue;
+                    go->setPosition(go->getPosition() + CCPoint{dx, dy});
+                    if (movedSeen.insert(go).second) moved.push_back(go);
                     ++affected;
                 }
             } else if (kind == "delete") {
                 for (auto* go : targets) {
-                    journalEditOp(go, true);
+                    if (!journalEditOp(go, true)) continue;
                     go->setVisible(false);          // soft until Accept
-                    s_editOpDeleted.insert(go);
                     ++affected;
                 }
             } else if (kind == "edit") {
@@ -10180,7 +14947,7 @@ protected:
                 int  colorCh  = (int)levelcheck::getFloat(op, "color_channel", 0.f);
                 int  detailCh = (int)levelcheck::getFloat(op, "detail_color_channel", 0.f);
                 for (auto* go : targets) {
-                    journalEditOp(go, false);
+                    if (!journalEditOp(go, false)) continue;
                     if (hasRot)
                         go->setRotation(levelcheck::getFloat(op, "rotation", 0.f));
                     if (hasScale)
@@ -10195,9 +14962,12 @@ protected:
                 }
             }
         }
-        if (affected > 0)
+        for (auto* go : moved) m_editorLayer->updateObjectSection(go);
+        if (affected > 0) {
+            ++s_levelMutationEpoch;
             log::info("Applied {} edit op(s) touching {} objects",
                       ops.size(), affected);
+        }
         return affected;
     }
 
@@ -10218,8 +14988,8 @@ protected:
 
     // ── Progressive object spawner ────────────────────────────────────────────
 
-    // Simulated cube run drawn over the staged blueprint: green where the
-    // bot survives, red rings where it dies. Advisory only.
+    // Verifier witness route drawn over the staged blueprint: green where a
+    // route exists, a red ring where every timing dies. Advisory only.
     // ── Vision: level snapshot for image-capable models ─────────────────────
     // Renders the editor's object layer (framed around the generated region)
     // to a small PNG and returns it base64-encoded; empty when capture isn't
@@ -10234,7 +15004,7 @@ protected:
         size_t editorCount = m_editorLayer->m_objects
             ? (size_t)m_editorLayer->m_objects->count() : 0;
         size_t fp = m_accumulatedObjects.size() * 1315423911u
-                  ^ s_previewObjects.size()     * 2654435761u
+                  ^ m_stage->previewObjects.size() * 2654435761u
                   ^ editorCount                 * 97u;
         if (fp == m_snapCacheFp && !m_snapCacheB64.empty())
             return m_snapCacheB64;
@@ -10311,15 +15081,79 @@ protected:
     // the old level until apply).
     std::string visionSnapshotIfSupported() {
         if (!Mod::get()->getSettingValue<bool>("enable-vision")) return "";
-        if (m_shouldClearLevel && !s_inPreviewMode) return "";
-        std::string provider = Mod::get()->getSettingValue<std::string>("ai-provider");
+        if (m_shouldClearLevel && !m_stage->inPreview) return "";
+        std::string provider = genProvider();
         if (!toolUse::supportsVision(provider, getProviderModel(provider)))
             return "";
         return captureLevelSnapshotB64();
     }
 
+    // Tool-facing verdict of the input-search verifier: a witness summary,
+    // or the first X no timing survives (flagged when the search dropped
+    // states, inconclusive past objects the bot can't play).
+    static std::string describeVerify(const levelcheck::VerifyResult& sim) {
+        if (sim.passable) {
+            std::string holds;
+            for (size_t i = 0; i < sim.holds.size() && i < 6; ++i)
+                holds += fmt::format("{}{:.0f}-{:.0f}", i ? ", " : "",
+                                     sim.holds[i].first, sim.holds[i].second);
+            if (sim.holds.size() > 6) holds += ", ...";
+            return fmt::format(
+                "PASSABLE: the input-search bot found a route to the end (X={:.0f}) "
+                "with {} press(es){}{}. Sections are beatable with the right timing.",
+                sim.reachedX, sim.holds.size(), holds.empty() ? "" : " — holds at X=",
+                holds);
+        }
+        if (sim.reachedX <= 0.f && sim.reason.empty())
+            return "(nothing collidable in the draft yet)";
+        if (!sim.modeled)
+            return fmt::format(
+                "INCONCLUSIVE: the bot stopped at X={:.0f} ({}), but before that the "
+                "draft uses objects its physics doesn't model (gravity, size, dual or "
+                "teleport portals, special orbs/pads). Not a verdict — don't rebuild "
+                "that stretch on this alone.",
+                sim.blockedX, sim.reason);
+        return fmt::format(
+            "BLOCKED at X={:.0f}: {}. {} Fix that spot first (wider spacing, "
+            "lower obstacles, a bigger gap, or an orb/pad assist).",
+            sim.blockedX, sim.reason,
+            sim.exhaustive
+                ? "No input sequence gets past it in the bot's physics model."
+                : "No route found (search beam was saturated, so this is likely "
+                  "but not proven impossible).");
+    }
+
+    // Column scan + input-search verifier over `arr` on a worker, posted
+    // back to the main thread the way copilotTick does it: a dense draft
+    // keeps the bot busy for a noticeable stretch, which used to be a
+    // frozen frame. `then` only runs while the popup is still on the
+    // generation that asked.
+    using VerifyThen = std::function<void(levelcheck::Result, levelcheck::VerifyResult)>;
+    void verifyAsync(matjson::Value arr, levelcheck::TriggerGraph graph, VerifyThen then) {
+        float groundY = (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y");
+        // Moved, never copied, off the main thread (see copilotTick).
+        Ref<AIGeneratorPopup> self = this;
+        std::thread([self = std::move(self), gen = m_generation, arr = std::move(arr),
+                     graph = std::move(graph), groundY, then = std::move(then)]() mutable {
+            const levelcheck::TriggerGraph* g = graph.size() ? &graph : nullptr;
+            auto pass  = levelcheck::check(arr, g);
+            auto route = levelcheck::verifyPassable(arr, groundY, g);
+            Loader::get()->queueInMainThread(
+                [self = std::move(self), gen, pass = std::move(pass),
+                 route = std::move(route), then = std::move(then)]() mutable {
+                    if (self->m_generation != gen) return;
+                    then(std::move(pass), std::move(route));
+                });
+        }).detach();
+    }
+
+    // Snapshot of the accumulator and its trigger graph for verifyAsync.
+    void verifyDraftAsync(VerifyThen then) {
+        verifyAsync(m_accumulatedObjects, draftGraph(), std::move(then));
+    }
+
     void drawPlaytestGhost() {
-        removePlaytestGhost();
+        removePlaytestGhost(*m_stage);
         if (!m_editorLayer || !m_editorLayer->m_objectLayer) return;
         if (m_deferredObjects.empty()) return;
 
@@ -10338,25 +15172,37 @@ protected:
             if (sc) o["scale"] = sc.unwrap();
             arr.push(std::move(o));
         }
-        auto sim = levelcheck::simulateCube(arr,
-            (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"));
+        // Drawn when the verdict lands, onto the context that asked — and
+        // only while it is still in review.
+        verifyAsync(std::move(arr), {},
+            [this, stage = m_stage.get()](levelcheck::Result, levelcheck::VerifyResult sim) {
+                if (m_stage.get() != stage || !stage->active() || stage->playtestGhost) return;
+                if (!revalidateEditor() || !m_editorLayer->m_objectLayer) return;
+                drawGhostRoute(sim);
+            });
+    }
+
+    void drawGhostRoute(const levelcheck::VerifyResult& sim) {
         if (sim.path.size() < 2) return;
 
+        // Witness route (or the furthest any input got) plus, when nothing
+        // survives and the bot could play everything up to there, a marker
+        // where every timing dies.
         auto draw = CCDrawNode::create();
         constexpr ccColor4F PATH_COL  {0.25f, 0.9f, 0.35f, 0.55f};
         constexpr ccColor4F DEATH_COL {1.f, 0.25f, 0.25f, 0.9f};
         for (size_t i = 1; i < sim.path.size(); ++i)
             draw->drawSegment(sim.path[i - 1], sim.path[i], 1.2f, PATH_COL);
-        for (auto& d : sim.deaths) {
-            draw->drawDot({d.x, d.y}, 6.f, DEATH_COL);
-            draw->drawCircle({d.x, d.y}, 14.f, DEATH_COL, 1.5f, ccColor4F{0,0,0,0}, 24);
+        if (sim.blocked()) {
+            CCPoint at{sim.blockedX, sim.blockedY ? sim.blockedY : sim.path.back().y};
+            draw->drawDot(at, 6.f, DEATH_COL);
+            draw->drawCircle(at, 14.f, DEATH_COL, 1.5f, ccColor4F{0,0,0,0}, 24);
         }
         draw->setZOrder(900);
         m_editorLayer->m_objectLayer->addChild(draw);
-        s_playtestGhost = draw;
-        if (!sim.deaths.empty())
-            log::info("Playtest ghost: {} death(s), first at X={:.0f}",
-                      sim.deaths.size(), sim.deaths[0].x);
+        m_stage->playtestGhost = draw;
+        if (sim.blocked())
+            log::info("Playtest ghost: no route past X={:.0f} ({})", sim.blockedX, sim.reason);
     }
 
     // Spawns one deferred object as a ghost. Returns false when the editor
@@ -10364,7 +15210,7 @@ protected:
     bool spawnDeferredOne() {
         if (!revalidateEditor()) {
             log::error("Editor layer destroyed during object creation!");
-            m_isCreatingObjects = false;
+            releaseReservation();
             return false;
         }
         auto& deferred = m_deferredObjects[m_currentObjectIndex];
@@ -10376,28 +15222,67 @@ protected:
             // (Accept restores them), then move the object onto the preview
             // layer. The editor is already switched there, so the new build
             // renders full-color over the faded level.
-            s_previewIntendedLayers.emplace_back(
+            m_stage->intendedLayers.emplace_back(
                 gameObj->m_editorLayer, gameObj->m_editorLayer2);
-            gameObj->m_editorLayer  = s_previewLayer;
-            gameObj->m_editorLayer2 = s_previewLayer;
-            s_previewObjects.emplace_back(gameObj);
+            gameObj->m_editorLayer  = m_stage->previewLayer;
+            gameObj->m_editorLayer2 = m_stage->previewLayer;
+            m_stage->previewObjects.emplace_back(gameObj);
         }
         ++m_currentObjectIndex;
         return true;
     }
 
+    // Abort path for a fresh preview: reservePreviewLayer registered the
+    // context before the first ghost spawned, so a spawn that dies before
+    // finishSpawning (editor gone, cancel, error, engine freed) must hand it
+    // back — otherwise it sits in s_stagings holding its layer, and the
+    // session's next engine (acquireStage) inherits a half-built preview.
+    // Ghosts spawned so far and this turn's edit ops are undone with it.
+    void releaseReservation() {
+        if (m_stage->active()) return;
+        if (std::find(s_stagings.begin(), s_stagings.end(), m_stage) == s_stagings.end())
+            return;
+        m_isCreatingObjects = false;
+        m_deferredObjects.clear();
+        m_currentObjectIndex = 0;
+        if (revalidateEditor()) {
+            rollbackEditOps(m_editorLayer, *m_stage);
+            for (auto& objRef : m_stage->previewObjects)
+                if (GameObject* obj = objRef; obj && obj->getParent())
+                    m_editorLayer->removeObject(obj, true);
+            if (!m_stage->previewObjects.empty()) ++s_levelMutationEpoch;
+            if (m_stage->previewLayer >= 0 && focusedStage() == nullptr)
+                setEditorCurrentLayer(m_editorLayer, m_stage->layerBefore);
+        } else {
+            m_stage->editOps.clear();
+        }
+        m_stage->previewObjects.clear();
+        m_stage->intendedLayers.clear();
+        m_stage->previewLayer  = -1;
+        m_stage->layerReserved = false;
+        retireStage(m_stage);
+    }
+
     // Completion transition shared by the 20 Hz tick and immediate staging.
     void finishSpawning() {
         m_isCreatingObjects = false;
+        if (m_traceSpawnStartUs) {
+            trace::record(traceSession(), "spawn", "stage", m_traceSpawnStartUs, trace::nowUs());
+            m_traceSpawnStartUs = 0;
+        }
 
-        // Playtest ghost: run the cube bot over what was just staged and
-        // draw its trajectory on the editor (sub-millisecond — swept
-        // geometry, one pass per generation).
+        // Playtest ghost: run the input-search verifier over what was just
+        // staged and draw its witness route on the editor (one search per
+        // generation, segments in parallel).
         this->drawPlaytestGhost();
 
         // Enter blueprint preview mode — ghost objects are placed,
-        // user must accept or deny via buttons on the editor UI.
-        s_inPreviewMode = true;
+        // user must accept or deny via buttons on the editor UI. Another
+        // context may already be under review; this one then waits its
+        // turn on its own layer (the tray's counter shows the queue).
+        m_stage->inPreview = true;
+        registerStage(m_stage);
+        bool focused = focusedStage() == m_stage;
 
         if (m_editorLayer && m_editorLayer->m_editorUI) {
             m_editorLayer->m_editorUI->updateButtons();
@@ -10407,20 +15292,24 @@ protected:
         if (m_generateBtn) m_generateBtn->setEnabled(true);
         // Edit ops (moves/deletes/restyles of existing objects) are part of
         // the staged changeset too — surface them next to the spawn count.
-        std::string editNote = s_editOpJournal.empty()
+        std::string editNote = m_stage->editOps.empty()
             ? std::string()
-            : fmt::format(" + {} edited", s_editOpJournal.size());
+            : fmt::format(" + {} edited", m_stage->editOps.size());
         showStatus(fmt::format("Preview: {} objects{}",
-                               s_previewObjects.size(), editNote), false);
+                               m_stage->previewObjects.size(), editNote), false);
         if (m_session) {
             m_session->state = GenSession::State::Staged;
             m_session->push(GenSession::Entry::Kind::Status,
                 fmt::format("Staged {} objects{} on preview layer {}",
-                            s_previewObjects.size(), editNote, s_previewLayer));
+                            m_stage->previewObjects.size(), editNote,
+                            m_stage->previewLayer));
         }
         Notification::create(
-            fmt::format("Preview on layer {}: {} objects{} — accept or deny",
-                s_previewLayer, s_previewObjects.size(), editNote),
+            focused
+                ? fmt::format("Preview on layer {}: {} objects{} — accept or deny",
+                    m_stage->previewLayer, m_stage->previewObjects.size(), editNote)
+                : fmt::format("Staged on layer {}: {} objects{} — queued for review",
+                    m_stage->previewLayer, m_stage->previewObjects.size(), editNote),
             NotificationIcon::Info
         )->show();
 
@@ -10446,710 +15335,71 @@ protected:
         while (m_currentObjectIndex < m_deferredObjects.size())
             if (!spawnDeferredOne()) return;
         finishSpawning();
-    }
-
-    void updateObjectCreation(float /*dt*/) {
-        if (!m_isCreatingObjects || m_deferredObjects.empty()) return;
-
-        if (m_currentObjectIndex >= m_deferredObjects.size()) {
-            finishSpawning();
-            return;
-        }
-
-        for (int b = 0; b < m_spawnBatchSize && m_currentObjectIndex < m_deferredObjects.size(); ++b)
-            if (!spawnDeferredOne()) return;
-
-        if (m_currentObjectIndex % 10 == 0) {
-            float pct = (float)m_currentObjectIndex / (float)m_deferredObjects.size() * 100.0f;
-            showStatus(fmt::format("Creating objects... {:.0f}%", pct), false);
-        }
-    }
-
-    void applyObjectProperties(GameObject* gameObj, matjson::Value& objData) {
-        if (!gameObj) return;
-        bool advFeatures = m_advFeatures;
-
-        // Merge in any block_template properties for this object's type FIRST,
-        // so they act as defaults the per-object fields can override. Mutates
-        // objData in place; safe because we only fill in missing keys.
-        int templateMerged = applyBlockTemplateToObject(objData);
-        if (templateMerged > 0) {
-            log::debug("Applied block template ({} props) to object id {}",
-                       templateMerged, gameObj->m_objectID);
-        }
-
-        {
-            // Probe through a CONST ref: non-const matjson operator[] inserts a
-            // null member on every missing key — per object, per spawn tick.
-            const matjson::Value& objConst = objData;
-            // ── Basic transform ───────────────────────────────────────────────
-            auto rotResult = objConst["rotation"].asDouble();
-            if (rotResult) {
-                float r = static_cast<float>(rotResult.unwrap());
-                if (r >= -360.0f && r <= 360.0f) gameObj->setRotation(r);
-            }
-            auto scaleResult = objConst["scale"].asDouble();
-            if (scaleResult) {
-                float s = static_cast<float>(scaleResult.unwrap());
-                if (s >= 0.1f && s <= 10.0f) gameObj->setScale(s);
-            }
-            auto flipXResult = objConst["flip_x"].asBool();
-            if (flipXResult && flipXResult.unwrap())
-                gameObj->setScaleX(-gameObj->getScaleX());
-
-            auto flipYResult = objConst["flip_y"].asBool();
-            if (flipYResult && flipYResult.unwrap())
-                gameObj->setScaleY(-gameObj->getScaleY());
-
-            // ── Z layering & editor layers ────────────────────────────────────
-            // The EAS parser and macro passthroughs have carried these fields
-            // since day one; this is where they finally land on the GameObject.
-            // ZLayer uses GD's odd-number scheme: B5=-5, B4=-3, B3=-1, B2=1,
-            // B1=3, Default=0, T1=5..T4=11 — accept those values verbatim.
-            auto zLayerResult = objConst["z_layer"].asInt();
-            if (zLayerResult) {
-                // Only odd values + 0 are real ZLayer members; snap anything
-                // else (the AI loves z_layer=2) to the nearest valid one.
-                static constexpr int kValidZLayers[] = {-5, -3, -1, 0, 1, 3, 5, 7, 9, 11};
-                int zl = std::clamp((int)zLayerResult.unwrap(), -5, 11);
-                int best = 0, bestDist = 99;
-                for (int v : kValidZLayers) {
-                    int d = std::abs(zl - v);
-                    if (d < bestDist) { bestDist = d; best = v; }
-                }
-                // setCustomZLayer also re-parents the sprite to the right
-                // layer batch node — assigning m_zLayer alone leaves the
-                // ghost rendering in its original layer until reload.
-                gameObj->setCustomZLayer(best);
-            }
-            auto zOrderResult = objConst["z_order"].asInt();
-            if (zOrderResult) {
-                gameObj->m_zOrder = std::clamp((int)zOrderResult.unwrap(), -999, 999);
-            }
-            auto edLayerResult = objConst["editor_layer"].asInt();
-            if (edLayerResult) {
-                gameObj->m_editorLayer =
-                    (short)std::clamp((int)edLayerResult.unwrap(), 0, 999);
-            }
-            auto edLayer2Result = objConst["editor_layer_2"].asInt();
-            if (edLayer2Result) {
-                gameObj->m_editorLayer2 =
-                    (short)std::clamp((int)edLayer2Result.unwrap(), 0, 999);
-            }
-
-            // ── Group IDs (advanced features) ─────────────────────────────────
-            if (advFeatures && objData.contains("groups") && objConst["groups"].isArray()) {
-                auto& groupsArr = objConst["groups"];
-                int assigned = 0;
-                for (size_t gi = 0; gi < groupsArr.size() && assigned < 10; ++gi) {
-                    auto gid = groupsArr[gi].asInt();
-                    if (gid) {
-                        int groupID = gid.unwrap();
-                        if (groupID >= 1 && groupID <= 9999) {
-                            if (gameObj->addToGroup(groupID) == 1 && m_editorLayer) {
-                                m_editorLayer->addToGroup(gameObj, groupID, false);
-                                ++assigned;
-                            }
-                        }
-                    }
-                }
-            }
-
-            // ── Color channel assignment ──────────────────────────────────────
-            // Assigns the object's base color to a GD color channel (1-999).
-            // Objects on the same channel change together when a color trigger fires.
-            auto baseColorResult = objConst["color_channel"].asInt();
-            if (baseColorResult) {
-                int ch = std::clamp((int)baseColorResult.unwrap(), 1, 1010);
-                if (gameObj->m_baseColor) {
-                    gameObj->m_baseColor->m_colorID = ch;
-                }
-            }
-
-            auto detailColorResult = objConst["detail_color_channel"].asInt();
-            if (detailColorResult) {
-                int ch = std::clamp((int)detailColorResult.unwrap(), 1, 1010);
-                if (gameObj->m_detailColor) {
-                    gameObj->m_detailColor->m_colorID = ch;
-                }
-            }
-
-            // ── 2.2 editor flags (any object) ─────────────────────────────────
-            // Set-only (true): all members verified against the 2.2074
-            // bindings. passable = player phases through a solid block;
-            // no_touch = hazard loses its hitbox (decorative spikes).
-            {
-                auto setFlag = [&objConst](const char* key, bool& member) {
-                    auto r = objConst[key].asBool();
-                    if (r && r.unwrap()) member = true;
-                };
-                setFlag("passable",    gameObj->m_isPassable);
-                setFlag("no_touch",    gameObj->m_isNoTouch);
-                setFlag("hide",        gameObj->m_isHide);
-                setFlag("no_glow",     gameObj->m_hasNoGlow);
-                setFlag("dont_fade",   gameObj->m_isDontFade);
-                setFlag("dont_enter",  gameObj->m_isDontEnter);
-                setFlag("high_detail", gameObj->m_isHighDetail);
-                setFlag("no_effects",  gameObj->m_hasNoEffects);
-            }
-
-            // One RTTI check for every trigger block below — the old code
-            // repeated typeinfo_cast<EffectGameObject*> in each of the 9
-            // per-trigger branches.
-            auto* effectObj = advFeatures
-                ? typeinfo_cast<EffectGameObject*>(gameObj) : nullptr;
-
-            // ── Multi-activate (orbs, pads, triggers, portals) ─────────────
-            if (advFeatures && effectObj) {
-                auto multiResult = objConst["multi_activate"].asBool();
-                if (multiResult && multiResult.unwrap()) {
-                    effectObj->m_isMultiTriggered = true;
-                }
-            }
-
-            // ── Color Trigger properties (advanced features, ID 899) ───────────
-            if (advFeatures && gameObj->m_objectID == 899) {
-                if (!effectObj) return;
-
-                auto channelResult = objConst["color_channel"].asInt();
-                if (channelResult) {
-                    effectObj->m_targetColor = std::clamp((int)channelResult.unwrap(), 1, 1010);
-                }
-
-                auto colorHexResult = objConst["color"].asString();
-                if (!colorHexResult && objConst.contains("color") &&
-                    objConst["color"].isArray() && objConst["color"].size() >= 3) {
-                    // EAS-parser origin: color stored as [r,g,b].
-                    const auto& carr = objConst["color"];
-                    auto rr = carr[0].asInt(); auto gg = carr[1].asInt(); auto bb = carr[2].asInt();
-                    effectObj->m_triggerTargetColor = {
-                        (GLubyte)std::clamp(rr ? (int)rr.unwrap() : 255, 0, 255),
-                        (GLubyte)std::clamp(gg ? (int)gg.unwrap() : 255, 0, 255),
-                        (GLubyte)std::clamp(bb ? (int)bb.unwrap() : 255, 0, 255)};
-                }
-                if (colorHexResult) {
-                    GLubyte r = 255, g = 255, b = 255;
-                    if (parseHexColor(colorHexResult.unwrap(), r, g, b)) {
-                        effectObj->m_triggerTargetColor = {r, g, b};
-                    }
-                }
-
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult) {
-                    effectObj->m_duration = std::clamp(
-                        static_cast<float>(durResult.unwrap()), 0.0f, 30.0f);
-                }
-
-                auto blendResult = objConst["blending"].asBool();
-                if (blendResult) {
-                    effectObj->m_usesBlending = blendResult.unwrap();
-                }
-
-                auto opacityResult = objConst["opacity"].asDouble();
-                if (opacityResult) {
-                    effectObj->m_opacity = std::clamp(
-                        static_cast<float>(opacityResult.unwrap()), 0.0f, 1.0f);
-                }
-
-            }
-
-            // ── Move Trigger properties (advanced features, ID 901) ────────────
-            if (advFeatures && gameObj->m_objectID == 901) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto moveXResult = objConst["move_x"].asDouble();
-                auto moveYResult = objConst["move_y"].asDouble();
-                float offsetX = moveXResult ? static_cast<float>(moveXResult.unwrap()) : 0.0f;
-                float offsetY = moveYResult ? static_cast<float>(moveYResult.unwrap()) : 0.0f;
-                offsetX = std::clamp(offsetX, -32767.0f, 32767.0f);
-                offsetY = std::clamp(offsetY, -32767.0f, 32767.0f);
-                effectObj->m_moveOffset = CCPoint(offsetX, offsetY);
-
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult) {
-                    effectObj->m_duration = std::clamp(
-                        static_cast<float>(durResult.unwrap()), 0.0f, 30.0f);
-                }
-
-                auto easingResult = objConst["easing"].asInt();
-                if (easingResult) {
-                    int easingVal = std::clamp((int)easingResult.unwrap(), 0, 18);
-                    effectObj->m_easingType = (EasingType)easingVal;
-                } else {
-                    effectObj->m_easingType = EasingType::None;
-                }
-
-                auto easingRateResult = objConst["easing_rate"].asDouble();
-                if (easingRateResult) {
-                    effectObj->m_easingRate = std::clamp(
-                        static_cast<float>(easingRateResult.unwrap()), 0.01f, 100.0f);
-                }
-
-                auto lockXResult = objConst["lock_to_player_x"].asBool();
-                if (lockXResult && lockXResult.unwrap()) {
-                    effectObj->m_lockToPlayerX = true;
-                }
-
-                auto lockYResult = objConst["lock_to_player_y"].asBool();
-                if (lockYResult && lockYResult.unwrap()) {
-                    effectObj->m_lockToPlayerY = true;
-                }
-
-            }
-
-            // ── Alpha Trigger (ID 1007) — fades a group's opacity ──────────────
-            if (advFeatures && gameObj->m_objectID == 1007) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto opacityResult = objConst["opacity"].asDouble();
-                if (opacityResult) {
-                    effectObj->m_opacity = std::clamp(
-                        static_cast<float>(opacityResult.unwrap()), 0.0f, 1.0f);
-                }
-
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult) {
-                    effectObj->m_duration = std::clamp(
-                        static_cast<float>(durResult.unwrap()), 0.0f, 30.0f);
-                }
-
-                auto easingResult = objConst["easing"].asInt();
-                if (easingResult) {
-                    effectObj->m_easingType = (EasingType)std::clamp((int)easingResult.unwrap(), 0, 18);
-                }
-
-                auto easingRateResult = objConst["easing_rate"].asDouble();
-                if (easingRateResult) {
-                    effectObj->m_easingRate = std::clamp(
-                        static_cast<float>(easingRateResult.unwrap()), 0.01f, 100.0f);
-                }
-
-            }
-
-            // ── Rotate Trigger (ID 1346) — rotates a group around a center ─────
-            if (advFeatures && gameObj->m_objectID == 1346) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto centerGroupResult = objConst["center_group"].asInt();
-                if (centerGroupResult) {
-                    effectObj->m_centerGroupID = std::clamp((int)centerGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto degreesResult = objConst["degrees"].asDouble();
-                if (degreesResult) {
-                    effectObj->m_rotationDegrees = static_cast<float>(degreesResult.unwrap());
-                }
-
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult) {
-                    effectObj->m_duration = std::clamp(
-                        static_cast<float>(durResult.unwrap()), 0.0f, 30.0f);
-                }
-
-                auto easingResult = objConst["easing"].asInt();
-                if (easingResult) {
-                    effectObj->m_easingType = (EasingType)std::clamp((int)easingResult.unwrap(), 0, 18);
-                }
-
-                auto easingRateResult = objConst["easing_rate"].asDouble();
-                if (easingRateResult) {
-                    effectObj->m_easingRate = std::clamp(
-                        static_cast<float>(easingRateResult.unwrap()), 0.01f, 100.0f);
-                }
-
-                auto lockRotResult = objConst["lock_object_rotation"].asBool();
-                if (lockRotResult && lockRotResult.unwrap()) {
-                    effectObj->m_lockObjectRotation = true;
-                }
-
-            }
-
-            // ── Toggle Trigger (ID 1049) — shows or hides a group ──────────────
-            if (advFeatures && gameObj->m_objectID == 1049) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto activateResult = objConst["activate_group"].asBool();
-                if (activateResult) {
-                    effectObj->m_activateGroup = activateResult.unwrap();
-                }
-
-            }
-
-            // ── Pulse Trigger (ID 1006) — pulses color on a group or channel ───
-            if (advFeatures && gameObj->m_objectID == 1006) {
-                if (!effectObj) return;
-
-                // Can target either a group or a color channel
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                    effectObj->m_pulseTargetType = 1;  // group
-                }
-
-                auto targetColorResult = objConst["target_color_channel"].asInt();
-                if (targetColorResult) {
-                    effectObj->m_targetColor = std::clamp((int)targetColorResult.unwrap(), 1, 1010);
-                    effectObj->m_pulseTargetType = 0;  // color channel
-                }
-
-                auto colorHexResult = objConst["color"].asString();
-                if (!colorHexResult && objConst.contains("color") &&
-                    objConst["color"].isArray() && objConst["color"].size() >= 3) {
-                    // EAS-parser origin: color stored as [r,g,b].
-                    const auto& carr = objConst["color"];
-                    auto rr = carr[0].asInt(); auto gg = carr[1].asInt(); auto bb = carr[2].asInt();
-                    effectObj->m_triggerTargetColor = {
-                        (GLubyte)std::clamp(rr ? (int)rr.unwrap() : 255, 0, 255),
-                        (GLubyte)std::clamp(gg ? (int)gg.unwrap() : 255, 0, 255),
-                        (GLubyte)std::clamp(bb ? (int)bb.unwrap() : 255, 0, 255)};
-                }
-                if (colorHexResult) {
-                    GLubyte r = 255, g = 255, b = 255;
-                    if (parseHexColor(colorHexResult.unwrap(), r, g, b)) {
-                        effectObj->m_triggerTargetColor = {r, g, b};
-                    }
-                }
-
-                auto fadeInResult = objConst["fade_in"].asDouble();
-                if (fadeInResult) {
-                    effectObj->m_fadeInDuration = std::clamp(
-                        static_cast<float>(fadeInResult.unwrap()), 0.0f, 10.0f);
-                }
-
-                auto holdResult = objConst["hold"].asDouble();
-                if (holdResult) {
-                    effectObj->m_holdDuration = std::clamp(
-                        static_cast<float>(holdResult.unwrap()), 0.0f, 10.0f);
-                }
-
-                auto fadeOutResult = objConst["fade_out"].asDouble();
-                if (fadeOutResult) {
-                    effectObj->m_fadeOutDuration = std::clamp(
-                        static_cast<float>(fadeOutResult.unwrap()), 0.0f, 10.0f);
-                }
-
-                auto exclusiveResult = objConst["exclusive"].asBool();
-                if (exclusiveResult) {
-                    effectObj->m_pulseExclusive = exclusiveResult.unwrap();
-                }
-
-            }
-
-            // ── Spawn Trigger (ID 1268) — spawns/activates another trigger group
-            if (advFeatures && gameObj->m_objectID == 1268) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-                auto delayResult = objConst["delay"].asDouble();
-                if (delayResult) {
-                    effectObj->m_spawnTriggerDelay = std::clamp(
-                        static_cast<float>(delayResult.unwrap()), 0.0f, 30.0f);
-                }
-
-                auto editorDisableResult = objConst["editor_disable"].asBool();
-                if (editorDisableResult) {
-                    effectObj->m_previewDisable = editorDisableResult.unwrap();
-                }
-
-            }
-
-            // ── Stop Trigger (ID 1616) — stops a trigger group ─────────────────
-            if (advFeatures && gameObj->m_objectID == 1616) {
-                if (!effectObj) return;
-
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult) {
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                }
-
-            }
-
-            // ── Scale trigger (2.2, ID 2067) ────────────────────────────────────
-            // EAS has emitted these since the verb landed; the fields finally
-            // get applied here. Uniform X/Y scale from the "scale" key.
-            if (advFeatures && gameObj->m_objectID == 2067) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 30.f);
-                if (auto* xform = typeinfo_cast<TransformTriggerGameObject*>(gameObj)) {
-                    auto scaleToResult = objConst["scale"].asDouble();
-                    if (scaleToResult) {
-                        float s = std::clamp((float)scaleToResult.unwrap(), 0.05f, 10.f);
-                        xform->m_objectScaleX = s;
-                        xform->m_objectScaleY = s;
-                    }
-                }
-            }
+    }
 
-            // ── Shake trigger (ID 1520) ────────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1520) {
-                if (!effectObj) return;
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 30.f);
-                auto strengthResult = objConst["strength"].asDouble();
-                if (strengthResult)
-                    effectObj->m_shakeStrength = std::clamp((float)strengthResult.unwrap(), 0.f, 20.f);
-                auto intervalResult = objConst["interval"].asDouble();
-                if (intervalResult)
-                    effectObj->m_shakeInterval = std::clamp((float)intervalResult.unwrap(), 0.f, 5.f);
-            }
-
-            // ── Camera triggers (2.2): zoom 1913 / static 1914 / offset 1916 ───
-            if (advFeatures && gameObj->m_objectID == 1913) {
-                if (!effectObj) return;
-                auto zoomResult = objConst["zoom"].asDouble();
-                if (zoomResult)
-                    effectObj->m_zoomValue = std::clamp((float)zoomResult.unwrap(), 0.25f, 4.f);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 30.f);
-            }
-            if (advFeatures && gameObj->m_objectID == 1914) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 30.f);
-                if (auto* cam = typeinfo_cast<CameraTriggerGameObject*>(gameObj)) {
-                    auto exitResult = objConst["exit"].asBool();
-                    if (exitResult && exitResult.unwrap()) cam->m_exitStatic = true;
-                }
-            }
-            if (advFeatures && gameObj->m_objectID == 1916) {
-                if (!effectObj) return;
-                // Camera offset reuses the move-trigger offset pair.
-                auto offXResult = objConst["move_x"].asDouble();
-                auto offYResult = objConst["move_y"].asDouble();
-                float ox = offXResult ? std::clamp((float)offXResult.unwrap(), -2000.f, 2000.f) : 0.f;
-                float oy = offYResult ? std::clamp((float)offYResult.unwrap(), -2000.f, 2000.f) : 0.f;
-                effectObj->m_moveOffset = CCPoint(ox, oy);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 30.f);
-            }
-
-            // ── Timewarp trigger (2.2, ID 1935) ─────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1935) {
-                if (!effectObj) return;
-                auto modResult = objConst["mod"].asDouble();
-                if (modResult)
-                    effectObj->m_timeWarpTimeMod =
-                        std::clamp((float)modResult.unwrap(), 0.1f, 3.f);
-            }
-
-            // ── Song (1934) / SFX (3602) triggers ───────────────────────────────
-            if (advFeatures && (gameObj->m_objectID == 1934 || gameObj->m_objectID == 3602)) {
-                if (!effectObj) return;
-                if (auto* sfx = typeinfo_cast<SFXTriggerGameObject*>(gameObj)) {
-                    auto idResult = objConst["sound_id"].asInt();
-                    if (idResult)
-                        sfx->m_soundID = std::max(0, (int)idResult.unwrap());
-                    auto volResult = objConst["volume"].asDouble();
-                    if (volResult)
-                        sfx->m_volume = std::clamp((float)volResult.unwrap(), 0.f, 2.f);
-                    auto pitchResult = objConst["pitch"].asDouble();
-                    if (pitchResult)
-                        sfx->m_pitch = std::clamp((float)pitchResult.unwrap(), -12.f, 12.f);
-                    if (gameObj->m_objectID == 1934) {
-                        if (auto* song = typeinfo_cast<SongTriggerGameObject*>(gameObj)) {
-                            auto chResult = objConst["channel"].asInt();
-                            if (chResult)
-                                song->m_songChannel = std::clamp((int)chResult.unwrap(), 0, 4);
-                        }
-                    }
-                }
-            }
+    void updateObjectCreation(float /*dt*/) {
+        if (!m_isCreatingObjects || m_deferredObjects.empty()) return;
 
-            // ── Follow trigger (ID 1347) ────────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1347) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto followResult = objConst["follow_group"].asInt();
-                if (followResult)
-                    effectObj->m_centerGroupID = std::clamp((int)followResult.unwrap(), 1, 9999);
-                auto xModResult = objConst["x_mod"].asDouble();
-                if (xModResult)
-                    effectObj->m_followXMod = std::clamp((float)xModResult.unwrap(), -10.f, 10.f);
-                auto yModResult = objConst["y_mod"].asDouble();
-                if (yModResult)
-                    effectObj->m_followYMod = std::clamp((float)yModResult.unwrap(), -10.f, 10.f);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 600.f);
-            }
-
-            // ── Follow Player Y trigger (ID 1814) ───────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1814) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto speedResult = objConst["speed"].asDouble();
-                if (speedResult)
-                    effectObj->m_followYSpeed = std::clamp((float)speedResult.unwrap(), 0.f, 100.f);
-                auto delayResult = objConst["delay"].asDouble();
-                if (delayResult)
-                    effectObj->m_followYDelay = std::clamp((float)delayResult.unwrap(), 0.f, 10.f);
-                auto offsetResult = objConst["offset"].asInt();
-                if (offsetResult)
-                    effectObj->m_followYOffset = std::clamp((int)offsetResult.unwrap(), -500, 500);
-                auto maxSpeedResult = objConst["max_speed"].asDouble();
-                if (maxSpeedResult)
-                    effectObj->m_followYMaxSpeed = std::clamp((float)maxSpeedResult.unwrap(), 0.f, 100.f);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp((float)durResult.unwrap(), 0.f, 600.f);
-            }
-
-            // ── Touch trigger (ID 1595) ─────────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1595) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto activateResult = objConst["activate"].asBool();
-                if (activateResult)
-                    effectObj->m_activateGroup = activateResult.unwrap();
-                auto holdResult = objConst["hold"].asBool();
-                if (holdResult)
-                    effectObj->m_touchHoldMode = holdResult.unwrap();
-            }
-
-            // ── Count (1611) / Instant Count (1811) / Pickup (1817) triggers ────
-            if (advFeatures && (gameObj->m_objectID == 1611 ||
-                                gameObj->m_objectID == 1811 ||
-                                gameObj->m_objectID == 1817)) {
-                if (!effectObj) return;
-                auto itemResult = objConst["item_id"].asInt();
-                if (itemResult)
-                    effectObj->m_itemID = std::clamp((int)itemResult.unwrap(), 1, 9999);
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto activateResult = objConst["activate"].asBool();
-                if (activateResult)
-                    effectObj->m_activateGroup = activateResult.unwrap();
-                if (auto* count = typeinfo_cast<CountTriggerGameObject*>(gameObj)) {
-                    auto countResult = objConst["count"].asInt();
-                    if (countResult)
-                        count->m_pickupCount =
-                            std::clamp((int)countResult.unwrap(), -9999, 9999);
-                }
-            }
+        if (m_currentObjectIndex >= m_deferredObjects.size()) {
+            finishSpawning();
+            return;
+        }
 
-            // ── On-Death trigger (ID 1812) ──────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1812) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto activateResult = objConst["activate"].asBool();
-                if (activateResult)
-                    effectObj->m_activateGroup = activateResult.unwrap();
-            }
-
-            // ── Linked teleport portal (ID 747) — vertical jump distance ───────
-            // Not advFeatures-gated: teleports are plain gameplay objects like
-            // every other portal.
-            if (gameObj->m_objectID == 747) {
-                if (auto* tp = typeinfo_cast<TeleportPortalObject*>(gameObj)) {
-                    auto offResult = objConst["teleport_y_offset"].asDouble();
-                    if (offResult)
-                        tp->m_teleportYOffset =
-                            std::clamp((float)offResult.unwrap(), -450.f, 450.f);
-                }
-            }
+        if (!m_traceSpawnStartUs) m_traceSpawnStartUs = trace::nowUs();
+        trace::Span span("spawn-tick", traceSession(), "stage");
+        for (int b = 0; b < m_spawnBatchSize && m_currentObjectIndex < m_deferredObjects.size(); ++b)
+            if (!spawnDeferredOne()) return;
 
-            // ── Animate trigger (ID 1585) ───────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 1585) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-                auto animResult = objConst["animation_id"].asInt();
-                if (animResult)
-                    effectObj->m_animationID = std::clamp((int)animResult.unwrap(), 0, 50);
-            }
-
-            // ── Gravity trigger (ID 2066) ───────────────────────────────────────
-            if (advFeatures && gameObj->m_objectID == 2066) {
-                if (!effectObj) return;
-                auto gravResult = objConst["gravity"].asDouble();
-                if (gravResult)
-                    effectObj->m_gravityValue =
-                        std::clamp((float)gravResult.unwrap(), 0.f, 10.f);
-                auto durResult = objConst["duration"].asDouble();
-                if (durResult)
-                    effectObj->m_duration = std::clamp(
-                        static_cast<float>(durResult.unwrap()), 0.0f, 30.0f);
-            }
-
-            // ── Teleport trigger (ID 3022) — sends the player to a group ───────
-            if (advFeatures && gameObj->m_objectID == 3022) {
-                if (!effectObj) return;
-                auto targetGroupResult = objConst["target_group"].asInt();
-                if (targetGroupResult)
-                    effectObj->m_targetGroupID = std::clamp((int)targetGroupResult.unwrap(), 1, 9999);
-            }
-
-            // ── Placement-only effect triggers — the ID alone is the effect ────
-            //   1612/1613 hide/show player, 32/33 hide/show trail,
-            //   1917 reverse, 1818/1819 BG-effect on/off, 1915 no-enter-effect,
-            //   200-203/1334 speed portals. No fields needed.
-
-            // ── Trigger activation mode (any trigger) ───────────────────────────
-            // Runs AFTER the per-trigger branches. Default is position-
-            // triggered: the trigger fires when the screen reaches its X —
-            // matching the EAS emitter and the "triggers at y=0" convention
-            // (a touch-triggered trigger at y=0 can never fire; the old
-            // hardcoded touch default is why AI triggers silently did nothing).
-            //   touch_triggered=true → fires on player contact instead
-            //   spawn_triggered=true → fires only via a Spawn-trigger chain
-            if (advFeatures && effectObj) {
-                auto ttResult = objConst["touch_triggered"].asBool();
-                if (ttResult)
-                    effectObj->m_isTouchTriggered = ttResult.unwrap();
-                auto stResult = objConst["spawn_triggered"].asBool();
-                if (stResult && stResult.unwrap()) {
-                    effectObj->m_isSpawnTriggered = true;
-                    effectObj->m_isTouchTriggered = false;
-                }
-            }
+        if (m_currentObjectIndex % 10 == 0) {
+            float pct = (float)m_currentObjectIndex / (float)m_deferredObjects.size() * 100.0f;
+            showStatus(fmt::format("Creating objects... {:.0f}%", pct), false);
+        }
+    }
+
+    void applyObjectProperties(GameObject* gameObj, matjson::Value& objData) {
+        if (!gameObj) return;
+        bool advFeatures = m_advFeatures;
 
+        // Merge in any block_template properties for this object's type FIRST,
+        // so they act as defaults the per-object fields can override. Mutates
+        // objData in place; safe because we only fill in missing keys.
+        int templateMerged = applyBlockTemplateToObject(objData);
+        if (templateMerged > 0) {
+            log::debug("Applied block template ({} props) to object id {}",
+                       templateMerged, gameObj->m_objectID);
         }
+
+        // Every field lands through the props schema: walk only the keys the
+        // object actually carries, collect the rows they hit, then apply in
+        // schema order (scale before flips, touch before spawn_triggered).
+        // Iterating through a CONST ref: non-const matjson operator[] inserts
+        // a null member on every missing key — per object, per spawn tick.
+        const matjson::Value& objConst = objData;
+        if (!objConst.isObject()) return;
+        // One RTTI check for every trigger row — not one per field.
+        auto* effectObj = advFeatures
+            ? typeinfo_cast<EffectGameObject*>(gameObj) : nullptr;
+        const props::Target target{gameObj, effectObj, m_editorLayer, advFeatures};
+        const int objectID = gameObj->m_objectID;
+        const auto& rows = props::schema();
+        const auto& appliers = props::appliers();
+
+        static std::vector<std::pair<uint16_t, const matjson::Value*>> hits;
+        hits.clear();
+        for (auto& [key, value] : objConst) {
+            auto it = appliers.find(std::string_view(key));
+            if (it == appliers.end()) continue;
+            for (uint16_t r : it->second) {
+                const auto& p = rows[r];
+                if (!p.ids.empty() && !props::forId(p, objectID)) continue;
+                if ((p.scope & props::Fx) && !effectObj) continue;
+                if (!props::accepts(p.type, value)) continue;
+                hits.emplace_back(r, &value);
+            }
+        }
+        std::sort(hits.begin(), hits.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (auto& [r, value] : hits) rows[r].set(target, *value, rows[r]);
     }
 
     // ── Level metadata (name, description, song, background, ground, colors) ────
@@ -11342,6 +15592,7 @@ protected:
 
     void prepareObjects(matjson::Value& objectsArray) {
         if (!m_editorLayer || !objectsArray.isArray()) return;
+        trace::Span span("prepare-objects", traceSession(), "stage");
 
         // Split out MOVE/DELETE/EDIT ops first — they act on EXISTING
         // objects immediately (journaled, so Deny restores everything);
@@ -11384,9 +15635,10 @@ protected:
         // Ops-only turn: real changes happened but nothing new spawns.
         // Enter the staged state directly so Accept/Deny appear; keep the
         // editor on its current layer (there is no preview layer to show).
-        if (objectsArray.size() == 0 && opsAffected > 0 && !s_inPreviewMode) {
-            s_previewLayer             = m_editorLayer->m_currentLayer;
-            s_editorLayerBeforePreview = m_editorLayer->m_currentLayer;
+        if (objectsArray.size() == 0 && opsAffected > 0 && !m_stage->inPreview) {
+            m_stage->previewLayer  = m_editorLayer->m_currentLayer;
+            m_stage->layerReserved = false;
+            m_stage->layerBefore  = m_editorLayer->m_currentLayer;
             m_deferredObjects.clear();
             m_currentObjectIndex = 0;
             m_isCreatingObjects  = false;
@@ -11394,26 +15646,27 @@ protected:
             return;
         }
 
-        // Fresh preview: pick an unused editor layer (max used + 1) and
-        // switch the editor to it. Follow-up turns while a preview is live
-        // APPEND to the existing preview layer instead — that's how long
+        // Fresh preview: reserve an unused editor layer (above the level's
+        // layers and every other context's reservation — see
+        // reservePreviewLayer) and switch the editor to it unless another
+        // context is under review. Follow-up turns while a preview is live APPEND to
+        // the existing preview layer instead — that's how long
         // conversations make many small edits before one Accept.
-        if (!s_inPreviewMode) {
-            s_previewObjects.clear();
-            s_previewIntendedLayers.clear();
-            short maxLayer = 0;
-            if (m_editorLayer->m_objects) {
-                for (auto* raw : CCArrayExt<CCObject*>(m_editorLayer->m_objects)) {
-                    auto* go = typeinfo_cast<GameObject*>(raw);
-                    if (!go) continue;
-                    maxLayer = std::max({maxLayer, go->m_editorLayer, go->m_editorLayer2});
-                }
+        if (!m_stage->inPreview) {
+            m_stage->previewObjects.clear();
+            m_stage->intendedLayers.clear();
+            reservePreviewLayer(m_editorLayer, m_stage);
+            if (auto other = focusedStage(); other && other != m_stage) {
+                // Queued behind another review: when this one's turn ends
+                // the editor must land where the USER was, not on the
+                // other preview's layer.
+                m_stage->layerBefore = other->layerBefore;
+            } else {
+                m_stage->layerBefore = m_editorLayer->m_currentLayer;
+                setEditorCurrentLayer(m_editorLayer, m_stage->previewLayer);
             }
-            s_previewLayer = (short)std::min<int>(maxLayer + 1, 999);
-            s_editorLayerBeforePreview = m_editorLayer->m_currentLayer;
-            setEditorCurrentLayer(m_editorLayer, s_previewLayer);
             log::info("Preview layer {} (editor was on {})",
-                      s_previewLayer, s_editorLayerBeforePreview);
+                      m_stage->previewLayer, m_stage->layerBefore);
         }
         // NOTE: block templates are NOT reset here; they were already reset
         // before macros ran (see onAPISuccess) so any template the AI emitted
@@ -11431,25 +15684,7 @@ protected:
             // then read id/x/y back from objectsArray[i] — NOT from a local copy
             // captured before the write (that was the original bug causing
             // "Prepared 0 valid objects" since objData never had the id field).
-            auto typeResult = objectsArray[i]["type"].asString();
-            if (typeResult) {
-                const std::string& typeName = typeResult.unwrap();
-                // Triggers with hardcoded IDs not in object_ids.json
-                static const std::unordered_map<std::string, int> TRIGGER_IDS = {
-                    {"color_trigger", 899},
-                    {"move_trigger", 901},
-                    {"end_trigger", 34},
-                    {"show_trail_trigger", 32},
-                    {"hide_trail_trigger", 33},
-                };
-                auto trigIt = TRIGGER_IDS.find(typeName);
-                if (trigIt != TRIGGER_IDS.end()) {
-                    objectsArray[i]["id"] = trigIt->second;
-                } else {
-                    auto it = OBJECT_IDS.find(typeName);
-                    objectsArray[i]["id"] = (it != OBJECT_IDS.end()) ? it->second : 1;
-                }
-            }
+            resolveObjectTypeId(objectsArray[i]);
 
             // Read from the authoritative array slot (not a stale local copy)
             auto idResult = objectsArray[i]["id"].asInt();
@@ -11527,10 +15762,7 @@ protected:
             // Every entry failed validation — undo the fresh layer switch
             // above before erroring, or the editor is stranded on an empty
             // preview layer with no buttons to come back from.
-            if (!s_inPreviewMode && s_previewLayer >= 0) {
-                setEditorCurrentLayer(m_editorLayer, s_editorLayerBeforePreview);
-                s_previewLayer = -1;
-            }
+            releaseReservation();
             onError("No Valid Objects",
                 fmt::format("The AI returned an objects array, but none of the entries had recognizable "
                             "object types or valid x/y fields. Try rephrasing the prompt to ask for "
@@ -11549,6 +15781,7 @@ protected:
     // ── System prompt ─────────────────────────────────────────────────────────
 
     std::string buildSystemPrompt() {
+        trace::Span span("build-system-prompt", traceSession());
         bool advFeatures   = Mod::get()->getSettingValue<bool>("enable-advanced-features");
 
         // ── Mode preface (Creation vs Edit) ───────────────────────────────
@@ -11934,7 +16167,7 @@ protected:
         // objects array (X normalized to 0).
         if (!EXAMPLE_SECTIONS.empty()) {
             int wantPicks = 1;
-            auto picks = pickExampleIndices(s_lastDifficulty, s_lastStyle, wantPicks);
+            auto picks = pickExampleIndices(m_stage->fb.difficulty, m_stage->fb.style, wantPicks);
             if (!picks.empty()) {
                 base += "\n\nFEW-SHOT (real GD slices, X normalized to 0 — adapt anywhere):\n";
                 for (size_t k = 0; k < picks.size(); ++k) {
@@ -11967,13 +16200,13 @@ protected:
         // to avoid blowing up context windows on smaller models.
         if (Mod::get()->getSettingValue<bool>("enable-rating")) {
             int maxExamples = (int)Mod::get()->getSettingValue<int64_t>("max-feedback-examples");
-            auto curDiff  = s_lastDifficulty;
-            auto curStyle = s_lastStyle;
-            auto curLen   = s_lastLength;
+            auto curDiff  = m_stage->fb.difficulty;
+            auto curStyle = m_stage->fb.style;
+            auto curLen   = m_stage->fb.length;
 
             // Halved from 8000 → 4000 chars (~1000 tokens). Past ratings stay
             // useful for style/difficulty cues; we don't need 5 verbose ones.
-            constexpr size_t FEEDBACK_CHAR_BUDGET = 4000;
+            const size_t FEEDBACK_CHAR_BUDGET = (size_t)(4000 * promptScale());
             std::string feedbackSection;
 
             // Truncate a level dump at a clean object boundary so a few
@@ -12042,17 +16275,53 @@ protected:
             base += feedbackSection;
         }
 
+        // Compact dialect — only for models that track a running cursor
+        // reliably (compactDialectFor). Lowered before parsing, so the
+        // objects it produces are identical to the long-hand script's.
+        {
+            std::string provider = genProvider();
+            if (compactDialectFor(provider, getProviderModel(provider))) {
+                float gY = getGroundY();
+                base += fmt::format(
+                    "\nCOMPACT DIALECT (optional, saves output tokens — mix freely "
+                    "with plain lines):\n"
+                    "@+N / @-N   x relative to the cursor; @N absolute. Each line's "
+                    "first @ x becomes the new cursor. Ranges: @+0..+600\n"
+                    "AT X / AT +DX   set or shift the cursor (emits nothing)\n"
+                    "rN = y {0:g}+30N (r0={0:g}, r1={1:g}, r2={2:g}); "
+                    "lN = y {0:g}+90N (l1={3:g}) — as y positionals or y=/y_bot=/y_top=\n"
+                    "WITH color=4 groups=2 {{   sticky fields for every line up to "
+                    "the closing }} (a line's own value wins; blocks nest)\n"
+                    "<line> *N   repeat the line N times; @ offsets re-apply each time\n"
+                    "REPEAT N every=DX {{   repeat the block up to }}; every= starts "
+                    "each pass DX after the previous one\n"
+                    "Block openers end their line with {{ and }} sits alone on its own line.\n"
+                    "Example:\n"
+                    "AT 600\n"
+                    "SPIKE @ r0\n"
+                    "SPIKE @+90 *3\n"
+                    "WITH color=4 {{\n"
+                    "BLOCK @+60 r1 *5\n"
+                    "}}\n"
+                    "ORB yellow @+30 r3\n",
+                    gY, gY + 30.f, gY + 60.f, gY + 90.f);
+            }
+        }
+
         // Edit-op grammar — always available (follow-up edit turns can occur
         // on any session), with the heavy-edit doctrine appended last in
         // edit mode so the AI sees it freshest.
-        base += "\nEDIT OPS (only valid when editing an existing level - the "
-                "mod sends you an OBJECT INVENTORY listing when they apply):\n"
+        base += "\nEDIT OPS (on an existing level against the OBJECT INVENTORY "
+                "the mod sends; while building a new level, against your own "
+                "earlier output by the #ids of the draft listings the mod "
+                "sends in fix/refinement rounds):\n"
                 "MOVE <sel> dx=F dy=F     shift existing objects by a delta\n"
                 "DELETE <sel>             remove existing objects\n"
                 "EDIT <sel> rot=F scale=F color=N detail=N flip_x flip_y   restyle\n"
                 "<sel> forms: #12 (inventory index) | #5-40 (index range) | "
                 "rect:x1,y1,x2,y2 (everything in the box) | id:spike (every "
-                "object of that type). rect/id may add type=NAME to filter. "
+                "object of that type) | group:7 (every member of group 7). "
+                "rect/id/group may add type=NAME to filter. "
                 "One bulk line can touch hundreds of objects. Ops run in "
                 "order at apply time and are previewed/reversible.\n";
         if (m_editMode) {
@@ -12075,17 +16344,6 @@ protected:
 
     // ── API call ──────────────────────────────────────────────────────────────
 
-    // Strips leading/trailing ASCII whitespace (spaces, tabs, newlines, carriage
-    // returns). API keys are frequently copy-pasted with invisible trailing
-    // characters that cause 401/403 responses even when the key is valid.
-    static std::string trimKey(std::string s) {
-        const std::string ws = " \t\r\n";
-        size_t start = s.find_first_not_of(ws);
-        if (start == std::string::npos) return "";
-        size_t end = s.find_last_not_of(ws);
-        return s.substr(start, end - start + 1);
-    }
-
     // ── Tool 1: download a reference level from GD's servers ───────────────
     // Builds a compact summary the AI can use as design inspiration. Skips
     // entirely if input is empty.
@@ -12117,16 +16375,9 @@ protected:
         auto& cache = levelSummaryCache();
         auto obj = matjson::Value::object();
         for (auto& [id, summary] : cache) obj[id] = summary;
-        std::string out = obj.dump();
-        auto path = Mod::get()->getSaveDir() / "level_cache.json";
-        // Same pattern as persistFeedback: serialize on the caller, write on
-        // a detached thread, mutex serializes concurrent writers.
-        std::thread([path, out = std::move(out)] {
-            static std::mutex s_cacheWriteMutex;
-            std::lock_guard lock(s_cacheWriteMutex);
-            auto res = utils::file::writeString(path, out);
-            if (!res) log::warn("level_cache.json write failed: {}", res.unwrapErr());
-        }).detach();
+        // Same pattern as persistFeedback: dump and write on the I/O worker.
+        io::write(Mod::get()->getSaveDir() / "level_cache.json",
+                  [obj = std::move(obj)] { return obj.dump(); });
     }
 
     void fireFetchLevelByID(const std::string& idInput,
@@ -12728,6 +16979,257 @@ protected:
     // tool round. After m_maxExtensionRounds we give up and apply whatever
     // we've got (so the AI can't pin the user forever).
     matjson::Value m_accumulatedObjects = matjson::Value::array();
+    // Analysis-tool density indexes (levelcheck::DensityIndex). The draft's
+    // grows with the accumulator (append-only between resets); the live
+    // editor's grows with spawns and rebuilds when objects are removed or
+    // edited (s_levelMutationEpoch) or the editor changes.
+    levelcheck::DensityIndex m_draftDensity;
+    size_t                   m_draftIndexed   = 0;
+    levelcheck::DensityIndex m_liveDensity;
+    CCArray*                 m_liveIndexedArr = nullptr;
+    unsigned                 m_liveIndexed    = 0;
+    uint32_t                 m_liveIndexEpoch = 0;
+
+    // Trigger/group graph over the draft (node i = accumulator entry i) and
+    // group membership over the live editor (node i = m_liveGraphObjs[i]).
+    levelcheck::TriggerGraph  m_draftGraph;
+    levelcheck::TriggerGraph  m_liveGraph;
+    std::vector<GameObject*>  m_liveGraphObjs;
+    uint32_t                  m_liveGraphEpoch = ~0u;
+    CCArray*                  m_liveGraphArr   = nullptr;
+    unsigned                  m_liveGraphCount = 0;
+
+    // Stable ids of the draft: m_draftIds[i] names accumulator entry i.
+    // Assigned on append and never reused within a generation, so the #ids
+    // one round's listing shows still name the same objects after later
+    // rounds add or delete (see draftpatch).
+    std::vector<uint32_t>     m_draftIds;
+    uint32_t                  m_nextDraftId = 0;
+
+    // Back to an empty accumulator: every draft index restarts.
+    void clearDraftIndexes() {
+        m_draftIndexed = 0; m_draftDensity.clear(); m_draftGraph.clear();
+        m_draftIds.clear(); m_nextDraftId = 0;
+    }
+
+    const std::vector<uint32_t>& draftIds() {
+        size_t n = m_accumulatedObjects.size();
+        if (m_draftIds.size() > n) { m_draftIds.clear(); m_nextDraftId = 0; }
+        while (m_draftIds.size() < n) m_draftIds.push_back(m_nextDraftId++);
+        return m_draftIds;
+    }
+
+    // MOVE/DELETE/EDIT against the draft. Density and trigger graph assume
+    // an append-only accumulator, so they rebuild on their next use.
+    draftpatch::Stats applyDraftOps(const std::vector<matjson::Value>& ops) {
+        draftIds();
+        auto st = draftpatch::apply(m_accumulatedObjects, m_draftIds, ops);
+        if (st.moved || st.deleted || st.edited) {
+            m_draftIndexed = 0; m_draftDensity.clear(); m_draftGraph.clear();
+        }
+        return st;
+    }
+
+    // Draft objects with X in [x0, x1], by X, each tagged with its stable
+    // id — the listing refinement and fix rounds patch against.
+    std::string draftListing(float x0, float x1, size_t cap) {
+        const auto& ids = draftIds();
+        std::vector<std::pair<float, size_t>> rows;
+        for (size_t i = 0; i < m_accumulatedObjects.size(); ++i) {
+            const auto& o = m_accumulatedObjects[i];
+            if (!o.isObject() || o.contains("op")) continue;
+            float x = levelcheck::getFloat(o, "x", 0.f);
+            if (x >= x0 && x <= x1) rows.push_back({x, i});
+        }
+        std::stable_sort(rows.begin(), rows.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::string out;
+        size_t shown = std::min(rows.size(), cap);
+        for (size_t k = 0; k < shown; ++k) {
+            const auto& o = m_accumulatedObjects[rows[k].second];
+            out += fmt::format("#{} {} x={:.0f} y={:.0f}", ids[rows[k].second],
+                               levelcheck::getStr(o, "type", "?"), rows[k].first,
+                               levelcheck::getFloat(o, "y", 0.f));
+            float rot = levelcheck::getFloat(o, "rotation", 0.f);
+            if (std::abs(rot) > 0.01f) out += fmt::format(" r={:.0f}", rot);
+            out += "\n";
+        }
+        if (rows.size() > shown)
+            out += fmt::format("(+{} more in this range - use rect:/id:/group:)\n",
+                               rows.size() - shown);
+        return out;
+    }
+
+    // Patch grammar for the loop-back rounds of a fresh level.
+    static const char* draftPatchHelp() {
+        return "PATCH what you already produced instead of layering on top of "
+               "it: MOVE <sel> dx=F dy=F, DELETE <sel>, EDIT <sel> rot=F "
+               "scale=F color=N detail=N flip_x flip_y, where <sel> is #id or "
+               "#a-b (ids from a listing - stable across rounds), "
+               "rect:x1,y1,x2,y2, id:<type> or group:N. Every other line is "
+               "added. Never hide or shove objects with alpha/move triggers to "
+               "get rid of them - DELETE them.";
+    }
+
+    // Loop-back quality passes, shared by the serial rounds and the
+    // parallel fan-out. The focuses rotate, one per refinement round.
+    static const std::vector<const char*>& refinementFocuses() {
+        static const std::vector<const char*> FOCUSES = {
+            "PACING + OBSTACLE VARIETY: scan for runs of identical objects "
+            "(e.g. 5 spike-trains in a row) and replace some with orbs, "
+            "pads, stairs, or platform sections. Fix any spacing < 60 "
+            "units between obstacles (too cramped) or > 300 units (boring "
+            "gap).",
+
+            "VISUAL COHESION: add decoration objects (gears, blades, "
+            "decorative blocks) sparsely to make the level feel built, "
+            "not random. Ensure color channels are used consistently — "
+            "if the level has a color palette, route blocks/spikes to "
+            "those channels with `color=N`.",
+
+            "DIFFICULTY CURVE: the level should ramp up, not be flat. "
+            "Easy intro (first 25%), build-up (next 50%), climax (last "
+            "25% — densest, hardest, with optional speed-up portal). If "
+            "the level is uniformly easy or uniformly chaotic, add or "
+            "remove obstacles to create a curve.",
+
+            "GAMEPLAY FLOW: verify every gamemode-change portal has a "
+            "FLOOR or CORRIDOR on the OTHER side leading away from it. "
+            "Verify orbs are reachable from the ground row (Y=105) with "
+            "a single jump (Y=135-165). Add small details that make "
+            "movement feel rhythmic — paired spikes, alternating orbs.",
+
+            "POLISH PASS: scan for anything that feels random — an "
+            "orphaned block in the air, a spike too close to a portal, "
+            "a color trigger that fires too late. Fix specific issues. "
+            "Add 1-2 TRIGGER pulse/color lines to mark transitions you "
+            "care about. End on a strong note (climax + clean transition "
+            "to TRIGGER end).",
+        };
+        return FOCUSES;
+    }
+
+    static const char* decorationPassText() {
+        return "DECORATION PASS. The gameplay skeleton is done — now make "
+               "it look BUILT, not generated. Work the checklist, every "
+               "item, whole level:\n"
+               "1. PALETTE: META bg/ground + COLOR lines for 2-3 custom "
+               "channels; TRIGGER color at each section boundary so the "
+               "mood shifts as the level progresses.\n"
+               "2. GROUND DETAIL: decorative strips/slabs along the floor "
+               "every 150-300u (vary them); small gears/plants/crystals "
+               "in dead corners.\n"
+               "3. BACKGROUND DEPTH: large slow decor (z_layer=-3, dim "
+               "color) behind the play path every 400-600u — silhouettes "
+               "make a level feel deep.\n"
+               "4. STRUCTURE DRESSING: outline existing block clusters "
+               "with slopes/connectors; glow edges (noglow off) on "
+               "platform lips the player lands on.\n"
+               "5. MOTION: TRIGGER pulse on the beat for 1-2 channels; "
+               "slow TRIGGER rotate on big background gears; one camera "
+               "zoom or shake at the biggest drop.\n"
+               "6. NEGATIVE SPACE: any 300u stretch with nothing but "
+               "floor gets at least one decor element.\n"
+               "DO NOT add, move, or block anything in the play path — "
+               "no new spikes, blocks at player height, portals, or "
+               "orbs. Decor that overlaps the path goes passable + "
+               "z_layer'd behind. Emit additional EAS lines only.";
+    }
+
+    static const char* critiquePassText() {
+        return "FINAL SELF-REVIEW before the level is applied. First "
+               "line of your reply MUST be \"RATING: n/10\" - your "
+               "honest overall score. Judge like a harsh playtester: "
+               "(a) playability - every jump makeable, no blind traps; "
+               "(b) pacing - density ramps with the difficulty curve; "
+               "(c) variety - no copy-pasted obstacle spam; "
+               "(d) decoration - no bare stretches, cohesive palette, "
+               "background/ground colors set; (e) faithfulness to the "
+               "user's request. If you rate 8+, follow the rating line "
+               "with exactly: ALL GOOD. Otherwise follow it with ONLY "
+               "the fix - 10-40 EAS lines/macros repairing EVERY issue "
+               "you found (fill empty stretches, fix impossible jumps, "
+               "decorate bare sections, add missing color triggers). "
+               "No rebuild, no commentary. ";
+    }
+
+    const levelcheck::TriggerGraph& draftGraph() {
+        size_t n = m_accumulatedObjects.size();
+        if (m_draftGraph.size() > n) m_draftGraph.clear();
+        for (size_t i = m_draftGraph.size(); i < n; ++i)
+            m_draftGraph.append(m_accumulatedObjects[i]);
+        return m_draftGraph;
+    }
+
+    const levelcheck::TriggerGraph& liveGraph() {
+        if (!revalidateEditor() || !m_editorLayer->m_objects) {
+            m_liveGraph.clear();
+            m_liveGraphObjs.clear();
+            m_liveGraphArr = nullptr;
+            return m_liveGraph;
+        }
+        auto* arr = m_editorLayer->m_objects;
+        unsigned n = arr->count();
+        unsigned from = m_liveGraphCount;
+        if (arr != m_liveGraphArr || n < m_liveGraphCount ||
+            m_liveGraphEpoch != s_levelMutationEpoch) {
+            m_liveGraph.clear();
+            m_liveGraphObjs.clear();
+            from = 0;
+        }
+        std::vector<int> groups;
+        for (unsigned i = from; i < n; ++i) {
+            auto* go = typeinfo_cast<GameObject*>(arr->objectAtIndex(i));
+            if (!go) continue;
+            groups.clear();
+            if (go->m_groups)
+                for (int k = 0; k < go->m_groupCount && k < 10; ++k)
+                    groups.push_back((*go->m_groups)[k]);
+            m_liveGraph.appendNode(go->getPositionX(), groups);
+            m_liveGraphObjs.push_back(go);
+        }
+        m_liveGraphArr   = arr;
+        m_liveGraphCount = n;
+        m_liveGraphEpoch = s_levelMutationEpoch;
+        return m_liveGraph;
+    }
+
+    const levelcheck::DensityIndex& draftDensity() {
+        size_t n = m_accumulatedObjects.size();
+        if (n < m_draftIndexed) { m_draftDensity.clear(); m_draftIndexed = 0; }
+        for (size_t i = m_draftIndexed; i < n; ++i)
+            m_draftDensity.addObject(m_accumulatedObjects[i]);
+        m_draftIndexed = n;
+        return m_draftDensity;
+    }
+
+    const levelcheck::DensityIndex& liveDensity() {
+        if (!revalidateEditor() || !m_editorLayer->m_objects) {
+            m_liveDensity.clear();
+            m_liveIndexedArr = nullptr;
+            m_liveIndexed    = 0;
+            return m_liveDensity;
+        }
+        auto* arr = m_editorLayer->m_objects;
+        unsigned n = arr->count();
+        unsigned from = m_liveIndexed;
+        if (arr != m_liveIndexedArr || n < m_liveIndexed ||
+            m_liveIndexEpoch != s_levelMutationEpoch) {
+            m_liveDensity.clear();
+            from = 0;
+        }
+        // createObject appends, so new spawns are the array's tail.
+        for (unsigned i = from; i < n; ++i) {
+            auto* go = typeinfo_cast<GameObject*>(arr->objectAtIndex(i));
+            if (!go || stageSoftDeleted(go)) continue;
+            m_liveDensity.add(go->getPositionX(),
+                              levelcheck::classifyObjectId(go->m_objectID));
+        }
+        m_liveIndexedArr = arr;
+        m_liveIndexed    = n;
+        m_liveIndexEpoch = s_levelMutationEpoch;
+        return m_liveDensity;
+    }
     LengthTarget   m_lengthTarget       = {"Medium", 30.f, 60.f};
     int            m_extensionRounds    = 0;
     int            m_maxExtensionRounds = 4;
@@ -12751,7 +17253,7 @@ protected:
     // enabled and the selected provider supports it.
     void runToolLoop(const std::string& userPrompt, const std::string& rawApiKey) {
         m_toolApiKey   = trimKey(rawApiKey);
-        m_toolProvider = Mod::get()->getSettingValue<std::string>("ai-provider");
+        m_toolProvider = genProvider();
         m_toolModel    = getProviderModel(m_toolProvider);
         // Tool use is unbounded — no round budget. The model runs until it
         // emits a final answer; the per-tool caps + duplicate guard +
@@ -12762,24 +17264,25 @@ protected:
         m_usingToolLoop   = true;
         m_toolHistory.clear();
         m_accumulatedObjects = matjson::Value::array();
+        clearDraftIndexes();
         m_extensionRounds = 0;
         m_passabilityFixRounds = 0;
         m_refinementRounds = 0;
         m_critiqueDone    = false;
         m_critiquePending = false;
         m_decorationPassDone = false;
+        cancelQualityPasses();
         m_toolCallSigCounts.clear();
         m_followUpTurn = false;
         m_editEnforceRounds = 0;
         m_targetObjRounds   = 0;
-        m_lengthTarget = lengthTargetForSetting(
-            Mod::get()->getSettingValue<std::string>("length"));
+        m_lengthTarget = lengthTargetForSetting(genSetting("length"));
 
         // Prompt context locals. (callAPI — our only caller — already wrote
-        // the s_last* rating-context statics from the same settings.)
-        std::string difficulty = Mod::get()->getSettingValue<std::string>("difficulty");
-        std::string style      = Mod::get()->getSettingValue<std::string>("style");
-        std::string length     = Mod::get()->getSettingValue<std::string>("length");
+        // the staging context's feedback fields from the same values.)
+        std::string difficulty = genSetting("difficulty");
+        std::string style      = genSetting("style");
+        std::string length     = genSetting("length");
         // "levelID" is the overlay's reference-level mode, not a style word —
         // the actual reference arrives via the "style: <id>" prompt directive.
         if (style == "levelID") style = "match the reference level";
@@ -12788,7 +17291,7 @@ protected:
         if (m_editMode) {
             // Edit runs get the numbered inventory — MOVE/DELETE/EDIT
             // selectors resolve against exactly this listing.
-            std::string inv = buildLevelInventoryListing(1500);
+            std::string inv = buildLevelInventoryListing((int)(1500 * promptScale()));
             log::info("=== Tool-loop: edit inventory context ({} chars) ===", inv.size());
             levelDataSection = "\n\n" + inv;
         } else if (!m_shouldClearLevel) {
@@ -13086,12 +17589,13 @@ protected:
         // History pruning: every round re-sends the whole conversation, and
         // old tool results (level dumps, search results) are its bulk. Keep
         // the last 2 ToolResults messages verbatim; truncate older ones to a
-        // stub. Structure (roles, tool_call ids, Gemini thoughtSignatures)
-        // stays intact — only the payload text shrinks. Idempotent: already-
-        // pruned results are below the cap and untouched.
+        // stub sized to the model's context (caps::historyWindow). Structure
+        // (roles, tool_call ids, Gemini thoughtSignatures) stays intact —
+        // only the payload text shrinks. Idempotent: already-pruned results
+        // are below the cap and untouched.
         {
             constexpr size_t PRUNE_KEEP_LAST = 2;
-            constexpr size_t PRUNE_CAP       = 300;
+            const size_t PRUNE_CAP = caps::historyWindow(m_toolProvider, m_toolModel).resultCap;
             size_t resultMsgsSeen = 0;
             for (auto it = m_toolHistory.rbegin(); it != m_toolHistory.rend(); ++it) {
                 if (it->role != toolUse::MessageRole::ToolResults) continue;
@@ -13123,58 +17627,87 @@ protected:
             }
         }
 
-        auto body = toolUse::buildRequest(m_toolProvider, m_toolHistory, m_toolModel);
-        std::string bodyStr = body.dump();
+        std::string bodyStr;
+        {
+            trace::Span span("serialize-request", traceSession());
+            auto body = toolUse::buildRequest(m_toolProvider, m_toolHistory, m_toolModel);
+            bodyStr = body.dump();
+        }
         std::string url     = toolUse::urlFor(m_toolProvider, m_toolModel);
         log::info("Tool round {}: POST {} ({} bytes)",
                   m_toolIterations, url, bodyStr.size());
         logApiRequest(m_toolProvider, m_toolModel, url, bodyStr);
 
-        auto request = web::WebRequest();
-        request.header("Content-Type", "application/json");
-        applyProviderAuth(request, m_toolProvider, m_toolApiKey);
-        // Tool rounds tend to be smaller than the final answer, but the
-        // first one carries the full system prompt + few-shot. Generous
-        // timeout matches the single-shot path.
-        request.timeout(providerTimeout(m_toolProvider));
-        request.bodyString(bodyStr);
-        m_listener.spawn(
-            request.post(url),
-            [this](web::WebResponse resp) { this->onToolRoundResponse(std::move(resp)); }
-        );
+        // Through the provider's shared budget: fires now if a token is
+        // free, otherwise from the limiter's timer. Ref<> keeps the popup
+        // alive while queued; the generation epoch drops a cancelled round.
+        if (ratelimit::blockedFor(m_toolProvider) > 0.5 ||
+            !ratelimit::bucket(m_toolProvider).queue.empty())
+            showStatus("Waiting for provider rate limit...");
+        Ref<AIGeneratorPopup> self = this;
+        ratelimit::acquire(m_toolProvider, rateOwner(),
+            [self, gen = m_generation, url = std::move(url), bodyStr = std::move(bodyStr)] {
+                if (!self->stillCurrent(gen)) return;
+                auto request = web::WebRequest();
+                request.header("Content-Type", "application/json");
+                applyProviderAuth(request, self->m_toolProvider, self->m_toolApiKey);
+                // Tool rounds tend to be smaller than the final answer, but the
+                // first one carries the full system prompt + few-shot. Generous
+                // timeout matches the single-shot path.
+                request.timeout(providerTimeout(self->m_toolProvider));
+                request.bodyString(bodyStr);
+                self->m_traceHttpStartUs = trace::nowUs();
+                auto* raw = self.data();
+                self->m_listener.spawn(
+                    request.post(url),
+                    [raw](web::WebResponse resp) { raw->onToolRoundResponse(std::move(resp)); }
+                );
+            });
     }
 
-    // One automatic retry on transient provider failures (rate limit /
-    // server error / overload). Returns true if a retry was scheduled.
-    // Ref<> keeps the popup alive across the backoff; m_isGenerating gates
-    // the re-fire so a cancelled generation doesn't resurrect itself.
-    bool retryToolRoundIfTransient(int httpCode) {
+    // Owner key for the rate limiter's fair queue.
+    int rateOwner() const { return m_session ? m_session->id : 0; }
+
+    // A deferred callback captured `gen`: is its generation still running?
+    bool stillCurrent(uint32_t gen) const { return m_isGenerating && m_generation == gen; }
+
+    // Retry budget per failure kind: a 429 is the limiter's job (it waits
+    // as long as the provider asked), so it gets a few tries; a 5xx is
+    // retried once.
+    bool transientRetryAllowed(int httpCode) {
         bool transient = httpCode == 429 || httpCode == 500 || httpCode == 502 ||
                          httpCode == 503 || httpCode == 529;
-        if (!transient || m_transientRetries >= 1) return false;
+        if (!transient || m_transientRetries >= (httpCode == 429 ? 3 : 1)) return false;
         ++m_transientRetries;
-        log::warn("Transient HTTP {} — retrying round once in 2s", httpCode);
-        showStatus(fmt::format("Provider hiccup (HTTP {}) — retrying...", httpCode));
-        // Move the Ref all the way into the main-thread closure: the worker
-        // thread must never destroy a Ref copy (CCObject's ref-count is not
-        // atomic, so release() off the main thread is a data race on ARM).
+        return true;
+    }
+
+    // Automatic retry on transient provider failures (rate limit / server
+    // error / overload). Returns true if a retry was scheduled. The retry
+    // queues on the limiter's timer — after Retry-After when the provider
+    // sent one, else 2s.
+    bool retryToolRoundIfTransient(int httpCode, double waitSeconds) {
+        if (!this->transientRetryAllowed(httpCode)) return false;
+        double delay = waitSeconds > 0 ? waitSeconds : 2.0;
+        log::warn("Transient HTTP {} — retrying round in {:.1f}s", httpCode, delay);
+        showStatus(fmt::format("Provider hiccup (HTTP {}) — retrying in {:.0f}s...",
+                               httpCode, std::ceil(delay)));
         Ref<AIGeneratorPopup> self = this;
-        std::thread([self = std::move(self)]() mutable {
-            std::this_thread::sleep_for(std::chrono::seconds(2));
-            Loader::get()->queueInMainThread([self = std::move(self)] {
-                if (!self->m_isGenerating) return;
-                --self->m_toolIterations;  // the retry isn't a new round
-                self->doToolRound();
-            });
-            // thread-local self is moved-from (null) — destructor is a no-op
-        }).detach();
+        ratelimit::defer(m_toolProvider, rateOwner(), [self, gen = m_generation] {
+            if (!self->stillCurrent(gen)) return;
+            --self->m_toolIterations;  // the retry isn't a new round
+            self->doToolRound();
+        }, delay);
         return true;
     }
 
     void onToolRoundResponse(web::WebResponse resp) {
         logApiResponse(resp.code(), resp.string().unwrapOr(""));
+        trace::record(traceSession(), "http", "net", m_traceHttpStartUs, trace::nowUs());
+        trace::Span handleSpan("handle-tool-round", traceSession());
+        double waitSeconds = ratelimit::observe(m_toolProvider, resp);
         if (!resp.ok()) {
-            if (this->retryToolRoundIfTransient(resp.code())) return;
+            if (this->retryToolRoundIfTransient(resp.code(), waitSeconds)) return;
             auto [title, msg] = parseAPIError(
                 resp.string().unwrapOr("No body"), resp.code());
             onError(title, msg);
@@ -13375,8 +17908,7 @@ protected:
     }
 
     // One-shot completion against the user's configured SECOND provider —
-    // powers ask_subagent. Minimal request bodies (no tools, no history):
-    // OpenAI-compat family + ollama generate + claude + gemini.
+    // powers ask_subagent.
     void fireSubagentCompletion(const std::string& provider,
                                 const std::string& question,
                                 std::function<void(std::string)> onDone)
@@ -13387,104 +17919,38 @@ protected:
         static const char* SUB_SYS =
             "You are a concise expert consultant for a Geometry Dash level-design "
             "AI. Answer the question directly in under 250 words. No preamble.";
-
-        matjson::Value body = matjson::Value::object();
-        std::string url;
-        auto request = web::WebRequest();
-        request.header("Content-Type", "application/json");
-        request.timeout(std::chrono::seconds(90));
-
-        if (provider == "claude") {
-            auto msg = matjson::Value::object();
-            msg["role"] = "user";
-            msg["content"] = question;
-            body["model"] = model;
-            body["max_tokens"] = 1024;
-            body["system"] = SUB_SYS;
-            body["messages"] = std::vector<matjson::Value>{msg};
-            url = "https://api.anthropic.com/v1/messages";
-        } else if (provider == "gemini") {
-            auto part = matjson::Value::object();
-            part["text"] = question;
-            auto content = matjson::Value::object();
-            auto parts = matjson::Value::array();
-            parts.push(part);
-            content["parts"] = parts;
-            auto contents = matjson::Value::array();
-            contents.push(content);
-            body["contents"] = contents;
-            auto sysPart = matjson::Value::object();
-            sysPart["text"] = SUB_SYS;
-            auto sysParts = matjson::Value::array();
-            sysParts.push(sysPart);
-            auto sysInst = matjson::Value::object();
-            sysInst["parts"] = sysParts;
-            body["systemInstruction"] = sysInst;
-            url = fmt::format(
-                "https://generativelanguage.googleapis.com/v1beta/models/{}:generateContent",
-                model);
-        } else if (provider == "ollama") {
-            body["model"] = model;
-            body["prompt"] = fmt::format("{}\n\n{}", SUB_SYS, question);
-            body["stream"] = false;
-            url = getOllamaUrl() + "/api/generate";
-        } else {
-            // OpenAI-compatible family (openai/openrouter/ministral/hf/
-            // deepseek/lm-studio/llama-cpp).
-            auto sys = matjson::Value::object();
-            sys["role"] = "system";  sys["content"] = SUB_SYS;
-            auto usr = matjson::Value::object();
-            usr["role"] = "user";    usr["content"] = question;
-            auto msgs = matjson::Value::array();
-            msgs.push(sys); msgs.push(usr);
-            body["model"] = model;
-            body["messages"] = msgs;
-            body["max_tokens"] = 1024;
-            url = toolUse::urlFor(provider, model);
-        }
-        applyProviderAuth(request, provider, apiKey);
-        request.bodyString(body.dump());
+        auto req = oneshot::build(provider, model, SUB_SYS, question, 1024);
         log::info("ask_subagent -> {} ({})", provider, model);
+        // Subagent calls spend the same provider budget as the main loop.
+        Ref<AIGeneratorPopup> self = this;
+        ratelimit::acquire(provider, rateOwner(),
+            [self, gen = m_generation, provider, apiKey, req = std::move(req),
+             onDone = std::move(onDone)] {
+                if (!self->stillCurrent(gen)) return;
+                auto request = web::WebRequest();
+                request.header("Content-Type", "application/json");
+                request.timeout(std::chrono::seconds(90));
+                applyProviderAuth(request, provider, apiKey);
+                request.bodyString(req.body);
+                self->fireSubagentRequest(provider, req.url, std::move(request), onDone);
+            });
+    }
+
+    void fireSubagentRequest(const std::string& provider, const std::string& url,
+                             web::WebRequest request,
+                             std::function<void(std::string)> onDone)
+    {
         m_subagentTask.spawn(
             request.post(url),
             [provider, onDone = std::move(onDone)](web::WebResponse resp) mutable {
+                ratelimit::observe(provider, resp);
                 if (!resp.ok()) {
                     onDone(fmt::format("(subagent HTTP {})", resp.code()));
                     return;
                 }
                 auto json = resp.json();
                 if (!json) { onDone("(subagent returned non-JSON)"); return; }
-                const auto j = json.unwrap();
-                std::string text;
-                if (provider == "claude") {
-                    if (j.contains("content") && j["content"].isArray() && j["content"].size() > 0) {
-                        auto t = j["content"][0]["text"].asString();
-                        if (t) text = t.unwrap();
-                    }
-                } else if (provider == "gemini") {
-                    if (j.contains("candidates") && j["candidates"].isArray() &&
-                        j["candidates"].size() > 0) {
-                        const auto& cand = j["candidates"][0];
-                        if (cand.contains("content") && cand["content"].contains("parts") &&
-                            cand["content"]["parts"].isArray()) {
-                            // All text parts — a leading thought part would
-                            // otherwise make parts[0]["text"] miss.
-                            const auto& parts = cand["content"]["parts"];
-                            for (size_t pi = 0; pi < parts.size(); ++pi)
-                                if (parts[pi].contains("text"))
-                                    if (auto t = parts[pi]["text"].asString())
-                                        text += t.unwrap();
-                        }
-                    }
-                } else if (provider == "ollama") {
-                    auto t = j["response"].asString();
-                    if (t) text = t.unwrap();
-                } else {
-                    if (j.contains("choices") && j["choices"].isArray() && j["choices"].size() > 0) {
-                        auto t = j["choices"][0]["message"]["content"].asString();
-                        if (t) text = t.unwrap();
-                    }
-                }
+                std::string text = oneshot::parse(provider, json.unwrap());
                 onDone(std::move(text));
             });
     }
@@ -13495,6 +17961,9 @@ protected:
     void executeOneToolCall(toolUse::ToolCall call,
                             std::function<void(toolUse::ToolResult)> onDone)
     {
+        // Synchronous tools finish inside this span; network tools only
+        // record their dispatch here (their wait shows up as a gap).
+        trace::Span span("tool-call", traceSession(), "tool");
         toolUse::ToolResult r;
         r.toolCallId = call.id;
         log::info("→ Tool call: {} args={}", call.name, call.args.dump());
@@ -13545,12 +18014,32 @@ protected:
             std::string body = this->buildLevelDataJson();
             if (m_editorLayer && m_editorLayer->m_level) {
                 auto* lvl = m_editorLayer->m_level;
+                // Whole-level pacing from the live density index: at most
+                // 40 windows, widened (from 1000u) to cover the level.
+                const auto& idx = liveDensity();
+                float width = std::max(1000.f, std::ceil(idx.maxX() / 40.f / 30.f) * 30.f);
+                auto rowsOf = [&](uint32_t mask) {
+                    return idx.histogram(width, mask, levelcheck::kAllClasses, 40);
+                };
+                auto all    = rowsOf(levelcheck::kAllClasses);
+                auto hazard = rowsOf(levelcheck::classBit(levelcheck::kHazard));
+                auto solid  = rowsOf(levelcheck::classBit(levelcheck::kSolid));
+                auto orb    = rowsOf(levelcheck::classBit(levelcheck::kOrb));
+                std::string rows;
+                for (size_t w = 0; w < all.size(); ++w) {
+                    if (w) rows += ",";
+                    rows += fmt::format("[{:.0f},{:.1f},{:.1f},{:.1f},{:.1f}]",
+                        all[w].x0, all[w].density, hazard[w].density,
+                        solid[w].density, orb[w].density);
+                }
                 body = fmt::format(
                     "{{\"level_name\":\"{}\",\"song_id\":{},"
-                    "\"audio_track\":{},\"objects_json\":{}}}",
+                    "\"audio_track\":{},\"density_per_1000u\":{{\"window\":{:.0f},"
+                    "\"cols\":[\"x\",\"all\",\"hazard\",\"solid\",\"orb_pad\"],"
+                    "\"rows\":[{}]}},\"objects_json\":{}}}",
                     std::string(lvl->m_levelName),
                     (int)lvl->m_songID, (int)lvl->m_audioTrack,
-                    body);
+                    width, rows, body);
             }
             r.content = body;
             onDone(std::move(r));
@@ -13632,25 +18121,15 @@ protected:
             if (m_accumulatedObjects.size() == 0) {
                 r.content = "(no accepted draft yet - emit your first draft, then "
                             "call this during EXTEND rounds.)";
-            } else {
-                auto sim = levelcheck::simulateCube(m_accumulatedObjects,
-                    (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"));
-                if (sim.deaths.empty()) {
-                    r.content = fmt::format(
-                        "Physics bot CLEARED the draft (reached X={:.0f}{}). "
-                        "Cube sections look jumpable.",
-                        sim.reachedX, sim.finished ? ", end of level" : "");
-                } else {
-                    std::string body = fmt::format(
-                        "Physics bot died {} time(s):\n", sim.deaths.size());
-                    for (auto& d : sim.deaths)
-                        body += fmt::format("  X={:.0f} Y={:.0f}: {}\n", d.x, d.y, d.reason);
-                    body += "Fix these spots (wider spacing, lower obstacles, or an "
-                            "orb/pad assist) before finalizing.";
-                    r.content = std::move(body);
-                }
+                onDone(std::move(r));
+                return;
             }
-            onDone(std::move(r));
+            verifyDraftAsync([this, r, onDone = std::move(onDone)](
+                                 levelcheck::Result, levelcheck::VerifyResult sim) mutable {
+                if (!m_isGenerating) return;
+                r.content = describeVerify(sim);
+                onDone(std::move(r));
+            });
             return;
         }
         if (call.name == "analyze_difficulty_curve") {
@@ -13658,7 +18137,7 @@ protected:
                 r.content = "(no accepted draft yet — emit your first draft, then "
                             "call this during EXTEND rounds.)";
             } else {
-                auto hist = levelcheck::difficultyHistogram(m_accumulatedObjects);
+                auto hist = levelcheck::difficultyHistogram(draftDensity());
                 if (hist.empty()) {
                     r.content = "(draft has no measurable span yet)";
                 } else {
@@ -13687,24 +18166,30 @@ protected:
                 r.content = "(no accepted draft yet — this tool only sees objects from "
                             "your previous JSON answers. Emit your first draft, then "
                             "call this during EXTEND rounds.)";
-            } else {
-                auto pass = levelcheck::check(m_accumulatedObjects);
+                onDone(std::move(r));
+                return;
+            }
+            verifyDraftAsync([this, r, onDone = std::move(onDone)](
+                                 levelcheck::Result pass, levelcheck::VerifyResult sim) mutable {
+                if (!m_isGenerating) return;
                 std::string zones;
                 for (size_t k = 0; k < pass.deaths.size() && k < 8; ++k) {
                     if (k) zones += ", ";
                     zones += fmt::format("X={:.0f}-{:.0f}",
                                          pass.deaths[k].x_start, pass.deaths[k].x_end);
                 }
-                r.content = fmt::format(
-                    "Passability: {:.1f}% across {} columns. {}{}",
-                    pass.pass_rate * 100.f, pass.total_columns,
-                    pass.deaths.empty()
-                        ? "No death zones — clear to finalize."
-                        : fmt::format("{} death zone(s) that MUST be fixed before the "
-                                      "final answer: ", pass.deaths.size()),
-                    zones);
-            }
-            onDone(std::move(r));
+                // The column scan only sees occupancy; the verifier's verdict
+                // decides whether its zones are real.
+                std::string columns = fmt::format(
+                    "Column scan: {:.1f}% of {} columns open", pass.pass_rate * 100.f,
+                    pass.total_columns);
+                if (!pass.deaths.empty())
+                    columns += fmt::format(", {} fully blocked ({})", pass.deaths.size(), zones);
+                r.content = fmt::format("{}\n{}{}", describeVerify(sim), columns,
+                    sim.passable && !pass.deaths.empty()
+                        ? " — a route exists anyway, no fix needed there." : ".");
+                onDone(std::move(r));
+            });
             return;
         }
         if (call.name == "get_level_region") {
@@ -13784,20 +18269,12 @@ protected:
             //   2. Anything we've already accumulated this generation
             //      (m_accumulatedObjects) — relevant during extension rounds
             //      so the AI sees the running total, not just the editor.
-            float editorMaxX = 0.f;
-            int editorObjectCount = 0;
-            // revalidate: the editor may have been freed during this unbounded
-            // loop — iterating a dead m_objects is a use-after-free.
-            if (revalidateEditor() && m_editorLayer->m_objects) {
-                for (auto* raw : CCArrayExt<CCObject*>(m_editorLayer->m_objects)) {
-                    auto* obj = typeinfo_cast<GameObject*>(raw);
-                    if (!obj) continue;
-                    float x = obj->getPositionX();
-                    if (x > editorMaxX) editorMaxX = x;
-                    ++editorObjectCount;
-                }
-            }
-            float accumMaxX = computeMaxXFromObjects(m_accumulatedObjects);
+            // Both from the density indexes — liveDensity() revalidates the
+            // editor (it may have been freed during this unbounded loop).
+            const auto& live = liveDensity();
+            float editorMaxX      = live.maxX();
+            int editorObjectCount = live.total();
+            float accumMaxX = draftDensity().maxX(levelcheck::kLengthClasses);
             float maxX = std::max(editorMaxX, accumMaxX);
             auto  [secs, cat] = describeLengthByX(maxX);
             float targetMinX  = m_lengthTarget.minSeconds * GD_PLAYER_SPEED_1X;
@@ -13842,6 +18319,7 @@ protected:
     // Shared "generation finished (one way or another)" UI reset: hide the
     // cancel button, restore Generate.
     void resetGenerationUI() {
+        removeDraftSketch();
         m_isGenerating = false;
         m_cancelBtn->setVisible(false);
         m_generateBtn->setVisible(true);
@@ -13852,6 +18330,7 @@ protected:
     // The portion of onAPISuccess after aiResponse is in hand. Factored out so
     // the tool-use loop can call it once its loop completes.
     void processFinalResponse(std::string aiResponse, const std::string& provider) {
+        trace::Span span("process-final-response", traceSession());
         resetGenerationUI();
         // Self-critique replies may legitimately contain no level content
         // ("ALL GOOD") — that must fall through to apply, not error out.
@@ -13876,7 +18355,7 @@ protected:
                 }
                 if (any) {
                     val = std::clamp(val, 1, 10);
-                    s_lastSelfRating = val;   // rides along with telemetry
+                    m_stage->fb.selfRating = val;   // rides along with telemetry
                     pushSession(GenSession::Entry::Kind::Status,
                         fmt::format("AI self-rated this level {}/10{}", val,
                                     val >= 8 ? "" : " - applying its own fixes"));
@@ -13937,6 +18416,10 @@ protected:
             }
         }
 
+        // Speculative draft: this reply is a patch over the local draft.
+        if (m_draftPhase == DraftPhase::Patching)
+            aiResponse = mergeDraftPatch(aiResponse);
+
         // Record the assistant's reply in the conversation log — follow-up
         // turns need the model to see what it previously produced (the tool
         // loop never appends its final answer; single-shot never appended
@@ -13992,9 +18475,9 @@ protected:
                     narration += " [...]";
                 }
             }
-            s_lastAINarration = std::move(narration);
-            if (!s_lastAINarration.empty())
-                pushSession(GenSession::Entry::Kind::Assistant, s_lastAINarration);
+            m_stage->fb.aiNarration = std::move(narration);
+            if (!m_stage->fb.aiNarration.empty())
+                pushSession(GenSession::Entry::Kind::Assistant, m_stage->fb.aiNarration);
         }
 
         // ── EAS auto-detect ─────────────────────────────────────────────
@@ -14008,7 +18491,8 @@ protected:
         {
             std::string scriptBody = eas::extractScript(aiResponse);
             if (eas::looksLikeEAS(scriptBody)) {
-                auto er = eas::parse(scriptBody);
+                trace::Span parseSpan("eas-parse", traceSession(), "parse");
+                auto er = eas::parseParallel(scriptBody);
                 if (er.ok) {
                     levelData = std::move(er.root);
                     parsedAsEAS = true;
@@ -14030,7 +18514,7 @@ protected:
             // nothing in the transcript yet.
             auto finishProseTurn = [&]() -> bool {
                 if (!m_followUpTurn) return false;
-                if (s_lastAINarration.empty())
+                if (m_stage->fb.aiNarration.empty())
                     pushSession(GenSession::Entry::Kind::Assistant, aiResponse);
                 if (m_session) m_session->chatPush(1, aiResponse);  // durable memory
                 log::info("Follow-up turn answered with prose only");
@@ -14061,7 +18545,10 @@ protected:
                 }
                 jsonBlock = aiResponse.substr(s, e - s + 1);
             }
-            auto levelLenient = editorai::json_lenient::parse(jsonBlock);
+            auto levelLenient = [&] {
+                trace::Span parseSpan("json-lenient-parse", traceSession(), "parse");
+                return editorai::json_lenient::parse(jsonBlock);
+            }();
             if (!levelLenient.ok) {
                 if (wasCritiqueReply) {
                     log::info("Self-critique: reply unparseable — accepting the level as-is");
@@ -14105,11 +18592,38 @@ protected:
         resetBlockTemplates();
 
         if (hasMacros) {
+            trace::Span macroSpan("macro-expand", traceSession(), "parse");
             std::vector<matjson::Value> expanded;
             macros::expandAll(levelData["macros"], expanded);
             for (auto& obj : expanded) objectsArray.push(std::move(obj));
         }
 
+        // Fresh-level rounds patch what earlier rounds produced: their ops
+        // run against the draft by stable id instead of the live editor
+        // (edit, mutation and co-op turns keep them for the live resolver).
+        if (!m_followUpTurn && !m_editMode && !m_mutationMode && !m_coopMode) {
+            bool anyOp = false;
+            for (size_t i = 0; i < objectsArray.size() && !anyOp; ++i)
+                anyOp = objectsArray[i].isObject() && objectsArray[i].contains("op");
+            if (anyOp) {
+                std::vector<matjson::Value> ops;
+                auto rest = matjson::Value::array();
+                for (size_t i = 0; i < objectsArray.size(); ++i) {
+                    auto& e = objectsArray[i];
+                    if (e.isObject() && e.contains("op")) ops.push_back(std::move(e));
+                    else rest.push(std::move(e));
+                }
+                objectsArray = std::move(rest);
+                auto st = applyDraftOps(ops);
+                log::info("Draft ops: {} op(s) - {} moved, {} deleted, {} edited, "
+                          "{} matched nothing", ops.size(), st.moved, st.deleted,
+                          st.edited, st.missed);
+                pushSession(GenSession::Entry::Kind::Status,
+                    fmt::format("Patched the draft: {} moved, {} deleted, {} edited",
+                                st.moved, st.deleted, st.edited));
+            }
+        }
+
         // Empty after expansion is allowed when metadata is present (the AI
         // can make level-wide changes without adding geometry). If neither
         // metadata nor objects/macros exist, log a warning and continue with
@@ -14183,7 +18697,7 @@ protected:
         bool inToolLoop = m_usingToolLoop && !m_editMode
                        && !m_mutationMode && !m_coopMode;
         if (inToolLoop) {
-            float currentMaxX = computeMaxXFromObjects(m_accumulatedObjects);
+            float currentMaxX = draftDensity().maxX(levelcheck::kLengthClasses);
             auto [curSecs, curCat] = describeLengthByX(currentMaxX);
             float targetSecs       = m_lengthTarget.minSeconds;
             float targetMinX       = targetSecs * GD_PLAYER_SPEED_1X;
@@ -14297,26 +18811,57 @@ protected:
         //   - the level is in EDIT mode (player is iterating on an existing
         //     level; bad-collision warnings would be noisy and incorrect
         //     because we don't have the existing level's geometry mapped in)
+        //
+        // The check runs over a snapshot of the accumulator on a worker; the
+        // generation stays armed (Cancel still works) until the verdict is
+        // posted back, and the remaining gates continue in
+        // finishFinalResponse. Only the (small) metadata object travels with
+        // it — levelData still holds the full objects array.
+        auto metadata = hasMetadata ? levelData["level_metadata"] : matjson::Value();
+        m_isGenerating = true;
+        if (m_cancelBtn)   m_cancelBtn->setVisible(true);
+        if (m_generateBtn) m_generateBtn->setVisible(false);
+        showStatus("Checking the level is beatable...");
+        int64_t checkStartUs = trace::nowUs();
+        verifyDraftAsync([this, checkStartUs, aiResponse = std::move(aiResponse),
+                          metadata = std::move(metadata)](
+                             levelcheck::Result pass, levelcheck::VerifyResult route) mutable {
+            if (!m_isGenerating) return;
+            trace::record(traceSession(), "levelcheck", "verify", checkStartUs, trace::nowUs());
+            resetGenerationUI();
+            finishFinalResponse(std::move(aiResponse), std::move(metadata),
+                                std::move(pass), std::move(route));
+        });
+    }
+
+    // processFinalResponse once the passability verdict is in: fix rounds,
+    // edit workload, quality passes, refinement, decoration, self-critique,
+    // then the final apply.
+    void finishFinalResponse(std::string aiResponse, matjson::Value levelMetadata,
+                             levelcheck::Result passResult, levelcheck::VerifyResult route) {
         constexpr float PASS_THRESHOLD = 0.95f;
         constexpr int MAX_PASSABILITY_FIXES = 2;
-        // Check the accumulator directly — the apply snapshot is only taken
-        // after every early-return round below, so no copies are wasted on
-        // intermediate passability/refinement rounds.
-        auto passResult = levelcheck::check(m_accumulatedObjects);
-        log::info("Passability: {}", passResult.summary);
-
+        log::info("Passability: {} | route: {}", passResult.summary,
+                  route.passable ? std::string("found")
+                                 : fmt::format("blocked at X={:.0f}", route.blockedX));
+
+        // A fix round only fires on a real impossibility: the verifier found
+        // no route through objects it fully models, and either proved it
+        // (nothing dropped) or the column scan agrees. Column-blocked zones a
+        // route gets through anyway are false alarms and not worth a round.
+        bool blocked = route.blocked() &&
+                       (route.exhaustive || passResult.pass_rate < PASS_THRESHOLD);
         // Follow-up turns are skipped outright: the accumulator holds only
         // this turn's delta, so "passability" against it is meaningless and
         // its warnings would be noise.
-        if (passResult.pass_rate < PASS_THRESHOLD && !m_editMode && !m_mutationMode
-            && !m_followUpTurn) {
+        if (blocked && !m_editMode && !m_mutationMode && !m_followUpTurn) {
             bool canLoopBack = m_usingToolLoop && !m_followUpTurn
                             && m_passabilityFixRounds < MAX_PASSABILITY_FIXES;
             if (canLoopBack) {
                 ++m_passabilityFixRounds;
-                log::warn("Level only {:.1f}% passable. Asking model to fix "
+                log::warn("No route past X={:.0f}. Asking model to fix "
                           "(round {}/{}).",
-                          passResult.pass_rate * 100.f,
+                          route.blockedX,
                           m_passabilityFixRounds, MAX_PASSABILITY_FIXES);
 
                 // (assistant turn already recorded once, unconditionally,
@@ -14336,19 +18881,19 @@ protected:
                 toolUse::Message fix;
                 fix.role = toolUse::MessageRole::User;
                 fix.text = fmt::format(
-                    "The level you produced has unpassable sections — only "
-                    "{:.1f}% of columns have an open vertical path (target: "
-                    "≥95%). A column is \"dead\" if it has a solid block "
-                    "or hazard at EVERY Y from 15 to 540 with no airspace to "
-                    "fly through. Death zones: {}. "
-                    "FIX THE LEVEL: remove or reposition objects in those X "
-                    "ranges so the player can fly through. Either re-emit the "
-                    "WHOLE level with those zones unblocked, OR emit just the "
-                    "ADDITIONAL objects/macros needed to clear the path (the "
-                    "mod accumulates). DO NOT add more obstacles in the dead "
-                    "zones — open them up. Fix round {} of {}.",
-                    passResult.pass_rate * 100.f, deathList,
-                    m_passabilityFixRounds, MAX_PASSABILITY_FIXES);
+                    "The level you produced is unpassable: the physics "
+                    "verifier tried every press/release timing and none "
+                    "survives past X={:.0f} — {}. Column scan: {:.1f}% of "
+                    "columns have an open vertical path{}{}. "
+                    "FIX THE LEVEL: delete or reposition the objects around "
+                    "that X so the player can get through — do NOT re-emit "
+                    "the level and do not add obstacles in the dead zones. "
+                    "{} Fix round {} of {}.\n\nOBJECTS NEAR X={:.0f} (#id):\n{}",
+                    route.blockedX, route.reason, passResult.pass_rate * 100.f,
+                    deathList.empty() ? "" : "; fully blocked: ", deathList,
+                    draftPatchHelp(),
+                    m_passabilityFixRounds, MAX_PASSABILITY_FIXES, route.blockedX,
+                    draftListing(route.blockedX - 240.f, route.blockedX + 120.f, 80));
                 fix.imageB64 = visionSnapshotIfSupported();
                 m_toolHistory.push_back(std::move(fix));
                 showStatus(fmt::format("Fixing impassable level (round {})...",
@@ -14359,9 +18904,8 @@ protected:
             // Out of fix rounds or no loop available — warn the user but
             // still apply (they may be able to repair manually).
             Notification::create(
-                fmt::format("Level is only {:.1f}% passable — applying anyway. "
-                            "{} death zone(s) flagged in the log.",
-                            passResult.pass_rate * 100.f, passResult.deaths.size()),
+                fmt::format("No route past X={:.0f} ({}) — applying anyway.",
+                            route.blockedX, route.reason),
                 NotificationIcon::Warning, 5.f
             )->show();
         }
@@ -14417,6 +18961,12 @@ protected:
             }
         }
 
+        // ── Parallel quality passes ────────────────────────────────────
+        // The refinement, decoration and self-check rounds below, fanned out
+        // at once (parallel-quality-passes). The merged patch comes back
+        // through here with every one of those gates already spent.
+        if (startQualityPasses(passResult)) return;
+
         // ── Refinement loop ────────────────────────────────────────────
         // After the level passes the length + passability checks, optionally
         // bounce the AI N more times asking it to look at its own work and
@@ -14443,42 +18993,9 @@ protected:
                 log::info("Refinement pass {}/{}", m_refinementRounds, maxRefine);
 
                 // Rotating focus per round so the AI doesn't repeat the same
-                // type of polish three times. We cycle through 5 angles and
-                // the model gets a different one each call.
-                static const std::vector<const char*> REFINEMENT_FOCUSES = {
-                    "PACING + OBSTACLE VARIETY: scan for runs of identical objects "
-                    "(e.g. 5 spike-trains in a row) and replace some with orbs, "
-                    "pads, stairs, or platform sections. Fix any spacing < 60 "
-                    "units between obstacles (too cramped) or > 300 units (boring "
-                    "gap).",
-
-                    "VISUAL COHESION: add decoration objects (gears, blades, "
-                    "decorative blocks) sparsely to make the level feel built, "
-                    "not random. Ensure color channels are used consistently — "
-                    "if the level has a color palette, route blocks/spikes to "
-                    "those channels with `color=N`.",
-
-                    "DIFFICULTY CURVE: the level should ramp up, not be flat. "
-                    "Easy intro (first 25%), build-up (next 50%), climax (last "
-                    "25% — densest, hardest, with optional speed-up portal). If "
-                    "the level is uniformly easy or uniformly chaotic, add or "
-                    "remove obstacles to create a curve.",
-
-                    "GAMEPLAY FLOW: verify every gamemode-change portal has a "
-                    "FLOOR or CORRIDOR on the OTHER side leading away from it. "
-                    "Verify orbs are reachable from the ground row (Y=105) with "
-                    "a single jump (Y=135-165). Add small details that make "
-                    "movement feel rhythmic — paired spikes, alternating orbs.",
-
-                    "POLISH PASS: scan for anything that feels random — an "
-                    "orphaned block in the air, a spike too close to a portal, "
-                    "a color trigger that fires too late. Fix specific issues. "
-                    "Add 1-2 TRIGGER pulse/color lines to mark transitions you "
-                    "care about. End on a strong note (climax + clean transition "
-                    "to TRIGGER end).",
-                };
-                const char* focus = REFINEMENT_FOCUSES[
-                    (m_refinementRounds - 1) % REFINEMENT_FOCUSES.size()];
+                // type of polish three times.
+                const auto& focuses = refinementFocuses();
+                const char* focus = focuses[(m_refinementRounds - 1) % focuses.size()];
 
                 // (assistant turn already recorded once, unconditionally,
                 // near the top of processFinalResponse)
@@ -14488,20 +19005,15 @@ protected:
                 refine.text = fmt::format(
                     "Refinement pass {} of {}. Look back at the level you just "
                     "built. It's {:.1f}% passable across {} columns. Don't "
-                    "rebuild it — emit a small polish update that adds, "
-                    "removes, or replaces 10-30 objects/macros to improve it.\n\n"
+                    "rebuild it — emit a small polish patch that adds, "
+                    "removes, moves or restyles 10-30 objects/macros.\n\n"
                     "FOCUS for this pass: {}\n\n"
-                    "Emit additional EAS lines (or JSON objects/macros) that "
-                    "the mod will ACCUMULATE on top of what you've already "
-                    "produced. To remove or replace an earlier object, you "
-                    "can't 'delete' — but you can override its position with "
-                    "a `TRIGGER move` or hide it with `TRIGGER alpha to=0` "
-                    "targeting its group, OR you can just add new objects that "
-                    "improve the flow around the bad spot. After this pass the "
-                    "level will be applied — make it count.",
+                    "{}\nAfter this pass the level will be applied — make it "
+                    "count.\n\nDRAFT OBJECTS by X (#id):\n{}",
                     m_refinementRounds, maxRefine,
                     passResult.pass_rate * 100.f, passResult.total_columns,
-                    focus);
+                    focus, draftPatchHelp(),
+                    draftListing(-1e9f, 1e9f, 400));
                 refine.imageB64 = visionSnapshotIfSupported();
                 m_toolHistory.push_back(std::move(refine));
                 showStatus(fmt::format("Refinement pass {}/{}...",
@@ -14527,31 +19039,7 @@ protected:
 
                 toolUse::Message decor;
                 decor.role = toolUse::MessageRole::User;
-                decor.text =
-                    "DECORATION PASS. The gameplay skeleton is done — now make "
-                    "it look BUILT, not generated. Work the checklist, every "
-                    "item, whole level:\n"
-                    "1. PALETTE: META bg/ground + COLOR lines for 2-3 custom "
-                    "channels; TRIGGER color at each section boundary so the "
-                    "mood shifts as the level progresses.\n"
-                    "2. GROUND DETAIL: decorative strips/slabs along the floor "
-                    "every 150-300u (vary them); small gears/plants/crystals "
-                    "in dead corners.\n"
-                    "3. BACKGROUND DEPTH: large slow decor (z_layer=-3, dim "
-                    "color) behind the play path every 400-600u — silhouettes "
-                    "make a level feel deep.\n"
-                    "4. STRUCTURE DRESSING: outline existing block clusters "
-                    "with slopes/connectors; glow edges (noglow off) on "
-                    "platform lips the player lands on.\n"
-                    "5. MOTION: TRIGGER pulse on the beat for 1-2 channels; "
-                    "slow TRIGGER rotate on big background gears; one camera "
-                    "zoom or shake at the biggest drop.\n"
-                    "6. NEGATIVE SPACE: any 300u stretch with nothing but "
-                    "floor gets at least one decor element.\n"
-                    "DO NOT add, move, or block anything in the play path — "
-                    "no new spikes, blocks at player height, portals, or "
-                    "orbs. Decor that overlaps the path goes passable + "
-                    "z_layer'd behind. Emit additional EAS lines only.";
+                decor.text = decorationPassText();
                 decor.imageB64 = visionSnapshotIfSupported();
                 m_toolHistory.push_back(std::move(decor));
                 showStatus("Decoration pass...");
@@ -14577,21 +19065,8 @@ protected:
 
                 toolUse::Message crit;
                 crit.role = toolUse::MessageRole::User;
-                crit.text =
-                    "FINAL SELF-REVIEW before the level is applied. First "
-                    "line of your reply MUST be \"RATING: n/10\" - your "
-                    "honest overall score. Judge like a harsh playtester: "
-                    "(a) playability - every jump makeable, no blind traps; "
-                    "(b) pacing - density ramps with the difficulty curve; "
-                    "(c) variety - no copy-pasted obstacle spam; "
-                    "(d) decoration - no bare stretches, cohesive palette, "
-                    "background/ground colors set; (e) faithfulness to the "
-                    "user's request. If you rate 8+, follow the rating line "
-                    "with exactly: ALL GOOD. Otherwise follow it with ONLY "
-                    "the fix - 10-40 additional EAS lines/macros repairing "
-                    "EVERY issue you found (fill empty stretches, fix "
-                    "impossible jumps, decorate bare sections, add missing "
-                    "color triggers). No rebuild, no commentary.";
+                crit.text = critiquePassText();
+                crit.text += draftPatchHelp();
                 crit.imageB64 = visionSnapshotIfSupported();
                 m_toolHistory.push_back(std::move(crit));
                 showStatus("Self-check...");
@@ -14621,13 +19096,13 @@ protected:
                 if (e.isObject() && e.contains("op")) continue;
                 cleaned.push(e);
             }
-            s_lastGeneratedJson = cleaned.dump();
+            m_stage->fb.generatedJson = cleaned.dump();
         }
 
         // Telemetry ON = every output ships to the community collector the
         // moment it's done (rating 0 = not yet rated; the AI's self-review
         // score rides along; a second send follows if the user rates).
-        autoContributeGeneration(0);
+        autoContributeGeneration(m_stage->fb, 0);
 
         // MOVE the accumulator into the apply snapshot — this is the final
         // apply (every loop path above returned early), nothing reads the
@@ -14637,14 +19112,46 @@ protected:
         // by construction. The dump for the rating popup was taken above.
         auto applyObjects = std::make_shared<matjson::Value>(std::move(m_accumulatedObjects));
         m_accumulatedObjects = matjson::Value::array();  // defensive re-init
+        clearDraftIndexes();
 
-        // Capture only the (small) metadata object — levelData still holds
-        // the original full objects array, which the lambda never needs.
-        auto metadata = std::make_shared<matjson::Value>(
-            hasMetadata ? levelData["level_metadata"] : matjson::Value());
+        auto metadata = std::make_shared<matjson::Value>(std::move(levelMetadata));
         auto applyResult = [this, metadata, applyObjects]() {
-            // No live editor (user left the level mid-generation): hold the
-            // result; the next editor session adopts and stages it.
+            // No live editor (user left the level mid-generation, or a
+            // headless/batch session): write straight into the target
+            // level's string only when the user opted in — a direct write
+            // has no Accept/Deny preview and no undo, so staging for review
+            // stays the default. Anything the writer can't express falls
+            // back to staging below.
+            if (!revalidateEditor() && m_session && m_session->targetLevel
+                && Mod::get()->getSettingValue<bool>("direct-write")) {
+                auto t0 = std::chrono::steady_clock::now();
+                auto* level = m_session->targetLevel.data();
+                std::string before = level->m_levelString;
+                auto res = levelstr::write(level, *applyObjects, m_shouldClearLevel,
+                    Mod::get()->getSettingValue<bool>("enable-advanced-features"),
+                    (int)Mod::get()->getSettingValue<int64_t>("max-objects"),
+                    getGroundY());
+                if (res.ok) {
+                    levelstr::applyLevelFields(level, *metadata);
+                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    std::string name = level->m_levelName;
+                    log::info("Direct write: {} objects into '{}' ({} -> {} bytes) in {} ms",
+                              res.written, name, before.size(),
+                              std::string(level->m_levelString).size(), ms);
+                    m_session->state = GenSession::State::Done;
+                    m_session->push(GenSession::Entry::Kind::Status,
+                        fmt::format("Wrote {} objects into '{}' in {} ms",
+                                    res.written, name, ms));
+                    Notification::create(
+                        fmt::format("AI level written to '{}'", name),
+                        NotificationIcon::Success)->show();
+                    return;
+                }
+                log::info("Direct write declined ({}) - staging instead", res.reason);
+            }
+            // Otherwise hold the result; the next editor session adopts and
+            // stages it.
             if (!revalidateEditor()) {
                 m_pendingApplyObjects = applyObjects;
                 m_pendingMetadata     = metadata;
@@ -14658,7 +19165,10 @@ protected:
                     NotificationIcon::Success)->show();
                 return;
             }
-            if (m_shouldClearLevel) clearLevel();
+            if (m_shouldClearLevel && !clearLevel()) {
+                reportClearRefused();
+                return;
+            }
             if (metadata->isObject()) applyLevelMetadata(*metadata);
             prepareObjects(*applyObjects);
             // Off-scene engines (backgrounded popup, copilot) have no spawn
@@ -14667,44 +19177,86 @@ protected:
         };
 
         // "Show AI output": write the FULL raw response to a file in the mod
-        // save folder (background thread — never block the frame on disk).
+        // save folder (I/O worker — never block the frame on disk).
         // Replaces the old 1800-char review popup, which truncated long
         // responses and gated the apply on a click.
         if (Mod::get()->getSettingValue<bool>("show-ai-output")) {
             auto path = Mod::get()->getSaveDir() / "last-ai-response.txt";
             log::info("EditorAI: raw response ({} chars) -> {}",
                       aiResponse.size(), utils::string::pathToString(path));
-            std::thread([path, text = aiResponse] {
-                // Serialize writers: back-to-back generations would otherwise
-                // race two detached threads on the same file.
-                static std::mutex s_dumpMutex;
-                bool okWrite;
-                {
-                    std::lock_guard lock(s_dumpMutex);
-                    auto res = utils::file::writeString(path, text);
-                    okWrite = res.isOk();
-                    if (!okWrite)
-                        log::error("Failed to write last-ai-response.txt: {}",
-                                   res.unwrapErr());
-                }
-                // Notify only after the write actually finished (and only
-                // claim success when it succeeded). UI must run on the main
-                // thread; queueInMainThread is safe to call from any thread.
-                Loader::get()->queueInMainThread([okWrite] {
-                    Notification::create(
-                        okWrite ? "AI output saved to last-ai-response.txt"
-                                : "Failed to save AI output (see logs)",
-                        okWrite ? NotificationIcon::Info
-                                : NotificationIcon::Error)->show();
-                });
-            }).detach();
+            // Notify only after the write actually landed (and only claim
+            // success when it did) — the completion runs on the main thread.
+            io::write(path, [text = aiResponse] { return text; },
+                      io::Durability::Buffered, [](bool okWrite) {
+                Notification::create(
+                    okWrite ? "AI output saved to last-ai-response.txt"
+                            : "Failed to save AI output (see logs)",
+                    okWrite ? NotificationIcon::Info
+                            : NotificationIcon::Error)->show();
+            });
         }
         applyResult();
     }
 
+    // The current level as budgeted compact EAS. The snapshot is taken here
+    // on the main thread; parsing and round-trip checking up to 4000
+    // objects run on a worker (the copilot's move-the-Ref pattern), started
+    // as soon as a popup first needs the context. Nothing on the main thread
+    // ever waits on it. Returns true when the cached context matches the
+    // level as it is now; otherwise a rebuild is running.
+    bool refreshLevelContext() {
+        unsigned count = m_editorLayer && m_editorLayer->m_objects
+                       ? m_editorLayer->m_objects->count() : 0;
+        if (m_levelEASValid && m_levelEASEpoch == s_levelMutationEpoch &&
+            m_levelEASCount == count)
+            return true;
+        if (m_levelEASBusy) return false;
+        m_levelEASBusy = true;
+        // The compact serializer folds rows/stacks/repeats into macro lines,
+        // so far more of a big level fits the same character budget than
+        // the old one-line-per-object form (which capped at 500 objects).
+        Ref<AIGeneratorPopup> self = this;
+        std::thread([self = std::move(self), current = buildLevelDataArray(4000),
+                     groundY = (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"),
+                     epoch = s_levelMutationEpoch, count]() mutable {
+            LevelContext ctx;
+            ctx.maxX = computeMaxXFromObjects(current);
+            ctx.eas  = eas::objectsToEASCompact(current, groundY, eas::CONTEXT_BUDGET);
+            Loader::get()->queueInMainThread(
+                [self = std::move(self), ctx = std::move(ctx), epoch, count]() mutable {
+                    self->m_levelEASBusy  = false;
+                    self->m_levelEAS      = std::move(ctx);
+                    self->m_levelEASValid = true;
+                    self->m_levelEASEpoch = epoch;
+                    self->m_levelEASCount = count;
+                    // Edited again while compacting: the waiters hold out
+                    // for the rebuild this starts.
+                    if (!self->refreshLevelContext()) return;
+                    auto waiters = std::exchange(self->m_levelEASWaiters, {});
+                    for (auto& w : waiters) w();
+                });
+        }).detach();
+        return false;
+    }
+
+    // Runs `then` once the level context is fresh — at once outside
+    // mutation / co-op, or when the popup-open prefetch is still current.
+    void whenLevelContextReady(std::function<void()> then) {
+        if ((!m_mutationMode && !m_coopMode) || refreshLevelContext()) {
+            then();
+            return;
+        }
+        showStatus("Reading the current level...");
+        m_levelEASWaiters.push_back(std::move(then));
+    }
+
     // Appends the mutation / co-op framing (with the current level as EAS)
     // to a system prompt. Shared by the single-shot path and the tool loop.
-    void appendModeContext(std::string& systemPrompt) {
+    // Never waits: a rebuild still running (the level changed mid-turn)
+    // leaves the last compacted level in place, and `estimate` (prompt
+    // sizing at popup open) stands the level in at its full budget until
+    // the first one lands.
+    void appendModeContext(std::string& systemPrompt, bool estimate = false) {
         // Locked palette applies to every mode, including plain generation.
         if (!m_lockedPalette.empty()) {
             systemPrompt += "\n\nLOCKED PALETTE (user-chosen - start your script "
@@ -14712,26 +19264,25 @@ protected:
             systemPrompt += m_lockedPalette;
         }
         if (!m_mutationMode && !m_coopMode) return;
-        auto current = buildLevelDataArray();
-        std::string currentEAS = eas::objectsToEAS(current,
-            (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"));
-        // Hard cap the context: huge levels would blow small-model windows.
-        if (currentEAS.size() > 24000) {
-            currentEAS.resize(24000);
-            auto nl = currentEAS.rfind('\n');
-            if (nl != std::string::npos) currentEAS.resize(nl);
-            currentEAS += "\n# (level truncated for context)";
-        }
+        refreshLevelContext();
+        std::string currentEAS;
+        if (m_levelEASValid)
+            currentEAS = m_levelEAS.eas;
+        else if (estimate)
+            currentEAS.assign(eas::CONTEXT_BUDGET, ' ');
+        else
+            currentEAS = "(the level is still being read - call get_level_region "
+                         "for the area you change)";
         if (m_mutationMode) {
             std::string regionNote;
-            if (s_pendingRegionDelete.active)
+            if (m_stage->regionDelete.active)
                 regionNote = fmt::format(
                     " REGION REBUILD: the user marked X=[{:.0f},{:.0f}] for "
                     "replacement — the mod DELETES the old objects in that "
                     "range when your preview is accepted. Emit a complete "
                     "replacement section for exactly that range (and nothing "
                     "outside it).",
-                    s_pendingRegionDelete.x0, s_pendingRegionDelete.x1);
+                    m_stage->regionDelete.x0, m_stage->regionDelete.x1);
             systemPrompt += fmt::format(
                 "\n\nMODE: MUTATION. The user wants a CHANGE to their existing "
                 "level, described in their message. The current level is below "
@@ -14742,7 +19293,7 @@ protected:
                 "Do NOT re-emit the existing level.{}\n\n"
                 "## Current Level\n{}", regionNote, currentEAS);
         } else {
-            float curMaxX = computeMaxXFromObjects(current);
+            float curMaxX = m_levelEAS.maxX;
             systemPrompt += fmt::format(
                 "\n\nMODE: CO-OP TURN. The human built the level up to "
                 "X={:.0f}. Continue it SEAMLESSLY for roughly 900 units "
@@ -14754,12 +19305,703 @@ protected:
         }
     }
 
+    // ── Speculative draft (local model drafts, main model patches) ──────────
+    // With draft-provider set, a fresh generation first asks that local model
+    // for the whole level. The draft is parsed, checked with levelcheck
+    // (column scan + input-search verifier) and handed to the main provider
+    // compressed, together with the report and a numbered listing of the
+    // objects around each problem. The main model answers with MOVE/DELETE/
+    // EDIT ops over the draft plus whatever it adds, so its output is a short
+    // patch instead of every line of the level. Any draft failure falls back
+    // to the normal path — the mode can only cost the local model's time.
+    enum class DraftPhase { Off, Drafting, Patching, Done };
+    DraftPhase     m_draftPhase     = DraftPhase::Off;
+    matjson::Value m_localDraft     = matjson::Value::array();  // sorted by (x, y)
+    matjson::Value m_localDraftMeta;
+    std::string    m_draftPatchPrompt;
+
+    void resetDraft() {
+        removeDraftSketch();
+        m_draftPhase     = DraftPhase::Off;
+        m_localDraft     = matjson::Value::array();
+        m_localDraftMeta = matjson::Value();
+        m_draftPatchPrompt.clear();
+    }
+
+    bool draftEligible(const std::string& provider) const {
+        if (m_draftPhase != DraftPhase::Off) return false;
+        auto dp = Mod::get()->getSettingValue<std::string>("draft-provider");
+        if (dp.empty() || dp == provider) return false;
+        // Fresh levels only: building onto, mutating or editing a level
+        // needs that level in the author's context, which the draft lacks.
+        return m_shouldClearLevel && !m_followUpTurn && !m_editMode
+            && !m_mutationMode && !m_coopMode;
+    }
+
+    void startDraft(const std::string& prompt, const std::string& rawApiKey) {
+        m_draftPhase = DraftPhase::Drafting;
+        std::string dp    = Mod::get()->getSettingValue<std::string>("draft-provider");
+        if (dp == "scaffold") return startScaffold(prompt, rawApiKey);
+        std::string model = Mod::get()->getSettingValue<std::string>("draft-model");
+        if (model.empty()) model = getProviderModel(dp);
+
+        std::string system = buildSystemPrompt();
+        appendModeContext(system);
+        std::string user = fmt::format(
+            "Generate a GD level.\n"
+            "Request: {}\n"
+            "Difficulty: {} | Style: {} | Length: {}\n\n"
+            "Keep the plan to a few lines, then write the COMPLETE level as EAS "
+            "after a \"## Level Script\" line.",
+            prompt, genSetting("difficulty"), genSetting("style"), genSetting("length"));
+        user += buildBeatGridNote(prompt);
+
+        auto req = oneshot::build(dp, model, system, user, 16384);
+        std::string key = trimKey(getProviderApiKey(dp));
+        log::info("Speculative draft: {} ({}) drafts, {} patches", dp, model, genProvider());
+        logApiRequest(dp, model, req.url, req.body);
+        pushSession(GenSession::Entry::Kind::Status,
+                    fmt::format("Drafting locally with {} ({})...", dp, model));
+        showStatus("Local model drafting...");
+
+        Ref<AIGeneratorPopup> self = this;
+        ratelimit::acquire(dp, rateOwner(),
+            [self, gen = m_generation, dp, key, prompt, rawApiKey, req = std::move(req)] {
+                if (!self->stillCurrent(gen)) return;
+                auto request = web::WebRequest();
+                request.header("Content-Type", "application/json");
+                applyProviderAuth(request, dp, key);
+                request.timeout(providerTimeout(dp));
+                request.bodyString(req.body);
+                auto* raw = self.data();
+                self->m_listener.spawn(request.post(req.url),
+                    [raw, dp, prompt, rawApiKey](web::WebResponse resp) {
+                        raw->onDraftResponse(std::move(resp), dp, prompt, rawApiKey);
+                    });
+            });
+    }
+
+    // draft-provider "scaffold": the procedural generator drafts in place
+    // of a local model. Same patch round afterwards, no draft latency.
+    void startScaffold(const std::string& prompt, const std::string& rawApiKey) {
+        scaffold::Params sp;
+        sp.seconds    = (m_lengthTarget.minSeconds + m_lengthTarget.maxSeconds) * 0.5f;
+        sp.difficulty = scaffold::difficultyLevel(genSetting("difficulty"));
+        sp.bpm        = parseBpmFromPrompt(prompt);
+        sp.groundY    = getGroundY();
+        sp.modes      = scaffold::modePlan(prompt);
+        sp.style      = eas::lower(genSetting("style"));
+        sp.seed       = scaffold::seedFor(prompt, genSetting("difficulty") + "|" +
+                                          genSetting("style") + "|" + genSetting("length"));
+        // The first layout is sketched at once; the verify/demote loop (up
+        // to 8 bot runs) runs on a worker and posts the checked scaffold back.
+        auto first = scaffold::build(sp, false);
+        if (first.objects.size() < 10)
+            return abandonDraft(fmt::format("scaffold produced {} objects", first.objects.size()),
+                                prompt, rawApiKey);
+        drawDraftSketch(first.objects);
+        showStatus("Scaffold: checking the layout...");
+
+        Ref<AIGeneratorPopup> self = this;
+        std::thread([self = std::move(self), gen = m_generation, sp, session = traceSession(),
+                     prompt, rawApiKey]() mutable {
+            scaffold::Result sc;
+            {
+                trace::Span span("scaffold", session, "draft");
+                sc = scaffold::build(sp);
+            }
+            Loader::get()->queueInMainThread(
+                [self = std::move(self), gen, sp = std::move(sp), sc = std::move(sc),
+                 prompt = std::move(prompt), rawApiKey = std::move(rawApiKey)]() mutable {
+                    if (!self->stillCurrent(gen) || self->m_draftPhase != DraftPhase::Drafting)
+                        return;
+                    self->finishScaffold(sp, std::move(sc), prompt, rawApiKey);
+                });
+        }).detach();
+    }
+
+    void finishScaffold(const scaffold::Params& sp, scaffold::Result sc,
+                        const std::string& prompt, const std::string& rawApiKey) {
+        if (sc.objects.size() < 10)
+            return abandonDraft(fmt::format("scaffold produced {} objects", sc.objects.size()),
+                                prompt, rawApiKey);
+
+        std::string plan;
+        for (auto& m : sp.modes) plan += (plan.empty() ? "" : " > ") + m;
+        log::info("Scaffold: {} objects, {} sections ({}), {} demotions, {}",
+                  sc.objects.size(), sc.sections, plan, sc.demoted,
+                  sc.route.passable ? "passable" : "blocked");
+        pushSession(GenSession::Entry::Kind::Status,
+            fmt::format("Scaffold: {} sections, {}{}, {}", sc.sections, plan,
+                        sp.bpm ? fmt::format(" @ {} BPM", sp.bpm) : "",
+                        sc.route.passable ? "passable" : "blocked - left to the patch"));
+
+        std::vector<matjson::Value> objs;
+        for (auto& o : sc.objects) objs.push_back(std::move(o));
+        beginDraftPatch(std::move(objs), matjson::Value(),
+            "A procedural generator laid out this level: gamemode sections in "
+            "the order the request names them, obstacles on the beat, checked "
+            "passable. It is plain on purpose - keep its route and timing, "
+            "make it match the request (themed obstacles, decoration, colors, "
+            "triggers, META) and fix anything the report flags.",
+            prompt, rawApiKey);
+    }
+
+    // The normal single-author path, after a draft that can't be used.
+    void abandonDraft(const std::string& why, const std::string& prompt,
+                      const std::string& rawApiKey) {
+        log::warn("Speculative draft abandoned: {}", why);
+        pushSession(GenSession::Entry::Kind::Status,
+            fmt::format("Local draft unusable ({}) - {} writes the level instead",
+                        why, genProvider()));
+        m_draftPhase = DraftPhase::Done;
+        callAPI(prompt, rawApiKey);
+    }
+
+    void onDraftResponse(web::WebResponse resp, const std::string& dp,
+                         const std::string& prompt, const std::string& rawApiKey) {
+        ratelimit::observe(dp, resp);
+        if (!m_isGenerating || m_draftPhase != DraftPhase::Drafting) return;
+        logApiResponse(resp.code(), resp.string().unwrapOr(""));
+        std::string text;
+        if (resp.ok())
+            if (auto json = resp.json()) text = oneshot::parse(dp, json.unwrap());
+        if (text.empty())
+            return abandonDraft(fmt::format("HTTP {}, no text", resp.code()), prompt, rawApiKey);
+
+        // Local reasoning models inline <think> blocks ahead of the script.
+        for (size_t tp; (tp = text.find("<think>")) != std::string::npos;) {
+            size_t te = text.find("</think>", tp);
+            text.erase(tp, te == std::string::npos ? std::string::npos : te + 8 - tp);
+        }
+        matjson::Value root;
+        std::string script = eas::extractScript(text);
+        if (eas::looksLikeEAS(script)) {
+            auto er = eas::parseParallel(script);
+            if (er.ok) root = std::move(er.root);
+        } else {
+            std::string block = extractLastEAIJsonBlock(text);
+            if (!block.empty()) {
+                auto lj = editorai::json_lenient::parse(block);
+                if (lj.ok && lj.value.isObject()) root = std::move(lj.value);
+            }
+        }
+        if (!root.isObject())
+            return abandonDraft("no EAS or JSON in the reply", prompt, rawApiKey);
+
+        // Expand macros and bake block templates in here: the patch indexes
+        // the final objects, and templates are reset before anything spawns.
+        resetBlockTemplates();
+        std::vector<matjson::Value> objs;
+        if (root.contains("objects") && root["objects"].isArray())
+            for (auto& o : root["objects"])
+                if (o.isObject() && !o.contains("op")) objs.push_back(o);
+        if (root.contains("macros") && root["macros"].isArray()) {
+            std::vector<matjson::Value> expanded;
+            macros::expandAll(root["macros"], expanded);
+            for (auto& o : expanded) objs.push_back(std::move(o));
+        }
+        for (auto& o : objs) applyBlockTemplateToObject(o);
+        resetBlockTemplates();
+        if (objs.size() < 10)
+            return abandonDraft(fmt::format("only {} objects", objs.size()), prompt, rawApiKey);
+        matjson::Value meta = root.contains("level_metadata") && root["level_metadata"].isObject()
+            ? root["level_metadata"] : matjson::Value();
+        beginDraftPatch(std::move(objs), std::move(meta),
+                        "A fast local model already drafted this level.", prompt, rawApiKey);
+    }
+
+    // Shared by both draft sources: index the draft, sketch it into the
+    // editor, and send the main provider the compressed draft plus its
+    // validation report, asking for a patch.
+    void beginDraftPatch(std::vector<matjson::Value> objs, matjson::Value meta,
+                         const char* origin, const std::string& prompt,
+                         const std::string& rawApiKey) {
+        std::stable_sort(objs.begin(), objs.end(),
+            [](const matjson::Value& a, const matjson::Value& b) {
+                float ax = levelcheck::getFloat(a, "x", 0.f);
+                float bx = levelcheck::getFloat(b, "x", 0.f);
+                if (ax != bx) return ax < bx;
+                return levelcheck::getFloat(a, "y", 0.f) < levelcheck::getFloat(b, "y", 0.f);
+            });
+        m_localDraft = matjson::Value::array();
+        for (auto& o : objs) m_localDraft.push(std::move(o));
+        m_localDraftMeta = std::move(meta);
+        drawDraftSketch(m_localDraft);
+
+        // The report (a full verifier run) and the compressed listing are
+        // built from a snapshot on a worker — this runs inside the draft's
+        // web callback, and a large draft stalled the frame for both.
+        showStatus("Checking the draft...");
+        Ref<AIGeneratorPopup> self = this;
+        std::thread([self = std::move(self), gen = m_generation, objs = m_localDraft,
+                     groundY = getGroundY(), target = m_lengthTarget,
+                     session = traceSession(), origin, prompt, rawApiKey]() mutable {
+            std::string report = draftReport(objs, groundY, target);
+            std::string compact;
+            {
+                trace::Span span("eas-compact", session, "prompt");
+                compact = eas::objectsToEASCompact(objs, groundY);
+            }
+            Loader::get()->queueInMainThread(
+                [self = std::move(self), gen, origin, prompt = std::move(prompt),
+                 rawApiKey = std::move(rawApiKey), report = std::move(report),
+                 compact = std::move(compact)]() mutable {
+                    if (!self->stillCurrent(gen) || self->m_draftPhase != DraftPhase::Drafting)
+                        return;
+                    self->sendDraftPatch(origin, prompt, rawApiKey, report, compact);
+                });
+        }).detach();
+    }
+
+    void sendDraftPatch(const char* origin, const std::string& prompt,
+                        const std::string& rawApiKey, const std::string& report,
+                        const std::string& compact) {
+        m_draftPatchPrompt = fmt::format(
+            "Generate a GD level.\n"
+            "Request: {}\n"
+            "Difficulty: {} | Style: {} | Length: {}\n\n"
+            "{} REVIEW and PATCH it - do not rewrite it.\n\n"
+            "## Draft ({} objects, compressed EAS)\n{}\n"
+            "## Validation report\n{}\n"
+            "Reply with a few lines on what you change, then \"## Level Script\" "
+            "and ONLY the patch:\n"
+            "  MOVE <sel> dx=F dy=F | DELETE <sel> | EDIT <sel> rot=F scale=F "
+            "color=N detail=N flip_x flip_y\n"
+            "  <sel> = #id or #a-b (ids number the draft by X then Y, as "
+            "listed above), rect:x1,y1,x2,y2, id:<type>, group:N\n"
+            "  plus new OBJ/macro lines for anything to ADD, and META/COLOR only "
+            "to change them.\n"
+            "Everything you don't touch is kept, so never re-emit draft objects. "
+            "Fix every BLOCKED spot and any length shortfall first. If the draft "
+            "is already good, leave the script empty.",
+            prompt, genSetting("difficulty"), genSetting("style"), genSetting("length"),
+            origin, m_localDraft.size(), compact, report);
+        m_draftPatchPrompt += buildBeatGridNote(prompt);
+
+        log::info("Speculative draft: {} objects, {} chars compressed; requesting a patch",
+                  m_localDraft.size(), compact.size());
+        pushSession(GenSession::Entry::Kind::Status,
+            fmt::format("Local draft: {} objects - {} is reviewing it",
+                        m_localDraft.size(), genProvider()));
+        showStatus("Main model reviewing the draft...");
+        m_draftPhase = DraftPhase::Patching;
+        callAPI(prompt, rawApiKey);
+    }
+
+    // Outline of the draft in the editor while the patch round runs, so the
+    // layout is visible at once. Hazards red, solids grey, orbs/pads/portals
+    // cyan. Gone when the reply is applied or the generation ends.
+    Ref<CCDrawNode> m_draftSketch;
+
+    void removeDraftSketch() {
+        if (m_draftSketch) {
+            m_draftSketch->removeFromParent();
+            m_draftSketch = nullptr;
+        }
+    }
+
+    void drawDraftSketch(const matjson::Value& objs) {
+        removeDraftSketch();
+        if (!m_editorLayer || !m_editorLayer->m_objectLayer) return;
+        constexpr ccColor4F HAZARD {1.f, 0.3f, 0.3f, 0.8f};
+        constexpr ccColor4F SOLID  {0.75f, 0.75f, 0.8f, 0.6f};
+        constexpr ccColor4F ACTIVE {0.3f, 0.85f, 1.f, 0.8f};
+        constexpr ccColor4F CLEAR  {0.f, 0.f, 0.f, 0.f};
+        auto draw = CCDrawNode::create();
+        size_t drawn = 0;
+        for (const auto& o : objs) {
+            if (drawn >= 4000) break;
+            auto cls = levelcheck::classifyType(levelcheck::getStr(o, "type", ""));
+            const ccColor4F* col =
+                cls == levelcheck::kHazard ? &HAZARD :
+                cls == levelcheck::kSolid  ? &SOLID  :
+                cls == levelcheck::kOrb || cls == levelcheck::kPortal ? &ACTIVE : nullptr;
+            if (!col) continue;
+            float x = levelcheck::getFloat(o, "x", 0.f);
+            float y = levelcheck::getFloat(o, "y", 0.f);
+            float h = 14.f * std::clamp(levelcheck::getFloat(o, "scale", 1.f), 0.1f, 10.f);
+            CCPoint box[4] = {{x - h, y - h}, {x + h, y - h}, {x + h, y + h}, {x - h, y + h}};
+            draw->drawPolygon(box, 4, CLEAR, 1.f, *col);
+            ++drawn;
+        }
+        draw->setZOrder(900);
+        m_editorLayer->m_objectLayer->addChild(draw);
+        m_draftSketch = draw;
+    }
+
+    // Length, column scan and verifier verdict for a (sorted) draft, plus
+    // the objects around each problem with their #index. Touches no popup
+    // state, so beginDraftPatch runs it on a worker.
+    static std::string draftReport(const matjson::Value& objs, float groundY,
+                                   const LengthTarget& target) {
+        levelcheck::TriggerGraph graph;
+        graph.build(objs);
+        auto pass  = levelcheck::check(objs, &graph);
+        auto route = levelcheck::verifyPassable(objs, groundY, &graph);
+        float maxX = computeMaxXFromObjects(objs);
+        auto [secs, cat] = describeLengthByX(maxX);
+        std::string out = fmt::format(
+            "Length: {:.0f}s ({}, maxX={:.0f}); target {} {:.0f}-{:.0f}s{}\n"
+            "Column scan: {}\n"
+            "Route: {}\n",
+            secs, cat, maxX, target.label, target.minSeconds, target.maxSeconds,
+            secs < target.minSeconds ? " - TOO SHORT, extend it" : "",
+            pass.summary, describeVerify(route));
+
+        size_t unknown = 0;
+        std::string sample;
+        for (size_t i = 0; i < objs.size(); ++i) {
+            std::string t = levelcheck::getStr(objs[i], "type", "");
+            if (t.empty() || OBJECT_IDS.count(t) || t.find("_trigger") != std::string::npos)
+                continue;
+            if (++unknown <= 5) sample += (sample.empty() ? "" : ", ") + t;
+        }
+        if (unknown > 0)
+            out += fmt::format("Unknown types ({} objects, dropped on spawn): {}\n",
+                               unknown, sample);
+
+        // Problem windows, merged so overlapping spots list once.
+        std::vector<std::pair<float, float>> spots;
+        if (route.blocked())
+            spots.push_back({route.blockedX - 150.f, route.blockedX + 150.f});
+        for (size_t i = 0; i < pass.deaths.size() && i < 4; ++i)
+            spots.push_back({pass.deaths[i].x_start - 60.f, pass.deaths[i].x_end + 60.f});
+        if (spots.empty()) return out;
+        std::sort(spots.begin(), spots.end());
+        std::vector<std::pair<float, float>> merged;
+        for (auto& s : spots) {
+            if (!merged.empty() && s.first <= merged.back().second)
+                merged.back().second = std::max(merged.back().second, s.second);
+            else
+                merged.push_back(s);
+        }
+        out += "Problem areas (#id for MOVE/DELETE/EDIT):\n";
+        int listed = 0;
+        for (auto [x0, x1] : merged) {
+            size_t lo = 0, hi = objs.size();
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (levelcheck::getFloat(objs[mid], "x", 0.f) < x0) lo = mid + 1;
+                else hi = mid;
+            }
+            out += fmt::format(" X {:.0f}-{:.0f}:\n", x0, x1);
+            for (size_t i = lo; i < objs.size() && listed < 80; ++i, ++listed) {
+                const auto& o = objs[i];
+                float x = levelcheck::getFloat(o, "x", 0.f);
+                if (x > x1) break;
+                out += fmt::format("  #{} {} x={:.0f} y={:.0f}\n", i,
+                                   levelcheck::getStr(o, "type", "?"), x,
+                                   levelcheck::getFloat(o, "y", 0.f));
+            }
+        }
+        return out;
+    }
+
+    // Applies the main model's patch to the draft and leaves the result in
+    // the accumulator. Returns what processFinalResponse carries on with:
+    // the model's note plus the merged level metadata as JSON.
+    std::string mergeDraftPatch(const std::string& reply) {
+        m_draftPhase = DraftPhase::Done;
+        matjson::Value objs = std::move(m_localDraft);
+        m_localDraft = matjson::Value::array();
+        matjson::Value meta = m_localDraftMeta.isObject() ? m_localDraftMeta : matjson::Value::object();
+        bool hasMeta = m_localDraftMeta.isObject();
+
+        auto mark = reply.rfind("## Level Script");
+        std::string note = mark == std::string::npos ? reply : reply.substr(0, mark);
+        std::vector<matjson::Value> ops, adds;
+        std::string script = eas::extractScript(reply);
+        if (eas::looksLikeEAS(script)) {
+            if (mark == std::string::npos) note.clear();   // the reply was all script
+            auto er = eas::parse(script);
+            if (er.ok) {
+                auto& r = er.root;
+                if (r.contains("objects") && r["objects"].isArray())
+                    for (auto& o : r["objects"]) {
+                        if (!o.isObject()) continue;
+                        (o.contains("op") ? ops : adds).push_back(o);
+                    }
+                resetBlockTemplates();
+                if (r.contains("macros") && r["macros"].isArray()) {
+                    std::vector<matjson::Value> expanded;
+                    macros::expandAll(r["macros"], expanded);
+                    for (auto& o : expanded) adds.push_back(std::move(o));
+                }
+                // Templates the patch sets restyle the draft too.
+                for (auto& o : adds) applyBlockTemplateToObject(o);
+                for (size_t i = 0; i < objs.size(); ++i) applyBlockTemplateToObject(objs[i]);
+                resetBlockTemplates();
+                if (r.contains("level_metadata") && r["level_metadata"].isObject()) {
+                    hasMeta = true;
+                    for (auto& [k, v] : r["level_metadata"]) {
+                        // Color defaults accumulate; the patch's come last and win.
+                        if (k == "default_colors" && meta.contains(k) && meta[k].isArray()
+                            && v.isArray()) {
+                            for (auto& c : v) meta[k].push(c);
+                        } else {
+                            meta[k] = v;
+                        }
+                    }
+                }
+            }
+        }
+
+        // The sorted draft becomes the accumulator; its fresh ids are the
+        // positions the problem-area listing showed.
+        m_accumulatedObjects = std::move(objs);
+        clearDraftIndexes();
+        auto st = applyDraftOps(ops);
+        for (auto& o : adds) m_accumulatedObjects.push(std::move(o));
+        log::info("Draft patch: {} op(s) - {} moved, {} deleted, {} edited, {} missed; "
+                  "{} added -> {} objects", ops.size(), st.moved, st.deleted, st.edited,
+                  st.missed, adds.size(), m_accumulatedObjects.size());
+        pushSession(GenSession::Entry::Kind::Status,
+            fmt::format("Patched the local draft: {} moved, {} deleted, {} edited, "
+                        "{} added{}", st.moved, st.deleted, st.edited, adds.size(),
+                        st.missed ? fmt::format(" ({} op(s) matched nothing)", st.missed) : ""));
+
+        auto body = matjson::Value::object();
+        body["objects"] = matjson::Value::array();
+        if (hasMeta) body["level_metadata"] = meta;
+        auto first = note.find_first_not_of(" \t\r\n");
+        note = first == std::string::npos ? "" : note.substr(first);
+        return fmt::format("Draft review (local draft + patch):\n{}\n\n{}",
+                           note, body.dump(matjson::NO_INDENTATION));
+    }
+
+    // ── Parallel quality passes ────────────────────────────────────────────
+    // The refinement focuses, the decoration pass and the self-check run as
+    // serial rounds of the conversation — four or five full-context round
+    // trips after the build. With parallel-quality-passes they go out at
+    // once instead: independent one-shot requests that each carry the
+    // draft, one task and the patch grammar, and each answer with a patch
+    // over the draft's #ids. draftpatch::merge resolves overlaps (self-check
+    // first, then the focuses in rotation order, decoration last) and the
+    // result re-enters processFinalResponse once, so length and passability
+    // are validated a single time. A pass that fails is merged without.
+    struct QualityJob {
+        std::string label;
+        std::string task;
+        std::string reply;
+        int  tries    = 0;
+        bool critique = false;
+    };
+    static constexpr size_t MAX_QUALITY_JOBS = 8;
+    std::vector<QualityJob> m_qualityJobs;                // in merge priority order
+    std::array<async::TaskHolder<web::WebResponse>, MAX_QUALITY_JOBS> m_qualityTasks;
+    size_t      m_qualityPending = 0;
+    std::string m_qualitySystem;                          // shared by every job
+    std::string m_qualityContext;                         // draft + framing; task appended
+
+    void cancelQualityPasses() {
+        for (auto& t : m_qualityTasks) t = {};
+        m_qualityJobs.clear();
+        m_qualityPending = 0;
+    }
+
+    bool startQualityPasses(const levelcheck::Result& pass) {
+        if (!Mod::get()->getSettingValue<bool>("parallel-quality-passes")) return false;
+        if (m_followUpTurn || !m_usingToolLoop || m_editMode || m_mutationMode || m_coopMode)
+            return false;
+
+        std::vector<QualityJob> jobs;
+        if (Mod::get()->getSettingValue<bool>("enable-self-critique") && !m_critiqueDone)
+            jobs.push_back({"self-check",
+                            std::string(critiquePassText()) + draftPatchHelp(), "", 0, true});
+        // Rounds past the distinct focuses would repeat one against the same
+        // draft at the same time — nothing to gain, so they are dropped.
+        int maxRefine = (int)Mod::get()->getSettingValue<int64_t>("refinement-rounds");
+        const auto& focuses = refinementFocuses();
+        int refine = std::clamp(maxRefine - m_refinementRounds, 0, (int)focuses.size());
+        for (int i = 0; i < refine; ++i) {
+            const char* focus = focuses[(m_refinementRounds + i) % focuses.size()];
+            std::string_view head(focus);
+            head = head.substr(0, head.find(':'));
+            jobs.push_back({eas::lower(std::string(head)),
+                            fmt::format("REFINEMENT - emit a small polish patch that adds, "
+                                        "removes, moves or restyles 10-30 objects/macros.\n"
+                                        "FOCUS: {}", focus)});
+        }
+        if (Mod::get()->getSettingValue<bool>("two-pass-generation") && !m_decorationPassDone)
+            jobs.push_back({"decoration", decorationPassText()});
+        // One pass gains nothing from the fan-out; the serial gate runs it.
+        if (jobs.size() < 2) return false;
+        if (jobs.size() > MAX_QUALITY_JOBS) jobs.resize(MAX_QUALITY_JOBS);
+
+        m_refinementRounds   = std::max(m_refinementRounds, maxRefine);
+        m_decorationPassDone = true;
+        m_critiqueDone       = true;
+
+        m_qualitySystem = buildSystemPrompt();
+        appendModeContext(m_qualitySystem);
+        std::string compact;
+        {
+            trace::Span span("eas-compact", traceSession(), "prompt");
+            compact = eas::objectsToEASCompact(m_accumulatedObjects, getGroundY(),
+                                               eas::CONTEXT_BUDGET);
+        }
+        auto [secs, cat] = describeLengthByX(draftDensity().maxX(levelcheck::kLengthClasses));
+        m_qualityContext = fmt::format(
+            "Request: {}\n"
+            "Difficulty: {} | Style: {} | Length: {}\n\n"
+            "This level is built ({} objects, {:.0f}s, {:.1f}% of {} columns "
+            "passable). Several reviewers are improving it at the same time, "
+            "each with ONE task - do yours and leave the rest of the level "
+            "alone. Don't rebuild it: a few lines on what you change, then "
+            "\"## Level Script\" and ONLY your patch.\n\n"
+            "## Level (compressed EAS)\n{}\n"
+            "## Objects by X (#id)\n{}\n"
+            "{}\n\n"
+            "## Your task\n",
+            m_lastCallPrompt, genSetting("difficulty"), genSetting("style"),
+            genSetting("length"), m_accumulatedObjects.size(), secs,
+            pass.pass_rate * 100.f, pass.total_columns, compact,
+            draftListing(-1e9f, 1e9f, 400), draftPatchHelp());
+
+        m_qualityJobs    = std::move(jobs);
+        m_qualityPending = m_qualityJobs.size();
+        std::string labels;
+        for (auto& j : m_qualityJobs) labels += (labels.empty() ? "" : ", ") + j.label;
+        log::info("Quality passes in parallel: {}", labels);
+        pushSession(GenSession::Entry::Kind::Status,
+                    fmt::format("{} quality passes in parallel: {}", m_qualityJobs.size(), labels));
+        showStatus(fmt::format("{} quality passes in parallel...", m_qualityJobs.size()));
+
+        // resetGenerationUI() dropped these at the top of processFinalResponse.
+        m_isGenerating = true;
+        if (m_cancelBtn)   m_cancelBtn->setVisible(true);
+        if (m_generateBtn) m_generateBtn->setVisible(false);
+        for (size_t i = 0; i < m_qualityJobs.size(); ++i) sendQualityJob(i);
+        return true;
+    }
+
+    void sendQualityJob(size_t i) {
+        auto req = oneshot::build(m_toolProvider, m_toolModel, m_qualitySystem,
+                                  m_qualityContext + m_qualityJobs[i].task, 8192);
+        logApiRequest(m_toolProvider, m_toolModel, req.url, req.body);
+        Ref<AIGeneratorPopup> self = this;
+        ratelimit::acquire(m_toolProvider, rateOwner(),
+            [self, gen = m_generation, i, req = std::move(req)] {
+                if (!self->stillCurrent(gen) || i >= self->m_qualityJobs.size()) return;
+                auto request = web::WebRequest();
+                request.header("Content-Type", "application/json");
+                applyProviderAuth(request, self->m_toolProvider, self->m_toolApiKey);
+                request.timeout(providerTimeout(self->m_toolProvider));
+                request.bodyString(req.body);
+                auto* raw = self.data();
+                self->m_qualityTasks[i].spawn(request.post(req.url),
+                    [raw, i](web::WebResponse resp) {
+                        raw->onQualityResponse(i, std::move(resp));
+                    });
+            });
+    }
+
+    void onQualityResponse(size_t i, web::WebResponse resp) {
+        double waitSeconds = ratelimit::observe(m_toolProvider, resp);
+        if (!m_isGenerating || i >= m_qualityJobs.size() || m_qualityPending == 0) return;
+        logApiResponse(resp.code(), resp.string().unwrapOr(""));
+        auto& job = m_qualityJobs[i];
+        int code = resp.code();
+        bool transient = code == 429 || code == 500 || code == 502 ||
+                         code == 503 || code == 529;
+        if (!resp.ok() && transient && job.tries < (code == 429 ? 3 : 1)) {
+            ++job.tries;
+            Ref<AIGeneratorPopup> self = this;
+            ratelimit::defer(m_toolProvider, rateOwner(), [self, gen = m_generation, i] {
+                if (self->stillCurrent(gen) && i < self->m_qualityJobs.size())
+                    self->sendQualityJob(i);
+            }, waitSeconds > 0 ? waitSeconds : 2.0);
+            return;
+        }
+        if (resp.ok())
+            if (auto json = resp.json()) job.reply = oneshot::parse(m_toolProvider, json.unwrap());
+        if (job.reply.empty())
+            log::warn("Quality pass '{}' failed (HTTP {}) - merging without it",
+                      job.label, code);
+        if (--m_qualityPending > 0) {
+            showStatus(fmt::format("Quality passes: {}/{} back...",
+                                   m_qualityJobs.size() - m_qualityPending,
+                                   m_qualityJobs.size()));
+            return;
+        }
+        mergeQualityPasses();
+    }
+
+    void mergeQualityPasses() {
+        std::vector<draftpatch::Patch> patches;
+        std::string rating, notes;
+        bool critiqued = false;
+        for (auto& job : m_qualityJobs) {
+            std::string& text = job.reply;
+            if (text.empty()) continue;
+            for (size_t tp; (tp = text.find("<think>")) != std::string::npos;) {
+                size_t te = text.find("</think>", tp);
+                text.erase(tp, te == std::string::npos ? std::string::npos : te + 8 - tp);
+            }
+            if (job.critique) {
+                critiqued = true;
+                auto rp = text.find("RATING:");
+                if (rp != std::string::npos && (rp == 0 || text[rp - 1] == '\n'))
+                    rating = text.substr(rp, text.find('\n', rp) - rp);
+            }
+            auto pt = draftpatch::parse(text);
+            pt.label = job.label;
+            auto first = pt.note.find_first_not_of(" \t\r\n");
+            if (first != std::string::npos) {
+                std::string line = pt.note.substr(first, pt.note.find('\n', first) - first);
+                GenSession::utf8Trim(line, 200);
+                if (line.rfind("RATING:", 0) != 0)
+                    notes += fmt::format("- {}: {}\n", job.label, line);
+            }
+            patches.push_back(std::move(pt));
+        }
+        size_t sent = m_qualityJobs.size();
+        std::string labels;
+        for (auto& j : m_qualityJobs) labels += (labels.empty() ? "" : ", ") + j.label;
+        cancelQualityPasses();
+
+        auto merged = draftpatch::merge(m_accumulatedObjects, draftIds(), patches);
+        auto st = applyDraftOps(merged.ops);
+        for (auto& o : merged.adds) m_accumulatedObjects.push(std::move(o));
+        log::info("Quality passes merged ({}/{} answered): ops {} kept, {} narrowed, "
+                  "{} dropped; {} added, {} overlapping dropped -> {} objects",
+                  patches.size(), sent, merged.st.kept, merged.st.narrowed,
+                  merged.st.dropped, merged.st.added, merged.st.overlapping,
+                  m_accumulatedObjects.size());
+        pushSession(GenSession::Entry::Kind::Status,
+            fmt::format("Merged {} quality passes: {} moved, {} deleted, {} edited, "
+                        "{} added{}", patches.size(), st.moved, st.deleted, st.edited,
+                        merged.st.added,
+                        merged.st.dropped + merged.st.overlapping
+                            ? fmt::format(" ({} conflicting change(s) dropped)",
+                                          merged.st.dropped + merged.st.overlapping)
+                            : ""));
+
+        // The conversation keeps alternating: the passes stand in for a user
+        // turn, the merge for the assistant's answer to it. processFinalResponse
+        // reads the rating line off the top, as from a serial self-check.
+        toolUse::Message asked;
+        asked.role = toolUse::MessageRole::User;
+        asked.text = fmt::format("Quality passes ({}) ran in parallel over the level "
+                                 "as patches; merge them.", labels);
+        m_toolHistory.push_back(std::move(asked));
+        m_critiquePending = critiqued;
+        auto body = matjson::Value::object();
+        body["objects"] = matjson::Value::array();
+        if (merged.meta.isObject()) body["level_metadata"] = merged.meta;
+        processFinalResponse(fmt::format("{}{}Quality passes (merged):\n{}\n{}",
+                                         rating, rating.empty() ? "" : "\n", notes,
+                                         body.dump(matjson::NO_INDENTATION)),
+                             m_toolProvider);
+    }
+
     void callAPI(const std::string& prompt, const std::string& rawApiKey) {
         // Stashed for the transient-failure retry in onAPISuccess.
         m_lastCallPrompt = prompt;
         m_lastCallKey    = rawApiKey;
         std::string apiKey     = trimKey(rawApiKey);
-        std::string provider   = Mod::get()->getSettingValue<std::string>("ai-provider");
+        std::string provider   = genProvider();
         std::string model      = getProviderModel(provider);
         // Keep the tool-loop identity fields current on EVERY generation —
         // processFinalResponse's loop-back gates read them, and a stale
@@ -14768,19 +20010,19 @@ protected:
         m_toolProvider = provider;
         m_toolModel    = model;
         m_toolApiKey   = apiKey;
-        std::string difficulty = Mod::get()->getSettingValue<std::string>("difficulty");
-        std::string style      = Mod::get()->getSettingValue<std::string>("style");
-        std::string length     = Mod::get()->getSettingValue<std::string>("length");
+        std::string difficulty = genSetting("difficulty");
+        std::string style      = genSetting("style");
+        std::string length     = genSetting("length");
         // "levelID" is the overlay's reference-level mode, not a style word —
         // the actual reference arrives via the "style: <id>" prompt directive.
         if (style == "levelID") style = "match the reference level";
 
         // Capture generation context for the rating popup
-        s_lastUserPrompt = prompt;
-        if (!m_followUpTurn) s_lastSelfRating = 0;  // fresh generation, fresh score
-        s_lastDifficulty = difficulty;
-        s_lastStyle      = style;
-        s_lastLength     = length;
+        m_stage->fb.userPrompt = prompt;
+        if (!m_followUpTurn) m_stage->fb.selfRating = 0;  // fresh generation, fresh score
+        m_stage->fb.difficulty = difficulty;
+        m_stage->fb.style      = style;
+        m_stage->fb.length     = length;
 
         // ── Multi-turn tool-use path ──────────────────────────────────────
         // When the user has tool use on (default) and the selected provider
@@ -14792,6 +20034,14 @@ protected:
         // never be cleared by these flows.
         if (m_mutationMode || m_coopMode) m_shouldClearLevel = false;
 
+        // Speculative draft: a local model writes the level first; this
+        // provider is then called (single-shot) to patch it.
+        if (draftEligible(provider)) {
+            this->startDraft(prompt, rawApiKey);
+            return;
+        }
+        bool patching = m_draftPhase == DraftPhase::Patching;
+
         bool toolsEnabled = Mod::get()->getSettingValue<bool>("enable-ai-tools");
         // Platinum's coordinator only serves /api/generate — the tool loop
         // needs /api/chat, which 404s there. Force single-shot on Platinum.
@@ -14802,13 +20052,14 @@ protected:
         // rounds. Co-op keeps tools (the model may want references).
         // Edit mode RIDES the tool loop (heavy reworks need analyze/verify
         // tools, the object inventory, and the workload-enforcement rounds).
-        if (toolsEnabled && !m_mutationMode && !platinum
-            && toolUse::supportsToolUse(provider)) {
+        if (toolsEnabled && !m_mutationMode && !platinum && !patching
+            && toolUse::supportsToolUse(provider, model)) {
             log::info("Routing to tool-use loop (provider={})", provider);
             this->runToolLoop(prompt, apiKey);
             return;
         }
         m_usingToolLoop = false;   // single-shot turn: gates must not loop back
+        m_platinumNode.clear();
 
         // Single-shot + style reference: fetch the reference's style brief
         // first (one hop through the disk-backed level cache), then re-enter.
@@ -14845,7 +20096,7 @@ protected:
             // Edit runs get the numbered inventory so MOVE/DELETE/EDIT
             // selectors resolve against exactly what the model saw — even
             // on single-shot providers (tools off, Platinum, custom).
-            std::string inv = buildLevelInventoryListing(1500);
+            std::string inv = buildLevelInventoryListing((int)(1500 * promptScale()));
             log::info("=== Single-shot: edit inventory context ({} chars) ===", inv.size());
             levelDataSection = "\n\n" + inv;
         } else if (!m_shouldClearLevel) {
@@ -14861,7 +20112,7 @@ protected:
         // Per-call user prompt — kept tight. The system prompt already covers
         // format details and rules; here we just relay the request + plan
         // cues. Both EAS and JSON are accepted (see system prompt).
-        std::string fullPrompt = fmt::format(
+        std::string fullPrompt = patching ? m_draftPatchPrompt : fmt::format(
             "Generate a GD level.\n"
             "Request: {}\n"
             "Difficulty: {} | Style: {} | Length: {}{}\n\n"
@@ -14869,7 +20120,7 @@ protected:
             "macro choices), then emit EAS (preferred) or JSON.",
             prompt, difficulty, style, length, levelDataSection
         );
-        fullPrompt += buildBeatGridNote(prompt);
+        if (!patching) fullPrompt += buildBeatGridNote(prompt);
 
         // Seed the conversation log so follow-up chat works for single-shot
         // generations too (edit mode, tools off, Platinum, custom provider —
@@ -14969,10 +20220,24 @@ protected:
         // handles the line-by-line parsing and accumulation of the response field.
         } else if (provider == "ollama") {
             std::string ollamaUrl = getOllamaUrl();
+            if (platinum) {
+                // Lowest-ETA coordinator this generation hasn't failed on;
+                // once every node has been tried, start the rotation over.
+                ollamaUrl = platinum::pick(m_platinumTried);
+                if (ollamaUrl.empty()) {
+                    m_platinumTried.clear();
+                    ollamaUrl = platinum::pick();
+                }
+                m_platinumNode      = ollamaUrl;
+                m_platinumFactor    = platinum::queueFactor(ollamaUrl);
+                m_platinumRequestId = platinum::newRequestId();
+                m_platinumBytes     = std::make_shared<std::atomic<size_t>>(0);
+            }
             log::info("Using Ollama at: {}", ollamaUrl + "/api/generate");
 
             auto options = matjson::Value::object();
             options["temperature"] = 0.7;
+            if (int ctx = ollamaNumCtx(model)) options["num_ctx"] = ctx;
 
             requestBody            = matjson::Value::object();
             requestBody["model"]   = model;
@@ -14983,6 +20248,7 @@ protected:
             // fought that instruction. The response pipeline handles EAS,
             // fenced JSON, and lenient JSON equally well.
             requestBody["options"] = options;
+            if (auto ka = ollamaKeepAlive(); !ka.isNull()) requestBody["keep_alive"] = ka;
 
             url = ollamaUrl + "/api/generate";
 
@@ -15003,7 +20269,7 @@ protected:
             // Token-limit field + value comes from the same table the
             // tool-use loop uses (exactly one field — two at once is an
             // HTTP 400 on strict servers).
-            const auto spec = toolUse::tokenLimitSpec(provider);
+            const auto spec = toolUse::tokenLimitSpec(provider, model);
 
             auto sysMsg = matjson::Value::object();
             sysMsg["role"]    = "system";
@@ -15040,23 +20306,42 @@ protected:
             }
         }
 
-        std::string jsonBody = requestBody.dump();
+        std::string jsonBody;
+        {
+            trace::Span span("serialize-request", traceSession());
+            jsonBody = requestBody.dump();
+        }
         log::info("Sending request to {} ({} bytes)", provider, jsonBody.length());
 
-        auto request = web::WebRequest();
-        request.header("Content-Type", "application/json");
-        // Same auth headers and timeouts the tool-use loop applies.
-        applyProviderAuth(request, provider, apiKey);
-        request.timeout(providerTimeout(provider));
-
-        request.bodyString(jsonBody);
         logApiRequest(provider, model, url, jsonBody);
-        m_listener.spawn(
-            request.post(url),
-            [this, provider](web::WebResponse response) {
-                this->onAPISuccess(std::move(response), provider);
-            }
-        );
+        Ref<AIGeneratorPopup> self = this;
+        std::string requestId = m_platinumNode.empty() ? std::string() : m_platinumRequestId;
+        auto bytes = m_platinumNode.empty() ? nullptr : m_platinumBytes;
+        ratelimit::acquire(provider, rateOwner(),
+            [self, gen = m_generation, provider, apiKey, url = std::move(url),
+             jsonBody = std::move(jsonBody), requestId, bytes] {
+                if (!self->stillCurrent(gen)) return;
+                auto request = web::WebRequest();
+                request.header("Content-Type", "application/json");
+                // Same auth headers and timeouts the tool-use loop applies.
+                applyProviderAuth(request, provider, apiKey);
+                request.timeout(providerTimeout(provider));
+                request.bodyString(jsonBody);
+                if (!requestId.empty()) request.header("X-Request-ID", requestId);
+                if (bytes)
+                    request.onProgress([bytes](web::WebProgress const& p) {
+                        bytes->store(p.downloaded());
+                    });
+                self->m_traceHttpStartUs = trace::nowUs();
+                self->m_platinumSentAt   = std::chrono::steady_clock::now();
+                auto* raw = self.data();
+                self->m_listener.spawn(
+                    request.post(url),
+                    [raw, provider](web::WebResponse response) {
+                        raw->onAPISuccess(std::move(response), provider);
+                    }
+                );
+            });
     }
 
     // ── Generate button handler ───────────────────────────────────────────────
@@ -15066,27 +20351,23 @@ protected:
         // dialog instead of calling an API. Defensive single chokepoint — covers
         // any path (cocos onGenerate, headless, resumed) that reaches here with
         // manual selected. (The overlay uses the editoraiManual* bridge directly.)
-        if (Mod::get()->getSettingValue<std::string>("ai-provider") == "manual") {
+        if (genProvider() == "manual") {
             startManualCopy(prompt);
             return;
         }
         // Rate limiting — prevent excessive API calls
-        static std::chrono::steady_clock::time_point lastRequestTime{};
-        if (Mod::get()->getSettingValue<bool>("enable-rate-limiting")) {
-            auto now = std::chrono::steady_clock::now();
-            int64_t minSeconds = Mod::get()->getSettingValue<int64_t>("rate-limit-seconds");
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastRequestTime).count();
-            if (elapsed < minSeconds) {
-                FLAlertLayer::create("Rate Limited",
-                    gd::string(fmt::format("Please wait {} more second(s).", minSeconds - elapsed)),
-                    "OK")->show();
-                return;
-            }
-            lastRequestTime = now;
+        if (int64_t wait = rateLimitRemaining(); wait > 0) {
+            FLAlertLayer::create("Rate Limited",
+                gd::string(fmt::format("Please wait {} more second(s).", wait)),
+                "OK")->show();
+            return;
         }
+        s_lastRequestTime = std::chrono::steady_clock::now();
 
         m_isGenerating = true;
+        ++m_generation;
         m_transientRetries = 0;
+        m_platinumTried.clear();
         m_generateBtn->setVisible(false);
         m_cancelBtn->setVisible(true);
 
@@ -15124,11 +20405,11 @@ protected:
 
         // Region rebuild only applies in mutation mode; any stale marker from
         // a previous generation is cleared either way.
-        s_pendingRegionDelete = {};
+        m_stage->regionDelete = {};
         if (m_mutationMode) {
             float rx0 = 0, rx1 = 0;
             if (extractRegionRange(prompt, rx0, rx1)) {
-                s_pendingRegionDelete = {rx0, rx1, true};
+                m_stage->regionDelete = {rx0, rx1, true};
                 log::info("Region rebuild armed: X=[{:.0f},{:.0f}] (old objects "
                           "delete on accept)", rx0, rx1);
             }
@@ -15141,6 +20422,8 @@ protected:
         // generation (stale flags made fresh single-shot runs report
         // garbage replies as "Answered" and mis-parse first responses).
         m_accumulatedObjects = matjson::Value::array();
+        clearDraftIndexes();
+        resetDraft();
         m_extensionRounds = 0;
         m_passabilityFixRounds = 0;
         m_refinementRounds = 0;
@@ -15151,13 +20434,16 @@ protected:
         m_decorationPassDone = false;
         m_targetObjRounds    = 0;
         m_editEnforceRounds  = 0;
-        m_lengthTarget = lengthTargetForSetting(
-            Mod::get()->getSettingValue<std::string>("length"));
+        m_lengthTarget = lengthTargetForSetting(genSetting("length"));
 
         // Hand off directly to the API. Tool fetching is done by the AI
         // itself via the multi-turn tool-use loop (see runToolLoop) — there
-        // are no user-facing pre-generation tool inputs.
-        callAPI(prompt, apiKey);
+        // are no user-facing pre-generation tool inputs. Mutation / co-op
+        // prompts carry the level, so an edit since the popup's prefetch
+        // finishes compacting first.
+        whenLevelContextReady([this, gen = m_generation, prompt, apiKey] {
+            if (stillCurrent(gen)) callAPI(prompt, apiKey);
+        });
     }
 
     void onGenerate(CCObject*) {
@@ -15247,11 +20533,11 @@ protected:
     // Shared core: build the prompt, copy it to the clipboard, record the turn.
     // UI-agnostic — both the cocos popup and the overlay call this.
     void doManualCopy(const std::string& prompt) {
-        s_lastUserPrompt = prompt;
-        s_lastSelfRating = 0;
-        s_lastDifficulty = Mod::get()->getSettingValue<std::string>("difficulty");
-        s_lastStyle      = Mod::get()->getSettingValue<std::string>("style");
-        s_lastLength     = Mod::get()->getSettingValue<std::string>("length");
+        m_stage->fb.userPrompt = prompt;
+        m_stage->fb.selfRating = 0;
+        m_stage->fb.difficulty = Mod::get()->getSettingValue<std::string>("difficulty");
+        m_stage->fb.style      = Mod::get()->getSettingValue<std::string>("style");
+        m_stage->fb.length     = Mod::get()->getSettingValue<std::string>("length");
 
         std::string blob = buildManualBlob(prompt);
         m_manualPromptBlob = blob;
@@ -15318,6 +20604,7 @@ protected:
         // rounds (m_usingToolLoop = false gates every extension/refine/critique
         // path in processFinalResponse).
         m_accumulatedObjects = matjson::Value::array();
+        clearDraftIndexes();
         m_extensionRounds = 0; m_passabilityFixRounds = 0; m_refinementRounds = 0;
         m_targetObjRounds = 0;  m_editEnforceRounds = 0;
         m_followUpTurn = false; m_followUpMode = 0;
@@ -15338,29 +20625,49 @@ protected:
 
     void onAPISuccess(web::WebResponse response, const std::string& provider) {
         logApiResponse(response.code(), response.string().unwrapOr(""));
+        // Geode's WebResponse lands whole, so TTFB and body download are one
+        // span; the separate "handle-response" span below is ours.
+        trace::record(traceSession(), "http", "net", m_traceHttpStartUs, trace::nowUs());
+        trace::Span handleSpan("handle-response", traceSession());
         // Transient-failure retry runs BEFORE the UI reset so the loading
         // state survives the backoff.
-        if (!response.ok()) {
+        double waitSeconds = ratelimit::observe(provider, response);
+        // Platinum: feed the routing stats, and fail over to another
+        // coordinator when this one never really answered (timeout, refused,
+        // or the coordinator's own gateway errors).
+        if (!m_platinumNode.empty()) {
             int code = response.code();
-            bool transient = code == 429 || code == 500 || code == 502 ||
-                             code == 503 || code == 529;
-            if (transient && m_transientRetries < 1) {
-                ++m_transientRetries;
-                log::warn("Transient HTTP {} on single-shot — retrying once in 2s", code);
-                showStatus(fmt::format("Provider hiccup (HTTP {}) — retrying...", code));
-                // Move-through capture — see retryToolRoundIfTransient for
-                // why the worker thread must never destroy a Ref copy.
-                Ref<AIGeneratorPopup> self = this;
-                std::thread([self = std::move(self)]() mutable {
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
-                    Loader::get()->queueInMainThread([self = std::move(self)] {
-                        if (!self->m_isGenerating) return;
-                        self->callAPI(self->m_lastCallPrompt, self->m_lastCallKey);
-                    });
-                }).detach();
-                return;
+            bool transportFail = code <= 0 || code == 502 || code == 503 || code == 504;
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - m_platinumSentAt).count();
+            platinum::observe(m_platinumNode, response.ok(), transportFail,
+                              ms / std::max(1.0, m_platinumFactor));
+            std::string failed = std::exchange(m_platinumNode, std::string());
+            if (transportFail) {
+                m_platinumTried.push_back(failed);
+                if (!platinum::pick(m_platinumTried).empty()) {
+                    log::warn("Platinum coordinator {} failed (HTTP {}) — failing over", failed, code);
+                    showStatus("Platinum node unreachable — trying another coordinator...");
+                    this->callAPI(m_lastCallPrompt, m_lastCallKey);
+                    return;
+                }
             }
         }
+        if (!response.ok() && this->transientRetryAllowed(response.code())) {
+            int code = response.code();
+            double delay = waitSeconds > 0 ? waitSeconds : 2.0;
+            log::warn("Transient HTTP {} on single-shot — retrying in {:.1f}s", code, delay);
+            showStatus(fmt::format("Provider hiccup (HTTP {}) — retrying in {:.0f}s...",
+                                   code, std::ceil(delay)));
+            // callAPI re-enters the limiter itself; the deferred slot only
+            // holds the retry back until the provider reopens.
+            Ref<AIGeneratorPopup> self = this;
+            ratelimit::defer(provider, rateOwner(), [self, gen = m_generation] {
+                if (!self->stillCurrent(gen)) return;
+                self->callAPI(self->m_lastCallPrompt, self->m_lastCallKey);
+            }, delay);
+            return;
+        }
 
         resetGenerationUI();
 
@@ -15438,6 +20745,11 @@ protected:
                     auto doneResult = lineObj["done"].asBool();
                     if (doneResult && doneResult.unwrap()) {
                         isDone = true;
+                        // load_duration (ns) is what the warm-up exists to
+                        // keep out of the generation — say when it didn't.
+                        double loadS = lineObj["load_duration"].asDouble().unwrapOr(0.0) / 1e9;
+                        if (loadS > 1.0)
+                            log::warn("Ollama: generation paid a {:.1f}s model load", loadS);
                     }
 
                     // Also surface any Ollama-level error messages
@@ -15593,10 +20905,21 @@ protected:
         }
     }
 
+    void reportClearRefused() {
+        onError("Level Not Cleared",
+            fmt::format("This generation replaces the level, but {} other AI "
+                        "preview(s) are still staged in this editor. Accept or "
+                        "deny them first, then re-generate. ({})",
+                        activeStageCount(), autoErrorCode(70, 4)));
+    }
+
     void onError(const std::string& title, const std::string& message) {
+        releaseReservation();
         resetGenerationUI();
         m_followUpTurn    = false;   // turn-scoped flags die with the turn
         m_critiquePending = false;
+        resetDraft();
+        cancelQualityPasses();
         showStatus("Failed!", true);
         log::error("Generation failed: {}", message);
         if (m_session) {
@@ -15616,11 +20939,19 @@ protected:
     void closePopup() { this->onClose(nullptr); }
 
 public:
+    // The session dropped its engine mid-spawn: nothing else will ever
+    // finish or release this context's reservation. (An engine that isn't
+    // spawning leaves the shared context alone — a successor may be.)
+    ~AIGeneratorPopup() override {
+        if (m_isCreatingObjects) releaseReservation();
+    }
+
     static AIGeneratorPopup* create(LevelEditorLayer* layer) {
         auto ret = new AIGeneratorPopup();
         if (ret->init(layer)) {
             ret->autorelease();
             ret->m_session = newGenSession();
+            ret->m_stage->sessionId = ret->m_session->id;
             ret->m_session->engineRef = ret;   // keeps the engine alive off-scene
             ret->m_session->enginePtr = ret;
             // Remember which level this generation belongs to — adoption and
@@ -15648,6 +20979,7 @@ public:
         if (ret->init(layer)) {
             ret->autorelease();
             ret->m_session = sess;
+            ret->m_stage   = acquireStage(sess->id);   // keep staging into its preview
             sess->engineRef = ret;
             sess->enginePtr = ret;
             sess->restored  = false;           // live again
@@ -15741,6 +21073,27 @@ public:
         startGeneration(prompt, getProviderApiKey(provider));
     }
 
+    // Headless batch entry (see the batch queue): provider and level
+    // parameters are pinned by the job, never the live settings. Returns
+    // false when startGeneration bailed before going live (a gate the
+    // scheduler didn't foresee) — the session is marked Failed so neither
+    // it nor the job sits in Running forever.
+    bool startBatch(const BatchJob& job, const std::string& apiKey) {
+        m_overrides = {job.provider, job.difficulty, job.style, job.length};
+        m_shouldClearLevel = job.replaceContents;
+        m_editMode = !job.replaceContents;
+        startGeneration(job.prompt, apiKey);
+        if (m_isGenerating) return true;
+        if (m_session) {
+            m_session->state = GenSession::State::Failed;
+            m_session->push(GenSession::Entry::Kind::Error,
+                            "Batch generation did not start");
+        }
+        return false;
+    }
+
+    std::shared_ptr<GenSession> sessionPtr() const { return m_session; }
+
     // Headless copilot entry: mutation-framed generation started by the
     // editor's copilot tick (the popup is never shown; results stage via
     // the off-scene immediate path).
@@ -15783,7 +21136,9 @@ public:
         m_followUpTurn       = true;
         m_followUpMode       = mode;
         m_isGenerating       = true;
+        ++m_generation;
         m_transientRetries   = 0;
+        m_platinumTried.clear();
         m_toolIterations     = 0;        // fresh, unbounded round count this turn
         m_forceFinalize      = false;
         m_forceFinalizeTries = 0;
@@ -15791,6 +21146,7 @@ public:
         m_toolCallSigCounts.clear();
         m_shouldClearLevel = false;      // follow-ups always modify additively
         m_accumulatedObjects = matjson::Value::array();
+        clearDraftIndexes();
 
         std::string modeNote;
         if (mode == 1) {
@@ -15807,7 +21163,7 @@ public:
                 "\n\n(EDIT MODE: follow-up turn on the same level. If the user "
                 "wants changes, act as a full co-editor: MOVE/DELETE/EDIT "
                 "existing objects (bulk selectors: #a-b, rect:x1,y1,x2,y2, "
-                "id:type) plus new additions — a substantive request deserves "
+                "id:type, group:N) plus new additions — a substantive request deserves "
                 "a substantive rework{}. If this is just a question, answer in "
                 "plain text with no script.)",
                 editTarget > 0
@@ -15817,19 +21173,22 @@ public:
             // The numbered inventory the selectors resolve against — rebuilt
             // every edit turn so indices always match what the model sees.
             if (revalidateEditor()) {
-                modeNote += "\n\n" + buildLevelInventoryListing(1500);
+                modeNote += "\n\n" + buildLevelInventoryListing((int)(1500 * promptScale()));
             }
         }
         // Unbounded conversations: past ~40 messages, fold the oldest turns
-        // away (keep the system prompt + the newest 30). The level itself is
+        // away (keep the system prompt + the newest 30; both scale with the
+        // model's context, see caps::historyWindow). The level itself is
         // re-sent as context each turn, so old turns lose value fast — but
         // the request would otherwise grow without limit.
         {
+            std::string provider = genProvider();
+            auto window = caps::historyWindow(provider, getProviderModel(provider));
             size_t nonSystem = 0;
             for (auto& m : m_toolHistory)
                 if (m.role != toolUse::MessageRole::System) ++nonSystem;
-            if (nonSystem > 40) {
-                size_t drop = nonSystem - 30;
+            if (nonSystem > window.trigger) {
+                size_t drop = nonSystem - window.keep;
                 for (auto it = m_toolHistory.begin();
                      it != m_toolHistory.end() && drop > 0;) {
                     if (it->role != toolUse::MessageRole::System &&
@@ -15922,11 +21281,12 @@ public:
         // Everyone else (custom endpoint, Platinum — whose coordinator has
         // no /api/chat) gets a single-shot follow-up: the recent exchange is
         // serialized into one prompt and sent through the normal API path.
-        std::string provider = Mod::get()->getSettingValue<std::string>("ai-provider");
+        std::string provider = genProvider();
         bool platinum = provider == "ollama" &&
             Mod::get()->getSettingValue<bool>("use-platinum");
         bool toolsEnabled = Mod::get()->getSettingValue<bool>("enable-ai-tools");
-        m_usingToolLoop = toolsEnabled && toolUse::supportsToolUse(provider) && !platinum;
+        m_usingToolLoop = toolsEnabled && !platinum &&
+            toolUse::supportsToolUse(provider, getProviderModel(provider));
         if (m_usingToolLoop) {
             this->doToolRound();
             return;
@@ -15978,7 +21338,12 @@ public:
         // Mirror the live-editor apply path: a fresh-mode generation clears
         // before staging — skipping this piled ghosts onto the new level.
         if (m_pendingApplyObjects && m_shouldClearLevel) {
-            clearLevel();
+            if (!clearLevel()) {
+                m_pendingApplyObjects.reset();
+                m_pendingMetadata.reset();
+                reportClearRefused();
+                return;
+            }
             m_shouldClearLevel = false;  // never double-clear on re-adopt
         }
         if (m_pendingApplyObjects) {
@@ -16007,28 +21372,30 @@ static CCNode* getAIButton(EditorUI* ui) {
     return menu->getChildByID("ai-button"_spr);
 }
 
-// Move every preview object from the preview layer back to its intended
-// editor layer(s), and return the editor to the layer it was on before the
-// preview opened. Shared by Accept and Edit (Deny removes the objects).
-static void restorePreviewLayers(LevelEditorLayer* lel) {
-    for (size_t i = 0; i < s_previewObjects.size(); ++i) {
-        if (GameObject* obj = s_previewObjects[i]) {
-            auto intended = i < s_previewIntendedLayers.size()
-                ? s_previewIntendedLayers[i]
+// Move every preview object of one context from its preview layer back to
+// its intended editor layer(s), and return the editor to the layer it was
+// on before the preview opened. Shared by Accept and Edit (Deny removes the
+// objects).
+static void restorePreviewLayers(LevelEditorLayer* lel, StagingContext& ctx) {
+    for (size_t i = 0; i < ctx.previewObjects.size(); ++i) {
+        if (GameObject* obj = ctx.previewObjects[i]) {
+            auto intended = i < ctx.intendedLayers.size()
+                ? ctx.intendedLayers[i]
                 : std::pair<short, short>{0, 0};
             obj->m_editorLayer  = intended.first;
             obj->m_editorLayer2 = intended.second;
         }
     }
-    setEditorCurrentLayer(lel, s_editorLayerBeforePreview);
-    s_previewLayer = -1;
+    setEditorCurrentLayer(lel, ctx.layerBefore);
+    ctx.previewLayer = -1;
+    ctx.layerReserved = false;
 }
 
 // Snapshot id+position of every preview object as the baseline for implicit
 // edit-tracking feedback. Shared by Accept and Edit.
-static void snapshotAcceptedObjects() {
+static void snapshotAcceptedObjects(const StagingContext& ctx) {
     s_acceptedSnapshot.clear();
-    for (auto& objRef : s_previewObjects) {
+    for (auto& objRef : ctx.previewObjects) {
         if (GameObject* obj = objRef) {
             s_acceptedSnapshot.push_back({
                 obj->m_objectID,
@@ -16037,7 +21404,7 @@ static void snapshotAcceptedObjects() {
             });
         }
     }
-    s_snapshotPrompt = s_lastUserPrompt;
+    s_snapshotPrompt = ctx.fb.userPrompt;
 }
 
 // Overlay-initiated generation queued until its target editor is ready
@@ -16069,6 +21436,8 @@ class $modify(AIEditorUI, EditorUI) {
         int m_copilotLastCount   = -1;
         int m_copilotStableTicks = 0;
         std::chrono::steady_clock::time_point m_copilotLastFix{};
+        std::chrono::steady_clock::time_point m_copilotLastCheck{};
+        bool m_copilotChecking = false;               // a check is on the worker
         std::string m_copilotLastFingerprint;
     };
 
@@ -16076,23 +21445,30 @@ class $modify(AIEditorUI, EditorUI) {
         if (!EditorUI::init(layer)) return false;
 
         // A fresh EditorUI means any previous editor scene is gone. If the
-        // user exited mid-preview, the shared preview state still points at
-        // objects from the dead scene and would permanently block the AI
-        // button ("Preview Active") with no buttons left to clear it.
-        if (s_inPreviewMode || s_inEditMode || !s_previewObjects.empty()
-            || !s_editOpJournal.empty()) {
-            log::info("EditorAI: clearing stale preview state from a previous editor session");
-            s_inPreviewMode = false;
-            s_inEditMode = false;
-            s_previewObjects.clear();
-            s_previewIntendedLayers.clear();
-            s_previewLayer = -1;
-            s_editorLayerBeforePreview = -1;   // never carry across editors
-            // Pending edit ops from the dead scene: the objects are gone with
-            // their editor — drop the journal (Refs would pin dead nodes).
-            s_editOpJournal.clear();
-            s_editOpDeleted.clear();
-            removePlaytestGhost();  // Ref would otherwise leak a dead-scene node
+        // user exited mid-preview, the staging contexts still point at
+        // objects from the dead scene and would permanently block Playtest
+        // with no tray left to clear them. The contexts are reset in place
+        // (engines hold them too) and dropped from the registry.
+        if (!s_stagings.empty()) {
+            log::info("EditorAI: clearing {} stale staging context(s) from a "
+                      "previous editor session", s_stagings.size());
+            for (auto& ctx : s_stagings) {
+                ctx->inPreview = false;
+                ctx->inEdit    = false;
+                ctx->previewObjects.clear();
+                ctx->intendedLayers.clear();
+                ctx->previewLayer = -1;
+                ctx->layerReserved = false;
+                ctx->layerBefore  = -1;   // never carry across editors
+                // Pending edit ops from the dead scene: the objects are gone
+                // with their editor — drop the journal (Refs would pin dead
+                // nodes).
+                ctx->editOps.clear();
+                ctx->regionDelete = {};
+                removePlaytestGhost(*ctx);  // Ref would otherwise leak a dead-scene node
+            }
+            s_stagings.clear();
+            s_focusedStage.reset();
         }
 
         // Ensure NodeIDs has assigned IDs before we look anything up.
@@ -16135,20 +21511,23 @@ class $modify(AIEditorUI, EditorUI) {
         }
 #endif
 
-        // A generation that finished while no editor existed is waiting:
-        // adopt the most recent one whose TARGET LEVEL matches this editor.
-        // Any other level's editor changes nothing — the session keeps
-        // waiting for its own level.
+        // Generations that finished while no editor existed are waiting:
+        // adopt every one whose TARGET LEVEL matches this editor, oldest
+        // first so the oldest is the one under review. Each stages into its
+        // own context on its own preview layer. Any other level's editor
+        // changes nothing — those sessions keep waiting for their level.
         GJGameLevel* hereLevel = this->m_editorLayer
             ? this->m_editorLayer->m_level : nullptr;
-        for (auto it = genSessions().rbegin(); it != genSessions().rend(); ++it) {
-            auto& s = *it;
+        std::vector<std::shared_ptr<GenSession>> waiting;
+        for (auto& s : genSessions()) {
             if (s->state != GenSession::State::AwaitingEditor || !s->enginePtr) continue;
             if (s->targetLevel && s->targetLevel != hereLevel) continue;
+            waiting.push_back(s);
+        }
+        for (auto& s : waiting) {
             auto* engine = static_cast<AIGeneratorPopup*>(s->enginePtr);
             log::info("EditorAI: adopting waiting session {} into new editor", s->id);
             engine->adoptEditor(this->m_editorLayer);
-            break;  // one blueprint at a time — preview is a singleton
         }
 
         // Overlay queued a generation — start it only if THIS editor is the
@@ -16166,23 +21545,26 @@ class $modify(AIEditorUI, EditorUI) {
                 engine->startHeadless(req.prompt, req.replaceContents);
         }
 
-        // An engineless session (restored, or its engine died) queued an
-        // edit follow-up for its level — if THIS is that level, rebuild the
-        // engine from the session's chat memory and run the edit now.
-        for (auto it = genSessions().rbegin(); it != genSessions().rend(); ++it) {
-            auto& s = *it;
+        // Engineless sessions (restored, or their engine died) queued edit
+        // follow-ups for their level — if THIS is that level, rebuild each
+        // engine from the session's chat memory and run the edits now; they
+        // generate concurrently and stage side by side.
+        std::vector<std::shared_ptr<GenSession>> resumable;
+        for (auto& s : genSessions()) {
             if (!s || s->pendingEdit.empty() || s->enginePtr) continue;
             if (s->targetLevel && s->targetLevel != hereLevel) continue;
             if (!s->targetLevel && hereLevel && !s->targetLevelName.empty()
                 && s->targetLevelName != std::string(hereLevel->m_levelName))
                 continue;
+            resumable.push_back(s);
+        }
+        for (auto& s : resumable) {
             std::string text = std::move(s->pendingEdit);
             s->pendingEdit.clear();
             int mode = s->pendingEditMode;
             log::info("EditorAI: resuming session {} edit in its editor", s->id);
             if (auto* engine = AIGeneratorPopup::createForSession(this->m_editorLayer, s))
                 engine->resumeFollowUp(text, mode, /*echoUser=*/false);
-            break;  // one preview at a time
         }
 
         // Copilot: watch the level while the user edits; propose fixes when
@@ -16190,14 +21572,21 @@ class $modify(AIEditorUI, EditorUI) {
         this->schedule(schedule_selector(AIEditorUI::copilotTick), 4.0f);
     }
 
-    // 4 s cadence; all checks are local math until a fix actually fires.
-    void copilotTick(float) {
-        if (!Mod::get()->getSettingValue<bool>("copilot-mode")) return;
-        if (s_inPreviewMode || s_inEditMode) return;
-        // Never fire while any generation is in flight — a copilot engine
-        // would race the running one for the singleton preview state.
+    // 4 s cadence. The tick itself only snapshots the level; the column
+    // scan and the bot search run on a worker and report back through
+    // copilotReport on the main thread.
+    static bool copilotBlocked() {
+        if (!Mod::get()->getSettingValue<bool>("copilot-mode")) return true;
+        if (anyStageActive()) return true;
+        // Never fire while any generation is in flight — a copilot fix
+        // would analyze a level that is about to change under it.
         for (auto& s : genSessions())
-            if (s && s->state == GenSession::State::Running) return;
+            if (s && s->state == GenSession::State::Running) return true;
+        return false;
+    }
+
+    void copilotTick(float) {
+        if (copilotBlocked()) return;
         auto* editor = this->m_editorLayer;
         if (!editor || !editor->m_objects) return;
 
@@ -16210,12 +21599,18 @@ class $modify(AIEditorUI, EditorUI) {
             return;
         }
         if (++f->m_copilotStableTicks < 2) return;    // wait ~8 s of idle
+        if (f->m_copilotChecking) return;
 
         auto now = std::chrono::steady_clock::now();
-        if (f->m_copilotLastFix.time_since_epoch().count() != 0 &&
-            std::chrono::duration_cast<std::chrono::seconds>(
-                now - f->m_copilotLastFix).count() < 120)
-            return;                                   // 2-minute fix cooldown
+        auto secondsSince = [&](std::chrono::steady_clock::time_point t) {
+            return t.time_since_epoch().count() == 0
+                ? std::numeric_limits<int64_t>::max()
+                : (int64_t)std::chrono::duration_cast<std::chrono::seconds>(now - t).count();
+        };
+        if (secondsSince(f->m_copilotLastFix) < 120) return;   // 2-minute fix cooldown
+        // An idle level is re-checked every 30 s, not on every tick.
+        if (f->m_copilotStableTicks > 2 && secondsSince(f->m_copilotLastCheck) < 30) return;
+        f->m_copilotLastCheck = now;
 
         // Collect a capped object snapshot (same shape as the mutation flow).
         static const std::unordered_map<int, std::string>& idToName = objectIdToName();
@@ -16236,29 +21631,54 @@ class $modify(AIEditorUI, EditorUI) {
         }
         if (added < 10) return;
 
-        auto pass = levelcheck::check(arr);
-        auto sim  = levelcheck::simulateCube(arr,
-            (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"));
-        if (pass.deaths.empty() && sim.deaths.empty()) {
+        f->m_copilotChecking = true;
+        float groundY = (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y");
+        // The Ref is only ever moved off the main thread, never copied:
+        // retain/release aren't thread-safe.
+        Ref<AIEditorUI> self = this;
+        std::thread([self = std::move(self), arr = std::move(arr), groundY, count]() mutable {
+            auto pass = levelcheck::check(arr);
+            auto sim  = levelcheck::verifyPassable(arr, groundY);
+            Loader::get()->queueInMainThread(
+                [self = std::move(self), pass = std::move(pass), sim = std::move(sim),
+                 count]() mutable {
+                    self->m_fields->m_copilotChecking = false;
+                    self->copilotReport(std::move(pass), sim, count);
+                });
+        }).detach();
+    }
+
+    void copilotReport(levelcheck::Result pass, const levelcheck::VerifyResult& sim,
+                       int checkedCount) {
+        // The editor may have closed, or the level moved on, while the
+        // worker ran; a stale verdict is dropped and the next tick re-checks.
+        auto* editor = this->m_editorLayer;
+        if (!editor || editor != LevelEditorLayer::get() || !editor->m_objects) return;
+        if (editor->m_objects->count() != checkedCount || copilotBlocked()) return;
+
+        auto& f = m_fields;
+        // Column-blocked zones are only real when no route exists at all.
+        if (sim.passable) pass.deaths.clear();
+        if (pass.deaths.empty() && !sim.blocked()) {
             f->m_copilotLastFingerprint.clear();
-            return;                                   // level is healthy
+            return;                                   // level is healthy (or unjudgeable)
         }
 
         // Fingerprint the problem set so the same issue never double-fires.
         std::string fp;
         for (auto& d : pass.deaths) fp += fmt::format("z{:.0f};", d.x_start);
-        for (auto& d : sim.deaths)  fp += fmt::format("s{:.0f};", d.x);
+        if (sim.blocked()) fp += fmt::format("s{:.0f};", sim.blockedX);
         if (fp == f->m_copilotLastFingerprint) return;
         f->m_copilotLastFingerprint = fp;
-        f->m_copilotLastFix = now;
+        f->m_copilotLastFix = std::chrono::steady_clock::now();
 
         std::string problems;
         for (size_t i = 0; i < pass.deaths.size() && i < 4; ++i)
             problems += fmt::format("fully blocked X={:.0f}-{:.0f}; ",
                 pass.deaths[i].x_start, pass.deaths[i].x_end);
-        for (size_t i = 0; i < sim.deaths.size() && i < 4; ++i)
-            problems += fmt::format("cube bot dies at X={:.0f} ({}); ",
-                sim.deaths[i].x, sim.deaths[i].reason);
+        if (sim.blocked())
+            problems += fmt::format("no input survives past X={:.0f} ({}); ",
+                sim.blockedX, sim.reason);
 
         log::info("Copilot: firing auto-fix for: {}", problems);
         Notification::create("Copilot: proposing a fix for detected problems...",
@@ -16277,11 +21697,6 @@ class $modify(AIEditorUI, EditorUI) {
     void onMutateButton(CCObject*) {
         if (!this->m_editorLayer) return;
         cancelActiveRatingPopup();
-        if (s_inPreviewMode || s_inEditMode) {
-            FLAlertLayer::create("Preview Active",
-                gd::string("Finish the current AI preview first."), "OK")->show();
-            return;
-        }
         if (!this->m_editorLayer->m_objects || this->m_editorLayer->m_objects->count() == 0) {
             FLAlertLayer::create("Empty Level",
                 gd::string("Mutation changes an existing level - build or generate "
@@ -16302,15 +21717,6 @@ class $modify(AIEditorUI, EditorUI) {
         // start a fresh generation without first having to rate the previous
         // one. Rating data is simply discarded.
         cancelActiveRatingPopup();
-
-        if (s_inPreviewMode || s_inEditMode) {
-            FLAlertLayer::create("Preview Active",
-                gd::string(s_inEditMode
-                    ? "Please press Done to finish editing first."
-                    : "Please accept, edit, or deny the current AI preview first."),
-                "OK")->show();
-            return;
-        }
         AIGeneratorPopup::create(this->m_editorLayer)->show();
     }
 #endif  // !EDITORAI_HAS_IMGUI
@@ -16366,6 +21772,9 @@ class $modify(AIEditorUI, EditorUI) {
 
     void showPreviewButtons() {
         if (m_fields->m_previewButtonMenu) return;
+        auto ctx = focusedStage();
+        if (!ctx) return;
+        if (ctx->inEdit) { showDoneButton(); return; }
 
         CCMenu* menu = nullptr;
         // menuH must cover the Why button at y=135 (menu touch rect =
@@ -16373,14 +21782,35 @@ class $modify(AIEditorUI, EditorUI) {
         auto container = buildTrayFrame(162.f, 140.f, &menu);
 
         // Object-count line under the header, with a "why?" info dot that
-        // opens the AI's own plan narration for this generation.
+        // opens the AI's own plan narration for this generation. Several
+        // staged previews add a position counter and a "next" arrow that
+        // cycles the tray (and the editor layer) through them.
+        size_t total = activeStageCount();
+        size_t pos = 1;
+        for (auto& c : s_stagings) {
+            if (c == ctx) break;
+            if (c->active()) ++pos;
+        }
         auto count = CCLabelBMFont::create(
-            fmt::format("{} objects", s_previewObjects.size()).c_str(), "chatFont.fnt");
-        count->limitLabelWidth(70.f, 0.45f, 0.45f);
+            (total > 1
+                ? fmt::format("{} obj ({}/{})", ctx->previewObjects.size(), pos, total)
+                : fmt::format("{} objects", ctx->previewObjects.size())).c_str(),
+            "chatFont.fnt");
+        count->limitLabelWidth(total > 1 ? 56.f : 70.f, 0.45f, 0.45f);
         count->setColor(ui::TEXT_SECONDARY);
-        count->setPosition({42.f, 135.f});
+        count->setPosition({total > 1 ? 34.f : 42.f, 135.f});
         container->addChild(count);
-        if (!s_lastAINarration.empty()) {
+        if (total > 1) {
+            auto nextSpr = CCSprite::createWithSpriteFrameName("GJ_arrow_02_001.png");
+            nextSpr->setFlipX(true);
+            nextSpr->setScale(0.3f);
+            auto nextBtn = CCMenuItemSpriteExtra::create(nextSpr, this,
+                menu_selector(AIEditorUI::onNextPreview));
+            nextBtn->setID("next-btn"_spr);
+            nextBtn->setPosition({70.f, 135.f});
+            menu->addChild(nextBtn);
+        }
+        if (!ctx->fb.aiNarration.empty()) {
             auto whySpr = CCSprite::createWithSpriteFrameName("GJ_infoIcon_001.png");
             whySpr->setScale(0.42f);
             auto whyBtn = CCMenuItemSpriteExtra::create(whySpr, this,
@@ -16446,9 +21876,47 @@ class $modify(AIEditorUI, EditorUI) {
         }
     }
 
+    // Cycle the tray to the next staged preview (edit-mode contexts hold
+    // the tray until Done, so they're skipped).
+    void onNextPreview(CCObject*) {
+        auto cur = focusedStage();
+        if (!cur || s_stagings.empty()) return;
+        auto it = std::find(s_stagings.begin(), s_stagings.end(), cur);
+        size_t start = it == s_stagings.end() ? 0 : (size_t)(it - s_stagings.begin());
+        for (size_t k = 1; k <= s_stagings.size(); ++k) {
+            auto& c = s_stagings[(start + k) % s_stagings.size()];
+            if (!c->inPreview || c == cur) continue;
+            removePlaytestGhost(*cur);
+            s_focusedStage = c;
+            setEditorCurrentLayer(m_editorLayer, c->previewLayer);
+            removePreviewButtons();
+            showPreviewButtons();
+            return;
+        }
+    }
+
+    // A context just left review: hand the tray to the next one still
+    // staged (its preview layer becomes the editor's view), if any.
+    void advanceReview() {
+        auto next = focusedStage();
+        if (!next) return;
+        removePreviewButtons();
+        if (next->inPreview)
+            setEditorCurrentLayer(m_editorLayer, next->previewLayer);
+        showPreviewButtons();
+        Notification::create(
+            fmt::format("{} more preview(s) staged - next one shown",
+                        activeStageCount()),
+            NotificationIcon::Info)->show();
+    }
+
     void onAcceptPreview(CCObject*) {
-        removePlaytestGhost();
-        log::info("EditorAI: accepting {} preview objects", s_previewObjects.size());
+        auto ctx = focusedStage();
+        if (!ctx) { removePreviewButtons(); return; }
+        trace::Span span("accept", ctx->sessionId, "stage");
+        removePlaytestGhost(*ctx);
+        log::info("EditorAI: accepting {} preview objects (session {})",
+                  ctx->previewObjects.size(), ctx->sessionId);
 
         // Before accepting new objects, check if the user edited the PREVIOUS
         // accepted generation — if so, update that feedback entry with edit info.
@@ -16470,46 +21938,51 @@ class $modify(AIEditorUI, EditorUI) {
         }
 
         // Region rebuild: the replacement was accepted — remove the ORIGINAL
-        // objects inside the marked range. Preview objects are exempt (the
-        // pointer set), so the freshly accepted replacement survives. The
-        // deletion itself is not in the undo batch (v1 limitation, logged).
-        if (s_pendingRegionDelete.active && m_editorLayer && m_editorLayer->m_objects) {
+        // objects inside the marked range. Preview objects of EVERY staged
+        // context are exempt (the pointer set), so the freshly accepted
+        // replacement — and any other preview still awaiting review —
+        // survives. The deletion itself is not in the undo batch (v1
+        // limitation, logged).
+        auto& region = ctx->regionDelete;
+        if (region.active && m_editorLayer && m_editorLayer->m_objects) {
             std::unordered_set<GameObject*> previewSet;
-            previewSet.reserve(s_previewObjects.size());
-            for (auto& objRef : s_previewObjects)
-                if (GameObject* obj = objRef) previewSet.insert(obj);
+            previewSet.reserve(ctx->previewObjects.size());
+            for (auto& c : s_stagings)
+                for (auto& objRef : c->previewObjects)
+                    if (GameObject* obj = objRef) previewSet.insert(obj);
 
             std::vector<GameObject*> toDelete;
             for (auto* raw : CCArrayExt<CCObject*>(m_editorLayer->m_objects)) {
                 auto* gameObj = typeinfo_cast<GameObject*>(raw);
                 if (!gameObj || previewSet.count(gameObj)) continue;
                 float ox = gameObj->getPositionX();
-                if (ox >= s_pendingRegionDelete.x0 && ox <= s_pendingRegionDelete.x1)
+                if (ox >= region.x0 && ox <= region.x1)
                     toDelete.push_back(gameObj);
             }
             for (auto* obj : toDelete)
                 m_editorLayer->removeObject(obj, true);
+            ++s_levelMutationEpoch;
             log::info("Region rebuild: deleted {} original objects in X=[{:.0f},{:.0f}] "
                       "(not undoable - the added batch is)",
-                      toDelete.size(), s_pendingRegionDelete.x0, s_pendingRegionDelete.x1);
-            s_pendingRegionDelete = {};
+                      toDelete.size(), region.x0, region.x1);
+            region = {};
         }
 
         // AI edit ops (moves/deletes/restyles of existing objects) become
         // permanent: soft deletes are removed for real, the journal drops.
-        finalizeEditOps(m_editorLayer);
+        finalizeEditOps(m_editorLayer, *ctx);
 
         // Restore objects from ghost to solid, then snapshot them as the
         // baseline for future edit tracking
-        restorePreviewLayers(m_editorLayer);
-        snapshotAcceptedObjects();
+        restorePreviewLayers(m_editorLayer, *ctx);
+        snapshotAcceptedObjects(*ctx);
 
         // Register the whole accepted batch as ONE undo step (same command a
         // paste uses). Without this, Ctrl+Z after accepting did nothing —
         // the generation was irreversible, which is scary in edit mode.
-        if (m_editorLayer && m_editorLayer->m_undoObjects && !s_previewObjects.empty()) {
+        if (m_editorLayer && m_editorLayer->m_undoObjects && !ctx->previewObjects.empty()) {
             auto batch = CCArray::create();
-            for (auto& objRef : s_previewObjects)
+            for (auto& objRef : ctx->previewObjects)
                 if (GameObject* obj = objRef)
                     if (obj->getParent()) batch->addObject(obj);
             if (batch->count() > 0) {
@@ -16525,9 +21998,10 @@ class $modify(AIEditorUI, EditorUI) {
             }
         }
 
-        s_previewObjects.clear();
-        s_previewIntendedLayers.clear();
-        s_inPreviewMode = false;
+        ctx->previewObjects.clear();
+        ctx->intendedLayers.clear();
+        ctx->inPreview = false;
+        retireStage(ctx);
         removePreviewButtons();
 
         if (m_editorLayer && m_editorLayer->m_editorUI)
@@ -16535,19 +22009,21 @@ class $modify(AIEditorUI, EditorUI) {
 
         Notification::create("Objects accepted!", NotificationIcon::Success)->show();
 
-        s_lastWasAccepted = true;
-        showRatingIfEnabled();
+        ctx->fb.wasAccepted = true;
+        showRatingIfEnabled(*ctx);
+        advanceReview();
     }
 
     // Export the staged blueprint as a shareable .eas text file (+clipboard).
-    // Source is the accumulated matjson (s_lastGeneratedJson) — richer than
+    // Source is the focused context's accumulated matjson — richer than
     // reverse-engineering live GameObjects.
     void onExportPreview(CCObject*) {
-        if (s_lastGeneratedJson.empty()) {
+        auto ctx = focusedStage();
+        if (!ctx || ctx->fb.generatedJson.empty()) {
             Notification::create("Nothing to export yet", NotificationIcon::Warning)->show();
             return;
         }
-        auto parsed = matjson::parse(s_lastGeneratedJson);
+        auto parsed = matjson::parse(ctx->fb.generatedJson);
         if (!parsed || !parsed.unwrap().isArray()) {
             Notification::create("Export failed (unparseable blueprint)",
                                  NotificationIcon::Error)->show();
@@ -16558,44 +22034,45 @@ class $modify(AIEditorUI, EditorUI) {
             (float)Mod::get()->getSettingValue<int64_t>("ai-ground-y"));
 
         auto dir = Mod::get()->getSaveDir() / "exports";
-        std::error_code ec;
-        std::filesystem::create_directories(dir, ec);
         auto path = dir / fmt::format("blueprint-{}.eas",
             (long long)std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count());
-        // Clipboard immediately (cheap); file write off-thread.
+        // Clipboard immediately (cheap); file write on the I/O worker (which
+        // creates exports/ on demand).
         utils::clipboard::write(easText);
-        std::thread([path, easText] {
-            auto res = utils::file::writeString(path, easText);
-            std::string name = utils::string::pathToString(path.filename());
-            Loader::get()->queueInMainThread([ok = res.isOk(), name] {
-                Notification::create(
-                    ok ? fmt::format("Exported {} (also on clipboard)", name)
-                       : "Export write failed (EAS still on clipboard)",
-                    ok ? NotificationIcon::Success : NotificationIcon::Warning)->show();
-            });
-        }).detach();
+        std::string name = utils::string::pathToString(path.filename());
+        io::write(path, [easText] { return easText; },
+                  io::Durability::Buffered, [name](bool ok) {
+            Notification::create(
+                ok ? fmt::format("Exported {} (also on clipboard)", name)
+                   : "Export write failed (EAS still on clipboard)",
+                ok ? NotificationIcon::Success : NotificationIcon::Warning)->show();
+        });
     }
 
     // "Why?" — the AI's own plan prose for this generation, captured in
     // processFinalResponse before the script/JSON block was stripped.
     void onWhyPreview(CCObject*) {
-        std::string body = s_lastAINarration.empty()
-            ? "The AI went straight to output without narrating a plan."
-            : s_lastAINarration;
+        auto ctx = focusedStage();
+        std::string body = !ctx || ctx->fb.aiNarration.empty()
+            ? std::string("The AI went straight to output without narrating a plan.")
+            : ctx->fb.aiNarration;
         FLAlertLayer::create(nullptr, "AI's Plan", body, "OK", nullptr, 380.f)->show();
     }
 
     void onDenyPreview(CCObject*) {
-        removePlaytestGhost();
-        s_pendingRegionDelete = {};  // replacement denied - originals stay
+        auto ctx = focusedStage();
+        if (!ctx) { removePreviewButtons(); return; }
+        removePlaytestGhost(*ctx);
+        ctx->regionDelete = {};  // replacement denied - originals stay
         // Undo every AI edit op: moved objects return, soft-deleted ones
         // reappear, restyles revert.
-        rollbackEditOps(m_editorLayer);
-        log::info("EditorAI: denying {} preview objects", s_previewObjects.size());
+        rollbackEditOps(m_editorLayer, *ctx);
+        log::info("EditorAI: denying {} preview objects (session {})",
+                  ctx->previewObjects.size(), ctx->sessionId);
 
         if (m_editorLayer) {
-            for (auto& objRef : s_previewObjects) {
+            for (auto& objRef : ctx->previewObjects) {
                 if (GameObject* obj = objRef) {
                     // A live parent pointer means the object is still in the
                     // editor (we created it via createObject; anything the
@@ -16610,14 +22087,17 @@ class $modify(AIEditorUI, EditorUI) {
                     }
                 }
             }
+            ++s_levelMutationEpoch;
         }
 
-        s_previewObjects.clear();
-        s_previewIntendedLayers.clear();
-        s_inPreviewMode = false;
+        ctx->previewObjects.clear();
+        ctx->intendedLayers.clear();
+        ctx->inPreview = false;
         // Objects are gone — just hop the editor back off the preview layer.
-        setEditorCurrentLayer(m_editorLayer, s_editorLayerBeforePreview);
-        s_previewLayer = -1;
+        setEditorCurrentLayer(m_editorLayer, ctx->layerBefore);
+        ctx->previewLayer = -1;
+        ctx->layerReserved = false;
+        retireStage(ctx);
         removePreviewButtons();
 
         if (m_editorLayer && m_editorLayer->m_editorUI)
@@ -16625,27 +22105,33 @@ class $modify(AIEditorUI, EditorUI) {
 
         Notification::create("Objects denied and removed.", NotificationIcon::Warning)->show();
 
-        s_lastWasAccepted = false;
-        showRatingIfEnabled();
+        ctx->fb.wasAccepted = false;
+        showRatingIfEnabled(*ctx);
+        advanceReview();
     }
 
     void onEditPreview(CCObject*) {
-        removePlaytestGhost();
-        log::info("EditorAI: entering edit mode for {} preview objects", s_previewObjects.size());
+        auto ctx = focusedStage();
+        if (!ctx) { removePreviewButtons(); return; }
+        removePlaytestGhost(*ctx);
+        log::info("EditorAI: entering edit mode for {} preview objects (session {})",
+                  ctx->previewObjects.size(), ctx->sessionId);
 
         // The user is taking over from here — keep the AI's edit ops (they
         // can adjust manually) and make the soft deletes real.
-        finalizeEditOps(m_editorLayer);
+        finalizeEditOps(m_editorLayer, *ctx);
 
         // Make objects solid and interactable so the user can edit them, and
         // snapshot positions BEFORE the user edits — this is the baseline
-        restorePreviewLayers(m_editorLayer);
-        snapshotAcceptedObjects();
+        restorePreviewLayers(m_editorLayer, *ctx);
+        snapshotAcceptedObjects(*ctx);
 
-        s_previewObjects.clear();
-        s_previewIntendedLayers.clear();
-        s_inPreviewMode = false;
-        s_inEditMode    = true;
+        // The context stays focused (and the other previews queued) until
+        // Done.
+        ctx->previewObjects.clear();
+        ctx->intendedLayers.clear();
+        ctx->inPreview = false;
+        ctx->inEdit    = true;
 
         // Replace Accept/Edit/Deny with Done
         showDoneButton();
@@ -16659,20 +22145,24 @@ class $modify(AIEditorUI, EditorUI) {
     void onDoneEditing(CCObject*) {
         log::info("EditorAI: done editing, computing edit summary");
 
-        s_inEditMode = false;
+        auto ctx = focusedStage();
+        if (!ctx || !ctx->inEdit) { removePreviewButtons(); return; }
+        ctx->inEdit = false;
+        retireStage(ctx);
         removePreviewButtons();
 
         // Capture the edited objects and compute what changed
+        auto& fb = ctx->fb;
         if (!s_acceptedSnapshot.empty() && m_editorLayer) {
-            s_lastEditedObjectsJson = captureEditedObjects(m_editorLayer);
-            s_lastEditSummary = computeEditSummary(m_editorLayer);
-            if (!s_lastEditSummary.empty())
-                log::info("EditorAI: user edits: {}", s_lastEditSummary);
-            if (!s_lastEditedObjectsJson.empty())
-                log::info("EditorAI: captured {} chars of edited objects", s_lastEditedObjectsJson.size());
+            fb.editedObjectsJson = captureEditedObjects(m_editorLayer);
+            fb.editSummary = computeEditSummary(m_editorLayer);
+            if (!fb.editSummary.empty())
+                log::info("EditorAI: user edits: {}", fb.editSummary);
+            if (!fb.editedObjectsJson.empty())
+                log::info("EditorAI: captured {} chars of edited objects", fb.editedObjectsJson.size());
         } else {
-            s_lastEditedObjectsJson.clear();
-            s_lastEditSummary.clear();
+            fb.editedObjectsJson.clear();
+            fb.editSummary.clear();
         }
 
         if (m_editorLayer && m_editorLayer->m_editorUI)
@@ -16680,41 +22170,49 @@ class $modify(AIEditorUI, EditorUI) {
 
         Notification::create("Edits saved!", NotificationIcon::Success)->show();
 
-        s_lastWasAccepted = true;
-        showRatingIfEnabled();
+        fb.wasAccepted = true;
+        showRatingIfEnabled(*ctx);
+        advanceReview();
     }
 };
 
 // Bridge function: lets AIGeneratorPopup call showPreviewButtons() on EditorUI
 // without needing AIEditorUI's definition (which comes after the popup class).
+// Rebuilds an already-shown tray so its staged-preview counter stays current.
 static void showPreviewButtonsOnEditorUI(EditorUI* ui) {
-    static_cast<AIEditorUI*>(ui)->showPreviewButtons();
+    auto* aui = static_cast<AIEditorUI*>(ui);
+    aui->removePreviewButtons();
+    aui->showPreviewButtons();
 }
 
 // Shows the rating popup if the setting is enabled.
-static void showRatingIfEnabled() {
+static void showRatingIfEnabled(const StagingContext& ctx) {
     if (!Mod::get()->getSettingValue<bool>("enable-rating")) return;
     // Rating now lives inline in the overlay's session view (the old
-    // RatingPopup is retired). Flag the latest session and nudge.
-    for (auto it = genSessions().rbegin(); it != genSessions().rend(); ++it) {
+    // RatingPopup is retired). Flag the context's own session (the latest
+    // staged one for a context without an id) and nudge.
+    std::shared_ptr<GenSession> target;
+    for (auto& s : genSessions())
+        if (s && ctx.sessionId != 0 && s->id == ctx.sessionId) { target = s; break; }
+    for (auto it = genSessions().rbegin(); !target && it != genSessions().rend(); ++it) {
         if ((*it)->state == GenSession::State::Staged ||
-            (*it)->state == GenSession::State::Done) {
-            auto& s = *it;
-            s->needsRating = true;
-            s->state = GenSession::State::Done;
-            // Snapshot the feedback data NOW, while the s_last* globals
-            // still describe this generation — by rating time a newer
-            // generation may have overwritten them.
-            s->fbPrompt            = s_lastUserPrompt;
-            s->fbDifficulty        = s_lastDifficulty;
-            s->fbStyle             = s_lastStyle;
-            s->fbLength            = s_lastLength;
-            s->fbObjectsJson       = s_lastGeneratedJson;
-            s->fbEditedObjectsJson = s_lastEditedObjectsJson;
-            s->fbEditSummary       = s_lastEditSummary;
-            s->fbAccepted          = s_lastWasAccepted;
-            break;
-        }
+            (*it)->state == GenSession::State::Done)
+            target = *it;
+    }
+    if (target) {
+        auto& s = target;
+        s->needsRating = true;
+        s->state = GenSession::State::Done;
+        // Snapshot the feedback data NOW — the context is retired and a
+        // follow-up turn will overwrite it before the user rates.
+        s->fbPrompt            = ctx.fb.userPrompt;
+        s->fbDifficulty        = ctx.fb.difficulty;
+        s->fbStyle             = ctx.fb.style;
+        s->fbLength            = ctx.fb.length;
+        s->fbObjectsJson       = ctx.fb.generatedJson;
+        s->fbEditedObjectsJson = ctx.fb.editedObjectsJson;
+        s->fbEditSummary       = ctx.fb.editSummary;
+        s->fbAccepted          = ctx.fb.wasAccepted;
     }
     Notification::create(
 #ifdef GEODE_IS_MOBILE
@@ -16748,11 +22246,12 @@ class $modify(EditorPauseLayer) {
     // the user keeping the editor's current contents (staged preview
     // objects persist the same way), so commit the deletes for real.
     void saveLevel() {
-        if (!s_editOpJournal.empty() && m_editorLayer) {
+        for (auto& ctx : s_stagings) {
+            if (ctx->editOps.empty() || !m_editorLayer) continue;
             log::info("EditorAI: save with {} pending edit ops - committing "
                       "them (soft deletes would not survive the save)",
-                      s_editOpJournal.size());
-            finalizeEditOps(m_editorLayer);
+                      ctx->editOps.size());
+            finalizeEditOps(m_editorLayer, *ctx);
         }
         EditorPauseLayer::saveLevel();
     }
@@ -16766,12 +22265,11 @@ class $modify(EditorPauseLayer) {
                 if (auto previewMenu = editorUI->getChildByID("ai-preview-menu"_spr))
                     previewMenu->setVisible(true);
             }
-            // The playtest ghost is removed on pause but was never put back.
-            if (s_inPreviewMode) {
-                for (auto it = genSessions().rbegin(); it != genSessions().rend(); ++it) {
-                    auto& s = *it;
-                    if (!s || s->state != GenSession::State::Staged || !s->enginePtr)
-                        continue;
+            // The playtest ghost is removed on pause but was never put back
+            // — redraw the one under review.
+            if (auto ctx = focusedStage(); ctx && ctx->inPreview) {
+                for (auto& s : genSessions()) {
+                    if (!s || s->id != ctx->sessionId || !s->enginePtr) continue;
                     static_cast<AIGeneratorPopup*>(s->enginePtr)->redrawPlaytestGhost();
                     break;
                 }
@@ -16785,11 +22283,13 @@ class $modify(EditorPauseLayer) {
 class $modify(AILevelEditorLayer, LevelEditorLayer) {
     void onPlaytest() {
         // Block playtest while ghost objects are awaiting accept/deny/edit
-        if (s_inPreviewMode || s_inEditMode) {
+        if (auto ctx = focusedStage()) {
             Notification::create(
-                s_inEditMode
+                ctx->inEdit
                     ? "Press Done to finish editing first!"
-                    : "Accept, edit, or deny the AI preview first!",
+                    : activeStageCount() > 1
+                        ? "Accept, edit, or deny the staged AI previews first!"
+                        : "Accept, edit, or deny the AI preview first!",
                 NotificationIcon::Warning
             )->show();
             return;
@@ -16801,6 +22301,14 @@ class $modify(AILevelEditorLayer, LevelEditorLayer) {
         }
     }
 
+    // Any removal invalidates the live indexes, whoever makes it: a
+    // delete followed by an add keeps the object count, so the incremental
+    // append path alone would keep serving the removed object.
+    void removeObject(GameObject* obj, bool noUndo) {
+        LevelEditorLayer::removeObject(obj, noUndo);
+        ++s_levelMutationEpoch;
+    }
+
     void onStopPlaytest() {
         LevelEditorLayer::onStopPlaytest();
         if (auto editorUI = this->m_editorUI) {
@@ -16866,7 +22374,8 @@ $on_mod(Loaded) {
     // multi-hundred-KB level dumps, and the magic-static guard inside
     // loadFeedback() makes a concurrent first call from the main thread
     // simply wait instead of double-loading.
-    std::thread([] { loadFeedback(); }).detach();
+    io::post([] { loadFeedback(); });
+    telemetryOutboxResume();
 
     s_bypassCharFilter = Mod::get()->getSettingValue<bool>("bypass-char-filter");
     s_bypassCharLimit  = Mod::get()->getSettingValue<bool>("bypass-char-limit");
@@ -16971,9 +22480,6 @@ static Ref<AIGeneratorPopup> s_pendingManual = nullptr;
 bool editoraiManualCopy(const std::string& prompt, bool replaceContents,
                         std::string& err) {
     if (prompt.empty()) { err = "Type a prompt first."; return false; }
-    if (s_inPreviewMode || s_inEditMode) {
-        err = "Finish the current blueprint preview first."; return false;
-    }
     auto* editor = LevelEditorLayer::get();
     if (!editor) {
         err = "Open a level first - Manual builds into the current editor.";
@@ -17004,10 +22510,6 @@ bool editoraiStartGeneration(int target, const std::string& prompt,
                              bool replaceContents, std::string& err,
                              const std::string& expectedName) {
     if (prompt.empty()) { err = "Type a prompt first."; return false; }
-    if (s_inPreviewMode || s_inEditMode) {
-        err = "Finish the current blueprint preview first.";
-        return false;
-    }
 
     // Current editor: start immediately, headless.
     if (target == -1) {
@@ -17082,6 +22584,309 @@ bool editoraiStartGeneration(int target, const std::string& prompt,
     return true;
 }
 
+// ─── Batch generation queue ──────────────────────────────────────────────────
+// Unattended dataset runs: a list of jobs (prompt + difficulty/style/length +
+// provider + target level + priority), loaded from <save dir>/batch.json or
+// added from the overlay, executed by a 1 s scheduler tick. Each provider
+// gets its own concurrency limit (local backends default to 1 — they share
+// one GPU); the highest-priority queued job whose provider has a free slot
+// starts next, FIFO within a priority. Jobs run as ordinary headless
+// sessions with no editor attached, so results park as AwaitingEditor on
+// their target level exactly like any off-editor generation. Main thread
+// only.
+
+static std::vector<BatchJob>             s_batchJobs;
+static std::map<std::string, int>        s_batchLimits;   // per-provider overrides
+static bool                              s_batchPaused = false;
+static int                               s_batchNextId = 1;
+static int64_t                           s_batchEpoch  = 0;   // first start of this run
+
+static int64_t batchNow() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static int batchProviderLimit(const std::string& provider) {
+    if (auto it = s_batchLimits.find(provider); it != s_batchLimits.end())
+        return std::max(1, it->second);
+    if (isLocalProvider(provider)) return 1;
+    return (int)std::clamp<int64_t>(
+        Mod::get()->getSettingValue<int64_t>("batch-concurrency"), 1, 8);
+}
+
+const char* BatchJob::stateName() const {
+    switch (state) {
+        case State::Queued:    return "queued";
+        case State::Running:   return "running";
+        case State::Done:      return "done";
+        case State::Failed:    return "failed";
+        case State::Cancelled: return "cancelled";
+    }
+    return "?";
+}
+
+// Resolve (or create) the job's target level. Empty name = a fresh level.
+static GJGameLevel* batchResolveLevel(const BatchJob& job) {
+    if (job.targetLevelName.empty()) {
+        auto* glm = GameLevelManager::sharedState();
+        auto* level = glm ? glm->createNewLevel() : nullptr;
+        if (level) level->m_levelName = fmt::format("AI Batch {}", job.id);
+        return level;
+    }
+    auto* llm = LocalLevelManager::get();
+    if (!llm || !llm->m_localLevels) return nullptr;
+    for (auto* raw : CCArrayExt<CCObject*>(llm->m_localLevels)) {
+        auto* lvl = typeinfo_cast<GJGameLevel*>(raw);
+        if (lvl && std::string(lvl->m_levelName) == job.targetLevelName) return lvl;
+    }
+    return nullptr;
+}
+
+static void batchFinish(BatchJob& job, BatchJob::State st, std::string error = "") {
+    job.state      = st;
+    job.finishedAt = batchNow();
+    job.error      = std::move(error);
+    int64_t secs = job.startedAt > 0 ? job.finishedAt - job.startedAt : 0;
+    log::info("Batch job #{} {} after {}s{}", job.id, job.stateName(), secs,
+              job.error.empty() ? "" : " - " + job.error);
+    for (auto& s : genSessions()) {
+        if (!s || s->id != job.sessionId) continue;
+        s->push(GenSession::Entry::Kind::Status,
+                fmt::format("Batch job #{} {} in {}m{:02d}s", job.id,
+                            job.stateName(), secs / 60, secs % 60));
+        break;
+    }
+}
+
+static bool batchStart(BatchJob& job) {
+    // The rate gate may have closed since batchTick checked it; the job
+    // simply stays Queued for a later tick instead of starting a doomed
+    // engine.
+    if (rateLimitRemaining() > 0) return false;
+    if (job.provider.empty())
+        job.provider = Mod::get()->getSettingValue<std::string>("ai-provider");
+    if (job.provider == "manual") {
+        batchFinish(job, BatchJob::State::Failed,
+                    "the manual provider needs a human - pick an API provider");
+        return false;
+    }
+    std::string apiKey = getProviderApiKey(job.provider);
+    if (apiKey.empty() && !isLocalProvider(job.provider) && job.provider != "custom") {
+        batchFinish(job, BatchJob::State::Failed,
+                    fmt::format("no API key for {}", job.provider));
+        return false;
+    }
+    GJGameLevel* level = batchResolveLevel(job);
+    if (!level) {
+        batchFinish(job, BatchJob::State::Failed,
+                    fmt::format("level '{}' not found", job.targetLevelName));
+        return false;
+    }
+    // Stage straight in if the target's editor happens to be open.
+    auto* editor = LevelEditorLayer::get();
+    if (editor && editor->m_level != level) editor = nullptr;
+    auto* engine = AIGeneratorPopup::create(editor);
+    if (!engine) {
+        batchFinish(job, BatchJob::State::Failed, "engine creation failed");
+        return false;
+    }
+    auto sess = engine->sessionPtr();
+    sess->targetLevel     = level;
+    sess->targetLevelName = level->m_levelName;
+    std::string t = job.prompt;
+    if (t.size() > 32) { GenSession::utf8Trim(t, 31); t += "…"; }
+    sess->title = fmt::format("[batch #{}] {}", job.id, t);
+    sess->push(GenSession::Entry::Kind::Status,
+        fmt::format("Batch job #{} (priority {}, {}, {}/{}/{}) -> '{}'",
+                    job.id, job.priority, job.provider,
+                    job.difficulty.empty() ? "-" : job.difficulty,
+                    job.style.empty()      ? "-" : job.style,
+                    job.length.empty()     ? "-" : job.length,
+                    std::string(level->m_levelName)));
+    job.state     = BatchJob::State::Running;
+    job.sessionId = sess->id;
+    job.startedAt = batchNow();
+    if (s_batchEpoch == 0) s_batchEpoch = job.startedAt;
+    if (!engine->startBatch(job, apiKey)) {
+        batchFinish(job, BatchJob::State::Failed, "generation did not start");
+        return false;
+    }
+    return true;
+}
+
+static void batchTick() {
+    // Reap: a job is finished once its session leaves Running.
+    for (auto& job : s_batchJobs) {
+        if (job.state != BatchJob::State::Running) continue;
+        std::shared_ptr<GenSession> sess;
+        for (auto& s : genSessions())
+            if (s && s->id == job.sessionId) { sess = s; break; }
+        if (!sess) { batchFinish(job, BatchJob::State::Failed, "session removed"); continue; }
+        if (sess->state == GenSession::State::Running) continue;
+        if (sess->state == GenSession::State::Failed) {
+            // The reason is among the last few entries; at() past the ring
+            // would page spilled history back in from disk.
+            std::string why = "generation failed";
+            size_t n = sess->transcript.size();
+            for (size_t i = n; i-- > (n > 8 ? n - 8 : 0);) {
+                auto& e = sess->transcript.at(i);
+                if (e.kind == GenSession::Entry::Kind::Error) { why = e.text; break; }
+            }
+            batchFinish(job, BatchJob::State::Failed, why);
+        } else {
+            batchFinish(job, BatchJob::State::Done);
+        }
+    }
+    if (s_batchPaused) return;
+
+    std::map<std::string, int> running;
+    for (auto& job : s_batchJobs)
+        if (job.state == BatchJob::State::Running) ++running[job.provider];
+
+    while (true) {
+        // Starts pass the same gate as interactive generations.
+        if (rateLimitRemaining() > 0) return;
+        std::string current = Mod::get()->getSettingValue<std::string>("ai-provider");
+        BatchJob* pick = nullptr;
+        for (auto& job : s_batchJobs) {
+            if (job.state != BatchJob::State::Queued) continue;
+            const std::string& p = job.provider.empty() ? current : job.provider;
+            if (running[p] >= batchProviderLimit(p)) continue;
+            if (!pick || job.priority > pick->priority) pick = &job;   // FIFO on ties
+        }
+        if (!pick) return;
+        if (batchStart(*pick)) ++running[pick->provider];
+    }
+}
+
+class BatchPump : public CCObject {
+public:
+    void tick(float) { batchTick(); }
+};
+
+static void ensureBatchPump() {
+    static BatchPump* pump = nullptr;
+    if (pump) return;
+    pump = new BatchPump();   // lives for the process, like the scheduler
+    CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
+        schedule_selector(BatchPump::tick), pump, 1.f, false);
+}
+
+int editoraiBatchEnqueue(BatchJob job) {
+    if (job.prompt.empty()) return 0;
+    job.id       = s_batchNextId++;
+    job.state    = BatchJob::State::Queued;
+    job.queuedAt = batchNow();
+    bool idle = std::none_of(s_batchJobs.begin(), s_batchJobs.end(), [](auto& j) {
+        return j.state == BatchJob::State::Queued || j.state == BatchJob::State::Running;
+    });
+    if (idle) s_batchEpoch = 0;   // a new run: throughput restarts
+    s_batchJobs.push_back(std::move(job));
+    ensureBatchPump();
+    return s_batchJobs.back().id;
+}
+
+// <save dir>/batch.json — either a bare array of jobs or
+// {"limits": {"openai": 4}, "defaults": {...job fields...}, "jobs": [...]}.
+// Job fields: prompt (required), difficulty, style, length, provider,
+// level (local level name; omitted = a fresh level per job), replace,
+// priority, repeat (enqueue N copies).
+int editoraiBatchLoadFile(std::string& err) {
+    auto path = Mod::get()->getSaveDir() / "batch.json";
+    auto text = utils::file::readString(path);
+    if (!text) {
+        err = fmt::format("Couldn't read {}", utils::string::pathToString(path));
+        return 0;
+    }
+    auto parsed = matjson::parse(text.unwrap());
+    if (!parsed) { err = "batch.json is not valid JSON"; return 0; }
+    auto root = parsed.unwrap();
+    matjson::Value jobs = root, defaults = matjson::Value::object();
+    if (root.isObject()) {
+        jobs     = root["jobs"];
+        defaults = root.contains("defaults") ? root["defaults"] : defaults;
+        if (root.contains("limits") && root["limits"].isObject())
+            for (auto& [prov, v] : root["limits"])
+                s_batchLimits[prov] = (int)v.asInt().unwrapOr(1);
+    }
+    if (!jobs.isArray()) { err = "batch.json has no job list"; return 0; }
+    auto field = [&](const matjson::Value& j, const char* key) -> std::string {
+        if (j.contains(key)) return j[key].asString().unwrapOr("");
+        return defaults.contains(key) ? defaults[key].asString().unwrapOr("") : "";
+    };
+    int added = 0;
+    for (auto& j : jobs) {
+        if (!j.isObject()) continue;
+        BatchJob job;
+        job.prompt          = field(j, "prompt");
+        job.difficulty      = field(j, "difficulty");
+        job.style           = field(j, "style");
+        job.length          = field(j, "length");
+        job.provider        = field(j, "provider");
+        job.targetLevelName = field(j, "level");
+        job.replaceContents = j.contains("replace") ? j["replace"].asBool().unwrapOr(false)
+                                                    : defaults["replace"].asBool().unwrapOr(false);
+        job.priority        = (int)(j.contains("priority") ? j["priority"] : defaults["priority"])
+                                  .asInt().unwrapOr(0);
+        int repeat = (int)std::clamp<int64_t>(j["repeat"].asInt().unwrapOr(1), 1, 500);
+        for (int r = 0; r < repeat; ++r)
+            if (editoraiBatchEnqueue(job)) ++added;
+    }
+    if (added == 0) err = "batch.json contained no jobs with a prompt";
+    log::info("Batch: loaded {} job(s) from batch.json", added);
+    return added;
+}
+
+std::vector<BatchJob> editoraiBatchJobs() { return s_batchJobs; }
+
+BatchStats editoraiBatchStats() {
+    BatchStats st;
+    st.paused = s_batchPaused;
+    int64_t doneSecs = 0;
+    for (auto& j : s_batchJobs) {
+        switch (j.state) {
+            case BatchJob::State::Queued:  ++st.queued; break;
+            case BatchJob::State::Running: ++st.running; break;
+            case BatchJob::State::Done:
+                ++st.done;
+                doneSecs += j.finishedAt - j.startedAt;
+                break;
+            case BatchJob::State::Failed:  ++st.failed; break;
+            default: break;
+        }
+    }
+    if (st.done > 0) st.avgSeconds = (double)doneSecs / st.done;
+    if (s_batchEpoch > 0 && st.done > 0) {
+        // Floor the window at a minute so the first finish doesn't read
+        // as thousands of levels/hour.
+        double hours = std::max<int64_t>(batchNow() - s_batchEpoch, 60) / 3600.0;
+        st.levelsPerHour = st.done / hours;
+    }
+    return st;
+}
+
+void editoraiBatchCancel(int jobId) {
+    for (auto& j : s_batchJobs) {
+        if (j.id != jobId) continue;
+        if (j.state == BatchJob::State::Queued) {
+            j.state = BatchJob::State::Cancelled;
+        } else if (j.state == BatchJob::State::Running) {
+            for (auto& s : genSessions())
+                if (s && s->id == j.sessionId) { editoraiCancelSession(s); break; }
+            batchFinish(j, BatchJob::State::Cancelled);
+        }
+        return;
+    }
+}
+
+void editoraiBatchSetPaused(bool paused) { s_batchPaused = paused; }
+
+void editoraiBatchClearFinished() {
+    s_batchJobs.erase(std::remove_if(s_batchJobs.begin(), s_batchJobs.end(), [](auto& j) {
+        return j.state != BatchJob::State::Queued && j.state != BatchJob::State::Running;
+    }), s_batchJobs.end());
+}
+
 bool editoraiGoToSessionLevel(const std::shared_ptr<GenSession>& session) {
     if (!session || !session->targetLevel) return false;
     if (s_gotoTransitionPending) return false;
@@ -17108,50 +22913,353 @@ bool editoraiGoToSessionLevel(const std::shared_ptr<GenSession>& session) {
 // self-rating attached) and once more when the user rates it. Payload is
 // prompt + settings + ratings + the generated level — no keys, no identity.
 static async::TaskHolder<web::WebResponse> s_shareTask;
-static async::TaskHolder<web::WebResponse> s_autoContribTask;
-static bool        s_autoContribInFlight = false;
-static std::string s_autoContribPending;   // one-slot queue: newest wins
 
-static void autoContribSend(std::string body);  // fwd (self-chaining)
+// Uploads go through a persistent outbox (telemetry-outbox.json): contributions
+// queue on disk, leave in batches as one gzip'd request, retry with backoff,
+// and survive restarts — the old one-slot in-memory queue dropped anything
+// produced offline or in a burst. The completion upload and the rating
+// re-upload of the same generation coalesce while both are still queued.
+namespace outbox {
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t MAX_ITEMS       = 400;               // disk cap: oldest drop past it
+static constexpr size_t MAX_BYTES       = 6u << 20;
+static constexpr size_t BATCH_ITEMS     = 16;
+static constexpr size_t BATCH_BYTES     = 1u << 20;          // raw JSON per request
+static constexpr auto   LINGER          = std::chrono::seconds(30);    // let a burst fill a batch
+static constexpr auto   MAX_DEFER       = std::chrono::minutes(5);     // busy-editor postponement cap
+static constexpr int    BACKOFF_BASE_S  = 15;
+static constexpr int    BACKOFF_MAX_S   = 30 * 60;
+
+struct Item {
+    std::string    key;        // prompt+objects hash — coalesces re-uploads
+    matjson::Value body;       // v2 contribution object
+    size_t         bytes = 0;  // dumped size
+};
+
+struct Stats {
+    int64_t sent = 0, batches = 0, merged = 0, dropped = 0, failures = 0;
+    int64_t rejected = 0;      // refused by the collector for good (4xx), not retried
+    int64_t rawBytes = 0, wireBytes = 0;
+};
+
+static std::deque<Item> s_items;
+static size_t           s_bytes     = 0;
+static size_t           s_inflight  = 0;      // front items riding the open request
+static Stats            s_stats;
+static bool             s_loaded    = false;
+static bool             s_legacy    = false;  // collector rejected batches this run
+static size_t           s_batchCap  = BATCH_ITEMS;  // halved per 413 this run
+static int              s_fails     = 0;      // consecutive, drives the backoff
+static std::string      s_lastError;
+static Clock::time_point s_nextTry{}, s_oldestAt{};
+static async::TaskHolder<web::WebResponse> s_task;
+
+static std::filesystem::path path() {
+    return Mod::get()->getSaveDir() / "telemetry-outbox.json";
+}
+
+static std::string keyOf(const matjson::Value& body) {
+    size_t h = std::hash<std::string>{}(body["prompt"].asString().unwrapOr(""));
+    h ^= std::hash<std::string>{}(body["objects"].asString().unwrapOr("")) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return fmt::format("{:016x}", (uint64_t)h);
+}
+
+// Queued contributions can't be regenerated, so the outbox is fsynced.
+static void persist() {
+    auto items = matjson::Value::array();
+    for (auto& it : s_items) {
+        auto o = matjson::Value::object();
+        o["key"]  = it.key;
+        o["body"] = it.body;
+        items.push(std::move(o));
+    }
+    auto stats = matjson::Value::object();
+    stats["sent"]       = s_stats.sent;
+    stats["batches"]    = s_stats.batches;
+    stats["merged"]     = s_stats.merged;
+    stats["dropped"]    = s_stats.dropped;
+    stats["failures"]   = s_stats.failures;
+    stats["rejected"]   = s_stats.rejected;
+    stats["raw_bytes"]  = s_stats.rawBytes;
+    stats["wire_bytes"] = s_stats.wireBytes;
+    auto root = matjson::Value::object();
+    root["items"] = std::move(items);
+    root["stats"] = std::move(stats);
+
+    io::write(path(),
+              [root = std::move(root)] { return root.dump(matjson::NO_INDENTATION); },
+              io::Durability::Synced);
+}
+
+static void load() {
+    if (s_loaded) return;
+    s_loaded = true;
+    auto read = geode::utils::file::readString(path());
+    if (!read) return;
+    auto parsed = matjson::parse(read.unwrap());
+    if (!parsed) return;
+    const auto root = parsed.unwrap();
+    const auto& stats = root["stats"];
+    s_stats.sent      = stats["sent"].asInt().unwrapOr(0);
+    s_stats.batches   = stats["batches"].asInt().unwrapOr(0);
+    s_stats.merged    = stats["merged"].asInt().unwrapOr(0);
+    s_stats.dropped   = stats["dropped"].asInt().unwrapOr(0);
+    s_stats.failures  = stats["failures"].asInt().unwrapOr(0);
+    s_stats.rejected  = stats["rejected"].asInt().unwrapOr(0);
+    s_stats.rawBytes  = stats["raw_bytes"].asInt().unwrapOr(0);
+    s_stats.wireBytes = stats["wire_bytes"].asInt().unwrapOr(0);
+    const auto& items = root["items"];
+    if (!items.isArray()) return;
+    for (const auto& o : items) {
+        if (!o["body"].isObject()) continue;
+        Item it;
+        it.key   = o["key"].asString().unwrapOr("");
+        it.body  = o["body"];
+        it.bytes = it.body.dump(matjson::NO_INDENTATION).size();
+        s_bytes += it.bytes;
+        s_items.push_back(std::move(it));
+    }
+    // Restored items are old by definition — no need to linger again.
+    s_oldestAt = Clock::now() - LINGER;
+}
+
+// Cap enforcement — the oldest queued (not in-flight) contributions go first.
+static void trim() {
+    while ((s_items.size() > MAX_ITEMS || s_bytes > MAX_BYTES) && s_items.size() > s_inflight) {
+        s_bytes -= s_items[s_inflight].bytes;
+        s_items.erase(s_items.begin() + s_inflight);
+        ++s_stats.dropped;
+    }
+}
+
+static void schedule(bool failed, const std::string& why = {}) {
+    if (!failed) {
+        s_fails = 0;
+        s_nextTry = {};
+        return;
+    }
+    ++s_fails;
+    ++s_stats.failures;
+    s_lastError = why;
+    int delay = std::min(BACKOFF_MAX_S, BACKOFF_BASE_S << std::min(s_fails - 1, 10));
+    s_nextTry = Clock::now() + std::chrono::seconds(delay);
+    log::info("Telemetry upload deferred {}s ({})", delay, why);
+}
+
+static void finish(size_t n, size_t rawBytes, size_t wireBytes) {
+    for (size_t k = 0; k < n && !s_items.empty(); ++k) {
+        s_bytes -= s_items.front().bytes;
+        s_items.pop_front();
+    }
+    s_stats.sent      += (int64_t)n;
+    s_stats.batches   += 1;
+    s_stats.rawBytes  += (int64_t)rawBytes;
+    s_stats.wireBytes += (int64_t)wireBytes;
+    s_lastError.clear();
+    // A backlog is already old: the next batch goes on the next tick.
+    s_oldestAt = s_items.empty() ? Clock::now() : Clock::now() - LINGER;
+    schedule(false);
+}
+
+// The front item was refused for what it is (too large, malformed) — a
+// retry can only fail the same way, so it leaves the queue instead of
+// blocking everything behind it.
+static void reject(int code) {
+    if (s_items.empty()) return;
+    log::warn("Collector refused a telemetry contribution for good (HTTP {}); dropping it", code);
+    s_bytes -= s_items.front().bytes;
+    s_items.pop_front();
+    ++s_stats.rejected;
+    s_oldestAt = s_items.empty() ? Clock::now() : Clock::now() - LINGER;
+    schedule(false);
+}
+
+static bool permanentRefusal(int code) { return code == 400 || code == 413 || code == 422; }
 
-static void autoContribSend(std::string body) {
-    s_autoContribInFlight = true;
+// Collectors that predate batching get the old one-object-per-request body.
+static void sendLegacy() {
+    s_inflight = 1;
+    std::string body = s_items.front().body.dump();
+    size_t size = body.size();
     auto request = web::WebRequest();
     request.header("Content-Type", "application/json");
-    request.timeout(std::chrono::seconds(10));
+    request.timeout(std::chrono::seconds(15));
     request.bodyString(body);
-    s_autoContribTask.spawn(
-        request.post("http://sn-1.vltgg.net:21800/api/contribute"),
-        [](web::WebResponse resp) {
-            s_autoContribInFlight = false;
-            if (!resp.ok())
-                log::info("Telemetry upload skipped (collector said {})", resp.code());
-            if (!s_autoContribPending.empty()) {
-                std::string next = std::move(s_autoContribPending);
-                s_autoContribPending.clear();
-                autoContribSend(std::move(next));
-            }
-        });
+    s_task.spawn(request.post(platinum::pick() + "/api/contribute"), [size](web::WebResponse resp) {
+        s_inflight = 0;
+        int code = resp.code();
+        if (resp.ok()) finish(1, size, size);
+        else if (permanentRefusal(code)) reject(code);
+        else schedule(true, code > 0 ? fmt::format("HTTP {}", code) : std::string("unreachable"));
+        persist();
+    });
+}
+
+static void send() {
+    if (s_items.empty() || s_inflight) return;
+    if (s_legacy) { sendLegacy(); return; }
+    auto arr = matjson::Value::array();
+    size_t n = 0, raw = 0;
+    while (n < s_items.size() && n < s_batchCap &&
+           (n == 0 || raw + s_items[n].bytes <= BATCH_BYTES)) {
+        arr.push(s_items[n].body);
+        raw += s_items[n].bytes;
+        ++n;
+    }
+    // ZipUtils::compressString = gzip + URL-safe base64, GD's own level-string
+    // encoding. Level dumps are repetitive JSON, so this is ~8-10x smaller.
+    std::string packed = cocos2d::ZipUtils::compressString(
+        gd::string(arr.dump(matjson::NO_INDENTATION)), false, 0);
+    auto env = matjson::Value::object();
+    env["v"]        = 3;
+    env["count"]    = (int)n;
+    env["encoding"] = "gzip+base64url";
+    env["batch"]    = packed;
+    std::string body = env.dump(matjson::NO_INDENTATION);
+    size_t wire = body.size();
+
+    s_inflight = n;
+    auto request = web::WebRequest();
+    request.header("Content-Type", "application/json");
+    request.timeout(std::chrono::seconds(30));
+    request.bodyString(body);
+    s_task.spawn(request.post(platinum::pick() + "/api/contribute"), [n, raw, wire](web::WebResponse resp) {
+        s_inflight = 0;
+        int code = resp.code();
+        if (resp.ok()) {
+            finish(n, raw, wire);
+        } else if (code == 413 && n > 1) {
+            // Too large, not unsupported: halve the batch and go again.
+            s_batchCap = std::max<size_t>(1, n / 2);
+            log::info("Collector refused a {}-item batch as too large; retrying {} at a time",
+                      n, s_batchCap);
+            Loader::get()->queueInMainThread([] { send(); });
+        } else if (code == 413) {
+            reject(code);                      // one contribution alone is over the limit
+        } else if (code == 400 || code == 404 || code == 415 || code == 422) {
+            // The collector understood the request and refused the envelope
+            // — not an outage. Fall back to single uploads for this run.
+            log::info("Collector rejected batched telemetry (HTTP {}); sending singly", code);
+            s_legacy = true;
+            Loader::get()->queueInMainThread([] { send(); });
+        } else {
+            schedule(true, code > 0 ? fmt::format("HTTP {}", code) : std::string("unreachable"));
+        }
+        persist();
+    });
+}
+
+// Idle = no generation streaming; uploads don't compete with it.
+static bool busy() {
+    for (auto& s : genSessions())
+        if (s && s->state == GenSession::State::Running) return true;
+    return false;
+}
+
+static void tick() {
+    load();
+    if (s_items.empty() || s_inflight) return;
+    if (!Mod::get()->getSettingValue<bool>("allow-telemetry")) {
+        // Consent withdrawn: queued contributions are never uploaded.
+        s_items.clear();
+        s_bytes = 0;
+        persist();
+        return;
+    }
+    auto now = Clock::now();
+    if (now < s_nextTry) return;
+    bool full = s_items.size() >= BATCH_ITEMS;
+    if (!full && now - s_oldestAt < LINGER) return;
+    if (busy() && now - s_oldestAt < MAX_DEFER) return;
+    send();
+}
+
+class Pump : public CCObject {
+public:
+    void tick(float) { outbox::tick(); }
+};
+
+static void ensurePump() {
+    static Pump* pump = nullptr;
+    if (pump) return;
+    pump = new Pump();   // lives for the process, like the batch pump
+    CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
+        schedule_selector(Pump::tick), pump, 1.f, false);
+}
+
+static void enqueue(matjson::Value body) {
+    load();
+    Item it;
+    it.key   = keyOf(body);
+    it.bytes = body.dump(matjson::NO_INDENTATION).size();
+    // Same generation still queued (not yet in flight): the newer upload
+    // supersedes it, keeping the self-rating the rated re-upload lacks.
+    for (size_t k = s_inflight; k < s_items.size(); ++k) {
+        auto& old = s_items[k];
+        if (old.key != it.key) continue;
+        if (body["ai_rating"].asInt().unwrapOr(0) == 0)
+            body["ai_rating"] = old.body["ai_rating"].asInt().unwrapOr(0);
+        s_bytes -= old.bytes;
+        s_items.erase(s_items.begin() + k);
+        ++s_stats.merged;
+        break;
+    }
+    if (s_items.size() <= s_inflight) s_oldestAt = Clock::now();
+    it.body = std::move(body);
+    s_bytes += it.bytes;
+    s_items.push_back(std::move(it));
+    trim();
+    persist();
+    ensurePump();
+}
+
+static std::string summary() {
+    load();
+    std::string s = fmt::format("Telemetry outbox: {} queued ({:.0f} KB)",
+                                s_items.size(), s_bytes / 1024.0);
+    if (s_stats.batches > 0)
+        s += fmt::format(" | sent {} in {} batches, {:.0f}->{:.0f} KB",
+                         s_stats.sent, s_stats.batches,
+                         s_stats.rawBytes / 1024.0, s_stats.wireBytes / 1024.0);
+    if (s_stats.merged || s_stats.dropped)
+        s += fmt::format(" | {} merged, {} dropped", s_stats.merged, s_stats.dropped);
+    if (s_stats.rejected)
+        s += fmt::format(" | {} refused by the collector", s_stats.rejected);
+    if (s_nextTry > Clock::now())
+        s += fmt::format(" | retry in {}s ({})",
+            std::chrono::duration_cast<std::chrono::seconds>(s_nextTry - Clock::now()).count(),
+            s_lastError);
+    return s;
+}
+
+} // namespace outbox
+
+static void telemetryOutboxResume() {
+    // First tick loads the file; anything left from the last run goes out
+    // once the collector is reachable.
+    Loader::get()->queueInMainThread([] {
+        outbox::load();
+        if (!outbox::s_items.empty()) outbox::ensurePump();
+    });
 }
 
-static void autoContributeGeneration(int userRating) {
+static std::string telemetryOutboxSummary() { return outbox::summary(); }
+
+static void autoContributeGeneration(const GenerationFeedback& fb, int userRating) {
     if (!Mod::get()->getSettingValue<bool>("allow-telemetry")) return;
-    if (s_lastGeneratedJson.empty() || s_lastUserPrompt.empty()) return;
+    if (fb.generatedJson.empty() || fb.userPrompt.empty()) return;
     auto body = matjson::Value::object();
     body["v"]          = 2;
     body["rating"]     = userRating;          // 0 = not (yet) user-rated
-    body["ai_rating"]  = s_lastSelfRating;    // self-review score, 0 if none
-    body["prompt"]     = s_lastUserPrompt;
-    body["difficulty"] = s_lastDifficulty;
-    body["style"]      = s_lastStyle;
-    body["length"]     = s_lastLength;
-    body["objects"]    = s_lastGeneratedJson;
-    std::string dump = body.dump();
-    if (s_autoContribInFlight) {
-        s_autoContribPending = std::move(dump);  // newest wins; older drop
-        return;
-    }
-    autoContribSend(std::move(dump));
+    body["ai_rating"]  = fb.selfRating;       // self-review score, 0 if none
+    body["prompt"]     = fb.userPrompt;
+    body["difficulty"] = fb.difficulty;
+    body["style"]      = fb.style;
+    body["length"]     = fb.length;
+    body["objects"]    = fb.generatedJson;
+    outbox::enqueue(std::move(body));
 }
 
 void editoraiRateSession(const std::shared_ptr<GenSession>& session, int rating) {
@@ -17172,14 +23280,11 @@ void editoraiRateSession(const std::shared_ptr<GenSession>& session, int rating)
     entry.timestamp         = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
     saveFeedbackEntry(entry);
-    s_lastEditSummary.clear();
-    s_lastEditedObjectsJson.clear();
     session->push(GenSession::Entry::Kind::Status,
                   fmt::format("Rated {}/10 - thanks!", rating));
 
     // Telemetry ON: re-upload with the human verdict attached — built from
-    // THIS session's snapshot (the s_last* globals may already describe a
-    // newer generation).
+    // THIS session's snapshot (its staging context is long retired).
     if (Mod::get()->getSettingValue<bool>("allow-telemetry") &&
         !session->fbObjectsJson.empty() && !session->fbPrompt.empty()) {
         auto body = matjson::Value::object();
@@ -17191,10 +23296,8 @@ void editoraiRateSession(const std::shared_ptr<GenSession>& session, int rating)
         body["style"]      = session->fbStyle;
         body["length"]     = session->fbLength;
         body["objects"]    = session->fbObjectsJson;
-        std::string dump = body.dump();
-        if (s_autoContribInFlight) s_autoContribPending = std::move(dump);
-        else                       autoContribSend(std::move(dump));
-        session->fbShared = true;   // collector has it — retire any Share UI
+        outbox::enqueue(std::move(body));
+        session->fbShared = true;   // queued for the collector — retire any Share UI
     }
 }
 
@@ -17231,6 +23334,14 @@ void editoraiSetSavedInt(const char* key, int64_t v) {
     Mod::get()->setSavedValue<int64_t>(key, v);
 }
 
+bool editoraiExportTrace(std::string& pathOut, std::string& err) {
+    return trace::exportToFile(pathOut, err);
+}
+
+std::string editoraiParserSelfTest() {
+    return easParallelSelfTest() + "\n" + easCompactSelfTest();
+}
+
 bool editoraiShareSession(const std::shared_ptr<GenSession>& session,
                           std::string& err) {
     if (!session) { err = "No session."; return false; }
@@ -17262,7 +23373,7 @@ bool editoraiShareSession(const std::shared_ptr<GenSession>& session,
     request.timeout(std::chrono::seconds(10));
     request.bodyString(body.dump());
     s_shareTask.spawn(
-        request.post("http://sn-1.vltgg.net:21800/api/contribute"),
+        request.post(platinum::pick() + "/api/contribute"),
         [session](web::WebResponse resp) {
             s_shareInFlight = false;
             if (resp.ok()) {
@@ -17485,7 +23596,6 @@ void editoraiOAuthTick(float dt) {
 bool editoraiOpenGenerator() {
     auto* editor = LevelEditorLayer::get();
     if (!editor) return false;
-    if (s_inPreviewMode || s_inEditMode) return false;
     AIGeneratorPopup::create(editor)->show();
     return true;
 }
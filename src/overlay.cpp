@@ -120,6 +120,9 @@ struct OverlayState {
     // session only once the editor opens — until a session with id beyond
     // this marker appears, the chat pane must not latch onto an OLD session.
     int  pendingSelectAfter = -1;
+    // Batch queue composer inputs.
+    int  batchPriority = 0;
+    int  batchRepeat   = 1;
 };
 OverlayState g_st;
 float g_animT = 0.f;                // panel open/close animation (0..1)
@@ -558,10 +561,138 @@ void renderEntry(const GenSession::Entry& e, int idx) {
     ImGui::PopID();
 }
 
+// Virtualized transcript: only on-screen entries are laid out. Entries vary
+// in height (wrapped cards, tree nodes), so instead of ImGuiListClipper's
+// uniform-height stepping each entry's last measured height is cached and
+// prefix-summed — the visible range is two binary searches, everything else
+// is skipped with SetCursorPosY. Unseen entries start at one line and are
+// corrected the first time they're drawn (or re-measured on a wrap-width
+// change); spilled entries are only paged in from disk when scrolled to.
+struct TranscriptView {
+    std::vector<float> heights;   // per global entry index
+    std::vector<float> prefix;    // prefix[i] = sum of heights[0, i)
+    size_t dirtyFrom = 0;         // prefix valid below this index
+};
+std::unordered_map<int, TranscriptView> g_transcriptViews;
+
+// Drop the views of sessions that are gone (cleared here, evicted by the
+// engine's cap, or removed by the batch queue). A handful of entries —
+// checked every frame the chat tab draws.
+void pruneTranscriptViews(const std::vector<std::shared_ptr<GenSession>>& sessions) {
+    for (auto it = g_transcriptViews.begin(); it != g_transcriptViews.end();) {
+        bool live = std::any_of(sessions.begin(), sessions.end(),
+                                [&](auto& s) { return s && s->id == it->first; });
+        it = live ? std::next(it) : g_transcriptViews.erase(it);
+    }
+}
+
+void renderTranscript(const GenSession& s) {
+    auto& v = g_transcriptViews[s.id];
+    const auto& tr = s.transcript;
+    size_t n = tr.size();
+    if (v.heights.size() > n) v = {};   // defensive: transcripts only grow
+    if (v.heights.size() < n) {
+        v.dirtyFrom = std::min(v.dirtyFrom, v.heights.size());
+        v.heights.resize(n, ImGui::GetTextLineHeightWithSpacing());
+    }
+    if (v.dirtyFrom < n || v.prefix.size() != n + 1) {
+        v.prefix.resize(n + 1);
+        v.prefix[0] = 0.f;
+        for (size_t i = v.dirtyFrom; i < n; ++i)
+            v.prefix[i + 1] = v.prefix[i] + v.heights[i];
+        v.dirtyFrom = n;
+    }
+
+    float originY = ImGui::GetCursorPosY();
+    float viewTop = ImGui::GetScrollY() - originY;
+    float viewBot = viewTop + ImGui::GetWindowHeight();
+    // First entry ending below the viewport top .. first starting below
+    // its bottom.
+    size_t first = std::upper_bound(v.prefix.begin() + 1, v.prefix.end(), viewTop)
+                   - (v.prefix.begin() + 1);
+    size_t last  = std::lower_bound(v.prefix.begin(), v.prefix.end(), viewBot)
+                   - v.prefix.begin();
+    first = std::min(first, n);
+    last  = std::clamp(last, first, n);
+
+    ImGui::SetCursorPosY(originY + v.prefix[first]);
+    for (size_t i = first; i < last; ++i) {
+        float y0 = ImGui::GetCursorPosY();
+        renderEntry(tr.at(i), (int)i);
+        float h = ImGui::GetCursorPosY() - y0;
+        if (std::abs(h - v.heights[i]) > 0.5f) {
+            v.heights[i] = h;
+            v.dirtyFrom = std::min(v.dirtyFrom, i);
+        }
+    }
+    // Reserve the full history's height so the scrollbar spans everything.
+    ImGui::SetCursorPosY(originY + v.prefix[n]);
+    ImGui::Dummy(ImVec2(0.f, 0.f));
+}
+
 void composerBody(float dt);   // the "+ new chat" pane (defined below)
 
+// Batch queue summary at the top of the session list: progress, throughput
+// and per-job timing. Hidden while the queue is empty.
+void batchPanel() {
+    auto jobs = editoraiBatchJobs();
+    if (jobs.empty()) return;
+    auto st = editoraiBatchStats();
+    int total = (int)jobs.size();
+    bool open = ImGui::TreeNodeEx("##batch", ImGuiTreeNodeFlags_None, "batch %d/%d",
+                                  st.done + st.failed, total);
+    ImGui::SameLine();
+    ImGui::TextColored(COL_DIM, "%.1f lvl/h", st.levelsPerHour);
+    tipIfHovered(fmt::format("{} queued, {} running, {} done, {} failed\n"
+                             "average {:.0f}s per finished level{}",
+                             st.queued, st.running, st.done, st.failed,
+                             st.avgSeconds, st.paused ? "\n(paused)" : "").c_str());
+    if (!open) { ImGui::Separator(); return; }
+
+    if (ImGui::SmallButton(st.paused ? "resume" : "pause"))
+        editoraiBatchSetPaused(!st.paused);
+    tipIfHovered("Pause stops NEW jobs from starting; running ones finish.");
+    ImGui::SameLine();
+    if (ImGui::SmallButton("clear done")) editoraiBatchClearFinished();
+
+    int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto& j : jobs) {
+        ImGui::PushID(j.id);
+        ImVec4 col =
+            j.state == BatchJob::State::Running ? COL_ACCENT :
+            j.state == BatchJob::State::Failed  ? COL_ERR    : COL_DIM;
+        int64_t secs = j.startedAt == 0 ? 0
+                     : (j.finishedAt ? j.finishedAt : now) - j.startedAt;
+        ImGui::TextColored(col, "#%d %s", j.id, j.stateName());
+        tipIfHovered(fmt::format("priority {}  {}\n{}{}{}", j.priority,
+            j.provider.empty() ? "(current provider)" : j.provider,
+            j.prompt, j.error.empty() ? "" : "\n", j.error).c_str());
+        if (j.startedAt) {
+            ImGui::SameLine();
+            ImGui::TextColored(COL_DIM, "%lldm%02llds",
+                               (long long)(secs / 60), (long long)(secs % 60));
+        }
+        if (j.state == BatchJob::State::Queued || j.state == BatchJob::State::Running) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("x")) editoraiBatchCancel(j.id);
+        } else if (j.sessionId) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("open")) {
+                g_st.selectedSessionId  = j.sessionId;
+                g_st.pendingSelectAfter = -1;
+                g_st.composing = false;
+            }
+        }
+        ImGui::PopID();
+    }
+    ImGui::TreePop();
+    ImGui::Separator();
+}
+
 void tabChat(float dt) {
     auto& sessions = genSessions();
+    pruneTranscriptViews(sessions);
     // No sessions → the composer IS the view. Sync the flag (not just a
     // local) so the first session appearing from any source — copilot
     // included — doesn't silently flip the pane.
@@ -594,6 +725,7 @@ void tabChat(float dt) {
                      "conversation continues right here once it starts.");
         ImGui::Separator();
     }
+    batchPanel();
     if (!sessions.empty()) {
         bool anyFinished = false;
         for (auto& s : sessions)
@@ -702,15 +834,7 @@ void tabChat(float dt) {
     ImGui::BeginChild("transcript", ImVec2(0, -footerH), ImGuiChildFlags_Borders);
     if (sel) {
         bool pinBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY() - 4.f;
-        // Render the newest 150 entries — full 400-entry transcripts cost
-        // real CPU every frame and nobody scrolls that far back.
-        size_t start = sel->transcript.size() > 150
-            ? sel->transcript.size() - 150 : 0;
-        if (start > 0)
-            ImGui::TextColored(COL_DIM, "(%d older entries not shown)",
-                               (int)start);
-        for (size_t i = start; i < sel->transcript.size(); ++i)
-            renderEntry(sel->transcript[i], (int)i);
+        renderTranscript(*sel);
         if (pinBottom) ImGui::SetScrollHereY(1.0f);
     } else {
         ImGui::PushStyleColor(ImGuiCol_Text, COL_DIM);
@@ -1033,6 +1157,56 @@ void composerBody(float dt) {
         ImGui::TextColored(COL_DIM, "describe the level first");
     }
 
+    // Batch queue: park this prompt (with the current difficulty/style/
+    // length/provider pinned) for unattended runs instead of starting it.
+    ImGui::Spacing();
+    ImGui::TextColored(COL_ACCENT, "Batch");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(90.f);
+    ImGui::InputInt("priority##bprio", &g_st.batchPriority);
+    tipIfHovered("Higher-priority jobs start first; equal priorities run in "
+                 "the order they were queued.");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(90.f);
+    if (ImGui::InputInt("x##brep", &g_st.batchRepeat))
+        g_st.batchRepeat = std::clamp(g_st.batchRepeat, 1, 500);
+    tipIfHovered("How many copies of this job to queue.");
+    bool batchable = can && !manualProv && g_st.genTarget != -1;
+    ImGui::BeginDisabled(!batchable);
+    if (ImGui::Button("Add to batch", ImVec2(140, 0))) {
+        BatchJob job;
+        job.prompt     = g_st.genPrompt;
+        job.difficulty = editoraiGetStr("difficulty");
+        job.style      = editoraiGetStr("style");
+        job.length     = editoraiGetStr("length");
+        job.provider   = editoraiGetStr("ai-provider");
+        job.priority   = g_st.batchPriority;
+        if (g_st.genTarget >= 0 && g_st.genTarget < (int)g_st.levels.size()) {
+            job.targetLevelName = g_st.levels[g_st.genTarget].name;
+            job.replaceContents = g_st.genReplace;
+        }
+        for (int r = 0; r < g_st.batchRepeat; ++r) editoraiBatchEnqueue(job);
+    }
+    ImGui::EndDisabled();
+    tipIfHovered(manualProv ? "The manual provider needs you at the keyboard - "
+                              "pick an API provider for batches."
+                 : g_st.genTarget == -1
+                     ? "Batches run without an editor - pick '+ New level' "
+                       "(a fresh level per job) or one of your levels."
+                     : "Queue this prompt; the scheduler runs it when its "
+                       "provider has a free slot.");
+    ImGui::SameLine();
+    if (ImGui::Button("Load batch.json", ImVec2(140, 0))) {
+        std::string err;
+        if (editoraiBatchLoadFile(err) == 0) {
+            g_st.genError = err;
+            g_st.genErrorTtl = 6.f;
+        }
+    }
+    tipIfHovered("Queue every job in batch.json in the mod's save folder: a "
+                 "list of {prompt, difficulty, style, length, provider, "
+                 "level, replace, priority, repeat}.");
+
     if (!g_st.genError.empty()) {
         if (g_st.genErrorTtl > 0.f) {
             g_st.genErrorTtl -= dt;
@@ -1072,9 +1246,17 @@ void tabSettings() {
                 "Routes through the VLT GG-hosted volunteer network instead "
                 "of localhost. Prompts run on donor machines - don't put "
                 "personal info in them.");
+            if (editoraiGetBool("use-platinum"))
+                settingText("coordinators", "platinum-coordinators",
+                    "http://sn-1.vltgg.net:21800", false,
+                    "Comma-separated coordinator URLs. Requests go to the "
+                    "shortest expected wait and fail over between them.", true);
             settingInt("timeout (s)", "ollama-timeout", 60, 1800,
                 "How long to wait for the local/Platinum model before "
                 "giving up. Big models on slow hardware need more.");
+            settingInt("keep loaded (min)", "ollama-keep-alive", 0, 1440,
+                "Preloads the model when the panel opens and keeps it in "
+                "memory between generations. 0 = off.");
         } else if (p == "lm-studio") {
             settingText("server URL", "lm-studio-url", "http://localhost:1234",
                 false, "Where your LM Studio server listens.", true);
@@ -1124,6 +1306,28 @@ void tabSettings() {
             settingText("subagent model", "subagent-model",
                 "empty = provider default", false,
                 "Model the subagent uses.", true);
+        ImGui::Separator();
+        ImGui::TextColored(COL_DIM, "Draft - a local model drafts, the main model patches");
+        static const std::vector<const char*> DRAFT_PROVIDERS = {
+            "", "ollama", "llama-cpp", "lm-studio", "scaffold"};
+        settingCombo("draft", "draft-provider", DRAFT_PROVIDERS,
+            "Fresh levels are drafted by this local model and checked "
+            "locally; the main provider only sends back fixes. Much less "
+            "output from the paid model. scaffold = built-in procedural "
+            "generator, no model and no wait. Empty = off.");
+        if (auto dp = editoraiGetStr("draft-provider"); !dp.empty() && dp != "scaffold")
+            settingText("draft model", "draft-model",
+                "empty = provider default", false,
+                "Model the local drafter uses.", true);
+        ImGui::Separator();
+        static const std::vector<const char*> COMPACTORS = {"subagent", "ollama", "off"};
+        settingCombo("chat memory", "chat-compactor", COMPACTORS,
+            "Long conversations: old turns are condensed into a structured "
+            "memory by this model in the background. 'subagent' needs a "
+            "subagent provider; 'off' just truncates.");
+        settingInt("chat budget", "chat-compact-budget", 4000, 200000,
+            "Characters of conversation kept verbatim before the oldest "
+            "turns get compacted.", ImGuiSliderFlags_Logarithmic);
     }
 
     if (ImGui::CollapsingHeader("Generation")) {
@@ -1139,6 +1343,10 @@ void tabSettings() {
         settingToggle("compact prompts (cheaper)", "compact-prompts",
             "Sends a ~3 KB prompt instead of ~60 KB. Cheaper and faster; "
             "the full prompt knows more object names.");
+        static const std::vector<const char*> DIALECTS = {"auto", "on", "off"};
+        settingCombo("compact script dialect", "eas-compact-dialect", DIALECTS,
+            "Relative x, ground rows, sticky fields and repeats - same "
+            "level, fewer output tokens. auto = hosted models only.");
         settingToggle("AI tools (search, level fetch, analysis)", "enable-ai-tools",
             "Lets the AI call tools mid-generation: web search, downloading "
             "reference levels, physics simulation, passability checks. The AI "
@@ -1155,6 +1363,10 @@ void tabSettings() {
         settingToggle("final self-check", "enable-self-critique",
             "The AI rates its own level 1-10 before staging and applies "
             "fixes for every issue it finds. One extra AI call.");
+        settingToggle("quality passes in parallel", "parallel-quality-passes",
+            "Refinement, decoration and self-check go out together and "
+            "their patches are merged - one round of waiting instead of "
+            "several.");
         settingToggle("vision (model sees the level)", "enable-vision",
             "Image-capable models (Claude, Gemini, GPT-4o, LLaVA...) get a "
             "rendered snapshot of the level on review and follow-up turns - "
@@ -1181,7 +1393,17 @@ void tabSettings() {
             "debugging weird generations.");
         settingToggle("rate limiting", "enable-rate-limiting",
             "Minimum delay between generations, so a double-click can't "
-            "fire two API calls.");
+            "fire two API calls. Also paces every request per provider, "
+            "backing off on 429s and honoring Retry-After.");
+        settingInt("batch concurrency", "batch-concurrency", 1, 8,
+            "How many batch-queue jobs may run at once per cloud provider. "
+            "Local providers run one at a time unless batch.json says "
+            "otherwise.");
+        settingToggle("write closed levels directly", "direct-write",
+            "Generations that finish with no editor open are written "
+            "straight into the level's saved data - no preview, no undo. "
+            "OFF (default) = they wait and stage for review when you open "
+            "that level.");
         settingInt("rate limit (s)", "rate-limit-seconds", 1, 60,
             "Seconds between allowed generations.");
         settingToggle("auto-share generations (opt-in telemetry)", "allow-telemetry",
@@ -1189,6 +1411,31 @@ void tabSettings() {
             "community training collector: prompt + settings + objects + "
             "ratings (yours and the AI's own). Never identity, never keys. "
             "Highly-rated levels train the free community models.");
+        {
+            // Result line persists until the next click.
+            static std::string s_traceMsg;
+            if (ImGui::SmallButton("export trace")) {
+                std::string path, err;
+                s_traceMsg = editoraiExportTrace(path, err) ? "wrote " + path : err;
+            }
+            tipIfHovered("Writes trace.json (where each generation's time went: "
+                         "prompt, request, parse, checks, tools, spawning) to the "
+                         "mod folder. Open it in chrome://tracing or Perfetto.");
+            if (!s_traceMsg.empty()) {
+                ImGui::SameLine();
+                ImGui::TextColored(COL_DIM, "%s", s_traceMsg.c_str());
+            }
+            static std::string s_selfTestMsg;
+            if (ImGui::SmallButton("parser self-test"))
+                s_selfTestMsg = editoraiParserSelfTest();
+            tipIfHovered("Checks that the multi-core script parser gives exactly "
+                         "the same result as the single-core one on the built-in "
+                         "example levels.");
+            if (!s_selfTestMsg.empty()) {
+                ImGui::SameLine();
+                ImGui::TextColored(COL_DIM, "%s", s_selfTestMsg.c_str());
+            }
+        }
     }
 
     if (ImGui::CollapsingHeader("Theme")) {
@@ -1278,6 +1525,7 @@ void drawOverlay() {
 
     // Background ticks that must run even with the panel closed.
     editoraiOAuthTick(dt);
+    editoraiOllamaTick(g_st.panelOpen);
     g_persistTimer += dt;
     if (g_persistTimer > 5.f) {
         g_persistTimer = 0.f;
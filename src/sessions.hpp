@@ -6,26 +6,91 @@
 #include <Geode/Geode.hpp>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+struct TranscriptEntry {
+    enum class Kind { User, Assistant, Thinking, ToolCall, ToolResult, Status, Error };
+    Kind kind;
+    std::string text;
+};
+
+// A session's display log. The newest RING_CAP entries live in a fixed ring
+// (push never shifts memory); older ones spill SPILL_BATCH at a time, one
+// file per batch (<save dir>/transcripts/session-<id>/<batch>.jsonl, one
+// JSON object per line), and page back in on demand, so history is never
+// lost and memory stays flat however long a session runs. Both directions
+// run on the I/O worker. Indices are global and stable: 0 is the first
+// entry the session ever logged. Main thread only. Spill/page I/O is
+// defined in main.cpp.
+class Transcript {
+public:
+    using Entry = TranscriptEntry;
+    static constexpr size_t RING_CAP    = 300;
+    static constexpr size_t SPILL_BATCH = 50;   // entries per spill file
+    static constexpr size_t MAX_PAGES   = 6;    // paged-in batches kept (LRU)
+
+    // Owning session id — names the spill files. GenSession::push binds it.
+    void bind(int sessionId) { m_owner = sessionId; }
+    void push(Entry e);
+    // Entry by global index (0 .. size()-1). A spilled entry whose batch
+    // isn't resident returns a "(loading…)" placeholder and queues a
+    // background read — the batch is there a frame or two later. A
+    // missing/corrupt spill file yields a placeholder instead of failing.
+    const Entry& at(size_t i) const;
+    size_t size()    const { return m_spilled + m_count; }
+    bool   empty()   const { return size() == 0; }
+    size_t spilled() const { return m_spilled; }   // entries on disk only
+    const Entry& back() const { return m_count ? ringAt(m_count - 1) : at(size() - 1); }
+    // In-memory tail (oldest first) — what sessions.json persists.
+    template <class F> void forEachResident(F&& f) const {
+        for (size_t i = 0; i < m_count; ++i) f(ringAt(i));
+    }
+    // Restore path: re-attach `spilledCount` entries already on disk, then
+    // push() the persisted tail.
+    void restoreSpilled(size_t spilledCount) { m_spilled = spilledCount; }
+
+private:
+    using Batch = std::vector<Entry>;
+    // Shared with the background writes and reads, whose completions run
+    // on the main thread — possibly after the session is gone.
+    struct SpillState {
+        // Spilled batches whose write hasn't landed yet: at() serves them
+        // from here, so a read right after a spill never races the file.
+        std::unordered_map<size_t, std::shared_ptr<const Batch>> unwritten;
+        std::vector<std::pair<size_t, Batch>> pages;   // paged in, MRU first
+        std::unordered_set<size_t>            loading; // reads in flight
+    };
+
+    const Entry& ringAt(size_t i) const { return m_ring[(m_head + i) % RING_CAP]; }
+    Entry& ringAt(size_t i) { return m_ring[(m_head + i) % RING_CAP]; }
+    void spillOldest(size_t n);
+
+    std::vector<Entry> m_ring;    // sized RING_CAP on first push
+    size_t m_head = 0, m_count = 0, m_spilled = 0;
+    int    m_owner = 0;
+    std::shared_ptr<SpillState> m_state = std::make_shared<SpillState>();
+};
+
 struct GenSession {
     enum class State { Running, AwaitingEditor, Staged, Done, Failed };
-    struct Entry {
-        enum class Kind { User, Assistant, Thinking, ToolCall, ToolResult, Status, Error };
-        Kind kind;
-        std::string text;
-    };
+    using Entry = TranscriptEntry;
     // Durable conversation memory — unlike `transcript` (a display log with
     // status/tool noise), `chat` holds only the user/assistant turns and is
     // what a resumed session's AI context is rebuilt from after a restart.
-    // chatPush() folds overflow into `chatSummary` so context never explodes.
+    // chatPush() keeps it bounded: past the budget a background compactor
+    // condenses the oldest turns into `chatSummary` (a structured memory),
+    // and a hard cap folds digests in place so context never explodes.
     struct ChatMsg { int role = 0; std::string text; };  // 0 = user, 1 = assistant
     int                          id = 0;
     std::string                  title;
     State                        state = State::Running;
-    std::vector<Entry>           transcript;
+    Transcript                   transcript;
     std::vector<ChatMsg>         chat;
-    std::string                  chatSummary;     // digest of folded-away turns
+    std::string                  chatSummary;     // memory of folded-away turns
+    size_t                       chatBytes  = 0;  // running size of `chat` (see chatCost)
+    uint64_t                     chatFolded = 0;  // turns ever removed from chat's front
     std::string                  targetLevelName; // persisted; re-resolves targetLevel
     std::string                  pendingEdit;     // edit follow-up waiting for its editor
     int                          pendingEditMode = 0;
@@ -51,24 +116,23 @@ struct GenSession {
     bool        restored   = false;  // loaded from disk — engine context gone
 
     void push(Entry::Kind k, std::string text) {
-        // Rolling window: long conversations keep flowing — the OLDEST
-        // entries fall off (a hard "stop recording" cap would silently
-        // freeze the transcript mid-conversation).
-        if (transcript.size() >= 400)
-            transcript.erase(transcript.begin(),
-                             transcript.begin() + (transcript.size() - 399));
+        // The ring spills its oldest entries to disk when full, so long
+        // conversations keep flowing without dropping history.
         if (text.size() > 1200) { utf8Trim(text, 1200); text += " [...]"; }
-        transcript.push_back({k, std::move(text)});
+        transcript.bind(id);
+        transcript.push({k, std::move(text)});
         void editoraiMarkSessionsDirty();      // fwd-decl; defined in main.cpp
         editoraiMarkSessionsDirty();
     }
 
     // The mod's own context manager: append a turn, then keep the live tail
-    // under a fixed character budget by folding the oldest turns into
-    // `chatSummary` (one digest line each). The summary itself is bounded by
-    // keeping its head (the original request era) plus its newest tail —
-    // so an arbitrarily long conversation always rebuilds into a prompt of
-    // roughly summary + last-N-turns, never the whole history.
+    // bounded. Past the chat-compact-budget setting the compactor (main.cpp)
+    // asks a cheap model, off the critical path, to rewrite the oldest turns
+    // into `chatSummary` and swaps it in when the reply lands. Without a
+    // compactor — or while one is slow — the oldest turns fold into one
+    // digest line each at a hard cap, and the summary is bounded by keeping
+    // its head (the original request era) plus its newest tail. Either way
+    // a long conversation rebuilds into roughly summary + last-N-turns.
     // Trim to at most `cap` bytes without splitting a UTF-8 codepoint (a
     // half-codepoint garbles both the ImGui transcript and API payloads).
     static void utf8Trim(std::string& s, size_t cap) {
@@ -80,14 +144,32 @@ struct GenSession {
             s.pop_back();
     }
 
+    static size_t chatCost(const ChatMsg& m) { return m.text.size() + 16; }
+
+    // Recompute chatBytes after `chat` was filled directly (restore path).
+    void chatRecount() {
+        chatBytes = 0;
+        for (auto& m : chat) chatBytes += chatCost(m);
+    }
+
+    // Drop the `n` oldest turns (the compactor has summarized them).
+    void chatDropFront(size_t n) {
+        n = std::min(n, chat.size());
+        for (size_t i = 0; i < n; ++i) chatBytes -= chatCost(chat[i]);
+        chat.erase(chat.begin(), chat.begin() + n);
+        chatFolded += n;
+    }
+
     void chatPush(int role, std::string text) {
         if (text.size() > 4000) { utf8Trim(text, 4000); text += " [...]"; }
         chat.push_back({role, std::move(text)});
-        size_t total = 0;
-        for (auto& m : chat) total += m.text.size() + 16;
-        while (total > 36000 && chat.size() > 8) {
+        chatBytes += chatCost(chat.back());
+        // Returns the hard cap to enforce here: the budget itself when no
+        // compactor runs, a looser ceiling while one does. Defined in main.cpp.
+        size_t editoraiCompactChat(GenSession& s);
+        size_t cap = editoraiCompactChat(*this);
+        while (chatBytes > cap && chat.size() > 8) {
             auto& old = chat.front();
-            total -= old.text.size() + 16;
             std::string line = old.role == 0 ? "User: " : "AI: ";
             std::string digest = old.text;
             bool cut = digest.size() > 220;
@@ -96,7 +178,7 @@ struct GenSession {
             if (cut) line += " ...";
             line += "\n";
             chatSummary += line;
-            chat.erase(chat.begin());
+            chatDropFront(1);
         }
         if (chatSummary.size() > 8000) {
             std::string head = chatSummary.substr(0, 2000);
@@ -154,6 +236,41 @@ bool editoraiStartGeneration(int target, const std::string& prompt,
                              bool replaceContents, std::string& err,
                              const std::string& expectedName = "");
 
+// ── Batch generation queue (unattended dataset runs) ────────────────────────
+// Jobs run as ordinary headless sessions, scheduled with a per-provider
+// concurrency limit (setting batch-concurrency; local backends default to 1)
+// and priority (higher first, FIFO within a priority). Empty fields fall back
+// to the live settings when the job starts. Defined in main.cpp.
+struct BatchJob {
+    enum class State { Queued, Running, Done, Failed, Cancelled };
+    int         id = 0;
+    std::string prompt, difficulty, style, length;
+    std::string provider;          // empty = the ai-provider setting at start
+    std::string targetLevelName;   // empty = a fresh level per job
+    bool        replaceContents = false;
+    int         priority  = 0;
+    State       state     = State::Queued;
+    int         sessionId = 0;     // the session running it (once started)
+    int64_t     queuedAt = 0, startedAt = 0, finishedAt = 0;   // unix seconds
+    std::string error;
+    const char* stateName() const;
+};
+struct BatchStats {
+    int    queued = 0, running = 0, done = 0, failed = 0;
+    double levelsPerHour = 0.0;   // done jobs over the run's wall time
+    double avgSeconds    = 0.0;   // mean duration of done jobs
+    bool   paused = false;
+};
+int                   editoraiBatchEnqueue(BatchJob job);   // returns the job id (0 = rejected)
+// Loads <save dir>/batch.json (a job array, or {limits, defaults, jobs});
+// returns the number of jobs queued, with a reason in err when 0.
+int                   editoraiBatchLoadFile(std::string& err);
+std::vector<BatchJob> editoraiBatchJobs();                  // snapshot for display
+BatchStats            editoraiBatchStats();
+void                  editoraiBatchCancel(int jobId);
+void                  editoraiBatchSetPaused(bool paused);
+void                  editoraiBatchClearFinished();
+
 // Manual provider (copy-paste with any chatbot): editoraiManualCopy builds the
 // full prompt for the CURRENT editor and copies it to the clipboard; the user
 // pastes it into any AI, copies the reply, then editoraiManualBuild reads the
@@ -199,10 +316,23 @@ void editoraiPersistSessionsIfDirty();   // throttled; overlay ticks this
 bool editoraiShareSession(const std::shared_ptr<GenSession>& session,
                           std::string& err);
 
+// Phase-trace export (Chrome trace-event JSON → <save dir>/trace.json, for
+// chrome://tracing or Perfetto). pathOut gets the written file's path.
+bool editoraiExportTrace(std::string& pathOut, std::string& err);
+// Differential checks: chunked (parallel) EAS parse vs sequential over the
+// embedded example corpus, and the compact dialect vs its long-hand
+// lowering. Returns one human-readable verdict line per check.
+std::string editoraiParserSelfTest();
+
 // ── Saved (online) levels — example/style reference pickers ────────────────
 struct SavedLevelInfo { std::string name; int levelId = 0; };
 std::vector<SavedLevelInfo> editoraiListSavedLevels();
 
+// ── Ollama residency (overlay's per-frame tick) ────────────────────────────
+// Preloads the configured model when the panel opens, keeps it pinned while
+// sessions run, and polls /api/ps for the provider chip. No-op off Ollama.
+void editoraiOllamaTick(bool panelOpen);
+
 // ── Headless OAuth (driven from the overlay's per-frame tick) ───────────────
 bool        editoraiOAuthAvailable(const std::string& provider);
 bool        editoraiOAuthStart(const std::string& provider);